@@ -308,6 +308,7 @@ VOID* Allocator::Bitmap = NULL;
 
 size_t Allocator::Perf_AllocationsNum = 0;
 size_t Allocator::Perf_TotalAllocatedSize = 0;
+ULONG64 Allocator::Perf_AllocCallsNum = 0;
 
 BOOLEAN Allocator::TestBitmap()
 {
@@ -417,6 +418,7 @@ VOID* Allocator::Alloc(size_t size)
 
 	Perf_AllocationsNum++;
 	Perf_TotalAllocatedSize += sizeInBits * BlockSize;
+	Perf_AllocCallsNum++;
 
 	return ret;
 }
@@ -506,6 +508,10 @@ VOID Allocator::GetPoolMap(CHAR* out, LONG num)
 
 VOID Allocator::FatalError(const CHAR* msg) // FIXFIX: find a way to Bug Check here without reentering in the debugger!
 {
+#ifdef BC_HOSTSIM
+	::HostSim_FatalError(msg); // the simulator aborts the test.
+#endif
+
 	while (1)
 		if (Root::I && Root::I->VideoAddr)
 		{
@@ -558,17 +564,26 @@ void __cdecl operator delete(void* address)
 
 //
 
+#ifndef BC_HOSTSIM
 void* __cdecl operator new(size_t, void* address)
 {
 	return address;
 }
+#endif
 
 void __cdecl operator delete[](void* address)
 {
 	::operator delete(address);
 }
 
+void __cdecl operator delete[](void* address, size_t)
+{
+	::operator delete(address);
+}
+
+#ifndef BC_HOSTSIM
 void __cdecl operator delete(void*, void*) {}
+#endif
 
 void __cdecl operator delete(void* address, size_t)
 {
@@ -599,6 +614,9 @@ namespace eastl
 		if (Root::I)
 			return &Root::I->eastl_allocator;
 		else
+		{
 			Allocator::FatalError("ROOT_NULL_IN_GETDEFAULTALLOCATOR");
+			return NULL; // FatalError never returns.
+		}
 	}
 }
@@ -41,15 +41,20 @@ public:
 
 	static size_t Perf_AllocationsNum; // for internal tests only.
 	static size_t Perf_TotalAllocatedSize; // for internal tests only.
+	static ULONG64 Perf_AllocCallsNum; // never decremented: shown by the PERF command.
 };
 
 //
 
 void* __cdecl operator new(size_t count);
+#ifndef BC_HOSTSIM // on the host, the placement forms are defined by the C++ library.
 void* __cdecl operator new(size_t, void* address);
+#endif
 void* operator new[](size_t size, const char* pName, int flags, unsigned debugFlags, const char* file, int line);
 void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, int flags, unsigned debugFlags, const char* file, int line);
 void __cdecl operator delete(void* address);
 void __cdecl operator delete[](void* address);
+#ifndef BC_HOSTSIM
 void __cdecl operator delete(void*, void*);
+#endif
 void __cdecl operator delete(void* address, size_t);
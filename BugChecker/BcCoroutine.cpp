@@ -3,6 +3,63 @@
 #include "Root.h"
 #include "Platform.h"
 
+#include <EASTL/sort.h>
+
+BYTE BcFramePool::Pool[BcFramePool::PoolSize];
+
+ULONG BcFramePool::top = 0;
+ULONG BcFramePool::last = (ULONG)-1;
+
+ULONG64 BcFramePool::Perf_PoolAllocsNum = 0;
+ULONG64 BcFramePool::Perf_HeapAllocsNum = 0;
+
+VOID* BcFramePool::Alloc(size_t size)
+{
+	size = (size + HeaderSize - 1) & ~((size_t)HeaderSize - 1);
+
+	if ((size_t)top + HeaderSize + size > PoolSize)
+	{
+		Perf_HeapAllocsNum++;
+		return ::operator new(size);
+	}
+
+	Perf_PoolAllocsNum++;
+
+	Header* header = (Header*)&Pool[top];
+
+	header->prev = last;
+	header->freed = FALSE;
+
+	last = top;
+	top += HeaderSize + (ULONG)size;
+
+	return (BYTE*)header + HeaderSize;
+}
+
+VOID BcFramePool::Free(VOID* ptr)
+{
+	if ((BYTE*)ptr < Pool || (BYTE*)ptr >= Pool + PoolSize)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	((Header*)((BYTE*)ptr - HeaderSize))->freed = TRUE;
+
+	// pop all the freed frames at the top of the stack.
+
+	while (last != (ULONG)-1)
+	{
+		Header* header = (Header*)&Pool[last];
+
+		if (!header->freed)
+			break;
+
+		top = last;
+		last = header->prev;
+	}
+}
+
 ProcessAwaiterRetVal BcAwaiterBase::ProcessAwaiter(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes)
 {
 	Root::I->DebuggerState = DEBST_COROUTINE;
@@ -24,98 +81,249 @@ ProcessAwaiterRetVal BcAwaiterBase::ProcessAwaiter(DBGKD_MANIPULATE_STATE64* pSt
 		}
 	}
 
-	// prepare the manipulate state request according to the awaiter's type.
+	// let the awaiter prepare the manipulate state request.
 
-	if (!::strcmp(Root::I->AwaiterPtr->function, "BcAwaiter_StateManipulate"))
+	return const_cast<BcAwaiterBase*>(Root::I->AwaiterPtr)->Prepare(pState, SecondBuffer, PayloadBytes);
+}
+
+ProcessAwaiterRetVal BcAwaiter_StateManipulateBase::RequestPrepared(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes)
+{
+	if (PayloadBytes) *PayloadBytes = SecondBuffer->Length;
+
+	// memory and breakpoint writes make the cached pages stale.
+
+	switch (pState->ApiNumber)
 	{
-		BcAwaiter_StateManipulate* ptr = (BcAwaiter_StateManipulate*)Root::I->AwaiterPtr;
-		ptr->prepareRequest(pState, SecondBuffer);
-		if (PayloadBytes) *PayloadBytes = SecondBuffer->Length;
-		return ProcessAwaiterRetVal::Ok;
+	case DbgKdWriteVirtualMemoryApi:
+		Root::I->ReadCache.Invalidate(pState->u.WriteMemory.TargetBaseAddress, pState->u.WriteMemory.TransferCount);
+		Root::I->DecodedInstrs.Invalidate(pState->u.WriteMemory.TargetBaseAddress, pState->u.WriteMemory.TransferCount);
+		Root::I->DisasmWindow.boundaries.Invalidate(pState->u.WriteMemory.TargetBaseAddress, pState->u.WriteMemory.TransferCount);
+		break;
+	case DbgKdWriteBreakPointApi:
+		Root::I->ReadCache.Invalidate(pState->u.WriteBreakPoint.BreakPointAddress, 1);
+		break;
+	case DbgKdRestoreBreakPointApi:
+	case DbgKdWriteBreakPointExApi:
+	case DbgKdRestoreBreakPointExApi:
+	case DbgKdWritePhysicalMemoryApi:
+	case DbgKdWriteControlSpaceApi:
+	case DbgKdWriteIoSpaceApi:
+	case DbgKdWriteIoSpaceExtendedApi:
+	case DbgKdFillMemoryApi:
+	case DbgKdPageInApi:
+		Root::I->ReadCache.InvalidateAll(); // the decoded instructions are validated by their bytes: they are not invalidated by the breakpoint writes, which happen at each step.
+		break;
 	}
-	else if (!::strcmp(Root::I->AwaiterPtr->function, "BcAwaiter_DiscoverPosInModules"))
+
+	return ProcessAwaiterRetVal::Ok;
+}
+
+ProcessAwaiterRetVal BcAwaiter_BreakPoints::Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes)
+{
+	if (current >= opsNum)
+		return ProcessAwaiterRetVal::RepeatLoop; // nothing to do: resume the coroutine.
+
+	if (!current)
+		startTime = __rdtsc();
+
+	BcBreakPointOp& op = ops[current];
+
+	pState->ReturnStatus = STATUS_PENDING;
+
+	if (op.restore)
 	{
-		BcAwaiter_DiscoverPosInModules* ptr = (BcAwaiter_DiscoverPosInModules*)Root::I->AwaiterPtr;
-		ptr->PrepareRequest();
-		return ProcessAwaiterRetVal::RepeatLoop;
+		pState->ApiNumber = DbgKdRestoreBreakPointApi;
+
+		pState->u.RestoreBreakPoint.BreakPointHandle = op.handle;
 	}
-	else if (!::strcmp(Root::I->AwaiterPtr->function, "BcAwaiter_RecvTimeout"))
+	else
 	{
-		return ProcessAwaiterRetVal::Timeout;
+		pState->ApiNumber = DbgKdWriteBreakPointApi;
+
+		pState->u.WriteBreakPoint.BreakPointHandle = 0;
+		pState->u.WriteBreakPoint.BreakPointAddress = op.address;
 	}
-	else if (!::strcmp(Root::I->AwaiterPtr->function, "BcAwaiter_ReadMemory"))
+
+	return BcAwaiter_StateManipulateBase::RequestPrepared(pState, SecondBuffer, PayloadBytes);
+}
+
+void BcAwaiter_BreakPoints::Complete(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer)
+{
+	BcBreakPointOp& op = ops[current++];
+
+	if (op.restore)
 	{
-		BcAwaiter_ReadMemory* ptr = (BcAwaiter_ReadMemory*)Root::I->AwaiterPtr;
-		ptr->PrepareRequest();
-		return ProcessAwaiterRetVal::RepeatLoop;
+		op.ok = pState->ApiNumber == DbgKdRestoreBreakPointApi && NT_SUCCESS(pState->ReturnStatus);
 	}
-	else if (!::strcmp(Root::I->AwaiterPtr->function, "BcAwaiter_Join"))
+	else if (pState->ApiNumber == DbgKdWriteBreakPointApi &&
+		NT_SUCCESS(pState->ReturnStatus) &&
+		pState->u.WriteBreakPoint.BreakPointHandle)
 	{
-		BcAwaiter_Join* ptr = (BcAwaiter_Join*)Root::I->AwaiterPtr;
+		op.handle = pState->u.WriteBreakPoint.BreakPointHandle;
+		op.ok = TRUE;
+	}
+	else
+		op.ok = FALSE;
 
-		Root::I->AwaiterStack.push_back(const_cast<BcAwaiterBase*>(Root::I->AwaiterPtr));
-		Root::I->AwaiterPtr = NULL;
+	if (op.ok)
+		retVal++;
 
-		ptr->coroutine.Start(&Root::I->AwaiterPtr);
+	// send the next request in the next KdReceivePacket call, without resuming the coroutine.
 
+	if (current < opsNum)
+	{
 		Root::I->DebuggerState = DEBST_PROCESS_AWAITER;
-		return ProcessAwaiterRetVal::RepeatLoop;
 	}
 	else
-		return ProcessAwaiterRetVal::RepeatLoop;
+	{
+		Root::I->Perf_BpOpsNum += opsNum;
+		Root::I->Perf_BpOpsBatchesNum++;
+		Root::I->Perf_BpOpsTime += __rdtsc() - startTime;
+	}
 }
 
-BcAwaiter_DiscoverPosInModules::BcAwaiter_DiscoverPosInModules(CHAR* outputBufferParam, ImageDebugInfo* debugInfoParam, ULONG_PTR pointerParam)
+ProcessAwaiterRetVal BcAwaiter_Join::Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes)
 {
-	function = "BcAwaiter_DiscoverPosInModules";
-	retVal = TRUE;
+	Root::I->AwaiterStack.push_back(this);
+	Root::I->AwaiterPtr = NULL;
 
-	::strcpy(outputBufferParam, "");
-	::memset(debugInfoParam, 0, sizeof(*debugInfoParam));
+	coroutine.Start(&Root::I->AwaiterPtr);
 
-	outputBuffer = outputBufferParam;
-	debugInfo = debugInfoParam;
-	bytePointer = (BYTE*)pointerParam;
+	Root::I->DebuggerState = DEBST_PROCESS_AWAITER;
+	return ProcessAwaiterRetVal::RepeatLoop;
 }
 
-void BcAwaiter_DiscoverPosInModules::PrepareRequest()
+ProcessAwaiterRetVal BcAwaiter_ReadMemory::Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes)
 {
-	auto params = (DiscoverBytePointerPosInModules_Params*)Root::I->MemReadCor.InputParams;
-
-	params->pszOutputBuffer = outputBuffer;
-	params->pidiDebugInfo = debugInfo;
-	params->pbBytePointer = bytePointer;
-
-	params->pvPsLoadedModuleList = (VOID*)(ULONG_PTR)Root::I->PsLoadedModuleList;
-	params->pvMmUserProbeAddress = Platform::UserProbeAddress;
-	params->pvPCRAddress = Platform::GetPcrAddress();
-
-	Root::I->MemReadCor.ResumePoint = 0;
+	Root::I->MemReadCor.ResumePoint = 2; // important, see ReadCompleted.
 
 	Root::I->MemReadCor.Pointer = NULL;
 	Root::I->MemReadCor.BytesToRead = 0;
 	Root::I->MemReadCor.ActualBytesRead = 0;
 	Root::I->MemReadCor.BufferPos = 0;
+	Root::I->MemReadCor.ChunkSize = 0;
 
-	Root::I->MemReadCor.pCoroutine = Platform::DiscoverBytePointerPosInModules;
+	Root::I->MemReadCor.pCoroutine = NULL;
 	Root::I->MemReadCor.EndDebuggerState = DEBST_COROUTINE;
 
 	Root::I->DebuggerState = DEBST_MEMREADCOR;
-	return;
+	return ProcessAwaiterRetVal::RepeatLoop;
+}
+
+void BcAwaiter_ReadMemory::ReadCompleted()
+{
+	Root::I->MemReadCor.ResumePoint--; // initialized to 2 in Prepare.
+
+	if (Root::I->MemReadCor.ResumePoint == 1)
+	{
+		Root::I->MemReadCor.Pointer = (VOID*)pointer;
+		Root::I->MemReadCor.BytesToRead = size;
+	}
+	else if (Root::I->MemReadCor.ResumePoint <= 0)
+	{
+		if (Root::I->MemReadCor.ActualBytesRead == Root::I->MemReadCor.BytesToRead)
+			retVal = Root::I->MemReadCor.Buffer;
+	}
 }
 
-void BcAwaiter_ReadMemory::PrepareRequest()
+ProcessAwaiterRetVal BcAwaiter_ReadMemoryBatch::Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes)
 {
-	Root::I->MemReadCor.ResumePoint = 2; // important, see the DEBST_MEMREADCOR handler.
+	// sort the ranges by address, so that the ones that are adjacent or in the same page can be read together.
+
+	order.clear();
+
+	for (size_t i = 0; i < rangesNum; i++)
+	{
+		ranges[i].ok = FALSE;
+
+		if (!ranges[i].size)
+		{
+			ranges[i].ok = TRUE;
+			retVal++;
+		}
+		else if (ranges[i].size <= sizeof(Root::I->MemReadCor.Buffer))
+		{
+			order.push_back(i);
+		}
+	}
+
+	eastl::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return ranges[a].pointer < ranges[b].pointer; });
+
+	first = last = 0;
+
+	// the first segment is set by ReadCompleted, called by the DEBST_MEMREADCOR handler.
+
+	Root::I->MemReadCor.ResumePoint = 1;
 
 	Root::I->MemReadCor.Pointer = NULL;
 	Root::I->MemReadCor.BytesToRead = 0;
 	Root::I->MemReadCor.ActualBytesRead = 0;
 	Root::I->MemReadCor.BufferPos = 0;
+	Root::I->MemReadCor.ChunkSize = 0;
 
 	Root::I->MemReadCor.pCoroutine = NULL;
 	Root::I->MemReadCor.EndDebuggerState = DEBST_COROUTINE;
 
 	Root::I->DebuggerState = DEBST_MEMREADCOR;
-	return;
+	return ProcessAwaiterRetVal::RepeatLoop;
+}
+
+void BcAwaiter_ReadMemoryBatch::ReadCompleted()
+{
+	// copy the data of the segment just read to its ranges: if the read failed, the range containing the failure point
+	// is marked as failed and the ranges after it are read again in a new segment.
+
+	size_t i;
+
+	for (i = first; i < last; i++)
+	{
+		BcReadMemoryRange& r = ranges[order[i]];
+
+		ULONG offset = (ULONG)(r.pointer - segmentStart);
+
+		if (offset + r.size > Root::I->MemReadCor.ActualBytesRead)
+		{
+			i++;
+			break;
+		}
+
+		::memcpy(r.dest, Root::I->MemReadCor.Buffer + offset, r.size);
+
+		r.ok = TRUE;
+		retVal++;
+	}
+
+	first = i;
+
+	if (first >= order.size())
+	{
+		Root::I->MemReadCor.ResumePoint = 0;
+		return;
+	}
+
+	// compose the next segment, coalescing the ranges that overlap or share a page with it.
+
+	BcReadMemoryRange& r0 = ranges[order[first]];
+
+	segmentStart = r0.pointer;
+	ULONG_PTR segmentEnd = r0.pointer + r0.size;
+
+	for (last = first + 1; last < order.size(); last++)
+	{
+		BcReadMemoryRange& r = ranges[order[last]];
+
+		if (r.pointer > segmentEnd && (r.pointer & ~(ULONG_PTR)(PAGE_SIZE - 1)) != ((segmentEnd - 1) & ~(ULONG_PTR)(PAGE_SIZE - 1)))
+			break;
+
+		ULONG_PTR end = _MAX_(segmentEnd, r.pointer + r.size);
+
+		if (end - segmentStart > sizeof(Root::I->MemReadCor.Buffer))
+			break;
+
+		segmentEnd = end;
+	}
+
+	Root::I->MemReadCor.Pointer = (VOID*)segmentStart;
+	Root::I->MemReadCor.BytesToRead = (ULONG)(segmentEnd - segmentStart);
+	Root::I->MemReadCor.ActualBytesRead = 0;
 }
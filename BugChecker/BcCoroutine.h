@@ -2,11 +2,16 @@
 
 #include "BugChecker.h"
 
+#ifndef BC_HOSTSIM
 #include "Cpp20CoroutineFill.h"
+#else
+#include <coroutine> // GCC: the C++ library header is used.
+#endif
 #include "KdCom.h"
 #include "DbgKd.h"
 
 #include <EASTL/functional.h>
+#include <EASTL/vector.h>
 
 //
 // Quick and simple C++ 20 coroutine support classes for BugChecker.
@@ -14,10 +19,51 @@
 
 struct BcAwaiterBase;
 
+enum class BcAwaiterType : BYTE // recorded in the KD packet trace.
+{
+	None,
+	StateManipulate,
+	RecvTimeout,
+	ReadMemory,
+	ReadMemoryBatch,
+	BreakPoints,
+	Join
+};
+
+class BcFramePool // LIFO stack where the coroutine frames are allocated: coroutines are nested strictly through BcAwaiter_Join, so the frames are freed in reverse order.
+{
+public:
+
+	static constexpr ULONG PoolSize = 512 * 1024;
+	static constexpr ULONG HeaderSize = 16;
+
+	static VOID* Alloc(size_t size); // falls back to the heap when the pool is full.
+	static VOID Free(VOID* ptr); // a frame freed out of order is released when the frames above it are freed.
+
+	static ULONG64 Perf_PoolAllocsNum;
+	static ULONG64 Perf_HeapAllocsNum;
+
+private:
+
+	struct Header
+	{
+		ULONG prev; // offset of the header of the previous frame, or -1.
+		ULONG freed;
+	};
+
+	alignas(16) static BYTE Pool[PoolSize];
+
+	static ULONG top;
+	static ULONG last;
+};
+
 struct BcCoroutine
 {
 	struct promise_type
 	{
+		static void* operator new(size_t size) { return BcFramePool::Alloc(size); } // not noexcept: never NULL, the allocator stops on out of memory.
+		static void operator delete(void* ptr) noexcept { BcFramePool::Free(ptr); }
+
 		BcCoroutine get_return_object() noexcept { return BcCoroutine(std::coroutine_handle<BcCoroutine::promise_type>::from_promise(*this)); }
 
 		std::suspend_always initial_suspend() noexcept { return {}; }
@@ -42,8 +88,6 @@ private:
 	std::coroutine_handle<BcCoroutine::promise_type> coroHandle = NULL;
 };
 
-using BcAwaiterFunction = const CHAR*;
-
 enum class ProcessAwaiterRetVal
 {
 	Ok,
@@ -61,10 +105,19 @@ struct BcAwaiterBase
 		p->coroHandle();
 	}
 
-	BcAwaiterFunction function = NULL;
-
 	static ProcessAwaiterRetVal ProcessAwaiter(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes);
 
+	// called by ProcessAwaiter: prepares the manipulate state request or changes the debugger state.
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes) = 0;
+
+	// called by KdSendPacket with the response to the request prepared above.
+	virtual void Complete(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {}
+
+	// called by the DEBST_MEMREADCOR handler when a read is completed, for the awaiters that set the DEBST_MEMREADCOR state without a custom coroutine.
+	virtual void ReadCompleted() {}
+
+	virtual BcAwaiterType GetType() = 0;
+
 protected:
 
 	std::coroutine_handle<BcCoroutine::promise_type> coroHandle = NULL;
@@ -91,69 +144,147 @@ struct BcAwaiterRetVal : BcAwaiterBase
 
 typedef BOOLEAN NoReturnValue; // =fixfix= with coroutines and templates, there are better ways to accomplish this!
 
-struct BcAwaiter_StateManipulate : BcAwaiterRetVal<BOOLEAN>
+struct BcAwaiter_StateManipulateBase : BcAwaiterRetVal<BOOLEAN>
+{
+	static ProcessAwaiterRetVal RequestPrepared(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes);
+
+	virtual BcAwaiterType GetType() { return BcAwaiterType::StateManipulate; }
+};
+
+template <typename PrepareRequestFn, typename ProcessResponseFn>
+struct BcAwaiter_StateManipulate : BcAwaiter_StateManipulateBase // the lambdas are stored by value in the awaiter (and so in the coroutine frame): no heap allocations.
 {
-	BcAwaiter_StateManipulate(
-		eastl::function<void(DBGKD_MANIPULATE_STATE64*, PKD_BUFFER)> prepareRequestParam,
-		eastl::function<BOOLEAN(DBGKD_MANIPULATE_STATE64*, PKD_BUFFER)> processResponseParam)
+	BcAwaiter_StateManipulate(PrepareRequestFn prepareRequestParam, ProcessResponseFn processResponseParam)
 		: prepareRequest(eastl::move(prepareRequestParam)),
 		processResponse(eastl::move(processResponseParam))
 	{
-		function = "BcAwaiter_StateManipulate";
 		retVal = FALSE;
 	}
 
-	eastl::function<void(DBGKD_MANIPULATE_STATE64*, PKD_BUFFER)> prepareRequest;
-	eastl::function<BOOLEAN(DBGKD_MANIPULATE_STATE64*, PKD_BUFFER)> processResponse;
-};
-
-class ImageDebugInfo;
-
-struct BcAwaiter_DiscoverPosInModules : BcAwaiterRetVal<NoReturnValue>
-{
-	BcAwaiter_DiscoverPosInModules(CHAR* outputBufferParam, ImageDebugInfo* debugInfoParam, ULONG_PTR pointerParam);
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes)
+	{
+		prepareRequest(pState, SecondBuffer);
+		return RequestPrepared(pState, SecondBuffer, PayloadBytes);
+	}
 
-	void PrepareRequest();
+	virtual void Complete(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) { retVal = processResponse(pState, SecondBuffer); }
 
-	CHAR* outputBuffer;
-	ImageDebugInfo* debugInfo;
-	BYTE* bytePointer;
+	PrepareRequestFn prepareRequest;
+	ProcessResponseFn processResponse;
 };
 
 struct BcAwaiter_RecvTimeout : BcAwaiterRetVal<NoReturnValue>
 {
 	BcAwaiter_RecvTimeout()
 	{
-		function = "BcAwaiter_RecvTimeout";
 		retVal = TRUE;
 	}
+
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes) { return ProcessAwaiterRetVal::Timeout; }
+
+	virtual BcAwaiterType GetType() { return BcAwaiterType::RecvTimeout; }
 };
 
 struct BcAwaiter_ReadMemory : BcAwaiterRetVal<VOID*>
 {
 	BcAwaiter_ReadMemory(ULONG_PTR pointerParam, size_t sizeParam)
 	{
-		function = "BcAwaiter_ReadMemory";
 		retVal = NULL;
 
 		pointer = pointerParam;
 		size = sizeParam;
 	}
 
-	void PrepareRequest();
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes);
+	virtual void ReadCompleted();
+
+	virtual BcAwaiterType GetType() { return BcAwaiterType::ReadMemory; }
 
 	ULONG_PTR pointer;
 	size_t size;
 };
 
+struct BcReadMemoryRange
+{
+	ULONG_PTR pointer;
+	ULONG size;
+	VOID* dest;
+	BOOLEAN ok; // set by BcAwaiter_ReadMemoryBatch.
+};
+
+struct BcAwaiter_ReadMemoryBatch : BcAwaiterRetVal<ULONG> // returns the number of ranges read successfully.
+{
+	BcAwaiter_ReadMemoryBatch(BcReadMemoryRange* rangesParam, size_t rangesNumParam)
+	{
+		retVal = 0;
+
+		ranges = rangesParam;
+		rangesNum = rangesNumParam;
+	}
+
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes);
+	virtual void ReadCompleted(); // the read of a segment is completed.
+
+	virtual BcAwaiterType GetType() { return BcAwaiterType::ReadMemoryBatch; }
+
+	BcReadMemoryRange* ranges;
+	size_t rangesNum;
+
+private:
+
+	eastl::vector<size_t> order; // the ranges sorted by address.
+
+	size_t first = 0; // the ranges in the segment being read: [first, last).
+	size_t last = 0;
+
+	ULONG_PTR segmentStart = 0;
+};
+
+struct BcBreakPointOp
+{
+	ULONG64 address; // write: address of the new breakpoint.
+	ULONG handle; // write: set to the handle of the new breakpoint; restore: handle of the breakpoint to remove.
+	BOOLEAN restore;
+	BOOLEAN ok; // set by BcAwaiter_BreakPoints.
+};
+
+struct BcAwaiter_BreakPoints : BcAwaiterRetVal<ULONG> // returns the number of operations that succeeded.
+{
+	BcAwaiter_BreakPoints(BcBreakPointOp* opsParam, size_t opsNumParam)
+	{
+		retVal = 0;
+
+		ops = opsParam;
+		opsNum = opsNumParam;
+	}
+
+	// the requests are sent one after the other, without resuming the coroutine until the last response is received.
+
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes);
+	virtual void Complete(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer);
+
+	virtual BcAwaiterType GetType() { return BcAwaiterType::BreakPoints; }
+
+	BcBreakPointOp* ops;
+	size_t opsNum;
+
+private:
+
+	size_t current = 0;
+	ULONG64 startTime = 0;
+};
+
 struct BcAwaiter_Join : BcAwaiterRetVal<NoReturnValue>
 {
 	BcAwaiter_Join(BcCoroutine coroutineParam)
 		: coroutine(eastl::move(coroutineParam))
 	{
-		function = "BcAwaiter_Join";
 		retVal = TRUE;
 	}
 
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes);
+
+	virtual BcAwaiterType GetType() { return BcAwaiterType::Join; }
+
 	BcCoroutine coroutine;
 };
@@ -210,6 +210,193 @@ BcCoroutine Cmd::WriteMemory(ULONG64 dest, VOID* src, ULONG count, BOOLEAN& res)
 	co_return;
 }
 
+BcCoroutine Cmd::SetBreakPoint(ULONG64 address, BYTE& prevByte, ULONG& handle) noexcept
+{
+	handle = 0;
+
+	// read the byte to overwrite with the breakpoint instruction.
+
+	VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)address, sizeof(BYTE) };
+	if (!ptr)
+	{
+		Print("Unable to read memory.");
+		co_return;
+	}
+
+	prevByte = *(BYTE*)ptr;
+
+	// set the breakpoint.
+
+	if (!co_await BcAwaiter_StateManipulate{
+	[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+		pState->ApiNumber = DbgKdWriteBreakPointApi;
+
+		pState->ReturnStatus = STATUS_PENDING;
+
+		pState->u.WriteBreakPoint.BreakPointHandle = 0;
+		pState->u.WriteBreakPoint.BreakPointAddress = address;
+	},
+	[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+		if (pState->ApiNumber == DbgKdWriteBreakPointApi)
+		{
+			if (NT_SUCCESS(pState->ReturnStatus) &&
+				pState->u.WriteBreakPoint.BreakPointHandle)
+			{
+				handle = pState->u.WriteBreakPoint.BreakPointHandle;
+				return TRUE;
+			}
+		}
+
+		return FALSE;
+	} })
+	{
+		Print("Error setting breakpoint.");
+		co_return;
+	}
+
+	co_return;
+}
+
+BcCoroutine Cmd::WriteDebugRegisters(BOOLEAN& res) noexcept
+{
+	// compute the debug registers: the breakpoints are local (Ln bits).
+
+	ULONG64 drs[4] = { 0 };
+	ULONG64 dr7 = 0;
+
+	for (BreakPoint& bp : Root::I->BreakPoints)
+		if (bp.drIndex >= 0)
+		{
+			drs[bp.drIndex] = bp.address;
+			dr7 |= (1ull << (bp.drIndex * 2)) | ((ULONG64)((bp.drLen << 2) | bp.drRw) << (16 + bp.drIndex * 4));
+		}
+
+	// DR0-DR3 are in the KSPECIAL_REGISTERS of each processor, which KD loads in the debug registers when the processor is resumed.
+	// DR7 is set on all the processors by the next DbgKdContinueApi2 request.
+
+	res = TRUE;
+
+	for (ULONG processor = 0; processor < Root::I->StateChange.NumberProcessors && res; processor++)
+	{
+#ifdef _AMD64_
+		// x64: the KSPECIAL_REGISTERS structure is read and written as a whole (at the control space address 2), since its size depends on the OS version.
+
+		static BYTE special[0x400];
+		ULONG specialSize = 0;
+
+		res = co_await BcAwaiter_StateManipulate{
+		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+			pState->ApiNumber = DbgKdReadControlSpaceApi;
+			pState->Processor = (USHORT)processor;
+
+			pState->ReturnStatus = STATUS_PENDING;
+
+			pState->u.ReadMemory.TargetBaseAddress = 2; // AMD64_DEBUG_CONTROL_SPACE_KSPECIAL
+			pState->u.ReadMemory.TransferCount = _MIN_(sizeof(special), SecondBuffer->MaxLength);
+			pState->u.ReadMemory.ActualBytesRead = 0;
+		},
+		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+			if (pState->ApiNumber == DbgKdReadControlSpaceApi)
+			{
+				if (NT_SUCCESS(pState->ReturnStatus) &&
+					SecondBuffer->pData != NULL && SecondBuffer->Length >= 0x40 && SecondBuffer->Length <= sizeof(special))
+				{
+					::memcpy(special, SecondBuffer->pData, SecondBuffer->Length);
+					specialSize = SecondBuffer->Length;
+					return TRUE;
+				}
+			}
+
+			return FALSE;
+		} };
+
+		if (!res)
+			break;
+
+		::memcpy(special + 0x20, drs, sizeof(drs)); // KernelDr0-KernelDr3, after Cr0, Cr2, Cr3 and Cr4.
+
+		const VOID* data = special;
+		ULONG64 address = 2;
+		ULONG size = specialSize;
+#else
+		// x86: the control space is the KPROCESSOR_STATE, i.e. the CONTEXT followed by the KSPECIAL_REGISTERS.
+
+		ULONG drs32[4] = { (ULONG)drs[0], (ULONG)drs[1], (ULONG)drs[2], (ULONG)drs[3] };
+
+		const VOID* data = drs32;
+		ULONG64 address = sizeof(CONTEXT) + 0x10; // KernelDr0-KernelDr3, after Cr0, Cr2, Cr3 and Cr4.
+		ULONG size = sizeof(drs32);
+#endif
+
+		res = co_await BcAwaiter_StateManipulate{
+		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+			SecondBuffer->Length = !SecondBuffer->pData ? 0 : _MIN_(SecondBuffer->MaxLength, size);
+			if (SecondBuffer->pData)
+				::memcpy(SecondBuffer->pData, data, SecondBuffer->Length);
+
+			pState->ApiNumber = DbgKdWriteControlSpaceApi;
+			pState->Processor = (USHORT)processor;
+
+			pState->ReturnStatus = STATUS_PENDING;
+
+			pState->u.WriteMemory.TargetBaseAddress = address;
+			pState->u.WriteMemory.TransferCount = size;
+			pState->u.WriteMemory.ActualBytesWritten = 0;
+		},
+		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+			return pState->ApiNumber == DbgKdWriteControlSpaceApi &&
+				NT_SUCCESS(pState->ReturnStatus) &&
+				pState->u.WriteMemory.ActualBytesWritten == size;
+		} };
+	}
+
+	if (res)
+	{
+		Root::I->HwDr7 = dr7;
+		Root::I->HwDr7Set = TRUE;
+	}
+
+	co_return;
+}
+
+BcCoroutine Cmd::AddHwBreakPoint(BreakPoint& bp, BOOLEAN& res) noexcept
+{
+	res = FALSE;
+
+	bp.drIndex = Root::I->BreakPoints.GetFreeDrIndex();
+	bp.handle = 0;
+
+	if (bp.drIndex < 0)
+	{
+		Print("All the debug registers are in use.");
+		co_return;
+	}
+
+	Root::I->BreakPoints.push_back(eastl::move(bp));
+
+	co_await BcAwaiter_Join{ WriteDebugRegisters(res) };
+
+	if (!res)
+	{
+		Print("Unable to write the debug registers.");
+
+		// remove the breakpoint and restore the previous debug registers.
+
+		Root::I->BreakPoints.erase(Root::I->BreakPoints.end() - 1);
+
+		BOOLEAN restored = FALSE;
+		co_await BcAwaiter_Join{ WriteDebugRegisters(restored) };
+	}
+
+	co_return;
+}
+
 BcCoroutine Cmd::ResolveArg(eastl::pair<BOOLEAN, ULONG64>& res, const CHAR* arg, BYTE* context, ULONG contextLen, BOOLEAN is32bitCompat) noexcept
 {
 	res.first = FALSE;
@@ -244,7 +431,7 @@ BcCoroutine Cmd::ResolveArg(eastl::pair<BOOLEAN, ULONG64>& res, const CHAR* arg,
 
 		if (len > 0 && len <= 16)
 		{
-			int i;
+			size_t i;
 			for (i = 0; i < len; i++)
 			{
 				CHAR c = ptr[i];
@@ -458,7 +645,7 @@ eastl::vector<ULONG> Cmd::ParseListOfDecsArgs(const CHAR* cmdId, const eastl::st
 
 	BOOLEAN all = FALSE;
 
-	for (int i = 0; i < argsStr.size(); i++)
+	for (int i = 0; i < (int)argsStr.size(); i++)
 	{
 		auto& arg = argsStr[i];
 
@@ -513,6 +700,44 @@ eastl::vector<ULONG> Cmd::ParseListOfDecsArgs(const CHAR* cmdId, const eastl::st
 	return nums;
 }
 
+BOOLEAN Cmd::ParseSamplingArg(eastl::vector<eastl::string>& args, int& i, ULONG& sampleEvery, ULONG& sampleRate)
+{
+	BOOLEAN isRate = Utils::AreStringsEqualI(args[i].c_str(), "-rate");
+	ULONG& value = isRate ? sampleRate : sampleEvery;
+
+	if (i == (int)args.size() - 1 || value)
+	{
+		Print("Syntax error.");
+		return FALSE;
+	}
+
+	i++;
+
+	// the rate can be followed by "/s".
+
+	eastl::string v = args[i];
+
+	if (isRate && v.size() > 2 && Utils::AreStringsEqualI(v.substr(v.size() - 2).c_str(), "/s"))
+		v = v.substr(0, v.size() - 2);
+
+	for (CHAR c : v)
+		if (!(c >= '0' && c <= '9'))
+		{
+			Print(isRate ? "Invalid sampling rate." : "Invalid sampling interval.");
+			return FALSE;
+		}
+
+	value = (ULONG)::BC_strtoui64(v.c_str(), NULL, 10);
+
+	if (!value)
+	{
+		Print(isRate ? "Sampling rate must be greater than 0." : "Sampling interval must be greater than 0.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 eastl::vector<BYTE> Cmd::ParseListOfBytesArgs(const CHAR* cmdId, const eastl::string& cmd)
 {
 	eastl::vector<BYTE> bytes;
@@ -538,7 +763,7 @@ eastl::vector<BYTE> Cmd::ParseListOfBytesArgs(const CHAR* cmdId, const eastl::st
 		return eastl::vector<BYTE>();
 	}
 
-	for (int i = 0; i < argsStr.size(); i++)
+	for (int i = 0; i < (int)argsStr.size(); i++)
 	{
 		auto& arg = argsStr[i];
 
@@ -552,7 +777,7 @@ eastl::vector<BYTE> Cmd::ParseListOfBytesArgs(const CHAR* cmdId, const eastl::st
 			BOOLEAN byte = FALSE;
 			for (CHAR c : arg)
 			{
-				if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || c >= 'a' && c <= 'f')
+				if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))
 				{
 					byte = TRUE;
 				}
@@ -652,7 +877,11 @@ BcCoroutine Cmd::ScanStackForRets(BOOLEAN& res, eastl::vector<eastl::pair<ULONG6
 
 		::memcpy(page, ptr, len);
 
-		// scan the memory page searching for return addresses.
+		// collect the values in the memory page that are inside one of the "valid" memory ranges.
+
+		const ULONG asmbSize = 32 + 32;
+
+		eastl::vector<ULONG64> candidates;
 
 		for (ULONG64 i = 0; i < len; i += (is64 ? 8 : 4))
 		{
@@ -661,47 +890,58 @@ BcCoroutine Cmd::ScanStackForRets(BOOLEAN& res, eastl::vector<eastl::pair<ULONG6
 			if (!l)
 				continue;
 
-			// is this address inside one of the "valid" memory ranges?
-
-			BOOLEAN inRange = FALSE;
-
 			for (auto& range : ranges)
 				if (l >= range.first && l < range.second)
 				{
-					inRange = TRUE;
+					candidates.push_back(i);
 					break;
 				}
+		}
 
-			if (!inRange)
-				continue;
+		// fetch the memory at all the POTENTIAL return addresses at once.
 
-			// fetch the memory at the POTENTIAL return address.
+		eastl::vector<BYTE> code(candidates.size() * asmbSize);
+		eastl::vector<BcReadMemoryRange> reads(candidates.size());
 
-			BYTE asmb[32 + 32];
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			ULONG64 l = is64 ? *(ULONG64*)(page + candidates[c]) : *(ULONG32*)(page + candidates[c]);
 
-			ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)l - sizeof(asmb) / 2, sizeof(asmb) };
-			if (!ptr)
+			reads[c] = { (ULONG_PTR)l - asmbSize / 2, asmbSize, code.data() + c * asmbSize, FALSE };
+		}
+
+		if (reads.size())
+			co_await BcAwaiter_ReadMemoryBatch{ reads.data(), reads.size() };
+
+		// scan the candidates searching for return addresses.
+
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			ULONG64 i = candidates[c];
+			ULONG64 l = is64 ? *(ULONG64*)(page + i) : *(ULONG32*)(page + i);
+
+			if (!reads[c].ok)
 				continue;
 
-			::memcpy(asmb, ptr, sizeof(asmb));
+			BYTE* asmb = code.data() + c * asmbSize;
 
 			// is the instruction BEFORE the return address a valid CALL?
 
 			BOOLEAN isCall = FALSE;
 
-			for (LONG offset = 0; offset < sizeof(asmb) / 2 - 2; offset++)
+			for (LONG offset = 0; offset <= (LONG)asmbSize / 2 - 2; offset++) // the shortest CALL ("call reg") has 2 bytes.
 			{
 				ZydisDecodedInstruction instruction;
 				ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT_VISIBLE];
 
-				if (!ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, asmb + offset, sizeof(asmb) - offset,
+				if (!ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, asmb + offset, asmbSize - offset,
 					&instruction, operands, ZYDIS_MAX_OPERAND_COUNT_VISIBLE,
 					ZYDIS_DFLAG_VISIBLE_OPERANDS_ONLY)))
 					continue;
 
 				if (!(
 					instruction.mnemonic == ZYDIS_MNEMONIC_CALL &&
-					offset + instruction.length == sizeof(asmb) / 2 &&
+					offset + instruction.length == asmbSize / 2 &&
 					instruction.operand_count_visible == 1 &&
 					(operands[0].type == ZYDIS_OPERAND_TYPE_IMMEDIATE ||
 						operands[0].type == ZYDIS_OPERAND_TYPE_REGISTER ||
@@ -737,6 +977,166 @@ BcCoroutine Cmd::ScanStackForRets(BOOLEAN& res, eastl::vector<eastl::pair<ULONG6
 	co_return;
 }
 
+BcCoroutine Cmd::WalkStack(BOOLEAN& res, eastl::vector<eastl::pair<ULONG64, ULONG64>>& addrs, BOOLEAN& is64, BYTE* context, BOOLEAN is32bitCompat, LONG depth) noexcept
+{
+	res = FALSE;
+	addrs.clear();
+	is64 = _6432_(TRUE, FALSE) && !is32bitCompat;
+
+	ULONG64 sp = ((CONTEXT*)context)->_6432_(Rsp, Esp);
+
+#ifdef _AMD64_
+
+	// unwind the frames of the kernel modules with the snapshot of their unwind info.
+
+	if (is64 && Root::I->UnwindInfo)
+	{
+		ULONG64 rip = ((CONTEXT*)context)->Rip;
+		ULONG64 rsp = ((CONTEXT*)context)->Rsp;
+		ULONG64 rbp = ((CONTEXT*)context)->Rbp;
+
+		BOOLEAN interrupted = TRUE; // the IP is not a return address: this frame was interrupted.
+
+		while (depth > 0)
+		{
+			const UnwindModule* mod = Root::I->UnwindInfo->FindModule(rip);
+			if (!mod)
+				break; // user space or a module without unwind info: continue with the scan.
+
+			const UnwindEntry* e = Root::I->UnwindInfo->FindEntry(*mod, rip);
+
+			ULONG64 slot = rsp; // leaf function: the return address is at the top of the stack.
+			ULONG64 nextRsp = 0;
+
+			if (e)
+			{
+				// an interrupted frame may be inside the prolog or the epilog.
+
+				if (interrupted)
+				{
+					if (rip - mod->base - e->begin < e->prologSize)
+						break;
+
+					ULONG len = (ULONG)_MIN_(UnwindEpilog::MaxCodeLen, 0x1000 - (rip & 0xFFF));
+
+					VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)rip, len };
+					if (!ptr)
+						break;
+
+					UnwindEpilog ep;
+
+					if (UnwindEpilog::Match(ep, (BYTE*)ptr, len, rip, mod->base + e->begin, mod->base + e->end))
+					{
+						// emulate the rest of the epilog.
+
+						ULONG64 pops = (ep.fromRbp ? rbp : rsp) + ep.rspDelta;
+
+						if (ep.rbpPop >= 0)
+						{
+							ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)(pops + ep.rbpPop * 8), sizeof(ULONG64) };
+							if (!ptr)
+								break;
+
+							rbp = *(ULONG64*)ptr;
+						}
+
+						slot = pops + ep.popsNum * 8;
+						e = NULL;
+					}
+				}
+			}
+
+			if (e)
+			{
+				// get the base of the frame and the caller's RBP.
+
+				ULONG64 base = rsp;
+
+				if (e->flags & UnwindEntry::FlagFramePointer)
+					base = rbp - e->frameOffset * 16;
+
+				if (e->rbpSave >= 0)
+				{
+					VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)(base + e->rbpSave), sizeof(ULONG64) };
+					if (!ptr)
+						break;
+
+					rbp = *(ULONG64*)ptr;
+				}
+
+				slot = base + e->frameSize;
+
+				// interrupts and exceptions: the caller's RSP is in the machine frame.
+
+				if (e->flags & UnwindEntry::FlagMachineFrame)
+				{
+					if (e->flags & UnwindEntry::FlagErrorCode)
+						slot += 8;
+
+					VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)(slot + 24), sizeof(ULONG64) };
+					if (!ptr)
+						break;
+
+					nextRsp = *(ULONG64*)ptr;
+				}
+			}
+
+			// read the return address.
+
+			VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)slot, sizeof(ULONG64) };
+			if (!ptr)
+				break;
+
+			ULONG64 ret = *(ULONG64*)ptr;
+
+			if (!nextRsp)
+				nextRsp = slot + 8;
+
+			if (slot < rsp || (nextRsp <= rsp && !(e && (e->flags & UnwindEntry::FlagMachineFrame))))
+				break; // corrupted frame: let the scan continue from here.
+
+			if (!ret)
+			{
+				res = TRUE; // end of the chain: typically the start address of a system thread.
+				co_return;
+			}
+
+			addrs.push_back(eastl::pair<ULONG64, ULONG64>(slot, ret));
+			depth--;
+
+			rip = ret;
+			rsp = nextRsp;
+
+			interrupted = e && (e->flags & UnwindEntry::FlagMachineFrame);
+		}
+
+		sp = rsp;
+	}
+
+#endif
+
+	// scan the rest of the stack searching for return addresses.
+
+	if (depth > 0)
+	{
+		BOOLEAN scanRes = FALSE;
+		eastl::vector<eastl::pair<ULONG64, ULONG64>> scanAddrs;
+
+		co_await BcAwaiter_Join{ ScanStackForRets(scanRes, scanAddrs, is64, sp, is32bitCompat, depth) };
+
+		if (!scanRes && !addrs.size())
+			co_return;
+
+		addrs.insert(addrs.end(), scanAddrs.begin(), scanAddrs.end());
+	}
+
+	// return to the caller.
+
+	res = TRUE;
+
+	co_return;
+}
+
 BcCoroutine Cmd::AddressToSymbol(eastl::string& retVal, ULONG64 l, BOOLEAN is64) noexcept
 {
 	// get the symbol name, if possible.
@@ -744,7 +1144,7 @@ BcCoroutine Cmd::AddressToSymbol(eastl::string& retVal, ULONG64 l, BOOLEAN is64)
 	CHAR posInModules[350] = { 0 };
 	ImageDebugInfo debugInfo = {};
 
-	co_await BcAwaiter_DiscoverPosInModules{ posInModules, &debugInfo, (ULONG_PTR)l };
+	co_await BcAwaiter_Join{ Platform::DiscoverBytePointerPosInModules(posInModules, &debugInfo, (ULONG_PTR)l) };
 
 	SymbolFile* symF = NULL;
 
@@ -799,7 +1199,7 @@ BcCoroutine Cmd::AddressToSymbol(eastl::string& retVal, ULONG64 l, BOOLEAN is64)
 
 		::strcat(posInModules, "0x");
 
-		::sprintf(posInModules + ::strlen(posInModules), _6432_(!is64 ? "%08X" : "%016llX", "%08X"), _6432_(!is64 ? (ULONG32)l : l, (ULONG32)l));
+		::sprintf(posInModules + ::strlen(posInModules), _6432_(!is64 ? "%08llX" : "%016llX", "%08X"), _6432_(!is64 ? (ULONG32)l : l, (ULONG32)l));
 	}
 
 	// return to the caller.
@@ -4,10 +4,13 @@
 
 #include "BcCoroutine.h"
 #include "Symbols.h"
+#include "KdTrace.h"
 
 #include "EASTL/string.h"
 #include "EASTL/vector.h"
 
+class BreakPoint;
+
 enum class CmdParamsResult
 {
 	None,
@@ -48,6 +51,10 @@ public:
 
 	virtual BcCoroutine Execute(CmdParams& params) noexcept = 0;
 
+	ULONG64 Perf_ExecutionsNum = 0;
+	ULONG64 Perf_KdRoundTripsNum = 0; // total number of StateManipulate requests sent to the kernel by this command.
+	LatencyHistogram Perf_Latency; // duration of the executions.
+
 public:
 
 	template <typename ... Args>
@@ -68,11 +75,16 @@ public:
 	static eastl::vector<eastl::string> TokenizeStr(const eastl::string& str, const eastl::string& delimiter);
 	static eastl::vector<eastl::string> TokenizeVec(const eastl::string& str, eastl::vector<eastl::string>& delimiters);
 	static BcCoroutine WriteMemory(ULONG64 dest, VOID* src, ULONG count, BOOLEAN& res) noexcept;
+	static BcCoroutine SetBreakPoint(ULONG64 address, BYTE& prevByte, ULONG& handle) noexcept; // handle is 0 on error, which is printed.
+	static BcCoroutine WriteDebugRegisters(BOOLEAN& res) noexcept; // programs DR0-DR3 on all the processors and computes DR7, from the hardware breakpoints.
+	static BcCoroutine AddHwBreakPoint(BreakPoint& bp, BOOLEAN& res) noexcept; // bp is moved in the list on success; errors are printed.
 	static BcCoroutine ResolveArg(eastl::pair<BOOLEAN, ULONG64>& res, const CHAR* arg, BYTE* context, ULONG contextLen, BOOLEAN is32bitCompat) noexcept;
 	static BcCoroutine PageIn(ULONG_PTR attachVal, ULONG_PTR pageInVal, BOOLEAN& res) noexcept;
 	static eastl::vector<ULONG> ParseListOfDecsArgs(const CHAR* cmdId, const eastl::string& cmd, ULONG size);
 	static eastl::vector<BYTE> ParseListOfBytesArgs(const CHAR* cmdId, const eastl::string& cmd);
+	static BOOLEAN ParseSamplingArg(eastl::vector<eastl::string>& args, int& i, ULONG& sampleEvery, ULONG& sampleRate); // "-every N" or "-rate X/s" at args[i]: errors are printed.
 	static BcCoroutine ScanStackForRets(BOOLEAN& res, eastl::vector<eastl::pair<ULONG64, ULONG64>>& addrs, BOOLEAN& is64, ULONG64 sp, BOOLEAN is32bitCompat, LONG depth) noexcept;
+	static BcCoroutine WalkStack(BOOLEAN& res, eastl::vector<eastl::pair<ULONG64, ULONG64>>& addrs, BOOLEAN& is64, BYTE* context, BOOLEAN is32bitCompat, LONG depth) noexcept; // unwind info of the kernel modules, then ScanStackForRets from the last frame.
 	static BcCoroutine AddressToSymbol(eastl::string& retVal, ULONG64 l, BOOLEAN is64) noexcept;
 	static BOOLEAN IsRet(ZydisMnemonic mnemonic);
 	static BcCoroutine StepOver(BYTE* context, ZydisDecodedInstruction* thisInstr) noexcept;
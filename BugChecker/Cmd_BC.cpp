@@ -2,6 +2,7 @@
 
 #include "Cmd.h"
 #include "Root.h"
+#include "QuickJSCppInterface.h"
 
 #include "EASTL/sort.h"
 
@@ -20,10 +21,12 @@ public:
 		if (!nums.size())
 			co_return;
 
-		// remove the specified breakpoints, in reverse order.
+		// remove the specified breakpoints from the system, all at once.
 
 		eastl::sort(nums.begin(), nums.end(), eastl::greater<>());
 
+		eastl::vector<BcBreakPointOp> ops;
+
 		for (auto n : nums)
 		{
 			if (n >= Root::I->BreakPoints.size()) // should never happen.
@@ -32,21 +35,38 @@ public:
 			BreakPoint& bp = *(Root::I->BreakPoints.begin() + n);
 
 			if (bp.handle)
-				co_await BcAwaiter_StateManipulate{
-				[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+				ops.push_back({ bp.address, bp.handle, TRUE, FALSE });
+		}
 
-					pState->ApiNumber = DbgKdRestoreBreakPointApi;
+		if (ops.size())
+			co_await BcAwaiter_BreakPoints{ ops.data(), ops.size() };
 
-					pState->ReturnStatus = STATUS_PENDING;
+		// remove the breakpoints from the vector, in reverse order.
 
-					pState->u.RestoreBreakPoint.BreakPointHandle = bp.handle;
-				},
-				[](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+		BOOLEAN hwBpsRemoved = FALSE;
+
+		for (auto n : nums)
+		{
+			if (n >= Root::I->BreakPoints.size()) // should never happen.
+				break;
 
-					return pState->ApiNumber == DbgKdRestoreBreakPointApi && NT_SUCCESS(pState->ReturnStatus);
-				} };
+			QuickJSCppInterface::FreeCompiled(Root::I->BreakPoints[n].whenFn);
+
+			if (Root::I->BreakPoints[n].drIndex >= 0)
+				hwBpsRemoved = TRUE;
+
+			Root::I->BreakPoints.erase(Root::I->BreakPoints.begin() + n);
+		}
+
+		// disarm the debug registers of the removed hardware breakpoints.
+
+		if (hwBpsRemoved)
+		{
+			BOOLEAN res = FALSE;
+			co_await BcAwaiter_Join{ WriteDebugRegisters(res) };
 
-			Root::I->BreakPoints.erase(&bp);
+			if (!res)
+				Print("Unable to write the debug registers.");
 		}
 
 		// return and ask to refresh the code window.
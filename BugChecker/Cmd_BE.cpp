@@ -28,6 +28,7 @@ public:
 			BreakPoint& bp = *(Root::I->BreakPoints.begin() + n);
 
 			bp.skip = FALSE;
+			bp.whenTimeoutsNum = 0;
 		}
 
 		// return and ask to refresh the code window.
@@ -9,7 +9,7 @@ class Cmd_BL : public Cmd
 public:
 
 	virtual const CHAR* GetId() { return "BL"; }
-	virtual const CHAR* GetDesc() { return "List all breakpoints."; }
+	virtual const CHAR* GetDesc() { return "List all breakpoints, with their hit counts and the cost of their conditions."; }
 	virtual const CHAR* GetSyntax() { return "BL (no parameters)"; }
 
 	virtual BcCoroutine Execute(CmdParams& params) noexcept
@@ -22,7 +22,7 @@ public:
 			co_return;
 		}
 
-		for (int i = 0; i < Root::I->BreakPoints.size(); i++)
+		for (int i = 0; i < (int)Root::I->BreakPoints.size(); i++)
 		{
 			BreakPoint& bp = Root::I->BreakPoints[i];
 			
@@ -33,6 +33,22 @@ public:
 				bp.skip ? "*" : " ");
 
 			Print((buffer + bp.cmd).c_str());
+
+			// print the statistics: the condition cost includes the logpoint and the WHEN expression.
+
+			if (!bp.hitsNum)
+				continue;
+
+			ULONG64 evaluatedNum = bp.hitsNum - bp.sampledOutNum;
+			ULONG64 condUs = Root::I->RdtscTicksPerMs ? bp.condTicks * 1000 / Root::I->RdtscTicksPerMs : 0;
+
+			CHAR stats[256];
+			::sprintf(stats, "      hits: %llu, true: %llu, sampled out: %llu, condition: %llu us (%llu us per hit), last cpu: %d",
+				bp.hitsNum, bp.trueNum, bp.sampledOutNum,
+				condUs, evaluatedNum ? condUs / evaluatedNum : 0,
+				bp.lastCpu);
+
+			Print(stats);
 		}
 
 		co_return;
@@ -0,0 +1,141 @@
+#include "BugChecker.h"
+
+#include "Cmd.h"
+#include "Root.h"
+#include "Utils.h"
+
+class Cmd_BPL : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "BPL"; }
+	virtual const CHAR* GetDesc() { return "Set a logpoint: a breakpoint that logs its arguments without breaking in and without running JavaScript."; }
+	virtual const CHAR* GetSyntax() { return "BPL address [-hw] [-every N] [-rate X/s] \"format\" [arg1, arg2, ...]"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		// split the command: the format is enclosed in double quotes and followed by the comma separated arguments.
+
+		size_t fmtStart = params.cmd.find('"');
+		size_t fmtEnd = fmtStart == eastl::string::npos ? eastl::string::npos : params.cmd.find('"', fmtStart + 1);
+
+		if (fmtEnd == eastl::string::npos)
+		{
+			Print("The format must be enclosed in double quotes.");
+			co_return;
+		}
+
+		auto args = TokenizeArgs(params.cmd.substr(0, fmtStart), "BPL", "-hw", "-every", "-rate");
+
+		if (args.size() < 2)
+		{
+			Print("Too few arguments.");
+			co_return;
+		}
+
+		BOOLEAN hw = FALSE;
+		ULONG sampleEvery = 0;
+		ULONG sampleRate = 0;
+
+		for (int i = 2; i < (int)args.size(); i++)
+		{
+			if (Utils::AreStringsEqualI(args[i].c_str(), "-hw") && !hw)
+			{
+				hw = TRUE;
+			}
+			else if (Utils::AreStringsEqualI(args[i].c_str(), "-every") || Utils::AreStringsEqualI(args[i].c_str(), "-rate"))
+			{
+				if (!ParseSamplingArg(args, i, sampleEvery, sampleRate))
+					co_return;
+			}
+			else
+			{
+				Print("Syntax error.");
+				co_return;
+			}
+		}
+
+		eastl::string format = params.cmd.substr(fmtStart + 1, fmtEnd - fmtStart - 1);
+
+		auto fmtArgs = TokenizeStr(params.cmd.substr(fmtEnd + 1), ",");
+
+		// resolve the address.
+
+		eastl::pair<BOOLEAN, ULONG64> res;
+		co_await BcAwaiter_Join{ ResolveArg(res, args[1].c_str(), params.context, params.contextLen, params.is32bitCompat) };
+
+		if (!res.first)
+			co_return;
+
+		ULONG64 address = res.second;
+
+		// is bp already set at this address?
+
+		if (Root::I->BreakPoints.Find(address))
+		{
+			Print("Breakpoint already set at this address.");
+			co_return;
+		}
+
+		// compile the format and the arguments: they are executed natively at each hit.
+
+		Logpoint log;
+		eastl::string error;
+
+		if (!log.Compile(format.c_str(), fmtArgs, params.context, error))
+		{
+			Print(error.c_str());
+			co_return;
+		}
+
+		// set the breakpoint: a hardware breakpoint is written in a debug register after being added to the vector.
+
+		BYTE prev = 0;
+		ULONG BreakPointHandle = 0;
+
+		if (!hw)
+		{
+			co_await BcAwaiter_Join{ SetBreakPoint(address, prev, BreakPointHandle) };
+
+			if (!BreakPointHandle)
+				co_return;
+		}
+
+		// add the new breakpoint to the vector.
+
+		BreakPoint bp;
+
+		bp.address = address;
+		bp.handle = BreakPointHandle;
+		bp.prevByte = prev;
+		bp.log = eastl::move(log);
+		bp.sampleEvery = sampleEvery;
+		bp.sampleRate = sampleRate;
+
+		bp.cmd =
+			"BPL 0x" +
+			Utils::HexToString(address, address >> 32 ? sizeof(ULONG64) : sizeof(ULONG32)) +
+			" (" + params.cmd + ")";
+
+		if (!hw)
+		{
+			Root::I->BreakPoints.push_back(eastl::move(bp));
+		}
+		else
+		{
+			BOOLEAN res = FALSE;
+			co_await BcAwaiter_Join{ AddHwBreakPoint(bp, res) };
+
+			if (!res)
+				co_return;
+		}
+
+		// return to the caller.
+
+		params.result = CmdParamsResult::RefreshCodeAndRegsWindows;
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_BPL)
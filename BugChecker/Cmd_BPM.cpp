@@ -0,0 +1,189 @@
+#include "BugChecker.h"
+
+#include "Cmd.h"
+#include "Root.h"
+#include "Utils.h"
+#include "QuickJSCppInterface.h"
+
+class Cmd_BPM : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "BPM"; }
+	virtual const CHAR* GetDesc() { return "Set a hardware breakpoint on memory access (DR0-DR3)."; }
+	virtual const CHAR* GetSyntax() { return "BPM address [-w|-rw|-x] [-l 1|2|4|8] [-every N] [-rate X/s] [WHEN js-expression]"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		// parse the arguments.
+
+		ULONG64 address = 0;
+		BOOLEAN addressSet = FALSE;
+		LONG rw = -1;
+		ULONG len = 0;
+		eastl::string when = "";
+		ULONG sampleEvery = 0;
+		ULONG sampleRate = 0;
+
+		auto args = TokenizeArgs(params.cmd, "BPM", "-w", "-rw", "-x", "-l", "-every", "-rate", "WHEN");
+
+		if (args.size() < 2)
+		{
+			Print("Too few arguments.");
+			co_return;
+		}
+
+		for (int i = 1; i < (int)args.size(); i++)
+		{
+			if (Utils::AreStringsEqualI(args[i].c_str(), "-w") ||
+				Utils::AreStringsEqualI(args[i].c_str(), "-rw") ||
+				Utils::AreStringsEqualI(args[i].c_str(), "-x"))
+			{
+				if (rw >= 0)
+				{
+					Print("Syntax error.");
+					co_return;
+				}
+
+				rw =
+					Utils::AreStringsEqualI(args[i].c_str(), "-w") ? BreakPoint::DrRwWrite :
+					Utils::AreStringsEqualI(args[i].c_str(), "-rw") ? BreakPoint::DrRwReadWrite :
+					BreakPoint::DrRwExecute;
+			}
+			else if (Utils::AreStringsEqualI(args[i].c_str(), "-l"))
+			{
+				if (i == (int)args.size() - 1 || len)
+				{
+					Print("Syntax error.");
+					co_return;
+				}
+
+				i++;
+
+				len = args[i].size() == 1 ? args[i][0] - '0' : 0;
+
+				if ((len != 1 && len != 2 && len != 4 && len != 8) || _6432_(FALSE, len == 8)) // 8 bytes only in 64-bit mode.
+				{
+					Print("Invalid length.");
+					co_return;
+				}
+			}
+			else if (Utils::AreStringsEqualI(args[i].c_str(), "-every") || Utils::AreStringsEqualI(args[i].c_str(), "-rate"))
+			{
+				if (!ParseSamplingArg(args, i, sampleEvery, sampleRate))
+					co_return;
+			}
+			else if (Utils::AreStringsEqualI(args[i].c_str(), "WHEN"))
+			{
+				if (i == (int)args.size() - 1)
+				{
+					Print("Syntax error.");
+					co_return;
+				}
+			}
+			else if (Utils::AreStringsEqualI(args[i - 1].c_str(), "WHEN"))
+			{
+				when = args[i];
+			}
+			else
+			{
+				if (addressSet)
+				{
+					Print("Syntax error.");
+					co_return;
+				}
+
+				eastl::pair<BOOLEAN, ULONG64> res;
+				co_await BcAwaiter_Join{ ResolveArg(res, args[i].c_str(), params.context, params.contextLen, params.is32bitCompat) };
+
+				if (!res.first)
+					co_return;
+
+				address = res.second;
+				addressSet = TRUE;
+			}
+		}
+
+		if (!addressSet)
+		{
+			Print("Too few arguments.");
+			co_return;
+		}
+
+		if (rw < 0)
+			rw = BreakPoint::DrRwReadWrite;
+
+		if (!len)
+			len = 1;
+
+		// the processor requires an aligned address and a length of 1 for the execution breakpoints.
+
+		if (rw == BreakPoint::DrRwExecute && len != 1)
+		{
+			Print("The length of an execution breakpoint must be 1.");
+			co_return;
+		}
+		else if (address & (len - 1))
+		{
+			Print("The address must be aligned to the length.");
+			co_return;
+		}
+
+		// is bp already set at this address?
+
+		if (Root::I->BreakPoints.Find(address))
+		{
+			Print("Breakpoint already set at this address.");
+			co_return;
+		}
+
+		// compile the condition.
+
+		LONG whenFn = -1;
+
+		if (when.size())
+		{
+			whenFn = QuickJSCppInterface::Compile(when.c_str());
+
+			if (whenFn < 0)
+			{
+				Print("Unable to compile the WHEN expression.");
+				co_return;
+			}
+		}
+
+		// add the new breakpoint to the vector and write the debug registers.
+
+		BreakPoint bp;
+
+		bp.address = address;
+		bp.when = when;
+		bp.whenFn = whenFn;
+		bp.sampleEvery = sampleEvery;
+		bp.sampleRate = sampleRate;
+		bp.drRw = (BYTE)rw;
+		bp.drLen = len == 1 ? 0 : len == 2 ? 1 : len == 4 ? 3 : 2; // LEN field in DR7.
+
+		bp.cmd =
+			"BPM 0x" +
+			Utils::HexToString(address, address >> 32 ? sizeof(ULONG64) : sizeof(ULONG32)) +
+			" (" + params.cmd + ")";
+
+		BOOLEAN res = FALSE;
+		co_await BcAwaiter_Join{ AddHwBreakPoint(bp, res) };
+
+		if (!res)
+		{
+			QuickJSCppInterface::FreeCompiled(whenFn);
+			co_return;
+		}
+
+		// return to the caller.
+
+		params.result = CmdParamsResult::RefreshCodeAndRegsWindows;
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_BPM)
@@ -3,6 +3,8 @@
 #include "Cmd.h"
 #include "Root.h"
 #include "Utils.h"
+#include "CrtFill.h"
+#include "QuickJSCppInterface.h"
 
 class Cmd_BPX : public Cmd
 {
@@ -10,7 +12,7 @@ public:
 
 	virtual const CHAR* GetId() { return "BPX"; }
 	virtual const CHAR* GetDesc() { return "Set a breakpoint on execution."; }
-	virtual const CHAR* GetSyntax() { return "BPX address [-t|-p|-kt thread|-kp process] [WHEN js-expression]"; }
+	virtual const CHAR* GetSyntax() { return "BPX address [-hw] [-t|-p|-kt thread|-kp process] [-every N] [-rate X/s] [-budget ms] [WHEN js-expression]"; }
 
 	virtual BcCoroutine Execute(CmdParams& params) noexcept
 	{
@@ -20,8 +22,12 @@ public:
 		ULONG64 eprocess = 0;
 		ULONG64 ethread = 0;
 		eastl::string when = "";
+		ULONG whenBudgetMs = 0;
+		BOOLEAN hw = FALSE;
+		ULONG sampleEvery = 0;
+		ULONG sampleRate = 0;
 
-		auto args = TokenizeArgs(params.cmd, "BPX", "-t", "-p", "WHEN", "-kt", "-kp");
+		auto args = TokenizeArgs(params.cmd, "BPX", "-t", "-p", "WHEN", "-kt", "-kp", "-budget", "-hw", "-every", "-rate");
 
 		if (args.size() < 2)
 		{
@@ -32,7 +38,7 @@ public:
 		{
 			int whenCount = 0;
 
-			for (int i = 1; i < args.size(); i++)
+			for (int i = 1; i < (int)args.size(); i++)
 			{
 				if (Utils::AreStringsEqualI(args[i].c_str(), "-t"))
 				{
@@ -63,7 +69,7 @@ public:
 				{
 					ULONG64& value = Utils::AreStringsEqualI(args[i].c_str(), "-kt") ? ethread : eprocess;
 
-					if (i == args.size() - 1 || value)
+					if (i == (int)args.size() - 1 || value)
 					{
 						Print("Syntax error.");
 						co_return;
@@ -79,9 +85,49 @@ public:
 					else
 						value = res.second;
 				}
+				else if (Utils::AreStringsEqualI(args[i].c_str(), "-hw"))
+				{
+					if (hw)
+					{
+						Print("Syntax error.");
+						co_return;
+					}
+
+					hw = TRUE;
+				}
+				else if (Utils::AreStringsEqualI(args[i].c_str(), "-every") || Utils::AreStringsEqualI(args[i].c_str(), "-rate"))
+				{
+					if (!ParseSamplingArg(args, i, sampleEvery, sampleRate))
+						co_return;
+				}
+				else if (Utils::AreStringsEqualI(args[i].c_str(), "-budget"))
+				{
+					if (i == (int)args.size() - 1 || whenBudgetMs)
+					{
+						Print("Syntax error.");
+						co_return;
+					}
+
+					i++;
+
+					for (CHAR c : args[i])
+						if (!(c >= '0' && c <= '9'))
+						{
+							Print("Invalid budget.");
+							co_return;
+						}
+
+					whenBudgetMs = (ULONG)::BC_strtoui64(args[i].c_str(), NULL, 10);
+
+					if (!whenBudgetMs)
+					{
+						Print("Budget must be greater than 0.");
+						co_return;
+					}
+				}
 				else if (Utils::AreStringsEqualI(args[i].c_str(), "WHEN"))
 				{
-					if (++whenCount > 1 || i == args.size() - 1)
+					if (++whenCount > 1 || i == (int)args.size() - 1)
 					{
 						Print("Syntax error.");
 						co_return;
@@ -111,59 +157,50 @@ public:
 				Print("-t/-kt and -p/-kp cannot be specified at the same time.");
 				co_return;
 			}
-		}
-
-		// is bp already set at this address?
-
-		for (BreakPoint& bp : Root::I->BreakPoints)
-			if (bp.address == address)
+			else if (whenBudgetMs && !when.size())
 			{
-				Print("Breakpoint already set at this address.");
+				Print("-budget requires a WHEN expression.");
 				co_return;
 			}
+		}
 
-		// read the byte to overwrite with the breakpoint instruction.
+		// is bp already set at this address?
 
-		VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)address, sizeof(BYTE) };
-		if (!ptr)
+		if (Root::I->BreakPoints.Find(address))
 		{
-			Print("Unable to read memory.");
+			Print("Breakpoint already set at this address.");
 			co_return;
 		}
 
-		BYTE prev = *(BYTE*)ptr;
+		// compile the condition: it is evaluated at each hit, so it is parsed only once here.
 
-		// set the breakpoint.
+		LONG whenFn = -1;
 
-		ULONG BreakPointHandle = 0;
+		if (when.size())
+		{
+			whenFn = QuickJSCppInterface::Compile(when.c_str());
 
-		if (!co_await BcAwaiter_StateManipulate{
-		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+			if (whenFn < 0)
+			{
+				Print("Unable to compile the WHEN expression.");
+				co_return;
+			}
+		}
 
-			pState->ApiNumber = DbgKdWriteBreakPointApi;
+		// set the breakpoint: a software breakpoint is written in memory, while a hardware breakpoint is written in a debug register after being added to the vector.
 
-			pState->ReturnStatus = STATUS_PENDING;
+		BYTE prev = 0;
+		ULONG BreakPointHandle = 0;
 
-			pState->u.WriteBreakPoint.BreakPointHandle = 0;
-			pState->u.WriteBreakPoint.BreakPointAddress = address;
-		},
-		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+		if (!hw)
+		{
+			co_await BcAwaiter_Join{ SetBreakPoint(address, prev, BreakPointHandle) };
 
-			if (pState->ApiNumber == DbgKdWriteBreakPointApi)
+			if (!BreakPointHandle)
 			{
-				if (NT_SUCCESS(pState->ReturnStatus) &&
-					pState->u.WriteBreakPoint.BreakPointHandle)
-				{
-					BreakPointHandle = pState->u.WriteBreakPoint.BreakPointHandle;
-					return TRUE;
-				}
+				QuickJSCppInterface::FreeCompiled(whenFn);
+				co_return;
 			}
-
-			return FALSE;
-		} })
-		{
-			Print("Error setting breakpoint.");
-			co_return;
 		}
 
 		// add the new breakpoint to the vector.
@@ -176,13 +213,31 @@ public:
 		bp.eprocess = eprocess;
 		bp.ethread = ethread;
 		bp.when = when;
+		bp.whenFn = whenFn;
+		bp.whenBudgetMs = whenBudgetMs;
+		bp.sampleEvery = sampleEvery;
+		bp.sampleRate = sampleRate;
 
 		bp.cmd =
 			"BPX 0x" +
 			Utils::HexToString(address, address >> 32 ? sizeof(ULONG64) : sizeof(ULONG32)) +
 			" (" + params.cmd + ")";
 
-		Root::I->BreakPoints.push_back(eastl::move(bp));
+		if (!hw)
+		{
+			Root::I->BreakPoints.push_back(eastl::move(bp));
+		}
+		else
+		{
+			BOOLEAN res = FALSE;
+			co_await BcAwaiter_Join{ AddHwBreakPoint(bp, res) };
+
+			if (!res)
+			{
+				QuickJSCppInterface::FreeCompiled(whenFn);
+				co_return;
+			}
+		}
 
 		// return to the caller.
 
@@ -24,7 +24,7 @@ static BcCoroutine D(const CHAR* cmdId, CmdParams& params) noexcept
 
 	BOOLEAN addressSet = FALSE;
 
-	for (int i = 1; i < args.size(); i++)
+	for (int i = 1; i < (int)args.size(); i++)
 	{
 		if (!Utils::AreStringsEqualI(args[i].c_str(), "-l"))
 		{
@@ -78,7 +78,7 @@ static BcCoroutine D(const CHAR* cmdId, CmdParams& params) noexcept
 
 	// print the memory contents.
 
-	for (int i = 0; i < length / 16; i++, address += 16)
+	for (int i = 0; i < (int)(length / 16); i++, address += 16)
 	{
 		BYTE* pb = (BYTE*)ptr;
 
@@ -0,0 +1,59 @@
+#include "BugChecker.h"
+
+#include "Cmd.h"
+#include "Root.h"
+#include "Utils.h"
+
+class Cmd_DBGPRINT : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "DBGPRINT"; }
+	virtual const CHAR* GetDesc() { return "Display DbgPrint statistics or mute/unmute the messages starting with a prefix."; }
+	virtual const CHAR* GetSyntax() { return "DBGPRINT [-mute prefix|-unmute prefix|-unmuteall]"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		auto args = TokenizeArgs(params.cmd, "DBGPRINT", "-mute", "-unmute", "-unmuteall");
+
+		DbgPrintRing& ring = Root::I->DbgPrints;
+
+		if (args.size() == 1)
+		{
+			// print the statistics and the muted prefixes.
+
+			CHAR text[256];
+
+			::sprintf(text, "Messages: %d, dropped (buffer full): %d, muted: %d.",
+				(LONG)ring.Perf_MsgsNum, (LONG)ring.Perf_DroppedNum, (LONG)ring.Perf_FilteredNum);
+
+			Print(text);
+
+			for (ULONG i = 0; i < DbgPrintRing::FiltersNum; i++)
+				if (ring.GetFilter(i)[0])
+					Print((eastl::string("Muted: \"") + ring.GetFilter(i) + "\"").c_str());
+		}
+		else if (args.size() == 2 && Utils::AreStringsEqualI(args[1].c_str(), "-unmuteall"))
+		{
+			ring.UnmuteAll();
+		}
+		else if (args.size() == 3 && Utils::AreStringsEqualI(args[1].c_str(), "-mute"))
+		{
+			if (!ring.Mute(args[2].c_str()))
+				Print("Unable to mute: prefix too long or too many prefixes.");
+		}
+		else if (args.size() == 3 && Utils::AreStringsEqualI(args[1].c_str(), "-unmute"))
+		{
+			if (!ring.Unmute(args[2].c_str()))
+				Print("Prefix not found.");
+		}
+		else
+		{
+			Print("Syntax error.");
+		}
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_DBGPRINT)
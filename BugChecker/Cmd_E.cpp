@@ -55,7 +55,7 @@ static BcCoroutine E(const CHAR* cmdId, CmdParams& params) noexcept
 
 	eastl::vector<T> data;
 
-	for (int i = 0; i < dataList.size(); i++)
+	for (int i = 0; i < (int)dataList.size(); i++)
 	{
 		ULONG64 value64 = 0;
 
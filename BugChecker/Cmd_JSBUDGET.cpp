@@ -0,0 +1,59 @@
+#include "BugChecker.h"
+
+#include "Cmd.h"
+#include "Root.h"
+#include "Utils.h"
+#include "CrtFill.h"
+
+class Cmd_JSBUDGET : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "JSBUDGET"; }
+	virtual const CHAR* GetDesc() { return "Display or set the time budget of the JavaScript evaluations."; }
+	virtual const CHAR* GetSyntax() { return "JSBUDGET [ms]"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		// parse the argument.
+
+		auto args = TokenizeArgs(params.cmd, "JSBUDGET");
+
+		if (args.size() == 1)
+		{
+			if (!Root::I->JsBudgetMs)
+				Print("Current time budget of the JavaScript evaluations: no limit.");
+			else
+				Print(("Current time budget of the JavaScript evaluations: " + Utils::I64ToString(Root::I->JsBudgetMs) + " ms.").c_str());
+
+			if (!Root::I->RdtscTicksPerMs)
+				Print("The time stamp counter is not calibrated: the budget is not enforced.");
+
+			co_return;
+		}
+		else if (args.size() != 2)
+		{
+			Print("Too many arguments.");
+			co_return;
+		}
+
+		eastl::string v = args[1];
+
+		v.trim();
+
+		for (CHAR c : v)
+			if (!(c >= '0' && c <= '9'))
+			{
+				Print("Invalid argument.");
+				co_return;
+			}
+
+		// set the new value: 0 means no limit. The WHEN expressions with their own budget are not affected.
+
+		Root::I->JsBudgetMs = (ULONG)::BC_strtoui64(v.c_str(), NULL, 10);
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_JSBUDGET)
@@ -22,7 +22,7 @@ public:
 		BOOLEAN user = FALSE;
 		BOOLEAN system = FALSE;
 
-		for (int i = 1; i < args.size(); i++)
+		for (int i = 1; i < (int)args.size(); i++)
 		{
 			if (Utils::AreStringsEqualI(args[i].c_str(), "-u"))
 				user = TRUE;
@@ -0,0 +1,228 @@
+#include "BugChecker.h"
+
+#include "Cmd.h"
+#include "Root.h"
+#include "Utils.h"
+
+#include <EASTL/sort.h>
+
+class Cmd_PERF : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "PERF"; }
+	virtual const CHAR* GetDesc() { return "Display or reset the KD round-trip, latency and allocation statistics, or dump the KD packet trace."; }
+	virtual const CHAR* GetSyntax() { return "PERF [-reset|-dump]"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		auto args = TokenizeArgs(params.cmd, "PERF", "-reset", "-dump");
+
+		if (args.size() > 2)
+		{
+			Print("Too many arguments.");
+			co_return;
+		}
+		else if (args.size() == 2 && Utils::AreStringsEqualI(args[1].c_str(), "-dump"))
+		{
+			// print the raw events of the KD packet trace, from the oldest.
+
+			CHAR line[128];
+
+			Print("tsc,delta,direction,packet type,api,bytes,awaiter");
+
+			ULONG64 prevTsc = 0;
+
+			for (ULONG i = 0; i < Root::I->KdEvents.Size(); i++)
+			{
+				auto& e = Root::I->KdEvents.Get(i);
+
+				KdTrace::Format(line, e, prevTsc);
+				Print(line);
+
+				prevTsc = e.tsc;
+			}
+
+			co_return;
+		}
+		else if (args.size() == 2)
+		{
+			if (!Utils::AreStringsEqualI(args[1].c_str(), "-reset"))
+			{
+				Print("Syntax error.");
+				co_return;
+			}
+
+			// reset all the counters.
+
+			Root::I->Perf_BreakInsNum = 0;
+			Root::I->Perf_KdRoundTripsNum = 0;
+
+			Root::I->ReadCache.Perf_HitsNum = 0;
+			Root::I->ReadCache.Perf_MissesNum = 0;
+
+			Root::I->DecodedInstrs.Perf_HitsNum = 0;
+			Root::I->DecodedInstrs.Perf_MissesNum = 0;
+
+			Root::I->Perf_BpOpsNum = 0;
+			Root::I->Perf_BpOpsBatchesNum = 0;
+			Root::I->Perf_BpOpsTime = 0;
+
+			Root::I->Perf_BpHitsNum = 0;
+			Root::I->Perf_BpRearmStepsNum = 0;
+			Root::I->Perf_HwBpHitsNum = 0;
+			Root::I->Perf_BpFilteredNum = 0;
+			Root::I->Perf_BpFilterRoundTripsNum = 0;
+
+			Allocator::Perf_AllocCallsNum = 0;
+			BcFramePool::Perf_PoolAllocsNum = 0;
+			BcFramePool::Perf_HeapAllocsNum = 0;
+
+			for (ULONG64& n : Root::I->Perf_KdRoundTripsByApi)
+				n = 0;
+
+			for (auto& c : Root::I->Cmds)
+			{
+				c->Perf_ExecutionsNum = 0;
+				c->Perf_KdRoundTripsNum = 0;
+				c->Perf_Latency.Clear();
+			}
+
+			Root::I->KdEvents.Clear();
+
+			Root::I->Perf_JsLatency.Clear();
+
+			co_return;
+		}
+
+		// print the round-trips by api.
+
+		CHAR text[512];
+
+		::sprintf(text, "Break-ins: %llu, KD round-trips: %llu.", Root::I->Perf_BreakInsNum, Root::I->Perf_KdRoundTripsNum);
+		Print(text);
+
+		for (ULONG i = 0; i < sizeof(Root::I->Perf_KdRoundTripsByApi) / sizeof(ULONG64); i++)
+		{
+			if (!Root::I->Perf_KdRoundTripsByApi[i])
+				continue;
+
+			::sprintf(text, "  %-24s %llu", GetApiName(DbgKdMinimumManipulate + i), Root::I->Perf_KdRoundTripsByApi[i]);
+			Print(text);
+		}
+
+		// print the read cache statistics: each hit is a saved round-trip.
+
+		::sprintf(text, "Read cache: %llu hits (saved round-trips), %llu misses.", Root::I->ReadCache.Perf_HitsNum, Root::I->ReadCache.Perf_MissesNum);
+		Print(text);
+
+		::sprintf(text, "Decode cache: %llu hits (saved decodings), %llu misses.", Root::I->DecodedInstrs.Perf_HitsNum, Root::I->DecodedInstrs.Perf_MissesNum);
+		Print(text);
+
+		// print the bulk breakpoint operations.
+
+		::sprintf(text, "Breakpoint writes/restores: %llu in %llu batches, %llu us per operation.",
+			Root::I->Perf_BpOpsNum, Root::I->Perf_BpOpsBatchesNum,
+			Root::I->Perf_BpOpsNum && Root::I->RdtscTicksPerMs ? Root::I->Perf_BpOpsTime * 1000 / Root::I->RdtscTicksPerMs / Root::I->Perf_BpOpsNum : 0);
+		Print(text);
+
+		// print the debugger entries per hit: a software breakpoint requires a single step to be recreated, while a hardware breakpoint stays armed.
+
+		ULONG64 entriesPerHit100 = Root::I->Perf_BpHitsNum ? (Root::I->Perf_BpHitsNum + Root::I->Perf_BpRearmStepsNum) * 100 / Root::I->Perf_BpHitsNum : 0;
+
+		::sprintf(text, "Breakpoint hits: %llu software (%llu re-arm steps, %llu.%02llu entries per hit), %llu hardware (1 entry per hit).",
+			Root::I->Perf_BpHitsNum, Root::I->Perf_BpRearmStepsNum, entriesPerHit100 / 100, entriesPerHit100 % 100,
+			Root::I->Perf_HwBpHitsNum);
+		Print(text);
+
+		// print the cost of the thread/process filters: the process of the current thread is read once per state change.
+
+		::sprintf(text, "Thread/process filters: %llu hits discarded, %llu KD round-trips.",
+			Root::I->Perf_BpFilteredNum, Root::I->Perf_BpFilterRoundTripsNum);
+		Print(text);
+
+		// print the allocations in the debugger context and where the coroutine frames were allocated.
+
+		::sprintf(text, "Allocations: %llu (%llu per break-in), coroutine frames: %llu from the frame pool, %llu from the heap.",
+			Allocator::Perf_AllocCallsNum, Root::I->Perf_BreakInsNum ? Allocator::Perf_AllocCallsNum / Root::I->Perf_BreakInsNum : 0,
+			BcFramePool::Perf_PoolAllocsNum, BcFramePool::Perf_HeapAllocsNum);
+		Print(text);
+
+		// print the latency of the KD round-trips.
+
+		CHAR histogram[192];
+
+		Root::I->KdEvents.RoundTrips.Format(histogram, sizeof(histogram));
+
+		::sprintf(text, "KD round-trip latency: %llu us avg, %llu us max. %s",
+			Root::I->KdEvents.RoundTrips.num ? TicksToUs(Root::I->KdEvents.RoundTrips.totalTicks) / Root::I->KdEvents.RoundTrips.num : 0,
+			TicksToUs(Root::I->KdEvents.RoundTrips.maxTicks), histogram);
+		Print(text);
+
+		// print the time spent in QuickJS by the evaluations (scripts, expressions and WHEN conditions).
+
+		Root::I->Perf_JsLatency.Format(histogram, sizeof(histogram));
+
+		::sprintf(text, "JS evaluations: %llu, %llu us avg, %llu us max. %s",
+			Root::I->Perf_JsLatency.num,
+			Root::I->Perf_JsLatency.num ? TicksToUs(Root::I->Perf_JsLatency.totalTicks) / Root::I->Perf_JsLatency.num : 0,
+			TicksToUs(Root::I->Perf_JsLatency.maxTicks), histogram);
+		Print(text);
+
+		// print the round-trips and the latency by command, the most expensive first.
+
+		eastl::vector<Cmd*> cmds;
+
+		for (auto& c : Root::I->Cmds)
+			if (c->Perf_ExecutionsNum)
+				cmds.push_back(c.get());
+
+		eastl::sort(cmds.begin(), cmds.end(), [](Cmd* a, Cmd* b) { return a->Perf_Latency.totalTicks > b->Perf_Latency.totalTicks; });
+
+		for (Cmd* c : cmds)
+		{
+			::sprintf(text, "  %-24s %llu executions, %llu round-trips (%llu per execution), %llu us total, %llu us avg, %llu us max", c->GetId(),
+				c->Perf_ExecutionsNum, c->Perf_KdRoundTripsNum, c->Perf_KdRoundTripsNum / c->Perf_ExecutionsNum,
+				TicksToUs(c->Perf_Latency.totalTicks), TicksToUs(c->Perf_Latency.totalTicks) / c->Perf_ExecutionsNum, TicksToUs(c->Perf_Latency.maxTicks));
+			Print(text);
+
+			c->Perf_Latency.Format(histogram, sizeof(histogram));
+
+			::sprintf(text, "    %s", histogram);
+			Print(text);
+		}
+
+		co_return;
+	}
+
+private:
+
+	static ULONG64 TicksToUs(ULONG64 ticks)
+	{
+		return Root::I->RdtscTicksPerMs ? ticks * 1000 / Root::I->RdtscTicksPerMs : 0;
+	}
+
+	static const CHAR* GetApiName(ULONG api)
+	{
+		switch (api)
+		{
+		case DbgKdReadVirtualMemoryApi: return "ReadVirtualMemory";
+		case DbgKdWriteVirtualMemoryApi: return "WriteVirtualMemory";
+		case DbgKdGetContextApi: return "GetContext";
+		case DbgKdSetContextApi: return "SetContext";
+		case DbgKdWriteBreakPointApi: return "WriteBreakPoint";
+		case DbgKdRestoreBreakPointApi: return "RestoreBreakPoint";
+		case DbgKdReadControlSpaceApi: return "ReadControlSpace";
+		case DbgKdWriteControlSpaceApi: return "WriteControlSpace";
+		case DbgKdGetVersionApi: return "GetVersion";
+		case DbgKdPageInApi: return "PageIn";
+		}
+
+		static CHAR name[32];
+		::sprintf(name, "Api %X", api);
+
+		return name;
+	}
+};
+
+REGISTER_COMMAND(Cmd_PERF)
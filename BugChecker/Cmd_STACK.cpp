@@ -2,23 +2,31 @@
 
 #include "Cmd.h"
 #include "Root.h"
+#include "Utils.h"
 
 class Cmd_STACK : public Cmd
 {
 public:
 
 	virtual const CHAR* GetId() { return "STACK"; }
-	virtual const CHAR* GetDesc() { return "Scan the stack searching for return addresses."; }
-	virtual const CHAR* GetSyntax() { return "STACK [stack-ptr]"; }
+	virtual const CHAR* GetDesc() { return "Walk the stack with the unwind info of the kernel modules or scan it searching for return addresses."; }
+	virtual const CHAR* GetSyntax() { return "STACK [-scan] [stack-ptr]"; }
 
-	virtual BcCoroutine Execute(CmdParams& params) noexcept // >>>> N.B. <<<< we need to scan the stack because the RUNTIME_FUNCTION tables are typically paged out!
+	virtual BcCoroutine Execute(CmdParams& params) noexcept // >>>> N.B. <<<< the RUNTIME_FUNCTION tables are typically paged out: we use the snapshot taken when the kernel modules were loaded.
 	{
 		// parse the arguments.
 
 		ULONG64 sp = 0;
 		BOOLEAN is32bc = FALSE;
+		BOOLEAN scan = FALSE;
 
-		auto args = TokenizeArgs(params.cmd, "STACK");
+		auto args = TokenizeArgs(params.cmd, "STACK", "-scan");
+
+		if (args.size() >= 2 && Utils::AreStringsEqualI(args[1].c_str(), "-scan"))
+		{
+			scan = TRUE;
+			args.erase(args.begin() + 1);
+		}
 
 		if (args.size() > 2)
 		{
@@ -32,6 +40,8 @@ public:
 		}
 		else
 		{
+			scan = TRUE; // no registers for this stack.
+
 			eastl::pair<BOOLEAN, ULONG64> res;
 			co_await BcAwaiter_Join{ ResolveArg(res, args[1].c_str(), params.context, params.contextLen, params.is32bitCompat) };
 
@@ -44,13 +54,16 @@ public:
 			}
 		}
 
-		// scan the stack searching for return addresses.
+		// walk the stack or scan it searching for return addresses.
 
 		BOOLEAN res = FALSE;
 		eastl::vector<eastl::pair<ULONG64, ULONG64>> addrs;
 		BOOLEAN is64 = FALSE;
 
-		co_await BcAwaiter_Join{ ScanStackForRets(res, addrs, is64, sp, is32bc, 999999) };
+		if (scan)
+			co_await BcAwaiter_Join{ ScanStackForRets(res, addrs, is64, sp, is32bc, 999999) };
+		else
+			co_await BcAwaiter_Join{ WalkStack(res, addrs, is64, params.context, is32bc, 999999) };
 
 		if (!res)
 			co_return;
@@ -80,7 +93,7 @@ public:
 			::sprintf(header, "%03d) ", lineNum++);
 
 			ULONG64 a = addr.first;
-			::sprintf(header + ::strlen(header), _6432_(!is64 ? "%08X" : "%016llX", "%08X"), _6432_(!is64 ? (ULONG32)a : a, (ULONG32)a));
+			::sprintf(header + ::strlen(header), _6432_(!is64 ? "%08llX" : "%016llX", "%08X"), _6432_(!is64 ? (ULONG32)a : a, (ULONG32)a));
 
 			::strcat(header, " ");
 
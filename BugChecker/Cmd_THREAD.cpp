@@ -21,13 +21,13 @@ public:
 
 		auto args = TokenizeArgs(params.cmd, "THREAD", "-kt", "-kp");
 
-		for (int i = 1; i < args.size(); i++)
+		for (int i = 1; i < (int)args.size(); i++)
 		{
 			if (Utils::AreStringsEqualI(args[i].c_str(), "-kt") || Utils::AreStringsEqualI(args[i].c_str(), "-kp"))
 			{
 				ULONG64& value = Utils::AreStringsEqualI(args[i].c_str(), "-kt") ? ethread : eprocess;
 
-				if (i == args.size() - 1 || value)
+				if (i == (int)args.size() - 1 || value)
 				{
 					Print("Syntax error.");
 					co_return;
@@ -101,7 +101,7 @@ public:
 
 		size_t structSz = 0;
 		for (LONG* ptrLong : offsets)
-			if (*ptrLong > structSz)
+			if ((size_t)*ptrLong > structSz)
 				structSz = *ptrLong;
 
 		structSz += 16;
@@ -195,12 +195,14 @@ public:
 		{
 			printLineP("TID", "KTHREAD", "KSTACK", "STATE", "TEB");
 
-			// iterate through the threads.
+			// iterate through the threads, collecting their addresses.
 
 			ULONG64 head = eprocess + offsetTlh;
 
 			ULONG64 Flink = head;
 
+			eastl::vector<ULONG64> threads;
+
 			for (int i = 0; i < 1024; i++)
 			{
 				// read the pointer to the next entry.
@@ -219,16 +221,23 @@ public:
 				if (!Flink || Flink == head)
 					break;
 
-				// read the thread structure.
+				threads.push_back(Flink - offsetTle);
+			}
 
-				ULONG64 thread = Flink - offsetTle;
+			// read all the thread structures at once.
 
-				ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)thread, structSz };
-				if (!ptr)
-					continue;
+			eastl::vector<BYTE> data(threads.size() * structSz);
+			eastl::vector<BcReadMemoryRange> reads(threads.size());
 
-				dumpThreadInfo((ULONG_PTR)ptr, (ULONG_PTR)thread);
-			}
+			for (size_t i = 0; i < threads.size(); i++)
+				reads[i] = { (ULONG_PTR)threads[i], (ULONG)structSz, data.data() + i * structSz, FALSE };
+
+			if (reads.size())
+				co_await BcAwaiter_ReadMemoryBatch{ reads.data(), reads.size() };
+
+			for (size_t i = 0; i < threads.size(); i++)
+				if (reads[i].ok)
+					dumpThreadInfo((ULONG_PTR)reads[i].dest, (ULONG_PTR)threads[i]);
 		}
 		else if (ethread)
 		{
@@ -284,7 +293,7 @@ public:
 				::sprintf(header, "%03d) ", lineNum++);
 
 				ULONG64 a = addr.first;
-				::sprintf(header + ::strlen(header), _6432_(!is64 ? "%08X" : "%016llX", "%08X"), _6432_(!is64 ? (ULONG32)a : a, (ULONG32)a));
+				::sprintf(header + ::strlen(header), _6432_(!is64 ? "%08llX" : "%016llX", "%08X"), _6432_(!is64 ? (ULONG32)a : a, (ULONG32)a));
 
 				::strcat(header, " ");
 
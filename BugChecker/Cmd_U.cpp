@@ -39,7 +39,7 @@ public:
 					Print("Instruction at PC is not a jump instruction.");
 					co_return;
 				}
-				else if (params.jumpDest == -1)
+				else if (params.jumpDest == (ULONG64)-1)
 				{
 					Print("Condition for jump instruction at PC is false (ie not jumping).");
 					co_return;
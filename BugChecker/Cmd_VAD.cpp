@@ -0,0 +1,100 @@
+#include "BugChecker.h"
+
+#include "Cmd.h"
+#include "Root.h"
+#include "Utils.h"
+
+class Cmd_VAD : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "VAD"; }
+	virtual const CHAR* GetDesc() { return "Display the VAD snapshot of a process."; }
+	virtual const CHAR* GetSyntax() { return "VAD [eprocess]"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		// parse the arguments.
+
+		ULONG64 eprocess = 0;
+
+		auto args = TokenizeArgs(params.cmd, "VAD");
+
+		if (args.size() > 2)
+		{
+			Print("Too many arguments.");
+			co_return;
+		}
+		else if (args.size() == 2)
+		{
+			eastl::pair<BOOLEAN, ULONG64> res;
+			co_await BcAwaiter_Join{ ResolveArg(res, args[1].c_str(), params.context, params.contextLen, params.is32bitCompat) };
+
+			if (!res.first)
+				co_return;
+			else
+				eprocess = res.second;
+		}
+		else
+		{
+			co_await BcAwaiter_Join{ Platform::GetCurrentEprocess(eprocess) };
+
+			if (!eprocess)
+			{
+				Print("Unable to get the current process.");
+				co_return;
+			}
+		}
+
+		// get the snapshot: it is built only once per break-in.
+
+		VadSnapshot* snapshot = NULL;
+
+		co_await BcAwaiter_Join{ Platform::GetVadSnapshot(snapshot, eprocess) };
+
+		if (!snapshot)
+		{
+			Print("Unable to read the VAD tree.");
+			co_return;
+		}
+
+		// print the header.
+
+		CHAR text[256];
+
+		ULONG64 buildTimeUs = Root::I->RdtscTicksPerMs ? snapshot->buildTime * 1000 / Root::I->RdtscTicksPerMs : 0;
+
+		::sprintf(text, "Process %s: %u nodes, %u ranges, built in %llu us.",
+			Utils::HexToString(eprocess, _6432_(sizeof(ULONG64), sizeof(ULONG32))).c_str(),
+			snapshot->nodesNum, (ULONG)snapshot->ranges.size(), buildTimeUs);
+		Print(text);
+
+		auto printLine = [](const eastl::string& start, const eastl::string& end, const eastl::string& node, const eastl::string& name) {
+
+			const int addrMaxLen = _6432_(16, 8) + 1;
+
+			eastl::string line =
+				start + eastl::string(_MAX_(1, addrMaxLen - (int)start.size()), ' ') +
+				end + eastl::string(_MAX_(1, addrMaxLen - (int)end.size()), ' ') +
+				node + eastl::string(_MAX_(1, addrMaxLen - (int)node.size()), ' ') +
+				name;
+
+			Print(line.c_str());
+		};
+
+		printLine("START", "END", "NODE", "FILE");
+
+		// print the list.
+
+		for (auto& r : snapshot->ranges)
+			printLine(
+				Utils::HexToString(r.start, _6432_(sizeof(ULONG64), sizeof(ULONG32))),
+				Utils::HexToString(r.end, _6432_(sizeof(ULONG64), sizeof(ULONG32))),
+				Utils::HexToString(r.node, _6432_(sizeof(ULONG64), sizeof(ULONG32))),
+				r.fileName);
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_VAD)
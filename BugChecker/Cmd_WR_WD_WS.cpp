@@ -2,7 +2,7 @@
 
 #include "Cmd.h"
 #include "Root.h"
-#include "crtFill.h"
+#include "CrtFill.h"
 
 static VOID CommandImpl(CmdParams& params, LONG* py)
 {
@@ -62,7 +62,7 @@ static VOID CommandImpl(CmdParams& params, LONG* py)
 	LONG last = 0;
 	eastl::vector<DivLine> v = Wnd::GetVisibleDivLines(first, last);
 
-	for (int i = 0; i < v.size(); i++)
+	for (int i = 0; i < (int)v.size(); i++)
 	{
 		if (v[i].py == py)
 		{
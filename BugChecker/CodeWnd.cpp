@@ -100,7 +100,7 @@ VOID CodeWnd::SyntaxColor(ULONG y)
 	int strIndex = -1;
 	int slashCn = 0;
 
-	for (int i = 0; i < text.size(); i++)
+	for (int i = 0; i < (int)text.size(); i++)
 	{
 		CHAR c = text[i];
 
@@ -152,14 +152,14 @@ VOID CodeWnd::SyntaxColor(ULONG y)
 
 		auto isIdChar = [&](size_t pos, int offset) -> BOOLEAN {
 
-			if (pos < 0 || pos >= text.size())
+			if (pos >= text.size()) // unsigned: a position before the start wraps around.
 				return FALSE;
 
 			auto posUnc = indexToPos(pos);
 
 			posUnc += offset;
 
-			if (posUnc < 0 || posUnc >= textUnc.size())
+			if (posUnc >= textUnc.size())
 				return FALSE;
 
 			CHAR c = textUnc[posUnc];
@@ -200,12 +200,12 @@ VOID CodeWnd::Add(const eastl::string& str)
 	auto& text = GetCurrentLine();
 
 	LONG pos = (Root::I->CursorX - 2) + posX;
-	if (pos < 0 || pos > text.size())
+	if (pos < 0 || pos > (LONG)text.size())
 		return;
 
 	text.insert(pos, str);
 
-	if (Root::I->CursorX < Root::I->WndWidth - 1 - str.size())
+	if (Root::I->CursorX < (LONG)Root::I->WndWidth - 1 - (LONG)str.size())
 		Wnd::ChangeCursorX(Root::I->CursorX + str.size());
 	else
 		posX += str.size();
@@ -218,7 +218,7 @@ VOID CodeWnd::Enter()
 	auto& text = GetCurrentLine();
 
 	LONG pos = (Root::I->CursorX - 2) + posX;
-	if (pos < 0 || pos > text.size())
+	if (pos < 0 || pos > (LONG)text.size())
 		return;
 
 	auto text2 = text.substr(pos);
@@ -232,7 +232,7 @@ VOID CodeWnd::Enter()
 
 	auto cursorY = Root::I->CursorY + 1;
 
-	if (cursorY > destY1)
+	if (cursorY > (LONG)destY1)
 	{
 		cursorY--;
 		posY++;
@@ -257,7 +257,7 @@ VOID CodeWnd::BackSpace()
 		if (!text.size())
 			return;
 
-		if (pos >= text.size())
+		if (pos >= (LONG)text.size())
 			return;
 
 		text.erase(pos, 1);
@@ -284,7 +284,7 @@ VOID CodeWnd::BackSpace()
 
 		LONG x = textSize + 2;
 
-		if (x > Root::I->WndWidth - 2)
+		if (x > (LONG)Root::I->WndWidth - 2)
 		{
 			x = Root::I->WndWidth - 2;
 			posX = textSize - (Root::I->WndWidth - 4);
@@ -292,7 +292,7 @@ VOID CodeWnd::BackSpace()
 
 		auto cursorY = Root::I->CursorY - 1;
 
-		if (cursorY < destY0)
+		if (cursorY < (LONG)destY0)
 		{
 			cursorY++;
 			posY--;
@@ -312,7 +312,7 @@ VOID CodeWnd::Del()
 	if (pos < 0)
 		return;
 
-	if (pos < text.size())
+	if (pos < (LONG)text.size())
 	{
 		text.erase(pos, 1);
 	}
@@ -350,7 +350,7 @@ VOID CodeWnd::Left()
 
 		LONG x = textSize + 2;
 
-		if (x > Root::I->WndWidth - 2)
+		if (x > (LONG)Root::I->WndWidth - 2)
 		{
 			x = Root::I->WndWidth - 2;
 			posX = textSize - (Root::I->WndWidth - 4);
@@ -358,7 +358,7 @@ VOID CodeWnd::Left()
 
 		auto cursorY = Root::I->CursorY - 1;
 
-		if (cursorY < destY0)
+		if (cursorY < (LONG)destY0)
 		{
 			cursorY++;
 			posY--;
@@ -379,9 +379,9 @@ VOID CodeWnd::Right()
 	if (pos < 0)
 		return;
 
-	if (pos < text.size())
+	if (pos < (LONG)text.size())
 	{
-		if (Root::I->CursorX < Root::I->WndWidth - 2)
+		if (Root::I->CursorX < (LONG)Root::I->WndWidth - 2)
 			Wnd::ChangeCursorX(Root::I->CursorX + 1);
 		else
 			posX++;
@@ -395,7 +395,7 @@ VOID CodeWnd::Right()
 
 		auto cursorY = Root::I->CursorY + 1;
 
-		if (cursorY > destY1)
+		if (cursorY > (LONG)destY1)
 		{
 			cursorY--;
 			posY++;
@@ -420,9 +420,9 @@ VOID CodeWnd::Up()
 
 	posX = 0;
 
-	LONG x = _MIN_(textSize + 2, Root::I->CursorX);
+	LONG x = _MIN_((LONG)textSize + 2, Root::I->CursorX);
 
-	if (x > Root::I->WndWidth - 2)
+	if (x > (LONG)Root::I->WndWidth - 2)
 	{
 		x = Root::I->WndWidth - 2;
 		posX = textSize - (Root::I->WndWidth - 4);
@@ -430,7 +430,7 @@ VOID CodeWnd::Up()
 
 	auto cursorY = Root::I->CursorY - 1;
 
-	if (cursorY < destY0)
+	if (cursorY < (LONG)destY0)
 	{
 		cursorY++;
 		posY--;
@@ -452,9 +452,9 @@ VOID CodeWnd::Down()
 
 	posX = 0;
 
-	LONG x = _MIN_(textSize + 2, Root::I->CursorX);
+	LONG x = _MIN_((LONG)textSize + 2, Root::I->CursorX);
 
-	if (x > Root::I->WndWidth - 2)
+	if (x > (LONG)Root::I->WndWidth - 2)
 	{
 		x = Root::I->WndWidth - 2;
 		posX = textSize - (Root::I->WndWidth - 4);
@@ -462,7 +462,7 @@ VOID CodeWnd::Down()
 
 	auto cursorY = Root::I->CursorY + 1;
 
-	if (cursorY > destY1)
+	if (cursorY > (LONG)destY1)
 	{
 		cursorY--;
 		posY++;
@@ -491,7 +491,7 @@ VOID CodeWnd::End()
 
 	LONG x = textSize + 2;
 
-	if (x > Root::I->WndWidth - 2)
+	if (x > (LONG)Root::I->WndWidth - 2)
 	{
 		x = Root::I->WndWidth - 2;
 		posX = textSize - (Root::I->WndWidth - 4);
@@ -529,9 +529,9 @@ VOID CodeWnd::PgUp()
 
 	posX = 0;
 
-	LONG x = _MIN_(textSize + 2, Root::I->CursorX);
+	LONG x = _MIN_((LONG)textSize + 2, Root::I->CursorX);
 
-	if (x > Root::I->WndWidth - 2)
+	if (x > (LONG)Root::I->WndWidth - 2)
 	{
 		x = Root::I->WndWidth - 2;
 		posX = textSize - (Root::I->WndWidth - 4);
@@ -539,7 +539,7 @@ VOID CodeWnd::PgUp()
 
 	auto cursorY = Root::I->CursorY;
 
-	if (posY >= winDim)
+	if (posY >= (ULONG)winDim)
 		posY -= winDim;
 	else
 	{
@@ -555,13 +555,13 @@ VOID CodeWnd::PgUp()
 VOID CodeWnd::PgDn()
 {
 	LONG id = (LONG)GetCurrentLineId();
-	if (id + 1 >= contents.size())
+	if (id + 1 >= (LONG)contents.size())
 		return;
 
 	const LONG winDim = destY1 - destY0 + 1;
 
 	id += winDim;
-	if (id >= contents.size())
+	if (id >= (LONG)contents.size())
 		id = contents.size() - 1;
 
 	auto& text = GetLine(id);
@@ -569,9 +569,9 @@ VOID CodeWnd::PgDn()
 
 	posX = 0;
 
-	LONG x = _MIN_(textSize + 2, Root::I->CursorX);
+	LONG x = _MIN_((LONG)textSize + 2, Root::I->CursorX);
 
-	if (x > Root::I->WndWidth - 2)
+	if (x > (LONG)Root::I->WndWidth - 2)
 	{
 		x = Root::I->WndWidth - 2;
 		posX = textSize - (Root::I->WndWidth - 4);
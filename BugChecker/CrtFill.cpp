@@ -174,7 +174,7 @@ static unsigned __int64 __cdecl strtoxq(
 	}
 	else if ((flags & FL_OVERFLOW) ||
 		(!(flags & FL_UNSIGNED) &&
-			(((flags & FL_NEG) && (number > -_I64_MIN)) ||
+			(((flags & FL_NEG) && (number > (unsigned __int64)_I64_MAX + 1)) ||
 				(!(flags & FL_NEG) && (number > _I64_MAX)))))
 	{
 		/* overflow or signed overflow occurred */
@@ -0,0 +1,197 @@
+#include "DbgPrintRing.h"
+
+#include "LogWnd.h"
+#include "Utils.h"
+
+DbgPrintRing::DbgPrintRing()
+{
+	ULONG num = ::KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+
+	rings = (CpuRing*)::ExAllocatePool(NonPagedPool, num * sizeof(CpuRing));
+
+	if (rings)
+	{
+		for (ULONG i = 0; i < num; i++)
+			new (&rings[i]) CpuRing(); // N.B. the data is not cleared: head and tail are all that the readers look at.
+		ringsNum = num;
+	}
+}
+
+DbgPrintRing::~DbgPrintRing()
+{
+	if (rings)
+		::ExFreePool(rings);
+}
+
+VOID DbgPrintRing::Push(const CHAR* psz, ULONG len)
+{
+	if (len > MaxMsgLen)
+		len = MaxMsgLen;
+
+	// discard the messages of the muted components.
+
+	if (IsMuted(psz, len))
+	{
+		::_InterlockedIncrement(&Perf_FilteredNum);
+		return;
+	}
+
+	// each cpu has its own ring, so the only concurrent access is between this producer and the consumer in Drain.
+
+	ULONG cpu = ::KeGetCurrentProcessorNumberEx(NULL);
+
+	if (cpu >= ringsNum) // should never happen.
+	{
+		::_InterlockedIncrement(&Perf_DroppedNum);
+		return;
+	}
+
+	CpuRing& ring = rings[cpu];
+
+	ULONG head = ring.head;
+	ULONG msgLen = sizeof(Header) + len;
+
+	if (RingSize - (head - ring.tail) < msgLen)
+	{
+		::_InterlockedIncrement(&Perf_DroppedNum);
+		return;
+	}
+
+	Header header = { (ULONG)::_InterlockedIncrement(&seq), len };
+
+	Write(ring, head, &header, sizeof(header));
+	Write(ring, head + sizeof(header), psz, len);
+
+	// publish the message.
+
+	::_InterlockedExchange((volatile LONG*)&ring.head, head + msgLen);
+
+	::_InterlockedIncrement(&Perf_MsgsNum);
+}
+
+VOID DbgPrintRing::Drain(LogWnd& log)
+{
+	static CHAR msg[MaxMsgLen + 1];
+
+	while (TRUE)
+	{
+		// take the oldest message among all the rings, in order to preserve the order of the prints.
+
+		CpuRing* oldest = NULL;
+		Header oldestHeader = {};
+
+		for (ULONG r = 0; r < ringsNum; r++)
+		{
+			CpuRing& ring = rings[r];
+
+			if (ring.head == ring.tail)
+				continue;
+
+			Header header;
+			Read(ring, ring.tail, &header, sizeof(header));
+
+			if (!oldest || (LONG)(header.seq - oldestHeader.seq) < 0)
+			{
+				oldest = &ring;
+				oldestHeader = header;
+			}
+		}
+
+		if (!oldest)
+			break;
+
+		Read(*oldest, oldest->tail + sizeof(Header), msg, oldestHeader.len);
+
+		::_InterlockedExchange((volatile LONG*)&oldest->tail, oldest->tail + sizeof(Header) + oldestHeader.len);
+
+		// add the message to the log window.
+
+		for (ULONG i = 0; i < oldestHeader.len; i++)
+			if ((UCHAR)msg[i] < 32)
+				msg[i] = ' ';
+			else if ((UCHAR)msg[i] >= 128)
+				msg[i] = '?';
+
+		msg[oldestHeader.len] = 0;
+
+		log.AddString(msg);
+	}
+
+	// tell the user if some messages were lost.
+
+	LONG droppedNum = Perf_DroppedNum;
+
+	if (droppedNum != lastDroppedNum)
+	{
+		CHAR text[128];
+		::sprintf(text, "WARNING: %d DbgPrint message(s) dropped (buffer full).", droppedNum - lastDroppedNum);
+
+		log.AddString(text);
+
+		lastDroppedNum = droppedNum;
+	}
+}
+
+BOOLEAN DbgPrintRing::Mute(const CHAR* prefix)
+{
+	ULONG len = ::strlen(prefix);
+
+	if (!len || len > FilterMaxLen)
+		return FALSE;
+
+	for (ULONG i = 0; i < FiltersNum; i++)
+		if (Utils::AreStringsEqualI(filters[i], prefix))
+			return TRUE;
+
+	for (ULONG i = 0; i < FiltersNum; i++)
+		if (!filters[i][0])
+		{
+			::strcpy(filters[i], prefix);
+			return TRUE;
+		}
+
+	return FALSE;
+}
+
+BOOLEAN DbgPrintRing::Unmute(const CHAR* prefix)
+{
+	for (ULONG i = 0; i < FiltersNum; i++)
+		if (filters[i][0] && Utils::AreStringsEqualI(filters[i], prefix))
+		{
+			filters[i][0] = 0;
+			return TRUE;
+		}
+
+	return FALSE;
+}
+
+VOID DbgPrintRing::UnmuteAll()
+{
+	for (ULONG i = 0; i < FiltersNum; i++)
+		filters[i][0] = 0;
+}
+
+BOOLEAN DbgPrintRing::IsMuted(const CHAR* psz, ULONG len)
+{
+	for (ULONG i = 0; i < FiltersNum; i++)
+	{
+		ULONG filterLen = ::strlen(filters[i]);
+
+		if (filterLen && filterLen <= len && !Utils::memicmp(psz, filters[i], filterLen))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+VOID DbgPrintRing::Write(CpuRing& ring, ULONG pos, const VOID* src, ULONG len)
+{
+	for (ULONG i = 0; i < len; i++)
+		ring.data[(pos + i) & (RingSize - 1)] = ((const BYTE*)src)[i];
+}
+
+VOID DbgPrintRing::Read(CpuRing& ring, ULONG pos, VOID* dest, ULONG len)
+{
+	for (ULONG i = 0; i < len; i++)
+		((BYTE*)dest)[i] = ring.data[(pos + i) & (RingSize - 1)];
+}
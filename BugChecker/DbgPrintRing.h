@@ -0,0 +1,61 @@
+#pragma once
+
+#include "BugChecker.h"
+
+class LogWnd;
+
+class DbgPrintRing // per-cpu byte rings where KdSendPacket stores the raw DbgPrint payloads, drained into the log window when the debugger UI is active.
+{
+public:
+
+	static constexpr ULONG RingSize = 32 * 1024; // must be a power of 2.
+	static constexpr ULONG MaxMsgLen = 1024;
+
+	static constexpr ULONG FiltersNum = 16;
+	static constexpr ULONG FilterMaxLen = 32;
+
+	DbgPrintRing(); // at PASSIVE_LEVEL: allocates one ring per processor.
+	~DbgPrintRing();
+
+	VOID Push(const CHAR* psz, ULONG len); // lock-free: called by KdSendPacket, at any irql, on any cpu.
+	VOID Drain(LogWnd& log); // called in the debugger context, when the other processors are frozen.
+
+	BOOLEAN Mute(const CHAR* prefix);
+	BOOLEAN Unmute(const CHAR* prefix);
+	VOID UnmuteAll();
+
+	const CHAR* GetFilter(ULONG index) { return filters[index]; }
+
+	volatile LONG Perf_MsgsNum = 0;
+	volatile LONG Perf_DroppedNum = 0; // ring full.
+	volatile LONG Perf_FilteredNum = 0; // muted component.
+
+private:
+
+	struct Header
+	{
+		ULONG seq;
+		ULONG len;
+	};
+
+	struct CpuRing
+	{
+		volatile ULONG head = 0; // written only by the producer.
+		volatile ULONG tail = 0; // written only by the consumer.
+		BYTE data[RingSize];
+	};
+
+	BOOLEAN IsMuted(const CHAR* psz, ULONG len);
+
+	static VOID Write(CpuRing& ring, ULONG pos, const VOID* src, ULONG len);
+	static VOID Read(CpuRing& ring, ULONG pos, VOID* dest, ULONG len);
+
+	CpuRing* rings = NULL; // indexed by the system-wide processor number (all the groups, including the processors that can be hot-added).
+	ULONG ringsNum = 0;
+
+	volatile LONG seq = 0;
+
+	CHAR filters[FiltersNum][FilterMaxLen + 1] = { 0 };
+
+	LONG lastDroppedNum = 0;
+};
@@ -0,0 +1,60 @@
+#include "DecodeCache.h"
+
+BOOLEAN DecodeCache::Decode(ULONG64 address, BOOLEAN is32bitCompat, const BYTE* bytes, ULONG size, ZydisDecodedInstruction& instr, ZydisDecodedOperand* ops)
+{
+	Entry& e = entries[(address ^ (address >> 9)) & (EntriesNum - 1)];
+
+	// hit: same address, same mode and same bytes.
+
+	if (e.valid && e.address == address && e.is32bitCompat == is32bitCompat &&
+		e.instr.length <= size && !::memcmp(e.bytes, bytes, e.instr.length))
+	{
+		Perf_HitsNum++;
+
+		instr = e.instr;
+		::memcpy(ops, e.ops, sizeof(e.ops));
+
+		return TRUE;
+	}
+
+	Perf_MissesNum++;
+
+	// decode the instruction: the failures are not cached, since they may depend on the bytes after the size.
+
+	ZydisDecoder decoder;
+	::ZydisDecoderInit(&decoder,
+		_6432_(is32bitCompat ? ZYDIS_MACHINE_MODE_LONG_COMPAT_32 : ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_MACHINE_MODE_LEGACY_32),
+		_6432_(is32bitCompat ? ZYDIS_STACK_WIDTH_32 : ZYDIS_STACK_WIDTH_64, ZYDIS_STACK_WIDTH_32));
+
+	if (!ZYAN_SUCCESS(::ZydisDecoderDecodeFull(&decoder, bytes, size,
+		&instr, ops, ZYDIS_MAX_OPERAND_COUNT_VISIBLE,
+		ZYDIS_DFLAG_VISIBLE_OPERANDS_ONLY)))
+	{
+		if (e.address == address)
+			e.valid = FALSE;
+
+		return FALSE;
+	}
+
+	e.address = address;
+	e.valid = TRUE;
+	e.is32bitCompat = is32bitCompat;
+	::memcpy(e.bytes, bytes, instr.length);
+	e.instr = instr;
+	::memcpy(e.ops, ops, sizeof(e.ops));
+
+	return TRUE;
+}
+
+VOID DecodeCache::Invalidate(ULONG64 address, ULONG size)
+{
+	for (Entry& e : entries)
+		if (e.valid && e.address < address + size && e.address + e.instr.length > address)
+			e.valid = FALSE;
+}
+
+VOID DecodeCache::InvalidateAll()
+{
+	for (Entry& e : entries)
+		e.valid = FALSE;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "BugChecker.h"
+
+class DecodeCache // decoded instructions, keyed by address and machine mode. An entry is used only if the instruction bytes are unchanged, so the cache survives the state changes (e.g. when stepping).
+{
+public:
+
+	static constexpr ULONG EntriesNum = 512; // must be a power of 2: direct-mapped.
+
+	BOOLEAN Decode(ULONG64 address, BOOLEAN is32bitCompat, const BYTE* bytes, ULONG size, ZydisDecodedInstruction& instr, ZydisDecodedOperand* ops); // ops has ZYDIS_MAX_OPERAND_COUNT_VISIBLE elements.
+
+	VOID Invalidate(ULONG64 address, ULONG size);
+	VOID InvalidateAll();
+
+	ULONG64 Perf_HitsNum = 0;
+	ULONG64 Perf_MissesNum = 0;
+
+private:
+
+	struct Entry
+	{
+		ULONG64 address = 0;
+		BOOLEAN valid = FALSE;
+		BOOLEAN is32bitCompat = FALSE;
+		BYTE bytes[ZYDIS_MAX_INSTRUCTION_LENGTH];
+		ZydisDecodedInstruction instr;
+		ZydisDecodedOperand ops[ZYDIS_MAX_OPERAND_COUNT_VISIBLE];
+	};
+
+	Entry entries[EntriesNum];
+};
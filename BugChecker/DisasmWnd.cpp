@@ -4,6 +4,9 @@
 #include "Root.h"
 #include "Utils.h"
 
+#include <EASTL/sort.h>
+#include <EASTL/algorithm.h>
+
 BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jumpDest, LONG navigate /*= 0*/) noexcept
 {
 	current32bitCompat = is32bitCompat;
@@ -21,14 +24,7 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 		isLastAddressShownASymName = FALSE;
 	}
 
-	// initialize decoder context.
-
-	ZydisDecoder decoder;
-	::ZydisDecoderInit(&decoder,
-		_6432_(is32bitCompat ? ZYDIS_MACHINE_MODE_LONG_COMPAT_32 : ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_MACHINE_MODE_LEGACY_32),
-		_6432_(is32bitCompat ? ZYDIS_STACK_WIDTH_32 : ZYDIS_STACK_WIDTH_64, ZYDIS_STACK_WIDTH_32));
-
-	// initialize formatter.
+	// initialize formatter. The instructions are decoded through Root::I->DecodedInstrs.
 
 	ZydisFormatter formatter;
 	::ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL);
@@ -81,7 +77,7 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 		contents.clear();
 
 		CHAR text[128];
-		::sprintf(text, _6432_(is32bitCompat ? "%08X" : "%016llX", "%08X"), _6432_(is32bitCompat ? (ULONG32)start : start, (ULONG32)start));
+		::sprintf(text, _6432_(is32bitCompat ? "%08llX" : "%016llX", "%08X"), _6432_(is32bitCompat ? (ULONG32)start : start, (ULONG32)start));
 		::strcat(text, " ???");
 
 		contents.push_back(text);
@@ -93,9 +89,13 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 
 	// hide our breakpoint instructions.
 
-	for (BreakPoint& bp : Root::I->BreakPoints)
-		if (bp.address >= asmBytesAddress && bp.address < asmBytesAddress + asmBytesSize)
-			asmBytes[bp.address - asmBytesAddress] = bp.prevByte;
+	eastl::vector<BreakPoint*> bpsInRange;
+
+	Root::I->BreakPoints.FindInRange(asmBytesAddress, asmBytesAddress + asmBytesSize, bpsInRange);
+
+	for (BreakPoint* bp : bpsInRange)
+		if (bp->drIndex < 0)
+			asmBytes[bp->address - asmBytesAddress] = bp->prevByte;
 
 	// disassemble backwards or forward.
 
@@ -103,60 +103,92 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 	ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT_VISIBLE];
 
 	ZyanUSize offset = 0;
-	ZyanU64 runtimeAddress = asmBytesAddress;
+	ZyanU64 runtimeAddress = 0;
 
 	eastl::vector<ULONG64> addresses;
 
-	while (TRUE)
+	BOOLEAN trusted = FALSE; // the decoding started at a known instruction boundary.
+
+	// select the boundaries of the module, the address space and the mode of the start address.
+
+	ImageDebugInfo startModule = {};
+	CHAR startPosInModules[sizeof(posInModules)];
+
+	co_await BcAwaiter_Join{ Platform::DiscoverBytePointerPosInModules(startPosInModules, &startModule, (ULONG_PTR)start) };
+
+	ULONG64 eprocess = 0;
+
+	if (start < (ULONG64)(ULONG_PTR)Platform::UserProbeAddress)
+		co_await BcAwaiter_Join{ Platform::GetCurrentEprocess(eprocess) };
+
+	boundaries.Select(eprocess, is32bitCompat, startModule);
+
+	// the function starts in the symbol file of the module are instruction boundaries also after data (e.g. a jump table): the decoding resynchronizes there.
+
+	ULONG64 rangeStart = asmBytesAddress;
+
+	if (startModule.startAddr && rangeStart < startModule.startAddr)
+		rangeStart = startModule.startAddr;
+
+	SymbolFile* startSymF = startModule.startAddr ? Root::I->GetSymbolFileByGuidAndAge(startModule.guid, startModule.age) : NULL;
+
+	eastl::vector<ULONG64> functionStarts;
+
+	GetFunctionStarts(functionStarts, startSymF, startModule, rangeStart, asmBytesAddress + asmBytesSize);
+
+	if (navigate >= 0)
 	{
-		// fill the "addresses" list. Each item represents a line in the disassembler window.
+		trusted = start == pc || boundaries.Contains(start);
 
-		addresses.push_back(runtimeAddress);
+		CollectAddresses(addresses, asmBytes, asmBytesSize, asmBytesAddress, start, navigate, contentsDim, is32bitCompat, functionStarts);
+	}
+	else
+	{
+		// backwards, the decoding must start at an instruction boundary: try the known boundaries and the function starts in the symbol file
+		// of the module (which don't require other memory reads), then the first bytes of the buffer.
 
-		if (navigate >= 0)
-		{
-			if (addresses.size() >= contentsDim + navigate)
-			{
-				addresses.erase(addresses.begin(), addresses.begin() + navigate);
-				break;
-			}
-		}
-		else
-		{
-			if (runtimeAddress > lastAddressShown)
-				co_return; // unaligned: unable to disassemble backwards.
-			else if (runtimeAddress == lastAddressShown)
-			{
-				if (addresses.size() < contentsDim + (-navigate) + (isLastAddressShownASymName ? 1 : 0)) co_return; // should never happen.
-				addresses.erase(addresses.end() - (-navigate) + (isLastAddressShownASymName ? 1 : 0), addresses.end());
-				addresses.erase(addresses.begin(), addresses.end() - contentsDim + (isLastAddressShownASymName ? -1 : 0));
-				break;
-			}
-		}
+		ULONG64 candidates[2 + ZYDIS_MAX_INSTRUCTION_LENGTH];
+		ULONG candidatesNum = 0;
 
-		// disassemble.
+		ULONG64 known = boundaries.FindFirstInRange(rangeStart, lastAddressShown); // N.B. the boundaries of this map are inside the module.
+		ULONG64 function = functionStarts.size() && functionStarts[0] < lastAddressShown ? functionStarts[0] : 0;
 
-		ULONG instrLength;
+		if (known)
+			candidates[candidatesNum++] = known;
+		if (function && function != known)
+			candidates[candidatesNum++] = function;
 
-		if (ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, asmBytes + offset, asmBytesSize - offset,
-			&instruction, operands, ZYDIS_MAX_OPERAND_COUNT_VISIBLE,
-			ZYDIS_DFLAG_VISIBLE_OPERANDS_ONLY)))
-			instrLength = instruction.length;
-		else
-			instrLength = 1;
+		if (candidatesNum == 2 && candidates[1] < candidates[0]) // the smallest one gives more lines.
+			eastl::swap(candidates[0], candidates[1]);
 
-		offset += instrLength;
-		runtimeAddress += instrLength;
+		ULONG trustedNum = candidatesNum;
+
+		for (ULONG b = 0; b < ZYDIS_MAX_INSTRUCTION_LENGTH; b++)
+			candidates[candidatesNum++] = asmBytesAddress + b;
+
+		ULONG i = 0;
+
+		for (; i < candidatesNum; i++)
+			if (CollectAddresses(addresses, asmBytes, asmBytesSize, asmBytesAddress, candidates[i], navigate, contentsDim, is32bitCompat, functionStarts))
+				break;
+
+		if (i == candidatesNum)
+			co_return; // unaligned: unable to disassemble backwards.
+
+		trusted = i < trustedNum;
 	}
 
 	if (addresses.size() != contentsDim + (isLastAddressShownASymName ? 1 : 0)) co_return; // should never happen.
 
+	if (trusted) // N.B. the decodings from the first bytes of the buffer are not trusted, even if they land on the last line shown: x86 code resynchronizes anyway.
+		boundaries.Add(addresses);
+
 	// determine in which module eip/rip is.
 
 	debugInfo = {};
 
 	if (addresses.size())
-		co_await BcAwaiter_DiscoverPosInModules{ posInModules, &debugInfo, (ULONG_PTR)addresses[0] };
+		co_await BcAwaiter_Join{ Platform::DiscoverBytePointerPosInModules(posInModules, &debugInfo, (ULONG_PTR)addresses[0]) };
 
 	symF = NULL;
 
@@ -192,7 +224,7 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 
 	contents.clear();
 
-	for (int j = 0; j < addresses.size(); j++)
+	for (int j = 0; j < (int)addresses.size(); j++)
 	{
 		runtimeAddress = addresses[j];
 		offset = runtimeAddress - asmBytesAddress;
@@ -203,9 +235,7 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 
 		ULONG instrLength;
 
-		if (ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, asmBytes + offset, asmBytesSize - offset,
-			&instruction, operands, ZYDIS_MAX_OPERAND_COUNT_VISIBLE,
-			ZYDIS_DFLAG_VISIBLE_OPERANDS_ONLY)))
+		if (Root::I->DecodedInstrs.Decode(runtimeAddress, is32bitCompat, asmBytes + offset, asmBytesSize - offset, instruction, operands))
 		{
 			instrLength = instruction.length;
 		}
@@ -215,12 +245,18 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 			error = TRUE;
 		}
 
+		if (j + 1 < (int)addresses.size() && addresses[j + 1] > runtimeAddress && addresses[j + 1] - runtimeAddress < instrLength) // cut at a function start.
+		{
+			instrLength = (ULONG)(addresses[j + 1] - runtimeAddress);
+			error = TRUE;
+		}
+
 		// is a breakpoint set here ?
 
 		BOOLEAN hasBp = FALSE;
 
-		for (BreakPoint& bp : Root::I->BreakPoints)
-			if (!bp.skip && bp.address == runtimeAddress)
+		for (BreakPoint* bp : bpsInRange)
+			if (!bp->skip && bp->address == runtimeAddress)
 			{
 				hasBp = TRUE;
 				break;
@@ -264,7 +300,7 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 
 		::strcat(line, ":");
 
-		::sprintf(line + ::strlen(line), _6432_(is32bitCompat ? "%08X" : "%016llX", "%08X"), _6432_(is32bitCompat ? (ULONG32)runtimeAddress : runtimeAddress, (ULONG32)runtimeAddress));
+		::sprintf(line + ::strlen(line), _6432_(is32bitCompat ? "%08llX" : "%016llX", "%08X"), _6432_(is32bitCompat ? (ULONG32)runtimeAddress : (ULONG64)runtimeAddress, (ULONG32)runtimeAddress));
 
 		*(USHORT*)(line + ::strlen(line)) = 0x00B3;
 
@@ -272,7 +308,7 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 
 		for (int i = 0; i < 10; i++)
 		{
-			if (i < instrLength)
+			if (i < (int)instrLength)
 				::sprintf(line + ::strlen(line), "%02X", *(asmBytes + offset + i));
 			else
 				::strcat(line, "  ");
@@ -314,7 +350,7 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 			auto ptr = const_cast<CHAR*>(StrCount(line, lineDim - 9));
 			if (ptr)
 			{
-				if (jumpDest == -1)
+				if (jumpDest == (ULONG64)-1)
 					::sprintf(ptr, "\n%02X(NO JUMP)", Wnd::bldClr);
 				else
 				{
@@ -449,6 +485,211 @@ BcCoroutine DisasmWnd::Disasm(BYTE* context, BOOLEAN is32bitCompat, ULONG64 jump
 	}
 }
 
+BOOLEAN DisasmWnd::CollectAddresses(eastl::vector<ULONG64>& addresses, const BYTE* asmBytes, size_t asmBytesSize, ULONG64 asmBytesAddress, ULONG64 decodeStart, LONG navigate, ULONG contentsDim, BOOLEAN is32bitCompat, const eastl::vector<ULONG64>& functionStarts)
+{
+	auto nextFunction = eastl::upper_bound(functionStarts.begin(), functionStarts.end(), decodeStart);
+
+	ZydisDecodedInstruction instruction;
+	ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT_VISIBLE];
+
+	ZyanUSize offset = decodeStart - asmBytesAddress;
+	ZyanU64 runtimeAddress = decodeStart;
+
+	addresses.clear();
+
+	while (offset < asmBytesSize)
+	{
+		// fill the "addresses" list. Each item represents a line in the disassembler window.
+
+		addresses.push_back(runtimeAddress);
+
+		if (navigate >= 0)
+		{
+			if (addresses.size() >= contentsDim + navigate)
+			{
+				addresses.erase(addresses.begin(), addresses.begin() + navigate);
+				return TRUE;
+			}
+		}
+		else
+		{
+			if (runtimeAddress > lastAddressShown)
+				return FALSE; // unaligned.
+			else if (runtimeAddress == lastAddressShown)
+			{
+				if (addresses.size() < contentsDim + (-navigate) + (isLastAddressShownASymName ? 1 : 0)) return FALSE; // the decoding started too close to the window.
+				addresses.erase(addresses.end() - (-navigate) + (isLastAddressShownASymName ? 1 : 0), addresses.end());
+				addresses.erase(addresses.begin(), addresses.end() - contentsDim + (isLastAddressShownASymName ? -1 : 0));
+				return TRUE;
+			}
+		}
+
+		// disassemble.
+
+		ULONG instrLength;
+
+		if (Root::I->DecodedInstrs.Decode(runtimeAddress, is32bitCompat, asmBytes + offset, asmBytesSize - offset, instruction, operands))
+			instrLength = instruction.length;
+		else
+			instrLength = 1;
+
+		if (nextFunction != functionStarts.end() && *nextFunction < runtimeAddress + instrLength) // the instruction overlaps the next function.
+		{
+			instrLength = (ULONG)(*nextFunction - runtimeAddress);
+			++nextFunction;
+		}
+
+		offset += instrLength;
+		runtimeAddress += instrLength;
+	}
+
+	return FALSE; // should never happen.
+}
+
+VOID DisasmWnd::GetFunctionStarts(eastl::vector<ULONG64>& starts, SymbolFile* symF, const ImageDebugInfo& module, ULONG64 start, ULONG64 end)
+{
+	// search backwards from "end" the public symbol starts in [start, end).
+
+	starts.clear();
+
+	if (!symF || !module.startAddr)
+		return;
+
+	ULONG64 moduleStart = (ULONG64)module.startAddr;
+
+	for (ULONG64 address = end - 1; address >= start && address >= moduleStart && address < moduleStart + module.length; )
+	{
+		BCSFILE_PUBLIC_SYMBOL* sym = NULL;
+
+		if (!Symbols::GetNameOfPublic(symF->GetHeader(), (ULONG)(address - moduleStart), &sym) || !sym)
+		{
+			address--; // padding between the functions.
+			continue;
+		}
+
+		ULONG64 symStart = moduleStart + sym->address;
+
+		if (symStart < start)
+			break;
+
+		starts.push_back(symStart);
+
+		if (symStart == moduleStart)
+			break;
+
+		address = symStart - 1;
+	}
+
+	eastl::reverse(starts.begin(), starts.end());
+}
+
+VOID InstrBoundaries::Select(ULONG64 eprocess, BOOLEAN is32bitCompat, const ImageDebugInfo& module)
+{
+	curr = NULL;
+
+	Map* lru = &maps[0];
+
+	for (Map& m : maps)
+	{
+		if (m.lastUse &&
+			m.eprocess == eprocess &&
+			m.is32bitCompat == is32bitCompat &&
+			m.moduleStart == (ULONG64)module.startAddr &&
+			m.moduleLength == module.length &&
+			!::memcmp(m.guid, module.guid, sizeof(m.guid)) &&
+			m.age == module.age)
+		{
+			curr = &m;
+			break;
+		}
+
+		if (m.lastUse < lru->lastUse)
+			lru = &m;
+	}
+
+	if (!curr)
+	{
+		curr = lru;
+
+		curr->eprocess = eprocess;
+		curr->is32bitCompat = is32bitCompat;
+		curr->moduleStart = module.startAddr;
+		curr->moduleLength = module.length;
+		::memcpy(curr->guid, module.guid, sizeof(curr->guid));
+		curr->age = module.age;
+
+		curr->addresses.clear();
+	}
+
+	curr->lastUse = ++useCounter;
+}
+
+BOOLEAN InstrBoundaries::Contains(ULONG64 address)
+{
+	if (!curr)
+		return FALSE;
+
+	return eastl::binary_search(curr->addresses.begin(), curr->addresses.end(), address);
+}
+
+ULONG64 InstrBoundaries::FindFirstInRange(ULONG64 start, ULONG64 end)
+{
+	if (!curr)
+		return 0;
+
+	auto it = eastl::lower_bound(curr->addresses.begin(), curr->addresses.end(), start);
+
+	return it != curr->addresses.end() && *it < end ? *it : 0;
+}
+
+VOID InstrBoundaries::Add(const eastl::vector<ULONG64>& addrs)
+{
+	if (!curr)
+		return;
+
+	auto& addresses = curr->addresses;
+
+	if (addresses.size() + addrs.size() > MaxSize)
+		addresses.clear();
+
+	for (ULONG64 a : addrs)
+		if (!curr->moduleStart || (a >= curr->moduleStart && a < curr->moduleStart + curr->moduleLength))
+			addresses.push_back(a);
+
+	eastl::sort(addresses.begin(), addresses.end());
+	addresses.erase(eastl::unique(addresses.begin(), addresses.end()), addresses.end());
+}
+
+VOID InstrBoundaries::Invalidate(ULONG64 address, ULONG size)
+{
+	// remove the instructions that may overlap the write (starting up to 14 bytes before it) and the ones right after it, whose decoding may have changed.
+
+	ULONG64 start = address - _MIN_(address, (ULONG64)ZYDIS_MAX_INSTRUCTION_LENGTH - 1);
+	ULONG64 end = address + size + ZYDIS_MAX_INSTRUCTION_LENGTH;
+
+	for (Map& m : maps)
+	{
+		auto first = eastl::lower_bound(m.addresses.begin(), m.addresses.end(), start);
+		auto last = eastl::lower_bound(first, m.addresses.end(), end);
+
+		m.addresses.erase(first, last);
+	}
+}
+
+VOID InstrBoundaries::Resume()
+{
+	// the user modules may be unloaded and the code outside of the modules may be regenerated.
+
+	for (Map& m : maps)
+		if (m.eprocess || !m.moduleStart)
+		{
+			m.lastUse = 0;
+			m.addresses.clear();
+		}
+
+	curr = NULL;
+}
+
 ZyanStatus DisasmWnd::ZydisFormatterPrintAddressAbsolute(const ZydisFormatter* formatter, ZydisFormatterBuffer* buffer, ZydisFormatterContext* context)
 {
 	auto I = &Root::I->DisasmWindow;
@@ -7,6 +7,44 @@
 #include "SymbolFile.h"
 #include "Platform.h"
 
+class InstrBoundaries // addresses known to be instruction starts (the PC and the instructions decoded forward from a known start), one map per address space, mode and module: used to disassemble backwards.
+{
+public:
+
+	static constexpr ULONG MapsNum = 8; // the least recently used map is recycled.
+	static constexpr ULONG MaxSize = 4 * 1024; // a map is cleared when full.
+
+	VOID Select(ULONG64 eprocess, BOOLEAN is32bitCompat, const ImageDebugInfo& module); // eprocess is 0 for the kernel addresses.
+
+	BOOLEAN Contains(ULONG64 address);
+	ULONG64 FindFirstInRange(ULONG64 start, ULONG64 end); // the smallest address in [start, end), or 0.
+
+	VOID Add(const eastl::vector<ULONG64>& addrs);
+
+	VOID Invalidate(ULONG64 address, ULONG size); // memory writes.
+	VOID Resume(); // the OS runs again: only the maps of the kernel modules remain valid.
+
+private:
+
+	struct Map
+	{
+		ULONG64 eprocess;
+		BOOLEAN is32bitCompat;
+		ULONG64 moduleStart; // 0: outside of the known modules.
+		ULONG moduleLength;
+		BYTE guid[16];
+		DWORD age;
+
+		ULONG64 lastUse;
+		eastl::vector<ULONG64> addresses; // sorted.
+	};
+
+	Map maps[MapsNum] = {};
+	Map* curr = NULL;
+
+	ULONG64 useCounter = 0;
+};
+
 class DisasmWnd : public Wnd
 {
 public:
@@ -35,6 +73,8 @@ public:
 
 	BOOLEAN current32bitCompat = FALSE;
 
+	InstrBoundaries boundaries;
+
 private:
 
 	ULONG64 firstAddressShown = 0;
@@ -43,6 +83,9 @@ private:
 	BOOLEAN isFirstAddressShownASymName = FALSE;
 	BOOLEAN isLastAddressShownASymName = FALSE;
 
+	BOOLEAN CollectAddresses(eastl::vector<ULONG64>& addresses, const BYTE* asmBytes, size_t asmBytesSize, ULONG64 asmBytesAddress, ULONG64 decodeStart, LONG navigate, ULONG contentsDim, BOOLEAN is32bitCompat, const eastl::vector<ULONG64>& functionStarts);
+	static VOID GetFunctionStarts(eastl::vector<ULONG64>& starts, SymbolFile* symF, const ImageDebugInfo& module, ULONG64 start, ULONG64 end); // sorted.
+
 private:
 
 	ZydisFormatterFunc defaultPrintAddressAbsolute = NULL;
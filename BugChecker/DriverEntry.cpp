@@ -33,7 +33,15 @@ char g_debugStr[256] = "";
 
 //
 
-extern "C" static KD_RECV_CODE
+#ifndef BC_HOSTSIM
+#define KD_HOOK_LINKAGE extern "C" static
+#else
+#define KD_HOOK_LINKAGE extern "C" // called directly by the KD target simulator of HostSim.
+#endif
+
+//
+
+KD_HOOK_LINKAGE KD_RECV_CODE
 __stdcall
 KdReceivePacket( // N.B. NTOSKRNL will call us at CLOCK_LEVEL when polling and at HIGH_LEVEL after a State Change!
 	__in ULONG PacketType,
@@ -121,6 +129,7 @@ KdReceivePacket( // N.B. NTOSKRNL will call us at CLOCK_LEVEL when polling and a
 				switch (BcAwaiterBase::ProcessAwaiter(pState, SecondBuffer, PayloadBytes))
 				{
 				case ProcessAwaiterRetVal::Ok:
+					Root::I->KdEvents.Add(FALSE, PacketType, pState->ApiNumber, SecondBuffer);
 					return KD_RECV_CODE_OK;
 				case ProcessAwaiterRetVal::Timeout:
 					return KD_RECV_CODE_TIMEOUT;
@@ -134,32 +143,27 @@ KdReceivePacket( // N.B. NTOSKRNL will call us at CLOCK_LEVEL when polling and a
 
 			case DEBST_MEMREADCOR:
 			{
-				BOOLEAN cpp20Coro = !Root::I->MemReadCor.pCoroutine && Root::I->AwaiterPtr && !::strcmp(Root::I->AwaiterPtr->function, "BcAwaiter_ReadMemory");
+				// check the response to the previous chunk request, if any: the current read is complete if all the bytes were read or if the kernel failed to read the chunk.
 
-				const ULONG _chunkSize_ = 1024;
-				ULONG btr = Root::I->MemReadCor.BytesToRead - Root::I->MemReadCor.BufferPos;
+				BOOLEAN readCompleted = TRUE;
 
-				if (btr <= _chunkSize_)
+				if (Root::I->MemReadCor.ChunkSize)
 				{
-					if (btr && Root::I->MemReadCor.ActualBytesRead == btr)
-						Root::I->MemReadCor.ActualBytesRead = Root::I->MemReadCor.BytesToRead;
+					BOOLEAN chunkFailed = Root::I->MemReadCor.ActualBytesRead <= Root::I->MemReadCor.BufferPos && !Root::I->MemReadCor.RetryChunk;
+
+					Root::I->MemReadCor.RetryChunk = FALSE;
 
-					if (cpp20Coro) // C++20 coroutines case.
+					Root::I->MemReadCor.ChunkSize = 0;
+					Root::I->MemReadCor.BufferPos = Root::I->MemReadCor.ActualBytesRead;
+
+					readCompleted = chunkFailed || Root::I->MemReadCor.ActualBytesRead >= Root::I->MemReadCor.BytesToRead;
+				}
+
+				if (readCompleted)
+				{
+					if (!Root::I->MemReadCor.pCoroutine) // C++20 coroutines case.
 					{
-						BcAwaiter_ReadMemory* ptr = (BcAwaiter_ReadMemory*)Root::I->AwaiterPtr;
-
-						Root::I->MemReadCor.ResumePoint--; // initialized to 2 before starting.
-
-						if (Root::I->MemReadCor.ResumePoint == 1)
-						{
-							Root::I->MemReadCor.Pointer = (VOID*)ptr->pointer;
-							Root::I->MemReadCor.BytesToRead = ptr->size;
-						}
-						else if (Root::I->MemReadCor.ResumePoint <= 0)
-						{
-							if (Root::I->MemReadCor.ActualBytesRead == Root::I->MemReadCor.BytesToRead)
-								ptr->retVal = Root::I->MemReadCor.Buffer;
-						}
+						const_cast<BcAwaiterBase*>(Root::I->AwaiterPtr)->ReadCompleted();
 					}
 					else // old BugChecker custom coroutines case.
 					{
@@ -172,24 +176,61 @@ KdReceivePacket( // N.B. NTOSKRNL will call us at CLOCK_LEVEL when polling and a
 						Root::I->DebuggerState = Root::I->MemReadCor.EndDebuggerState;
 						continue;
 					}
-					else
-					{
-						btr = Root::I->MemReadCor.BytesToRead;
-						Root::I->MemReadCor.BufferPos = 0;
-					}
+
+					Root::I->MemReadCor.BufferPos = 0;
+					Root::I->MemReadCor.ActualBytesRead = 0;
+
+					if (!Root::I->MemReadCor.BytesToRead)
+						continue; // nothing to read.
 				}
-				else
+
+				// get the next chunk: it is as big as the kernel packet buffer allows, but it never crosses a page boundary,
+				// so that a paged out page fails only its own request.
+
+				ULONG64 address = (ULONG64)Root::I->MemReadCor.Pointer + Root::I->MemReadCor.BufferPos;
+
+				ULONG maxTransfer = PACKET_MAX_SIZE - sizeof(DBGKD_MANIPULATE_STATE64);
+
+				if (SecondBuffer && SecondBuffer->MaxLength && SecondBuffer->MaxLength < maxTransfer)
+					maxTransfer = SecondBuffer->MaxLength;
+
+				if (Root::I->MemReadCor.TransferMax && Root::I->MemReadCor.TransferMax < maxTransfer)
+					maxTransfer = Root::I->MemReadCor.TransferMax;
+
+				ULONG pageOffset = (ULONG)(address & (PAGE_SIZE - 1));
+
+				ULONG chunkSize = Root::I->MemReadCor.BytesToRead - Root::I->MemReadCor.BufferPos;
+
+				chunkSize = _MIN_(chunkSize, maxTransfer);
+				chunkSize = _MIN_(chunkSize, PAGE_SIZE - pageOffset);
+
+				Root::I->MemReadCor.ChunkSize = chunkSize;
+
+				// serve the chunk from the page cache, if possible.
+
+				if (Root::I->ReadCache.Read(address, Root::I->MemReadCor.Buffer + Root::I->MemReadCor.BufferPos, chunkSize))
 				{
-					btr -= _chunkSize_;
-					Root::I->MemReadCor.BufferPos += _chunkSize_;
+					Root::I->ReadCache.Perf_HitsNum++;
+
+					Root::I->MemReadCor.ActualBytesRead = Root::I->MemReadCor.BufferPos + chunkSize;
+					continue;
 				}
 
+				Root::I->ReadCache.Perf_MissesNum++;
+
+				// request a window of the page around the chunk, as big as possible, so that the next reads in this page can be served by the cache.
+
+				ULONG windowEnd = _MIN_(PAGE_SIZE, pageOffset + maxTransfer);
+				ULONG windowStart = windowEnd > maxTransfer ? windowEnd - maxTransfer : 0;
+
+				Root::I->MemReadCor.WindowOffset = pageOffset - windowStart;
+
 				pState->ApiNumber = DbgKdReadVirtualMemoryApi;
 
 				pState->ReturnStatus = STATUS_PENDING;
 
-				pState->u.ReadMemory.TargetBaseAddress = (ULONG64)Root::I->MemReadCor.Pointer + Root::I->MemReadCor.BufferPos;
-				pState->u.ReadMemory.TransferCount = btr > _chunkSize_ ? _chunkSize_ : btr;
+				pState->u.ReadMemory.TargetBaseAddress = address - Root::I->MemReadCor.WindowOffset;
+				pState->u.ReadMemory.TransferCount = windowEnd - windowStart;
 				pState->u.ReadMemory.ActualBytesRead = 0;
 			}
 			break;
@@ -197,7 +238,7 @@ KdReceivePacket( // N.B. NTOSKRNL will call us at CLOCK_LEVEL when polling and a
 			case DEBST_CONTINUE:
 			default:
 			{
-				if (!Root::I->Trace)
+				if (!Root::I->Trace && !Root::I->HwDr7Set)
 				{
 					pState->ApiNumber = DbgKdContinueApi;
 					pState->ReturnStatus = DBG_CONTINUE; // DBG_EXCEPTION_HANDLED
@@ -210,16 +251,24 @@ KdReceivePacket( // N.B. NTOSKRNL will call us at CLOCK_LEVEL when polling and a
 					pState->ReturnStatus = DBG_CONTINUE;
 
 					pState->u.Continue2.ContinueStatus = DBG_CONTINUE;
-					pState->u.Continue2.AnyControlSet._6432_(Amd64ControlSet, X86ControlSet).TraceFlag = TRUE;
+					pState->u.Continue2.AnyControlSet._6432_(Amd64ControlSet, X86ControlSet).TraceFlag = Root::I->Trace;
+					pState->u.Continue2.AnyControlSet._6432_(Amd64ControlSet, X86ControlSet).Dr7 = (ULONG_PTR)Root::I->HwDr7; // KD sets it on all the processors and clears DR6.
 				}
 
 				Root::I->Trace = FALSE;
 
+				Root::I->ReadCache.InvalidateAll(); // the OS can change any page from now on.
+				Root::I->MemReadCor.TransferMax = 0; // learned again at the next state change, from its own short responses.
+				Root::I->VadSnapshots.clear();
+				Root::I->CurrentEprocess = 0;
+				Root::I->DisasmWindow.boundaries.Resume();
+
 				Root::I->VideoRestoreBufferTimer = __rdtsc();
 			}
 			break;
 			}
 
+			Root::I->KdEvents.Add(FALSE, PacketType, pState->ApiNumber, SecondBuffer);
 			return KD_RECV_CODE_OK;
 		}
 	}
@@ -229,7 +278,7 @@ KdReceivePacket( // N.B. NTOSKRNL will call us at CLOCK_LEVEL when polling and a
 	return KD_RECV_CODE_TIMEOUT;
 }
 
-extern "C" static VOID
+KD_HOOK_LINKAGE VOID
 __stdcall
 KdSendPacket(
 	__in ULONG PacketType,
@@ -244,27 +293,53 @@ KdSendPacket(
 		{
 			DBGKD_MANIPULATE_STATE64* pState = (DBGKD_MANIPULATE_STATE64*)FirstBuffer->pData;
 
+			Root::I->KdEvents.Add(TRUE, PacketType, pState->ApiNumber, SecondBuffer);
+
+			Root::I->Perf_KdRoundTripsNum++;
+
+			if (pState->ApiNumber >= DbgKdMinimumManipulate && pState->ApiNumber < DbgKdMaximumManipulate)
+				Root::I->Perf_KdRoundTripsByApi[pState->ApiNumber - DbgKdMinimumManipulate]++;
+
 			if (Root::I->DebuggerState == DEBST_COROUTINE)
 			{
-				if (!::strcmp(Root::I->AwaiterPtr->function, "BcAwaiter_StateManipulate"))
-				{
-					BcAwaiter_StateManipulate* ptr = (BcAwaiter_StateManipulate*)Root::I->AwaiterPtr;
-					ptr->retVal = ptr->processResponse(pState, SecondBuffer);
-				}
+				if (Root::I->AwaiterPtr)
+					const_cast<BcAwaiterBase*>(Root::I->AwaiterPtr)->Complete(pState, SecondBuffer);
 			}
 			else if (pState->ApiNumber == DbgKdReadVirtualMemoryApi && Root::I->DebuggerState == DEBST_MEMREADCOR)
 			{
 				if (NT_SUCCESS(pState->ReturnStatus) &&
 					SecondBuffer->pData && SecondBuffer->Length > 0 &&
-					pState->u.ReadMemory.ActualBytesRead == SecondBuffer->Length)
+					pState->u.ReadMemory.ActualBytesRead == SecondBuffer->Length &&
+					SecondBuffer->Length <= PAGE_SIZE)
 				{
-					::memcpy(Root::I->MemReadCor.Buffer + Root::I->MemReadCor.BufferPos, SecondBuffer->pData, SecondBuffer->Length);
+					// the response contains the requested window of the page: store it in the cache and copy the chunk in the buffer.
+
+					Root::I->ReadCache.Store(
+						(ULONG64)Root::I->MemReadCor.Pointer + Root::I->MemReadCor.BufferPos - Root::I->MemReadCor.WindowOffset,
+						SecondBuffer->pData, SecondBuffer->Length);
+
+					// a successful short response: the kernel has a smaller packet buffer than expected, so the next windows are made smaller.
+
+					if (SecondBuffer->Length < pState->u.ReadMemory.TransferCount)
+						Root::I->MemReadCor.TransferMax = SecondBuffer->Length;
+
+					if (SecondBuffer->Length <= Root::I->MemReadCor.WindowOffset)
+					{
+						Root::I->MemReadCor.ActualBytesRead = Root::I->MemReadCor.BufferPos;
+						Root::I->MemReadCor.RetryChunk = TRUE;
+					}
+					else
+					{
+						ULONG len = _MIN_(Root::I->MemReadCor.ChunkSize, SecondBuffer->Length - Root::I->MemReadCor.WindowOffset); // the kernel may return less bytes than requested.
+
+						::memcpy(Root::I->MemReadCor.Buffer + Root::I->MemReadCor.BufferPos, (BYTE*)SecondBuffer->pData + Root::I->MemReadCor.WindowOffset, len);
 
-					Root::I->MemReadCor.ActualBytesRead = SecondBuffer->Length;
+						Root::I->MemReadCor.ActualBytesRead = Root::I->MemReadCor.BufferPos + len;
+					}
 				}
 				else
 				{
-					Root::I->MemReadCor.ActualBytesRead = 0;
+					Root::I->MemReadCor.ActualBytesRead = Root::I->MemReadCor.BufferPos;
 				}
 			}
 		}
@@ -276,6 +351,8 @@ KdSendPacket(
 	{
 		Root::I->StateChange = *(DBGKD_ANY_WAIT_STATE_CHANGE*)FirstBuffer->pData;
 
+		Root::I->KdEvents.Add(TRUE, PacketType, Root::I->StateChange.NewState, SecondBuffer);
+
 		Root::I->DebuggerState = DEBST_STATE_CHANGED;
 	}
 
@@ -291,17 +368,7 @@ KdSendPacket(
 			debugIo->u.PrintString.LengthOfString <= SecondBuffer->Length)
 		{
 			if (Root::I)
-			{
-				eastl::string s((CHAR*)SecondBuffer->pData, debugIo->u.PrintString.LengthOfString);
-
-				for (int i = 0; i < s.size(); i++)
-					if (s[i] < 32)
-						s[i] = ' ';
-					else if (s[i] >= 128)
-						s[i] = '?';
-
-				Root::I->LogWindow.AddString(s.c_str());
-			}
+				Root::I->DbgPrints.Push((CHAR*)SecondBuffer->pData, debugIo->u.PrintString.LengthOfString); // the message is added to the log window when the debugger UI is shown.
 		}
 	}
 
@@ -418,9 +485,9 @@ static VOID PatchKdCom()
 			Root::I->KdSendPacketFp = new FunctionPatch();
 			Root::I->KdReceivePacketFp = new FunctionPatch();
 
-			if (!Root::I->KdSendPacketFp->Patch(pfSend, KdSendPacket))
+			if (!Root::I->KdSendPacketFp->Patch(pfSend, (VOID*)KdSendPacket))
 				::ReportInitError(BcInitError_PatchKdCom_FunctionPatch_Patch_KdSendPacket_Failed, "PatchKdCom::FunctionPatch::Patch of KdSendPacket failed.");
-			if (!Root::I->KdReceivePacketFp->Patch(pfRecv, KdReceivePacket))
+			if (!Root::I->KdReceivePacketFp->Patch(pfRecv, (VOID*)KdReceivePacket))
 				::ReportInitError(BcInitError_PatchKdCom_FunctionPatch_Patch_KdReceivePacket_Failed, "PatchKdCom::FunctionPatch::Patch of KdReceivePacket failed.");
 		}
 	}
@@ -489,7 +556,7 @@ static NTSTATUS DrvDispatchIoctl(IN PDEVICE_OBJECT DeviceObject, IN PIRP Irp)
 			{
 				ULONGLONG* p = (ULONGLONG*)mem;
 
-				for (int i = 0; i < in->size; i += sizeof(in->pattern), p++)
+				for (int i = 0; (ULONGLONG)i < in->size; i += sizeof(in->pattern), p++)
 				{
 					if ((*p & in->mask) == in->pattern)
 					{
@@ -626,6 +693,8 @@ static VOID DrvUnload(PDRIVER_OBJECT  DriverObject)
 
 //
 
+#ifndef BC_HOSTSIM // on the host, the static initializers are run by the C library.
+
 #define _CRTALLOC(x) __declspec(allocate(x))
 
 typedef void (__cdecl* _PVFV)(void);
@@ -638,6 +707,8 @@ extern _CRTALLOC(".CRT$XCZ") _PVFV __xc_z[] = { NULL };
 
 #pragma comment(linker, "/merge:.CRT=.rdata")
 
+#endif
+
 //
 
 CHAR BcVersion[256] = "";
@@ -652,6 +723,7 @@ extern "C" NTSTATUS DriverEntry(PDRIVER_OBJECT  pDriverObject, PUNICODE_STRING
 
 	// execute static initialization routines. >>> WARNING <<< we support only construction, not destruction!
 
+#ifndef BC_HOSTSIM
 	_PVFV* pfbegin = __xc_a;
 	_PVFV* pfend = __xc_z;
 
@@ -661,6 +733,7 @@ extern "C" NTSTATUS DriverEntry(PDRIVER_OBJECT  pDriverObject, PUNICODE_STRING
 			(**pfbegin)();
 		++pfbegin;
 	}
+#endif
 
 	// free Cmds memory before returning from this fn.
 
@@ -801,9 +874,10 @@ extern "C" NTSTATUS DriverEntry(PDRIVER_OBJECT  pDriverObject, PUNICODE_STRING
 
 					if (!result.size())
 					{
-						// create a snapshot of all the user modules in the system and install the notify routines.
+						// create a snapshot of all the user modules in the system (and of the unwind info of the kernel modules) and install the notify routines.
 
 						Platform::GetModulesSnapshot();
+						Platform::GetKernelUnwindSnapshot(pDriverObject);
 
 						Root::I->ProcessNotifyCreated = ::PsSetCreateProcessNotifyRoutine(&Platform::CreateProcessNotifyRoutine, FALSE) == STATUS_SUCCESS;
 						Root::I->ImageNotifyCreated = ::PsSetLoadImageNotifyRoutine(&Platform::LoadImageNotifyRoutine) == STATUS_SUCCESS;
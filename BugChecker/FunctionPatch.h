@@ -39,6 +39,7 @@ private:
             m_pPointer = MmMapLockedPagesSpecifyCache(m_pMdl, KernelMode, MmNonCached, NULL, FALSE, NormalPagePriority);
             NTSTATUS status = MmProtectMdlSystemAddress(m_pMdl, PAGE_EXECUTE_READWRITE);
             ASSERT(NT_SUCCESS(status));
+            UNREFERENCED_PARAMETER(status); // ASSERT is empty in the release builds.
         }
 
         //! Destroys the additional read-write mapping
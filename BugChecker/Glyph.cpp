@@ -108,7 +108,7 @@ void Glyph::DrawStr(IN const CHAR* pcStr, IN BYTE bTextColor, IN ULONG ulX, IN U
 	if (!pvPrimary || (_6432_(ULONG64, ULONG32))pvPrimary == 0x1)
 		return;
 
-	for (int i = 0; i < ::strlen(pcStr); i++, ulX++)
+	for (int i = 0; i < (int)::strlen(pcStr); i++, ulX++)
 		Glyph::Draw(pcStr[i], bTextColor, ulX, ulY, pvPrimary);
 }
 
@@ -303,7 +303,7 @@ VOID Glyph::UpdateScreen(ULONG x, ULONG y, ULONG w, ULONG h) // WARNING: caller
 		if (fifo[SVGA_FIFO_NEXT_CMD] == fifo[SVGA_FIFO_MAX] - 4)
 			fifo[SVGA_FIFO_NEXT_CMD] = fifo[SVGA_FIFO_MIN];
 		else
-			fifo[SVGA_FIFO_NEXT_CMD] += 4;
+			fifo[SVGA_FIFO_NEXT_CMD] = fifo[SVGA_FIFO_NEXT_CMD] + 4;
 	};
 
 	// try to avoid race conditions with the Guest's virtual device driver.
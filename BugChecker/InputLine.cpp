@@ -9,12 +9,12 @@
 VOID InputLine::AddChar(CHAR c)
 {
 	LONG pos = (Root::I->CursorX - 2) + offset;
-	if (pos > text.size())
+	if ((size_t)pos > text.size())
 		return;
 
 	text.insert(pos, 1, c);
 
-	if (Root::I->CursorX < Root::I->WndWidth - 2)
+	if (Root::I->CursorX < (LONG)Root::I->WndWidth - 2)
 		Wnd::ChangeCursorX(Root::I->CursorX + 1);
 	else
 		offset++;
@@ -94,10 +94,10 @@ VOID InputLine::Left()
 VOID InputLine::Right()
 {
 	LONG pos = (Root::I->CursorX - 2) + offset;
-	if (pos >= text.size())
+	if ((size_t)pos >= text.size())
 		return;
 
-	if (Root::I->CursorX < Root::I->WndWidth - 2)
+	if (Root::I->CursorX < (LONG)Root::I->WndWidth - 2)
 		Wnd::ChangeCursorX(Root::I->CursorX + 1);
 	else
 		offset++;
@@ -108,7 +108,7 @@ VOID InputLine::Right()
 VOID InputLine::Del()
 {
 	LONG pos = (Root::I->CursorX - 2) + offset;
-	if (pos >= text.size())
+	if ((size_t)pos >= text.size())
 		return;
 
 	text.erase(pos, 1);
@@ -131,7 +131,7 @@ VOID InputLine::End()
 
 	LONG x = text.size() + 2;
 
-	if (x > Root::I->WndWidth - 2)
+	if (x > (LONG)Root::I->WndWidth - 2)
 	{
 		x = Root::I->WndWidth - 2;
 		offset = text.size() - (Root::I->WndWidth - 4);
@@ -146,15 +146,15 @@ VOID InputLine::Up()
 {
 	LONG i = historyPos;
 
-	if (i < 0 || i >= Root::I->LogWindow.contents.size())
-		i = Root::I->LogWindow.contents.size();
+	if (i < 0 || i >= (LONG)Root::I->LogWindow.lines.Size())
+		i = Root::I->LogWindow.lines.Size();
 
 	for (i--; i >= 0; i--)
 	{
-		auto& s = Root::I->LogWindow.contents[i];
-		if (s.size() > 2 && s[0] == '\r' && s[1] == ':')
+		const CHAR* s = Root::I->LogWindow.lines.Get(i);
+		if (Root::I->LogWindow.lines.Len(i) > 2 && s[0] == '\r' && s[1] == ':')
 		{
-			text = s.substr(2);
+			text = s + 2;
 			End();
 			historyPos = i;
 			return;
@@ -166,15 +166,15 @@ VOID InputLine::Down()
 {
 	LONG i = historyPos;
 
-	if (i < 0 || i >= Root::I->LogWindow.contents.size())
+	if (i < 0 || i >= (LONG)Root::I->LogWindow.lines.Size())
 		return;
 
-	for (i++; i < Root::I->LogWindow.contents.size(); i++)
+	for (i++; i < (LONG)Root::I->LogWindow.lines.Size(); i++)
 	{
-		auto& s = Root::I->LogWindow.contents[i];
-		if (s.size() > 2 && s[0] == '\r' && s[1] == ':')
+		const CHAR* s = Root::I->LogWindow.lines.Get(i);
+		if (Root::I->LogWindow.lines.Len(i) > 2 && s[0] == '\r' && s[1] == ':')
 		{
-			text = s.substr(2);
+			text = s + 2;
 			End();
 			historyPos = i;
 			return;
@@ -217,12 +217,12 @@ VOID InputLine::Tab(BOOLEAN modifierKeyState)
 		return;
 
 	LONG pos = (Root::I->CursorX - 2) + offset;
-	if (pos > text.size())
+	if ((size_t)pos > text.size())
 		return;
 
 	if (!pos)
 		return;
-	else if (pos < text.size() && text[pos] != ' ')
+	else if ((size_t)pos < text.size() && text[pos] != ' ')
 		return;
 
 	// get the user word to search and complete.
@@ -283,7 +283,7 @@ VOID InputLine::Tab(BOOLEAN modifierKeyState)
 
 	LONG x = Root::I->CursorX + d;
 
-	if (x > Root::I->WndWidth - 2)
+	if (x > (LONG)Root::I->WndWidth - 2)
 	{
 		offset += x - (Root::I->WndWidth - 2);
 		x = Root::I->WndWidth - 2;
@@ -340,11 +340,11 @@ VOID InputLine::Finalize(BOOLEAN redrawWnds /*= TRUE*/)
 		{
 			eastl::sort(hints.begin(), hints.end());
 
-			for (int i = 0; i < hints.size(); i++)
+			for (int i = 0; i < (int)hints.size(); i++)
 			{
 				helpText += hints[i];
 
-				if (i != hints.size() - 1)
+				if (i != (int)hints.size() - 1)
 					helpText += ", ";
 			}
 		}
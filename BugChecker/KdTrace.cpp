@@ -0,0 +1,111 @@
+#include "KdTrace.h"
+
+#include "Root.h"
+
+VOID LatencyHistogram::Add(ULONG64 ticks)
+{
+	ULONG64 us = Root::I->RdtscTicksPerMs ? ticks * 1000 / Root::I->RdtscTicksPerMs : 0;
+
+	ULONG bucket = 0;
+
+	while (us && bucket < BucketsNum - 1)
+	{
+		us >>= 1;
+		bucket++;
+	}
+
+	buckets[bucket]++;
+	num++;
+	totalTicks += ticks;
+
+	if (ticks > maxTicks)
+		maxTicks = ticks;
+}
+
+VOID LatencyHistogram::Clear()
+{
+	*this = LatencyHistogram();
+}
+
+VOID LatencyHistogram::Format(CHAR* out, ULONG outSize) const
+{
+	::strcpy(out, "");
+
+	for (ULONG i = 0; i < BucketsNum; i++)
+	{
+		if (!buckets[i])
+			continue;
+
+		CHAR bucket[64];
+
+		if (i == BucketsNum - 1)
+			::sprintf(bucket, ">=%uus:%llu ", 1 << (i - 1), buckets[i]);
+		else
+			::sprintf(bucket, "<%uus:%llu ", 1 << i, buckets[i]);
+
+		if (::strlen(out) + ::strlen(bucket) >= outSize)
+			break;
+
+		::strcat(out, bucket);
+	}
+}
+
+VOID KdTrace::Add(BOOLEAN isSend, ULONG packetType, ULONG apiNumber, PKD_BUFFER SecondBuffer)
+{
+	Event& e = events[eventsNum++ & (EventsNum - 1)];
+
+	e.tsc = __rdtsc();
+	e.packetType = (USHORT)packetType;
+	e.apiNumber = (USHORT)apiNumber;
+	e.bytes = SecondBuffer && SecondBuffer->pData ? SecondBuffer->Length : 0;
+	e.isSend = isSend;
+	e.awaiterType = Root::I->AwaiterPtr ? const_cast<BcAwaiterBase*>(Root::I->AwaiterPtr)->GetType() : BcAwaiterType::None;
+
+	// measure the time taken by the kernel to process our request.
+
+	if (packetType == KdPacketType2_Ie_StateManipulate)
+	{
+		if (!isSend)
+			requestTsc = e.tsc;
+		else if (requestTsc)
+		{
+			RoundTrips.Add(e.tsc - requestTsc);
+			requestTsc = 0;
+		}
+	}
+}
+
+VOID KdTrace::Clear()
+{
+	eventsNum = 0;
+	requestTsc = 0;
+
+	RoundTrips.Clear();
+}
+
+VOID KdTrace::Format(CHAR* out, const Event& e, ULONG64 prevTsc)
+{
+	// tsc,delta,direction,packet type,api,bytes,awaiter
+
+	::sprintf(out, "%llu,%llu,%s,%u,%X,%u,%s",
+		e.tsc, prevTsc ? e.tsc - prevTsc : 0,
+		e.isSend ? "send" : "recv",
+		(ULONG)e.packetType, (ULONG)e.apiNumber, (ULONG)e.bytes,
+		GetAwaiterName(e.awaiterType));
+}
+
+const CHAR* KdTrace::GetAwaiterName(BcAwaiterType type)
+{
+	switch (type)
+	{
+	case BcAwaiterType::StateManipulate: return "StateManipulate";
+	case BcAwaiterType::RecvTimeout: return "RecvTimeout";
+	case BcAwaiterType::ReadMemory: return "ReadMemory";
+	case BcAwaiterType::ReadMemoryBatch: return "ReadMemoryBatch";
+	case BcAwaiterType::BreakPoints: return "BreakPoints";
+	case BcAwaiterType::Join: return "Join";
+	case BcAwaiterType::None: break;
+	}
+
+	return "None";
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "BugChecker.h"
+
+#include "BcCoroutine.h"
+
+class LatencyHistogram // log2 buckets of microseconds: bucket 0 is < 1us, bucket i is [2^(i-1), 2^i) us, the last bucket is open-ended.
+{
+public:
+
+	static constexpr ULONG BucketsNum = 24;
+
+	VOID Add(ULONG64 ticks);
+	VOID Clear();
+
+	VOID Format(CHAR* out, ULONG outSize) const; // only the non-empty buckets.
+
+	ULONG64 buckets[BucketsNum] = { 0 };
+	ULONG64 num = 0;
+	ULONG64 totalTicks = 0;
+	ULONG64 maxTicks = 0;
+};
+
+class KdTrace // ring of the packets exchanged with the kernel while the debugger is active: no locks are needed, since KD serializes the calls.
+{
+public:
+
+	static constexpr ULONG EventsNum = 4096; // must be a power of 2.
+
+	struct Event
+	{
+		ULONG64 tsc;
+		USHORT packetType;
+		USHORT apiNumber; // ApiNumber of the StateManipulate packets, NewState of the StateChange packets.
+		USHORT bytes; // size of the second buffer.
+		BYTE isSend; // FALSE: request returned by KdReceivePacket; TRUE: packet sent by the kernel through KdSendPacket.
+		BcAwaiterType awaiterType;
+	};
+
+	VOID Add(BOOLEAN isSend, ULONG packetType, ULONG apiNumber, PKD_BUFFER SecondBuffer); // the awaiter type is taken from Root::I->AwaiterPtr.
+	VOID Clear();
+
+	ULONG Size() const { return eventsNum < EventsNum ? (ULONG)eventsNum : EventsNum; }
+	const Event& Get(ULONG index) const { return events[(eventsNum - Size() + index) & (EventsNum - 1)]; } // 0 is the oldest event.
+
+	static VOID Format(CHAR* out, const Event& e, ULONG64 prevTsc); // one csv line per event.
+
+	static const CHAR* GetAwaiterName(BcAwaiterType type);
+
+	LatencyHistogram RoundTrips; // from the request returned by KdReceivePacket to the response in KdSendPacket.
+
+private:
+
+	Event events[EventsNum];
+	ULONG64 eventsNum = 0;
+
+	ULONG64 requestTsc = 0;
+};
@@ -13,8 +13,8 @@ VOID LogWnd::GoToEnd()
 
 	const ULONG winDim = destY1 - destY0 + 1;
 
-	if (contents.size() >= winDim)
-		posY = contents.size() - winDim;
+	if (lines.Size() >= winDim)
+		posY = lines.Size() - winDim;
 }
 
 VOID LogWnd::AddUserCmd(const CHAR* psz)
@@ -24,74 +24,52 @@ VOID LogWnd::AddUserCmd(const CHAR* psz)
 
 VOID LogWnd::AddString(const CHAR* psz, BOOLEAN doAppend /*= FALSE*/, BOOLEAN refreshUi /*= FALSE*/)
 {
-	auto prevStart0to99 = Allocator::Start0to99;
-	Allocator::Start0to99 = ALLOCATOR_START_0TO99_LOG;
-
-	auto allocStart = (LONG64)Allocator::Perf_TotalAllocatedSize;
+	eastl::string s = psz;
 
+	if (!doAppend)
 	{
-		eastl::string s = psz;
-
-		if (!doAppend)
-		{
-			if (!newLine)
-				while (contents.size() && !contents.back().size())
-					contents.pop_back();
+		if (!newLine)
+			while (lines.Size() && !lines.Len(lines.Size() - 1))
+				lines.PopBack();
 
-			if (s.size())
-				contents.push_back(eastl::move(s));
+		if (s.size())
+			lines.PushBack(s.c_str(), s.size());
 
-			newLine = TRUE;
-		}
-		else
-		{
-			for (CHAR& c : s)
-				if (c != '\n' && c != '\b' && (c < 32 || c >= 128))
-					c = '?';
+		newLine = TRUE;
+	}
+	else
+	{
+		for (CHAR& c : s)
+			if (c != '\n' && c != '\b' && ((BYTE)c < 32 || (BYTE)c >= 128))
+				c = '?';
 
-			auto v = Utils::Tokenize(s, "\n");
+		auto v = Utils::Tokenize(s, "\n");
 
-			BOOLEAN isFirst = TRUE;
+		BOOLEAN isFirst = TRUE;
 
-			for (auto& l : v)
+		for (auto& l : v)
+		{
+			if (newLine)
+				newLine = FALSE;
+			else if (isFirst)
 			{
-				if (newLine)
-					newLine = FALSE;
-				else if (isFirst)
+				if (lines.Size())
 				{
-					if (contents.size())
-					{
-						l = contents.back() + l;
-						contents.pop_back();
-					}
+					l = lines.Get(lines.Size() - 1) + l;
+					lines.PopBack();
 				}
-
-				for (CHAR& c : l)
-					if (c == '\b')
-						c = '\n';
-				
-				contents.push_back(eastl::move(l));
-
-				isFirst = FALSE;
 			}
-		}
-	}
 
-	allocSize += (LONG64)Allocator::Perf_TotalAllocatedSize - allocStart;
+			for (CHAR& c : l)
+				if (c == '\b')
+					c = '\n';
 
-	while (allocSize > LOG_WINDOW_CONTENTS_MAX_SIZE && contents.size())
-	{
-		allocStart = (LONG64)Allocator::Perf_TotalAllocatedSize;
+			lines.PushBack(l.c_str(), l.size());
 
-		{
-			contents.erase(contents.begin());
+			isFirst = FALSE;
 		}
-
-		allocSize += (LONG64)Allocator::Perf_TotalAllocatedSize - allocStart;
 	}
 
-	Allocator::Start0to99 = prevStart0to99;
-
 	// go to the end and refresh ui.
 
 	GoToEnd();
@@ -105,19 +83,23 @@ VOID LogWnd::AddString(const CHAR* psz, BOOLEAN doAppend /*= FALSE*/, BOOLEAN re
 
 VOID LogWnd::Clear()
 {
-	eastl::vector<eastl::string>().swap(contents);
-	allocSize = 0;
+	lines.Clear();
 	Home();
 }
 
+ULONG LogWnd::GetLinesNum()
+{
+	return lines.Size();
+}
+
 eastl::string LogWnd::GetLineToDraw(ULONG index)
 {
-	eastl::string s = contents[index];
+	const CHAR* psz = lines.Get(index);
 
-	if (s.size() && s[0] == '\r')
-		s = s.substr(1);
+	if (*psz == '\r')
+		psz++;
 
-	return s;
+	return psz;
 }
 
 VOID LogWnd::Left()
@@ -141,8 +123,8 @@ VOID LogWnd::Down()
 
 	ULONG maxPosY = 0;
 
-	if (contents.size() > winDim)
-		maxPosY = contents.size() - winDim;
+	if (lines.Size() > winDim)
+		maxPosY = lines.Size() - winDim;
 
 	posY++;
 
@@ -166,8 +148,8 @@ VOID LogWnd::PgDn()
 
 	ULONG maxPosY = 0;
 
-	if (contents.size() > winDim)
-		maxPosY = contents.size() - winDim;
+	if (lines.Size() > winDim)
+		maxPosY = lines.Size() - winDim;
 
 	posY += winDim;
 
@@ -184,3 +166,68 @@ VOID LogWnd::End()
 {
 	GoToEnd();
 }
+
+VOID LogLines::PushBack(const CHAR* psz, ULONG len)
+{
+	if (len > MaxLineLen)
+		len = MaxLineLen;
+
+	// a line is never split between two pages: if it doesn't fit, move to the next page, evicting the oldest lines stored there.
+
+	if (currPageUsed + len + 1 > PageSize)
+	{
+		currPage = (currPage + 1) % PagesNum;
+		currPageUsed = 0;
+
+		while (linesNum && lines[firstLine].offset / PageSize == currPage)
+			PopFront();
+	}
+
+	if (linesNum == MaxLinesNum)
+		PopFront();
+
+	// copy the line in the arena.
+
+	ULONG offset = currPage * PageSize + currPageUsed;
+
+	::memcpy(&arena[offset], psz, len);
+	arena[offset + len] = 0;
+
+	currPageUsed += len + 1;
+
+	lines[(firstLine + linesNum) % MaxLinesNum] = { offset, len };
+	linesNum++;
+}
+
+VOID LogLines::PopBack()
+{
+	if (!linesNum)
+		return;
+
+	linesNum--;
+
+	// if the line is the last one in the current page, give back its space.
+
+	const Line& line = lines[(firstLine + linesNum) % MaxLinesNum];
+
+	if (line.offset / PageSize == currPage)
+		currPageUsed = line.offset % PageSize;
+}
+
+VOID LogLines::PopFront()
+{
+	if (!linesNum)
+		return;
+
+	firstLine = (firstLine + 1) % MaxLinesNum;
+	linesNum--;
+}
+
+VOID LogLines::Clear()
+{
+	firstLine = 0;
+	linesNum = 0;
+
+	currPage = 0;
+	currPageUsed = 0;
+}
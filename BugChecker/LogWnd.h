@@ -4,6 +4,44 @@
 
 #include "Wnd.h"
 
+#define LOG_WINDOW_CONTENTS_MAX_SIZE (1*1024*1024)
+
+class LogLines // ring buffer of lines, stored in fixed-size pages of a single arena: O(1) append, evict and random access.
+{
+public:
+
+	static constexpr ULONG PageSize = 4 * 1024;
+	static constexpr ULONG PagesNum = LOG_WINDOW_CONTENTS_MAX_SIZE / PageSize;
+	static constexpr ULONG MaxLineLen = PageSize - 1;
+	static constexpr ULONG MaxLinesNum = 32 * 1024;
+
+	ULONG Size() const { return linesNum; }
+	const CHAR* Get(ULONG index) const { return (const CHAR*)&arena[lines[(firstLine + index) % MaxLinesNum].offset]; }
+	ULONG Len(ULONG index) const { return lines[(firstLine + index) % MaxLinesNum].len; }
+
+	VOID PushBack(const CHAR* psz, ULONG len);
+	VOID PopBack();
+	VOID PopFront();
+	VOID Clear();
+
+private:
+
+	struct Line
+	{
+		ULONG offset;
+		ULONG len;
+	};
+
+	BYTE arena[PagesNum * PageSize];
+	Line lines[MaxLinesNum];
+
+	ULONG firstLine = 0;
+	ULONG linesNum = 0;
+
+	ULONG currPage = 0;
+	ULONG currPageUsed = 0;
+};
+
 class LogWnd : public Wnd
 {
 public:
@@ -25,11 +63,12 @@ public:
 	VOID Home();
 	VOID End();
 
+	virtual ULONG GetLinesNum();
 	virtual eastl::string GetLineToDraw(ULONG index);
 
+	LogLines lines;
+
 private:
 
 	BOOLEAN newLine = TRUE;
-
-	LONG64 allocSize = 0;
 };
@@ -0,0 +1,381 @@
+#include "Logpoint.h"
+
+#include "Root.h"
+#include "X86Step.h"
+#include "Utils.h"
+#include "CrtFill.h"
+
+static VOID SkipSpaces(const CHAR*& p)
+{
+	while (*p == ' ' || *p == '\t')
+		p++;
+}
+
+static BOOLEAN IsIdentChar(CHAR c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+BOOLEAN Logpoint::Compile(const CHAR* format, const eastl::vector<eastl::string>& args, BYTE* context, eastl::string& error)
+{
+	ops.clear();
+	strings.clear();
+
+	compileContext = context;
+
+	ULONG argIndex = 0;
+
+	const CHAR* p = format;
+
+	while (*p)
+	{
+		// literal text, up to the next spec ("%%" is a literal '%').
+
+		ULONG textIndex = strings.size();
+
+		while (*p && (*p != '%' || p[1] == '%'))
+		{
+			strings.push_back(*p);
+			p += *p == '%' ? 2 : 1;
+		}
+
+		if (strings.size() != textIndex)
+			Emit(OpCode::Text, strings.size() - textIndex, 0, textIndex);
+
+		if (!*p)
+			break;
+
+		// parse the spec: %[flags][width](x|X|d|u|p|c).
+
+		eastl::string spec = "%";
+
+		p++;
+
+		while (*p == '-' || *p == '0' || *p == '+' || *p == ' ' || *p == '#')
+			spec.push_back(*p++);
+
+		ULONG width = 0;
+
+		while (*p >= '0' && *p <= '9')
+		{
+			width = width * 10 + (*p - '0');
+			spec.push_back(*p++);
+
+			if (width > MaxWidth) // the values are formatted in a small buffer at each hit.
+			{
+				error = "Field width too large (max " + Utils::I64ToString(MaxWidth) + ").";
+				return FALSE;
+			}
+		}
+
+		CHAR conv = *p;
+
+		if (conv != 'x' && conv != 'X' && conv != 'd' && conv != 'u' && conv != 'p' && conv != 'c')
+		{
+			error = "Invalid format specifier.";
+			return FALSE;
+		}
+
+		p++;
+
+		if (conv == 'p')
+			spec = "p";
+		else if (conv == 'c')
+			spec += "c";
+		else
+			spec += eastl::string("ll") + conv;
+
+		// compile the argument.
+
+		if (argIndex >= args.size())
+		{
+			error = "Too few arguments for the format.";
+			return FALSE;
+		}
+
+		const CHAR* a = args[argIndex++].c_str();
+		ULONG depth = 0;
+
+		if (!ParseExpr(a, depth, error))
+			return FALSE;
+
+		SkipSpaces(a);
+
+		if (*a)
+		{
+			error = "Syntax error in argument " + Utils::I64ToString(argIndex) + ".";
+			return FALSE;
+		}
+
+		ULONG index = strings.size();
+
+		strings += spec;
+		strings.push_back(0);
+
+		Emit(OpCode::Value, 0, 0, index);
+	}
+
+	if (argIndex != args.size())
+	{
+		error = "Too many arguments for the format.";
+		return FALSE;
+	}
+
+	if (!ops.size())
+		Emit(OpCode::Text);
+
+	return TRUE;
+}
+
+BOOLEAN Logpoint::ParseExpr(const CHAR*& p, ULONG& depth, eastl::string& error) // expr := term { ('+'|'-') term }
+{
+	if (!ParseTerm(p, depth, error))
+		return FALSE;
+
+	while (TRUE)
+	{
+		SkipSpaces(p);
+
+		CHAR c = *p;
+
+		if (c != '+' && c != '-')
+			return TRUE;
+
+		p++;
+
+		if (!ParseTerm(p, depth, error))
+			return FALSE;
+
+		Emit(c == '+' ? OpCode::Add : OpCode::Sub);
+		depth--;
+	}
+}
+
+BOOLEAN Logpoint::ParseTerm(const CHAR*& p, ULONG& depth, eastl::string& error) // term := factor { '*' factor }
+{
+	if (!ParseFactor(p, depth, error))
+		return FALSE;
+
+	while (TRUE)
+	{
+		SkipSpaces(p);
+
+		if (*p != '*')
+			return TRUE;
+
+		p++;
+
+		if (!ParseFactor(p, depth, error))
+			return FALSE;
+
+		Emit(OpCode::Mul);
+		depth--;
+	}
+}
+
+BOOLEAN Logpoint::ParseFactor(const CHAR*& p, ULONG& depth, eastl::string& error) // factor := number | register | [byte|word|dword|qword] '[' expr ']' | '(' expr ')'
+{
+	SkipSpaces(p);
+
+	// parse the identifier, if present: a size or a register.
+
+	eastl::string ident;
+
+	while (IsIdentChar(*p))
+		ident.push_back(*p++);
+
+	BYTE size = 0;
+
+	if (ident.size())
+	{
+		if (Utils::AreStringsEqualI(ident.c_str(), "byte")) size = 1;
+		else if (Utils::AreStringsEqualI(ident.c_str(), "word")) size = 2;
+		else if (Utils::AreStringsEqualI(ident.c_str(), "dword")) size = 4;
+		else if (Utils::AreStringsEqualI(ident.c_str(), "qword")) size = 8;
+
+		SkipSpaces(p);
+
+		if (size && *p != '[')
+		{
+			error = "'[' expected after '" + ident + "'.";
+			return FALSE;
+		}
+	}
+
+	if (ident.size() && !size)
+	{
+		if (ident[0] >= '0' && ident[0] <= '9') // number: hex if it starts with 0x, otherwise decimal.
+		{
+			const CHAR* n = ident.c_str();
+			BOOLEAN hex = n[0] == '0' && (n[1] == 'x' || n[1] == 'X');
+
+			CHAR* end = NULL;
+			ULONG64 imm = ::BC_strtoui64(hex ? n + 2 : n, &end, hex ? 16 : 10);
+
+			if (*end || (hex && !n[2]))
+			{
+				error = "Invalid number '" + ident + "'.";
+				return FALSE;
+			}
+
+			Emit(OpCode::Imm, imm);
+		}
+		else
+		{
+			ZydisRegister reg = X86Step::StringToZydisReg(ident.c_str());
+
+			size_t sz = 0;
+
+			if (reg == ZYDIS_REGISTER_NONE ||
+				!X86Step::ZydisRegToCtxRegValuePtr((CONTEXT*)compileContext, reg, &sz) ||
+				!sz || sz > sizeof(ULONG64))
+			{
+				error = "Invalid register name '" + ident + "'.";
+				return FALSE;
+			}
+
+			Emit(OpCode::Reg, 0, (BYTE)sz, 0, reg);
+		}
+
+		if (++depth > MaxStackDepth)
+		{
+			error = "Expression too complex.";
+			return FALSE;
+		}
+
+		return TRUE;
+	}
+
+	// parse the memory read or the parenthesized expression.
+
+	CHAR open = *p;
+	CHAR close = open == '[' ? ']' : ')';
+
+	if (open != '[' && open != '(')
+	{
+		error = "Syntax error.";
+		return FALSE;
+	}
+
+	p++;
+
+	if (!ParseExpr(p, depth, error))
+		return FALSE;
+
+	SkipSpaces(p);
+
+	if (*p != close)
+	{
+		error = eastl::string("'") + close + "' expected.";
+		return FALSE;
+	}
+
+	p++;
+
+	if (open == '[')
+		Emit(OpCode::Read, 0, size);
+
+	return TRUE;
+}
+
+BcCoroutine Logpoint::Run(BYTE* context, BOOLEAN is32bitCompat) noexcept
+{
+	static CHAR line[DbgPrintRing::MaxMsgLen + 1];
+	ULONG len = 0;
+
+	ULONG64 stack[MaxStackDepth];
+	ULONG sp = 0;
+
+	BOOLEAN failed = FALSE; // a memory read of the current value failed.
+
+	ULONG ptrSize = _6432_(is32bitCompat ? 4 : 8, 4);
+
+	auto append = [&](const CHAR* psz, ULONG n) {
+
+		n = _MIN_(n, DbgPrintRing::MaxMsgLen - len);
+
+		::memcpy(line + len, psz, n);
+		len += n;
+	};
+
+	for (const Op& op : ops)
+	{
+		switch (op.code)
+		{
+		case OpCode::Imm:
+			stack[sp++] = op.imm;
+			break;
+
+		case OpCode::Reg:
+		{
+			size_t sz = 0;
+			VOID* preg = X86Step::ZydisRegToCtxRegValuePtr((CONTEXT*)context, op.reg, &sz);
+
+			ULONG64 value = 0;
+
+			if (preg)
+				::memcpy(&value, preg, _MIN_(sz, sizeof(value)));
+
+			stack[sp++] = value;
+		}
+		break;
+
+		case OpCode::Add: sp--; stack[sp - 1] += stack[sp]; break;
+		case OpCode::Sub: sp--; stack[sp - 1] -= stack[sp]; break;
+		case OpCode::Mul: sp--; stack[sp - 1] *= stack[sp]; break;
+
+		case OpCode::Read:
+		{
+			ULONG size = op.size ? op.size : ptrSize;
+			ULONG64 value = 0;
+
+			if (!failed)
+			{
+				VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)stack[sp - 1], size };
+
+				if (ptr)
+					::memcpy(&value, ptr, size);
+				else
+					failed = TRUE;
+			}
+
+			stack[sp - 1] = value;
+		}
+		break;
+
+		case OpCode::Text:
+			append(strings.c_str() + op.index, (ULONG)op.imm);
+			break;
+
+		case OpCode::Value:
+		{
+			CHAR text[32]; // MaxWidth + sign and digits of a 64-bit value.
+			const CHAR* spec = strings.c_str() + op.index;
+
+			ULONG64 value = stack[--sp];
+
+			if (failed)
+				::strcpy(text, "?");
+			else if (spec[0] == 'p')
+				::sprintf(text, "%0*llX", ptrSize * 2, value);
+			else if (spec[::strlen(spec) - 1] == 'c')
+				::sprintf(text, spec, (int)(CHAR)value);
+			else
+				::sprintf(text, spec, value);
+
+			append(text, ::strlen(text));
+
+			failed = FALSE;
+		}
+		break;
+		}
+	}
+
+	// the line is shown in the log window with the DbgPrint messages.
+
+	Root::I->DbgPrints.Push(line, len);
+
+	Perf_HitsNum++;
+
+	co_return;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "BugChecker.h"
+
+#include "BcCoroutine.h"
+
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+
+class Logpoint // declarative logpoint set by BPL: the format and its arguments are compiled into a tiny stack machine, run at each hit without QuickJS.
+{
+public:
+
+	static constexpr ULONG MaxStackDepth = 16;
+	static constexpr ULONG MaxWidth = 20; // of a value spec.
+
+	BOOLEAN Compile(const CHAR* format, const eastl::vector<eastl::string>& args, BYTE* context, eastl::string& error); // the context is used to validate the register names.
+	BcCoroutine Run(BYTE* context, BOOLEAN is32bitCompat) noexcept; // formats the line and pushes it to the DbgPrint ring.
+
+	BOOLEAN IsSet() const { return ops.size() != 0; }
+
+	ULONG64 Perf_HitsNum = 0;
+
+private:
+
+	enum class OpCode : BYTE
+	{
+		Imm, // push imm.
+		Reg, // push the register "reg".
+		Add,
+		Sub,
+		Mul,
+		Read, // pop an address, push "size" bytes read from it (0: pointer size).
+		Text, // print "imm" characters of "strings", starting at "index".
+		Value // pop a value and print it with the spec in "strings", starting at "index".
+	};
+
+	struct Op
+	{
+		OpCode code;
+		BYTE size;
+		ULONG index;
+		ZydisRegister reg;
+		ULONG64 imm;
+	};
+
+	BOOLEAN ParseExpr(const CHAR*& p, ULONG& depth, eastl::string& error);
+	BOOLEAN ParseTerm(const CHAR*& p, ULONG& depth, eastl::string& error);
+	BOOLEAN ParseFactor(const CHAR*& p, ULONG& depth, eastl::string& error);
+
+	VOID Emit(OpCode code, ULONG64 imm = 0, BYTE size = 0, ULONG index = 0, ZydisRegister reg = ZYDIS_REGISTER_NONE) { ops.push_back({ code, size, index, reg, imm }); }
+
+	eastl::vector<Op> ops;
+	eastl::string strings; // the literal text and the value specs (NUL terminated).
+
+	BYTE* compileContext = NULL;
+};
@@ -7,6 +7,8 @@
 #include "Utils.h"
 #include "QuickJSCppInterface.h"
 
+#include <EASTL/sort.h>
+
 #ifdef _AMD64_
 extern "C" VOID Amd64_sgdt(BYTE * dest);
 #endif
@@ -21,6 +23,12 @@ BcCoroutine Main::EntryPoint() noexcept
 
 	Root::I->BpHitIndex = -1;
 
+	Root::I->Perf_BreakInsNum++;
+
+	// move the DbgPrint messages received while the system was running to the log window.
+
+	Root::I->DbgPrints.Drain(Root::I->LogWindow);
+
 	// make sure that the PsLoadedModuleList pointer is not null.
 
 	if (!Root::I->PsLoadedModuleList)
@@ -106,6 +114,7 @@ BcCoroutine Main::EntryPoint() noexcept
 	BOOLEAN updateContext = FALSE;
 	BOOLEAN deleteAllBreakPoints = FALSE;
 	BOOLEAN regsWndInvOld = FALSE;
+	BreakPoint* hwBp = NULL;
 
 	if (Root::I->StateChange.NewState == DbgKdExceptionStateChange)
 	{
@@ -139,12 +148,24 @@ BcCoroutine Main::EntryPoint() noexcept
 		else if (Root::I->StateChange.u.Exception.ExceptionRecord.ExceptionCode == STATUS_SINGLE_STEP || _6432_(Root::I->StateChange.u.Exception.ExceptionRecord.ExceptionCode == STATUS_WX86_SINGLE_STEP, FALSE))
 		{
 			ULONG64 pc = ((CONTEXT*)Context)->_6432_(Rip, Eip);
-			
-			if (BpTrace::Get().nextAddr == pc)
+
+			// is it a hardware breakpoint? B0-B3 in DR6 tell which debug register was hit.
+
+			ULONG64 dr6 = Root::I->StateChange.AnyControlReport._6432_(Amd64ControlReport, X86ControlReport).Dr6;
+
+			hwBp = Root::I->BreakPoints.FindHw(dr6);
+
+			// was it (also) a single step? BS in DR6 is set by the trap flag. The conditions of the hardware breakpoint are checked below.
+
+			BOOLEAN stepped = !hwBp || (dr6 & 0x4000);
+
+			if (stepped && BpTrace::Get().nextAddr == pc)
 			{
 				BpTrace::Get().nextAddr = 0;
+
+				Root::I->Perf_BpRearmStepsNum++;
 			}
-			else
+			else if (stepped)
 			{
 				breakIn = !Root::I->StepOutThread;
 			}
@@ -155,25 +176,34 @@ BcCoroutine Main::EntryPoint() noexcept
 
 	if (deleteAllBreakPoints)
 	{
+		eastl::vector<BcBreakPointOp> ops;
+
 		for (BreakPoint& bp : Root::I->BreakPoints)
-		{
 			if (bp.handle)
-				co_await BcAwaiter_StateManipulate{
-				[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+				ops.push_back({ bp.address, bp.handle, TRUE, FALSE });
 
-					pState->ApiNumber = DbgKdRestoreBreakPointApi;
+		if (ops.size())
+			co_await BcAwaiter_BreakPoints{ ops.data(), ops.size() };
 
-					pState->ReturnStatus = STATUS_PENDING;
+		ULONG hwBpsNum = 0;
 
-					pState->u.RestoreBreakPoint.BreakPointHandle = bp.handle;
-				},
-				[](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+		for (BreakPoint& bp : Root::I->BreakPoints)
+		{
+			QuickJSCppInterface::FreeCompiled(bp.whenFn);
 
-					return pState->ApiNumber == DbgKdRestoreBreakPointApi && NT_SUCCESS(pState->ReturnStatus);
-				} };
+			if (bp.drIndex >= 0)
+				hwBpsNum++;
 		}
 
 		Root::I->BreakPoints.clear();
+
+		hwBp = NULL;
+
+		if (hwBpsNum)
+		{
+			BOOLEAN res = FALSE;
+			co_await BcAwaiter_Join{ Cmd::WriteDebugRegisters(res) };
+		}
 	}
 
 	// disassemble the current instruction at PC, getting the PC of the next instruction.
@@ -196,149 +226,124 @@ BcCoroutine Main::EntryPoint() noexcept
 
 	ULONG64 currPc = ((CONTEXT*)Context)->_6432_(Rip, Eip);
 
-	for (BreakPoint& bp : Root::I->BreakPoints)
-	{
-		if (bp.address == prevBpTraceAddr || (bp.address > currPc - 64 && bp.address < currPc + 64))
-		{
-			if (bp.address == currPc)
-			{
-				bp.handle = 0; // bps at PC are deleted by KD.
+	// only the breakpoints near PC and the one that we stepped over are affected: they are taken from the index sorted by address,
+	// then processed in the order of the vector (the step bp first).
 
-				if (!pcBpProcessed) // the step bp and a normal bp can have the same address: in this case, we process only the step bp.
-				{
-					pcBpProcessed = TRUE;
+	eastl::vector<BreakPoint*> nearBps;
 
-					// we need to single step, then we can recreate the bp at PC.
-					
-					Root::I->Trace = TRUE;
-					BpTrace::Get().addr = currPc;
-					BpTrace::Get().nextAddr = stepAddr;
+	ULONG64 rangeStart = currPc >= 63 ? currPc - 63 : 0;
+	ULONG64 rangeEnd = currPc <= (ULONG64)-1 - 64 ? currPc + 64 : (ULONG64)-1;
 
-					// check the conditions of the BP.
+	Root::I->BreakPoints.FindInRange(rangeStart, rangeEnd, nearBps);
 
-					if (!breakIn)
-					{
-						breakIn = TRUE;
+	if (prevBpTraceAddr < rangeStart || prevBpTraceAddr >= rangeEnd)
+		Root::I->BreakPoints.FindInRange(prevBpTraceAddr, prevBpTraceAddr + 1, nearBps);
 
-						if (bp.skip)
-						{
-							breakIn = FALSE;
-						}
-						else if (bp.ethread)
-						{
-							if (bp.ethread != Root::I->StateChange.Thread)
-								breakIn = FALSE;
-						}
-						else if (bp.eprocess)
-						{
-							ULONG64 eprocess = 0;
-							co_await BcAwaiter_Join{ Platform::GetCurrentEprocess(eprocess) };
+	eastl::sort(nearBps.begin(), nearBps.end());
 
-							if (bp.eprocess != eprocess)
-								breakIn = FALSE;
-						}
+	for (BreakPoint* pbp : nearBps)
+	{
+		BreakPoint& bp = *pbp;
 
-						if (breakIn && bp.when.size())
-						{
-							NullableU64 nu64;
+		if (bp.drIndex >= 0) // hardware breakpoints are not written in memory.
+			continue;
 
-							co_await BcAwaiter_Join{ QuickJSCppInterface::Eval(bp.when.c_str(), Context, ContextLen, is32bitCompat, &nu64, TRUE) };
+		if (bp.address == currPc)
+		{
+			bp.handle = 0; // bps at PC are deleted by KD.
 
-							if (!nu64.isNull)
-							{
-								if (!nu64.value)
-									breakIn = FALSE;
-							}
-							else
-							{
-								Root::I->LogWindow.AddString("BPX WHEN expression: unable to convert javascript result to ULONG64.");
-							}
+			if (!pcBpProcessed) // the step bp and a normal bp can have the same address: in this case, we process only the step bp.
+			{
+				pcBpProcessed = TRUE;
 
-							// very special case: the user script modified EIP/RIP!
+				// we need to single step, then we can recreate the bp at PC.
+				
+				Root::I->Trace = TRUE;
+				BpTrace::Get().addr = currPc;
+				BpTrace::Get().nextAddr = stepAddr;
 
-							if (currPc != ((CONTEXT*)Context)->_6432_(Rip, Eip))
-							{
-								co_await BcAwaiter_Join{ DisasmCurrInstr(thisInstr, thisOps, jumpType, stepAddr, Context, is32bitCompat) };
+				// check the conditions of the BP.
 
-								// prevent BC from breaking in at the next INT1 if it happens at "stepAddr". Don't update "BpTrace::Get().addr" since the old value is required to recreate this breakpoint.
+				if (!breakIn)
+				{
+					if (!bp.isStepBp)
+						Root::I->Perf_BpHitsNum++;
 
-								BpTrace::Get().nextAddr = stepAddr;
-							}
-						}
+					co_await BcAwaiter_Join{ CheckBreakPoint(bp, breakIn, Context, ContextLen, is32bitCompat) };
 
-						if (breakIn && bp.isStepBp && Root::I->StepOutThread) // special case when we are in step out mode: don't break in!
-							breakIn = FALSE;
+					// very special case: the user script modified EIP/RIP!
 
-						if (breakIn && !bp.isStepBp)
-						{
-							Root::I->BpHitIndex = &bp - &Root::I->BreakPoints[0];
+					if (currPc != ((CONTEXT*)Context)->_6432_(Rip, Eip))
+					{
+						co_await BcAwaiter_Join{ DisasmCurrInstr(thisInstr, thisOps, jumpType, stepAddr, Context, is32bitCompat) };
 
-							regsWndInvOld = TRUE; // don't show old/new values differences in registers window.
+						// prevent BC from breaking in at the next INT1 if it happens at "stepAddr". Don't update "BpTrace::Get().addr" since the old value is required to recreate this breakpoint.
 
-							Root::I->LogWindow.AddString(("Break due to " + bp.cmd).c_str());
-						}
+						BpTrace::Get().nextAddr = stepAddr;
+					}
+
+					if (breakIn && bp.isStepBp && Root::I->StepOutThread) // special case when we are in step out mode: don't break in!
+						breakIn = FALSE;
+
+					if (breakIn && !bp.isStepBp)
+					{
+						Root::I->BpHitIndex = &bp - &Root::I->BreakPoints[0];
+
+						regsWndInvOld = TRUE; // don't show old/new values differences in registers window.
+
+						Root::I->LogWindow.AddString(("Break due to " + bp.cmd).c_str());
 					}
 				}
 			}
-			else
-			{
-				recreateList.push_back(&bp);
-			}
+		}
+		else
+		{
+			recreateList.push_back(&bp);
 		}
 	}
 
-	// recreate the breakpoints, in reverse order, leaving the step bp (if present) as last.
+	// process the hardware breakpoint: the debug registers stay armed, so no single step is required to recreate it.
 
-	for (int i = recreateList.size() - 1; i >= 0; i--)
+	if (hwBp && !breakIn)
 	{
-		BreakPoint& bp = *recreateList[i];
+		Root::I->Perf_HwBpHitsNum++;
 
-		co_await BcAwaiter_StateManipulate{
-		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+		co_await BcAwaiter_Join{ CheckBreakPoint(*hwBp, breakIn, Context, ContextLen, is32bitCompat) };
 
-			pState->ApiNumber = DbgKdWriteBreakPointApi;
+		if (breakIn)
+		{
+			Root::I->BpHitIndex = hwBp - &Root::I->BreakPoints[0];
 
-			pState->ReturnStatus = STATUS_PENDING;
+			regsWndInvOld = TRUE;
 
-			pState->u.WriteBreakPoint.BreakPointHandle = 0;
-			pState->u.WriteBreakPoint.BreakPointAddress = bp.address;
-		},
-		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+			Root::I->LogWindow.AddString(("Break due to " + hwBp->cmd).c_str());
+		}
+	}
 
-			if (pState->ApiNumber == DbgKdWriteBreakPointApi)
-			{
-				if (NT_SUCCESS(pState->ReturnStatus) &&
-					pState->u.WriteBreakPoint.BreakPointHandle)
-				{
-					bp.handle = pState->u.WriteBreakPoint.BreakPointHandle;
+	if (SetResumeFlag(Context))
+		updateContext = TRUE;
 
-					return TRUE;
-				}
-			}
+	// recreate the breakpoints, in reverse order, leaving the step bp (if present) as last.
 
-			return FALSE;
-		} };
+	if (recreateList.size())
+	{
+		eastl::vector<BcBreakPointOp> ops;
+
+		for (int i = recreateList.size() - 1; i >= 0; i--)
+			ops.push_back({ recreateList[i]->address, 0, FALSE, FALSE });
+
+		co_await BcAwaiter_BreakPoints{ ops.data(), ops.size() };
+
+		for (int i = recreateList.size() - 1, j = 0; i >= 0; i--, j++)
+			if (ops[j].ok)
+				recreateList[i]->handle = ops[j].handle;
 	}
 
 	// if we changed something, update the processor registers.
 
 	if (updateContext)
 	{
-		co_await BcAwaiter_StateManipulate{
-		[&Context, &ContextLen](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
-
-			if (SecondBuffer->pData != NULL && ContextLen > 0 && SecondBuffer->MaxLength >= ContextLen)
-			{
-				pState->ApiNumber = DbgKdSetContextApi;
-
-				::memcpy(SecondBuffer->pData, Context, ContextLen);
-				SecondBuffer->Length = ContextLen;
-			}
-		},
-		[](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
-
-			return pState->ApiNumber == DbgKdSetContextApi && NT_SUCCESS(pState->ReturnStatus);
-		} };
+		co_await BcAwaiter_Join{ SetContext(Context, ContextLen) };
 	}
 
 	// manage the step out mode case.
@@ -679,11 +684,62 @@ BcCoroutine Main::EntryPoint() noexcept
 		}
 	}
 
+	// the commands may have changed PC or set an execution breakpoint at PC.
+
+	if (SetResumeFlag(Context))
+		co_await BcAwaiter_Join{ SetContext(Context, ContextLen) };
+
 	// return from the coroutine, i.e. trigger a DbgKdContinueApi state manipulate request.
 
 	co_return;
 }
 
+BOOLEAN Main::SetResumeFlag(BYTE* Context)
+{
+	// the execution breakpoints are faults: without RF, the instruction at PC would hit its breakpoint again as soon as the
+	// processor is resumed, also when the stop was caused by a single step or by another breakpoint.
+
+	CONTEXT* context = (CONTEXT*)Context;
+
+	if (context->EFlags & 0x10000)
+		return FALSE;
+
+	ULONG64 pc = context->_6432_(Rip, Eip);
+
+	eastl::vector<BreakPoint*> bps;
+	Root::I->BreakPoints.FindInRange(pc, pc + 1, bps);
+
+	for (BreakPoint* bp : bps)
+		if (bp->drIndex >= 0 && bp->drRw == BreakPoint::DrRwExecute)
+		{
+			context->EFlags |= 0x10000;
+			return TRUE;
+		}
+
+	return FALSE;
+}
+
+BcCoroutine Main::SetContext(BYTE* Context, ULONG ContextLen) noexcept
+{
+	co_await BcAwaiter_StateManipulate{
+	[&Context, &ContextLen](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+		if (SecondBuffer->pData != NULL && ContextLen > 0 && SecondBuffer->MaxLength >= ContextLen)
+		{
+			pState->ApiNumber = DbgKdSetContextApi;
+
+			::memcpy(SecondBuffer->pData, Context, ContextLen);
+			SecondBuffer->Length = ContextLen;
+		}
+	},
+	[](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+		return pState->ApiNumber == DbgKdSetContextApi && NT_SUCCESS(pState->ReturnStatus);
+	} };
+
+	co_return;
+}
+
 BcCoroutine Main::ProcessCmd(const eastl::pair<eastl::string, Cmd*>& cmd, BOOLEAN& exit, BYTE* Context, ULONG ContextLen, BOOLEAN is32bitCompat, ULONG64 jumpDest, ZydisDecodedInstruction* thisInstr, ZydisDecodedOperand* thisOps) noexcept
 {
 	CmdParams params;
@@ -696,8 +752,15 @@ BcCoroutine Main::ProcessCmd(const eastl::pair<eastl::string, Cmd*>& cmd, BOOLEA
 	params.thisInstr = thisInstr;
 	params.thisOps = thisOps;
 
+	ULONG64 roundTripsStart = Root::I->Perf_KdRoundTripsNum;
+	ULONG64 tscStart = __rdtsc();
+
 	co_await BcAwaiter_Join{ cmd.second->Execute(params) };
 
+	cmd.second->Perf_ExecutionsNum++;
+	cmd.second->Perf_KdRoundTripsNum += Root::I->Perf_KdRoundTripsNum - roundTripsStart;
+	cmd.second->Perf_Latency.Add(__rdtsc() - tscStart);
+
 	if (params.result == CmdParamsResult::Continue)
 		exit = TRUE;
 	else if (params.result == CmdParamsResult::RefreshCodeAndRegsWindows)
@@ -776,6 +839,129 @@ Cmd* Main::GetCmd(const CHAR* id)
 	return NULL;
 }
 
+BcCoroutine Main::CheckBreakPoint(BreakPoint& bp, BOOLEAN& breakIn, BYTE* Context, ULONG ContextLen, BOOLEAN is32bitCompat) noexcept
+{
+	breakIn = TRUE;
+
+	bp.hitsNum++;
+	bp.lastCpu = Root::I->StateChange.Processor;
+
+	if (bp.skip)
+	{
+		breakIn = FALSE;
+	}
+	else if (bp.ethread)
+	{
+		if (bp.ethread != Root::I->StateChange.Thread)
+		{
+			breakIn = FALSE;
+			Root::I->Perf_BpFilteredNum++;
+		}
+	}
+	else if (bp.eprocess)
+	{
+		ULONG64 roundTripsStart = Root::I->Perf_KdRoundTripsNum;
+
+		ULONG64 eprocess = 0;
+		co_await BcAwaiter_Join{ Platform::GetCurrentEprocess(eprocess) };
+
+		Root::I->Perf_BpFilterRoundTripsNum += Root::I->Perf_KdRoundTripsNum - roundTripsStart;
+
+		if (bp.eprocess != eprocess)
+		{
+			breakIn = FALSE;
+			Root::I->Perf_BpFilteredNum++;
+		}
+	}
+
+	// sampling: the filtered hits don't evaluate the conditions and don't break in.
+
+	if (breakIn && (bp.sampleEvery || bp.sampleRate))
+	{
+		BOOLEAN sampled = TRUE;
+
+		if (bp.sampleEvery && bp.sampleCounter++ % bp.sampleEvery)
+			sampled = FALSE;
+
+		if (sampled && bp.sampleRate && Root::I->RdtscTicksPerMs)
+		{
+			ULONG64 now = __rdtsc();
+
+			if (now - bp.sampleWindowStart >= Root::I->RdtscTicksPerMs * 1000)
+			{
+				bp.sampleWindowStart = now;
+				bp.sampleWindowHits = 0;
+			}
+
+			if (bp.sampleWindowHits++ >= bp.sampleRate)
+				sampled = FALSE;
+		}
+
+		if (!sampled)
+		{
+			breakIn = FALSE;
+			bp.sampledOutNum++;
+		}
+	}
+
+	if (!breakIn)
+		co_return;
+
+	ULONG64 condStart = __rdtsc();
+
+	if (bp.log.IsSet())
+	{
+		co_await BcAwaiter_Join{ bp.log.Run(Context, is32bitCompat) };
+
+		breakIn = FALSE;
+	}
+
+	if (breakIn && bp.whenFn >= 0)
+	{
+		NullableU64 nu64;
+
+		co_await BcAwaiter_Join{ QuickJSCppInterface::Call(bp.whenFn, Context, ContextLen, is32bitCompat, &nu64, TRUE, bp.whenBudgetMs) };
+
+		if (QuickJSCppInterface::LastTimedOut)
+		{
+			// the condition is considered false, unless it keeps exceeding its budget: in this case the bp is disabled and we break in.
+
+			if (++bp.whenTimeoutsNum < BreakPoint::MaxWhenTimeouts)
+			{
+				breakIn = FALSE;
+
+				Root::I->LogWindow.AddString("BPX WHEN expression: interrupted, it exceeded its time budget.");
+			}
+			else
+			{
+				bp.skip = TRUE;
+
+				Root::I->LogWindow.AddString("BPX WHEN expression: it exceeded its time budget too many times in a row, the breakpoint was disabled.");
+			}
+		}
+		else if (!nu64.isNull)
+		{
+			bp.whenTimeoutsNum = 0;
+
+			if (!nu64.value)
+				breakIn = FALSE;
+		}
+		else
+		{
+			bp.whenTimeoutsNum = 0;
+
+			Root::I->LogWindow.AddString("BPX WHEN expression: unable to convert javascript result to ULONG64.");
+		}
+	}
+
+	bp.condTicks += __rdtsc() - condStart;
+
+	if (breakIn || bp.log.IsSet())
+		bp.trueNum++;
+
+	co_return;
+}
+
 BcCoroutine Main::SetStepBp(ULONG64 addr) noexcept
 {
 	// we allow only one step bp.
@@ -866,18 +1052,12 @@ BcCoroutine Main::DisasmCurrInstr(ZydisDecodedInstruction& thisInstr, ZydisDecod
 {
 	const size_t thisInstrMaxSize = 64;
 
-	auto ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)((CONTEXT*)Context)->_6432_(Rip, Eip), thisInstrMaxSize };
+	const ULONG64 pc = ((CONTEXT*)Context)->_6432_(Rip, Eip);
+
+	auto ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)pc, thisInstrMaxSize };
 	if (ptr)
 	{
-		ZydisDecoder decoder;
-		::ZydisDecoderInit(&decoder,
-			_6432_(is32bitCompat ? ZYDIS_MACHINE_MODE_LONG_COMPAT_32 : ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_MACHINE_MODE_LEGACY_32),
-			_6432_(is32bitCompat ? ZYDIS_STACK_WIDTH_32 : ZYDIS_STACK_WIDTH_64, ZYDIS_STACK_WIDTH_32));
-
-		if (ZYAN_SUCCESS(::ZydisDecoderDecodeFull(&decoder,
-			ptr, thisInstrMaxSize,
-			&thisInstr, thisOps,
-			ZYDIS_MAX_OPERAND_COUNT_VISIBLE, ZYDIS_DFLAG_VISIBLE_OPERANDS_ONLY)))
+		if (Root::I->DecodedInstrs.Decode(pc, is32bitCompat, (const BYTE*)ptr, thisInstrMaxSize, thisInstr, thisOps))
 		{
 			ULONG64 stepAddrImm = 0, stepAddrPtr = 0, stepAddrPtrSize = 0;
 
@@ -893,7 +1073,7 @@ BcCoroutine Main::DisasmCurrInstr(ZydisDecodedInstruction& thisInstr, ZydisDecod
 
 				ULONG64 stepAddrPtrReadResult = 0;
 
-				if (stepAddrPtrSize == _6432_(is32bitCompat ? 4 : 8, 4))
+				if (stepAddrPtrSize == _6432_((is32bitCompat ? 4 : 8), 4))
 				{
 					auto ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)stepAddrPtr, (size_t)stepAddrPtrSize };
 					if (ptr)
@@ -8,6 +8,8 @@
 
 #include "EASTL/string.h"
 
+class BreakPoint;
+
 class Main
 {
 public:
@@ -20,6 +22,9 @@ private:
 
 	static Cmd* GetCmd(const CHAR* id);
 	static BcCoroutine ProcessCmd(const eastl::pair<eastl::string, Cmd*>& cmd, BOOLEAN& exit, BYTE* Context, ULONG ContextLen, BOOLEAN is32bitCompat, ULONG64 jumpDest, ZydisDecodedInstruction* thisInstr, ZydisDecodedOperand* thisOps) noexcept;
+	static BcCoroutine CheckBreakPoint(BreakPoint& bp, BOOLEAN& breakIn, BYTE* Context, ULONG ContextLen, BOOLEAN is32bitCompat) noexcept; // conditions, logpoint and WHEN expression.
 	static BcCoroutine DisasmCurrInstr(ZydisDecodedInstruction& thisInstr, ZydisDecodedOperand* thisOps, JumpInstrType& jumpType, ULONG64& stepAddr, BYTE* Context, BOOLEAN is32bitCompat) noexcept;
 	static BcCoroutine DrawInterface(BYTE* Context, BOOLEAN is32bitCompat, ULONG64 jumpDest) noexcept;
+	static BOOLEAN SetResumeFlag(BYTE* Context); // sets RF if an execution breakpoint is armed at PC, whatever stopped the processor: TRUE if the context was changed.
+	static BcCoroutine SetContext(BYTE* Context, ULONG ContextLen) noexcept;
 };
@@ -15,6 +15,10 @@ PFNMemoryReaderCoroutine MemoryReaderCoroutineState::pCoroutine;
 DEBUGGER_STATE MemoryReaderCoroutineState::EndDebuggerState;
 
 ULONG MemoryReaderCoroutineState::BufferPos;
+ULONG MemoryReaderCoroutineState::ChunkSize;
+ULONG MemoryReaderCoroutineState::WindowOffset;
+ULONG MemoryReaderCoroutineState::TransferMax;
+BOOLEAN MemoryReaderCoroutineState::RetryChunk;
 
 MemoryReaderCoroutineState* MemoryReaderCoroutineState::ReadMemory_End()
 {
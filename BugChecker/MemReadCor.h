@@ -9,6 +9,7 @@ typedef MemoryReaderCoroutineState* (*PFNMemoryReaderCoroutine) (MemoryReaderCor
 
 //
 
+enum _DEBUGGER_STATE : int;
 typedef enum _DEBUGGER_STATE DEBUGGER_STATE;
 
 class MemoryReaderCoroutineState
@@ -33,7 +34,11 @@ public:
 
 	static DEBUGGER_STATE EndDebuggerState;
 
-	static ULONG BufferPos;
+	static ULONG BufferPos; // offset in Buffer of the chunk being read.
+	static ULONG ChunkSize; // size of the chunk request sent to the kernel; 0 if none.
+	static ULONG WindowOffset; // the kernel is asked to read a bigger window of the page: this is the offset of the chunk in the window.
+	static ULONG TransferMax; // the largest transfer of the kernel, learned from its short responses in this state change; 0 if unknown.
+	static BOOLEAN RetryChunk; // the window of the short response didn't reach the chunk: request it again with a smaller window.
 
 	// === caller and callee accessed fields ===
 
@@ -0,0 +1,74 @@
+#include "PageCache.h"
+
+PageCache::Entry* PageCache::Find(ULONG64 page)
+{
+	for (Entry& e : entries)
+		if (e.page == page && e.validEnd > e.validStart)
+			return &e;
+
+	return NULL;
+}
+
+BOOLEAN PageCache::Read(ULONG64 address, VOID* dest, ULONG size)
+{
+	ULONG64 page = address & ~(ULONG64)(PAGE_SIZE - 1);
+	ULONG offset = (ULONG)(address - page);
+
+	Entry* e = Find(page);
+
+	if (!e || offset < e->validStart || offset + size > e->validEnd)
+		return FALSE;
+
+	::memcpy(dest, e->data + offset, size);
+
+	return TRUE;
+}
+
+VOID PageCache::Store(ULONG64 address, const VOID* src, ULONG size)
+{
+	ULONG64 page = address & ~(ULONG64)(PAGE_SIZE - 1);
+	ULONG offset = (ULONG)(address - page);
+
+	if (!size || offset + size > PAGE_SIZE)
+		return;
+
+	// if the page is already in the cache, extend its valid range, otherwise replace the oldest entry.
+
+	Entry* e = Find(page);
+
+	if (e && offset <= e->validEnd && offset + size >= e->validStart)
+	{
+		e->validStart = _MIN_(e->validStart, offset);
+		e->validEnd = _MAX_(e->validEnd, offset + size);
+	}
+	else
+	{
+		if (!e)
+		{
+			e = &entries[nextEntry];
+			nextEntry = (nextEntry + 1) % EntriesNum;
+		}
+
+		e->page = page;
+		e->validStart = offset;
+		e->validEnd = offset + size;
+	}
+
+	::memcpy(e->data + offset, src, size);
+}
+
+VOID PageCache::Invalidate(ULONG64 address, ULONG size)
+{
+	ULONG64 first = address & ~(ULONG64)(PAGE_SIZE - 1);
+	ULONG64 last = (address + (size ? size - 1 : 0)) & ~(ULONG64)(PAGE_SIZE - 1);
+
+	for (Entry& e : entries)
+		if (e.page >= first && e.page <= last)
+			e.validStart = e.validEnd = 0;
+}
+
+VOID PageCache::InvalidateAll()
+{
+	for (Entry& e : entries)
+		e.validStart = e.validEnd = 0;
+}
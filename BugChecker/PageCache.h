@@ -0,0 +1,35 @@
+#pragma once
+
+#include "BugChecker.h"
+
+class PageCache // cache of the pages read through KD, valid until the debugger returns control to the OS.
+{
+public:
+
+	static constexpr ULONG EntriesNum = 64;
+
+	BOOLEAN Read(ULONG64 address, VOID* dest, ULONG size); // the range must not cross a page boundary.
+	VOID Store(ULONG64 address, const VOID* src, ULONG size); //  "  "
+
+	VOID Invalidate(ULONG64 address, ULONG size);
+	VOID InvalidateAll();
+
+	ULONG64 Perf_HitsNum = 0;
+	ULONG64 Perf_MissesNum = 0;
+
+private:
+
+	struct Entry
+	{
+		ULONG64 page = 0;
+		ULONG validStart = 0; // the valid bytes in the page: [validStart, validEnd).
+		ULONG validEnd = 0;
+		BYTE data[PAGE_SIZE];
+	};
+
+	Entry* Find(ULONG64 page);
+
+	Entry entries[EntriesNum];
+
+	ULONG nextEntry = 0;
+};
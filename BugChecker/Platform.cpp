@@ -146,690 +146,613 @@ int MACRO_IRQL_FIELDOFFSET_IN_PCR = -1;
 // This function comes from the first BugChecker, so it was
 // compatible only with Windows 2000/XP 32bit. It was then
 // ported to 64bit, made compatible with Windows 10/11 and
-// finally integrated with the Mem Reader Coroutine mechanism.
-// This is the reason why it is a bit messy...
-// 
-// NOTE AFTER SEVERAL WEEKS: =FIXFIX= now BugChecker has an
-// heap allocator that works at any IRQL, and support for
-// C++ 20 coroutines: we should update this function
-// accordingly...
+// finally rewritten as a C++ 20 coroutine: its reads go
+// through the page cache and the independent ones are batched.
+// User addresses are resolved through the VAD snapshot of the
+// process, built once per break-in.
 // 
 //======================================================
 
-MemoryReaderCoroutineState* Platform::DiscoverBytePointerPosInModules(MemoryReaderCoroutineState* pMemReadCor)
+class KernelModulesCacheEntry
 {
-	auto params = (DiscoverBytePointerPosInModules_Params*)pMemReadCor->InputParams;
+public:
+	ULONG_PTR entry;
+	ULONG_PTR imageBase;
+	ULONG imageSize;
+};
+
+static eastl::vector<KernelModulesCacheEntry>* KernelModulesCache = NULL; // PsLoadedModuleList lookups are slow: this cache was introduced later to speed up the process.
 
-	switch (pMemReadCor->ResumePoint)
+BOOLEAN Platform::DecodeVadNode(ULONG64& start, ULONG64& end, const BYTE* vad)
+{
+	// calculate the start and end address of the node.
+
+	if (MACRO_SIZEOF_VPN_IN_VAD == 4)
+	{
+		start = *(DWORD*)(vad + MACRO_STARTINGVPN_FIELDOFFSET_IN_VAD);
+		end = *(DWORD*)(vad + MACRO_ENDINGVPN_FIELDOFFSET_IN_VAD);
+	}
+	else if (MACRO_SIZEOF_VPN_IN_VAD == 8)
 	{
-	case 1: goto Resume_Label_01;
-	case 2: goto Resume_Label_02;
-	case 3: goto Resume_Label_03;
-	case 4: goto Resume_Label_04;
-	case 5: goto Resume_Label_05;
-	case 6: goto Resume_Label_06;
-	case 7: goto Resume_Label_07;
-	case 8: goto Resume_Label_08;
-	case 9: goto Resume_Label_09;
-	case 10: goto Resume_Label_10;
-	case 11: goto Resume_Label_11;
-	case 12: goto Resume_Label_12;
-	case 13: goto Resume_Label_13;
-	case 14: goto Resume_Label_14;
-	case 15: goto Resume_Label_15;
-	case 16: goto Resume_Label_16;
-	case 17: goto Resume_Label_17;
-	case 18: goto Resume_Label_18;
-	case 19: goto Resume_Label_19;
-	case 20: goto Resume_Label_20;
-	case 21: goto Resume_Label_21;
-	case 22: goto Resume_Label_22;
-	case 23: goto Resume_Label_23;
+		start = *(QWORD*)(vad + MACRO_STARTINGVPN_FIELDOFFSET_IN_VAD);
+		end = *(QWORD*)(vad + MACRO_ENDINGVPN_FIELDOFFSET_IN_VAD);
 	}
+	else
+		return FALSE;
 
-	static VOID* pvMatchingModuleStart;
-	static ULONG ulMatchingModuleLength;
-	static BYTE* pbMatchingModuleNtHeaders;
-	static CHAR szImageName[256];
-	static ULONG ulSizeofNtHeaders;
-	static IMAGE_FILE_HEADER ifhFileHeader;
-	static IMAGE_DATA_DIRECTORY iddDirDebug;
-	static eastl::vector<NtModule>* pvNtModules;
-	static NtModule* pNtModule;
+	start = start << 12;
+	end = ((end + 1) << 12) - 1;
 
-	iddDirDebug.VirtualAddress = 0;
-	iddDirDebug.Size = 0;
+	if (MACRO_STARTINGVPNHIGH_FIELDOFFSET_IN_VAD != -1 && MACRO_ENDINGVPNHIGH_FIELDOFFSET_IN_VAD != -1)
+	{
+		start |= (QWORD) * (BYTE*)(vad + MACRO_STARTINGVPNHIGH_FIELDOFFSET_IN_VAD) << 44;
+		end |= (QWORD) * (BYTE*)(vad + MACRO_ENDINGVPNHIGH_FIELDOFFSET_IN_VAD) << 44;
+	}
 
-	ulSizeofNtHeaders = sizeof(IMAGE_NT_HEADERS);
+	return start <= end;
+}
 
-	if (params->pszOutputBuffer)
-		strcpy(params->pszOutputBuffer, "");
+BcCoroutine Platform::ReadPointers(eastl::vector<ULONG_PTR>& values, const eastl::vector<ULONG_PTR>& addrs) noexcept
+{
+	// read the pointers at the specified addresses in a single batch: the values are 0 if the address is 0 or if the read fails.
 
-	if (params->pidiDebugInfo)
-		::memset(params->pidiDebugInfo, 0, sizeof(ImageDebugInfo));
+	values.clear();
+	values.resize(addrs.size(), 0);
 
-	pvNtModules = NULL;
-	pNtModule = NULL;
+	eastl::vector<BcReadMemoryRange> reads;
 
-	// Check whether the Pointer refers to User Memory or Kernel Memory.
+	for (size_t i = 0; i < addrs.size(); i++)
+		if (addrs[i])
+			reads.push_back({ addrs[i], sizeof(ULONG_PTR), &values[i], FALSE });
 
-	pvMatchingModuleStart = NULL;
-	ulMatchingModuleLength = 0;
-	pbMatchingModuleNtHeaders = NULL;
+	if (reads.size())
+		co_await BcAwaiter_ReadMemoryBatch{ reads.data(), reads.size() };
 
-	strcpy(szImageName, "");
+	for (auto& r : reads)
+		if (!r.ok)
+			*(ULONG_PTR*)r.dest = 0;
 
-	if ((ULONG_PTR)params->pbBytePointer < (ULONG_PTR)params->pvMmUserProbeAddress)
-	{
-		static BYTE* pbPcr;
-		static BYTE* pbKteb;
-		static BYTE* pbKpeb;
-		static BYTE* pbVadRoot;
-		static BYTE* pbMatchingNode;
-		static BYTE* pbNode;
-		static QWORD qwStart, qwEnd, qwPointer;
+	co_return;
+}
 
-		pbPcr = (BYTE*)params->pvPCRAddress;
+const VadRange* VadSnapshot::Find(ULONG64 address) const
+{
+	auto it = eastl::upper_bound(ranges.begin(), ranges.end(), address,
+		[](ULONG64 a, const VadRange& r) { return a < r.start; });
 
-		//
-		// USER SPACE.
-		//
+	if (it == ranges.begin())
+		return NULL;
 
-		// Get the Root Address of the VAT.
+	--it;
 
-		return pMemReadCor->ReadMemory(19, (ULONG_PTR*)(pbPcr + MACRO_KTEBPTR_FIELDOFFSET_IN_PCR));
-	Resume_Label_19:
+	return address <= it->end ? &*it : NULL;
+}
 
-		if (pMemReadCor->ReadMemory_Succeeded())
+BcCoroutine Platform::GetVadSnapshot(VadSnapshot*& retVal, ULONG64 eprocess) noexcept
+{
+	retVal = NULL;
+
+	// return the snapshot taken in this break-in, if any.
+
+	for (auto& s : Root::I->VadSnapshots)
+		if (s->eprocess == eprocess)
 		{
-			pbKteb = *(BYTE**)pMemReadCor->Buffer;
+			retVal = s.get();
+			co_return;
+		}
 
-			if (pbKteb)
-			{
-				return pMemReadCor->ReadMemory(20, (ULONG_PTR*)(pbKteb + MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB));
-			Resume_Label_20:
+	if (!eprocess ||
+		MACRO_VADROOT_FIELDOFFSET_IN_KPEB == -1 || MACRO_SIZEOF_VAD <= 0 ||
+		MACRO_LEFTLINK_FIELDOFFSET_IN_VAD == -1 || MACRO_RIGHTLINK_FIELDOFFSET_IN_VAD == -1)
+		co_return;
 
-				if (pMemReadCor->ReadMemory_Succeeded())
-				{
-					pbKpeb = *(BYTE**)pMemReadCor->Buffer;
+	ULONG64 buildStart = __rdtsc();
 
-					if (pbKpeb)
-					{
-						if (Root::I->NtModules)
-						{
-							auto fif = eastl::find_if(Root::I->NtModules->begin(), Root::I->NtModules->end(),
-								[&](const eastl::pair<ULONG64, eastl::vector<NtModule>>& e) { return e.first == (ULONG64)(ULONG_PTR)pbKpeb; });
+	auto snapshot = new VadSnapshot();
+	snapshot->eprocess = eprocess;
 
-							if (fif != Root::I->NtModules->end())
-							{
-								pvNtModules = &fif->second;
-							}
-						}
+	Root::I->VadSnapshots.push_back(eastl::unique_ptr<VadSnapshot>(snapshot));
 
-						return pMemReadCor->ReadMemory(21, (ULONG_PTR*)(pbKpeb + MACRO_VADROOT_FIELDOFFSET_IN_KPEB));
-					Resume_Label_21:
+	// read the tree level by level: the nodes of each level are read in a single batch.
 
-						if (pMemReadCor->ReadMemory_Succeeded())
-						{
-							pbVadRoot = *(BYTE**)pMemReadCor->Buffer;
+	const ULONG maxNodesNum = 64 * 1024; // protects against loops in an inconsistent tree.
 
-							if (pbVadRoot)
-							{
-								pbMatchingNode = NULL;
+	VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)eprocess + MACRO_VADROOT_FIELDOFFSET_IN_KPEB, sizeof(ULONG_PTR) };
 
-								qwPointer = (QWORD)params->pbBytePointer;
+	eastl::vector<ULONG_PTR> level;
 
-								// Check this Node.
+	if (ptr && *(ULONG_PTR*)ptr)
+		level.push_back(*(ULONG_PTR*)ptr);
 
-								pbNode = pbVadRoot;
+	eastl::vector<BYTE> data;
+	eastl::vector<BcReadMemoryRange> reads;
 
-								while (pbNode)
-								{
-									return pMemReadCor->ReadMemory(18, pbNode, MACRO_SIZEOF_VAD);
-								Resume_Label_18:
+	while (level.size() && snapshot->nodesNum < maxNodesNum)
+	{
+		data.resize(level.size() * MACRO_SIZEOF_VAD);
+		reads.resize(level.size());
 
-									auto temp_origNodePtr = pbNode;
+		for (size_t i = 0; i < level.size(); i++)
+			reads[i] = { level[i], (ULONG)MACRO_SIZEOF_VAD, data.data() + i * MACRO_SIZEOF_VAD, FALSE };
 
-									if (pMemReadCor->ReadMemory_Succeeded())
-										pbNode = (BYTE*)pMemReadCor->Buffer;
-									else
-										break;
+		co_await BcAwaiter_ReadMemoryBatch{ reads.data(), reads.size() };
 
-									// Calculate the start and end address of the node.
+		eastl::vector<ULONG_PTR> nextLevel;
 
-									if (MACRO_SIZEOF_VPN_IN_VAD == 4)
-									{
-										qwStart = *(DWORD*)(pbNode + MACRO_STARTINGVPN_FIELDOFFSET_IN_VAD);
-										qwEnd = *(DWORD*)(pbNode + MACRO_ENDINGVPN_FIELDOFFSET_IN_VAD);
-									}
-									else if (MACRO_SIZEOF_VPN_IN_VAD == 8)
-									{
-										qwStart = *(QWORD*)(pbNode + MACRO_STARTINGVPN_FIELDOFFSET_IN_VAD);
-										qwEnd = *(QWORD*)(pbNode + MACRO_ENDINGVPN_FIELDOFFSET_IN_VAD);
-									}
-									else
-										break;
+		for (size_t i = 0; i < level.size(); i++)
+		{
+			if (!reads[i].ok)
+				continue;
 
-									qwStart = qwStart << 12;
-									qwEnd = ((qwEnd + 1) << 12) - 1;
+			const BYTE* vad = (BYTE*)reads[i].dest;
 
-									if (MACRO_STARTINGVPNHIGH_FIELDOFFSET_IN_VAD != -1 && MACRO_ENDINGVPNHIGH_FIELDOFFSET_IN_VAD != -1)
-									{
-										qwStart |= (QWORD) * (BYTE*)(pbNode + MACRO_STARTINGVPNHIGH_FIELDOFFSET_IN_VAD) << 44;
-										qwEnd |= (QWORD) * (BYTE*)(pbNode + MACRO_ENDINGVPNHIGH_FIELDOFFSET_IN_VAD) << 44;
-									}
+			VadRange range;
+			range.node = level[i];
 
-									if (qwStart > qwEnd)
-										break;
+			if (!DecodeVadNode(range.start, range.end, vad))
+				continue;
 
-									// Check if we have a match.
+			snapshot->ranges.push_back(range);
 
-									if (qwPointer >= qwStart &&
-										qwPointer <= qwEnd)
-									{
-										pbMatchingNode = temp_origNodePtr;
-										break;
-									}
-									else if (qwPointer < qwStart)
-									{
-										pbNode = *(BYTE**)(pbNode + MACRO_LEFTLINK_FIELDOFFSET_IN_VAD);
-									}
-									else
-									{
-										pbNode = *(BYTE**)(pbNode + MACRO_RIGHTLINK_FIELDOFFSET_IN_VAD);
-									}
-								}
+			ULONG_PTR left = *(ULONG_PTR*)(vad + MACRO_LEFTLINK_FIELDOFFSET_IN_VAD);
+			ULONG_PTR right = *(ULONG_PTR*)(vad + MACRO_RIGHTLINK_FIELDOFFSET_IN_VAD);
 
-								if (pbMatchingNode)
-								{
-									static ULONG_PTR ImageBase;
-									static IMAGE_DOS_HEADER* pidhDosHdr;
-									static IMAGE_NT_HEADERS* pinhNtHdrs;
-									static ULONG_PTR* FileObjectPtr;
-									static BOOLEAN IsExFastRef;
-									static WORD* pwImageNameLengthPtr;
-									static WORD wImageNameLength;
-									static ULONG_PTR* ImageNameUnicodePtrPtr;
-									static WORD* pwImageNameUnicodePtr;
-									static WORD* pwWordPtr;
-									static CHAR* pcCharPtr;
-									static ULONG ulI;
-									static BYTE* pbControlArea;
-									static BYTE* pbFileObject;
+			if (left) nextLevel.push_back(left);
+			if (right) nextLevel.push_back(right);
+		}
 
-									ImageBase = (ULONG_PTR)qwStart;
+		snapshot->nodesNum += (ULONG)level.size();
 
-									pvMatchingModuleStart = (VOID*)ImageBase;
+		level = eastl::move(nextLevel);
+	}
 
-									// Check the DOS Header.
+	eastl::sort(snapshot->ranges.begin(), snapshot->ranges.end(),
+		[](const VadRange& a, const VadRange& b) { return a.start < b.start; });
 
-									pidhDosHdr = (IMAGE_DOS_HEADER*)ImageBase;
+	// get the names of the mapped files: each step of the pointer chain is read in a single batch for all the nodes.
 
-									return pMemReadCor->ReadMemory(9, (BYTE*)pidhDosHdr, sizeof(IMAGE_DOS_HEADER));
-								Resume_Label_09:
+	eastl::vector<ULONG_PTR> addrs(snapshot->ranges.size(), 0);
+	eastl::vector<ULONG_PTR> values;
 
-									if (pMemReadCor->ReadMemory_Succeeded())
-									{
-										pidhDosHdr = (IMAGE_DOS_HEADER*)pMemReadCor->Buffer;
+	BOOLEAN isExFastRef = FALSE;
 
-										if (pidhDosHdr->e_magic == IMAGE_DOS_SIGNATURE &&
-											pidhDosHdr->e_lfarlc >= 0x40)
-										{
-											// Check the NT Headers.
+	if (MACRO_CONTROLAREA_FIELDOFFSET_IN_VAD != -1 &&
+		MACRO_FILEOBJECT_FIELDOFFSET_IN_CONTROLAREA != -1)
+	{
+		for (size_t i = 0; i < addrs.size(); i++)
+			addrs[i] = (ULONG_PTR)snapshot->ranges[i].node + MACRO_CONTROLAREA_FIELDOFFSET_IN_VAD;
 
-											pinhNtHdrs = (IMAGE_NT_HEADERS*)(ImageBase + pidhDosHdr->e_lfanew);
+		co_await BcAwaiter_Join{ ReadPointers(values, addrs) };
 
-											return pMemReadCor->ReadMemory(10, (BYTE*)pinhNtHdrs, sizeof(IMAGE_NT_HEADERS64) > sizeof(IMAGE_NT_HEADERS32) ? sizeof(IMAGE_NT_HEADERS64) : sizeof(IMAGE_NT_HEADERS32));
-										Resume_Label_10:
+		for (size_t i = 0; i < addrs.size(); i++)
+			addrs[i] = values[i] ? values[i] + MACRO_FILEOBJECT_FIELDOFFSET_IN_CONTROLAREA : 0;
+	}
+	else if (MACRO_SUBSECTION_FIELDOFFSET_IN_VAD != -1 &&
+		MACRO_CONTROLAREA_FIELDOFFSET_IN_SUBSECTION != -1 &&
+		MACRO_FILEPOINTER_FIELDOFFSET_IN_CONTROLAREA != -1)
+	{
+		for (size_t i = 0; i < addrs.size(); i++)
+			addrs[i] = (ULONG_PTR)snapshot->ranges[i].node + MACRO_SUBSECTION_FIELDOFFSET_IN_VAD;
 
-											if (pMemReadCor->ReadMemory_Succeeded())
-											{
-												IMAGE_NT_HEADERS* temp_NtHdrs;
-												temp_NtHdrs = (IMAGE_NT_HEADERS*)pMemReadCor->Buffer;
+		co_await BcAwaiter_Join{ ReadPointers(values, addrs) };
 
-												if (temp_NtHdrs->Signature == IMAGE_NT_SIGNATURE &&
-													(temp_NtHdrs->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC || temp_NtHdrs->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC))
-												{
-													ifhFileHeader = temp_NtHdrs->FileHeader; // N.B. This is required later!
+		for (size_t i = 0; i < addrs.size(); i++)
+			addrs[i] = values[i] ? values[i] + MACRO_CONTROLAREA_FIELDOFFSET_IN_SUBSECTION : 0;
 
-													ULONG temp_SizeOfImage;
-													temp_SizeOfImage = 0;
+		co_await BcAwaiter_Join{ ReadPointers(values, addrs) };
 
-													if (temp_NtHdrs->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC)
-													{
-														temp_SizeOfImage = ((IMAGE_NT_HEADERS32*)temp_NtHdrs)->OptionalHeader.SizeOfImage;
-														ulSizeofNtHeaders = sizeof(IMAGE_NT_HEADERS32);
-														iddDirDebug = ((IMAGE_NT_HEADERS32*)temp_NtHdrs)->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
-													}
-													else if (temp_NtHdrs->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC)
-													{
-														temp_SizeOfImage = ((IMAGE_NT_HEADERS64*)temp_NtHdrs)->OptionalHeader.SizeOfImage;
-														ulSizeofNtHeaders = sizeof(IMAGE_NT_HEADERS64);
-														iddDirDebug = ((IMAGE_NT_HEADERS64*)temp_NtHdrs)->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
-													}
+		for (size_t i = 0; i < addrs.size(); i++)
+			addrs[i] = values[i] ? values[i] + MACRO_FILEPOINTER_FIELDOFFSET_IN_CONTROLAREA : 0;
 
-													if (((ULONG_PTR)params->pbBytePointer) >= ImageBase &&
-														((ULONG_PTR)params->pbBytePointer) <= ImageBase + temp_SizeOfImage - 1)
-													{
-														// Setup the Variables required later.
+		isExFastRef = TRUE;
+	}
+	else
+		addrs.clear();
 
-														ulMatchingModuleLength = temp_SizeOfImage;
-														pbMatchingModuleNtHeaders = (BYTE*)pinhNtHdrs;
+	if (addrs.size() && MACRO_FILENAME_FIELDOFFSET_IN_FILEOBJECT != -1)
+	{
+		co_await BcAwaiter_Join{ ReadPointers(values, addrs) };
 
-														// Sometimes Windows 10/11 obfuscates the image name.
+		// read the UNICODE_STRINGs with the file names.
 
-														::strcpy(szImageName, "???");
+		eastl::vector<UNICODE_STRING> names(addrs.size());
 
-														// Get the Full Name of the Specified Module.
+		reads.clear();
 
-														FileObjectPtr = NULL;
-														IsExFastRef = FALSE;
+		for (size_t i = 0; i < addrs.size(); i++)
+		{
+			ULONG_PTR fileObject = values[i];
 
-														if (MACRO_CONTROLAREA_FIELDOFFSET_IN_VAD != -1 &&
-															MACRO_FILEOBJECT_FIELDOFFSET_IN_CONTROLAREA != -1)
-														{
-															ULONG_PTR* temp_ControlAreaPtr;
+			if (isExFastRef)
+				fileObject &= (ULONG_PTR)MACRO_MASKOF_EXFASTREF;
 
-															temp_ControlAreaPtr = (ULONG_PTR*)(pbMatchingNode + MACRO_CONTROLAREA_FIELDOFFSET_IN_VAD);
+			if (fileObject)
+				reads.push_back({ fileObject + MACRO_FILENAME_FIELDOFFSET_IN_FILEOBJECT, sizeof(UNICODE_STRING), &names[i], FALSE });
+		}
 
-															return pMemReadCor->ReadMemory(12, temp_ControlAreaPtr);
-														Resume_Label_12:
+		if (reads.size())
+			co_await BcAwaiter_ReadMemoryBatch{ reads.data(), reads.size() };
 
-															if (pMemReadCor->ReadMemory_Succeeded())
-															{
-																pbControlArea = *(BYTE**)pMemReadCor->Buffer;
+		// read the strings: the nodes that don't map a file can contain garbage, so the strings are validated first.
 
-																if (pbControlArea)
-																{
-																	FileObjectPtr = (ULONG_PTR*)(pbControlArea + MACRO_FILEOBJECT_FIELDOFFSET_IN_CONTROLAREA);
-																}
-															}
-														}
-														else if (MACRO_SUBSECTION_FIELDOFFSET_IN_VAD != -1 &&
-															MACRO_CONTROLAREA_FIELDOFFSET_IN_SUBSECTION != -1 &&
-															MACRO_FILEPOINTER_FIELDOFFSET_IN_CONTROLAREA != -1)
-														{
-															ULONG_PTR* temp_SubsectionPtr;
-															temp_SubsectionPtr = (ULONG_PTR*)(pbMatchingNode + MACRO_SUBSECTION_FIELDOFFSET_IN_VAD);
+		const ULONG nameMaxLen = 255;
 
-															return pMemReadCor->ReadMemory(13, temp_SubsectionPtr);
-														Resume_Label_13:
+		eastl::vector<BcReadMemoryRange> strReads;
+		eastl::vector<size_t> strIndexes;
 
-															if (pMemReadCor->ReadMemory_Succeeded())
-															{
-																BYTE* temp_Subsection;
-																temp_Subsection = *(BYTE**)pMemReadCor->Buffer;
+		ULONG charsNum = 0;
 
-																ULONG_PTR* temp_ControlAreaPtr;
-																temp_ControlAreaPtr = (ULONG_PTR*)(temp_Subsection + MACRO_CONTROLAREA_FIELDOFFSET_IN_SUBSECTION);
+		for (auto& r : reads)
+		{
+			if (!r.ok)
+				continue;
 
-																return pMemReadCor->ReadMemory(14, temp_ControlAreaPtr);
-															Resume_Label_14:
+			UNICODE_STRING* name = (UNICODE_STRING*)r.dest;
 
-																if (pMemReadCor->ReadMemory_Succeeded())
-																{
-																	auto temp_ControlArea = *(BYTE**)pMemReadCor->Buffer;
+			if (name->Length && !(name->Length % sizeof(WORD)) && name->Length <= name->MaximumLength &&
+				name->Length / sizeof(WORD) <= nameMaxLen && name->Buffer)
+			{
+				strReads.push_back({ (ULONG_PTR)name->Buffer, name->Length, (VOID*)(ULONG_PTR)charsNum, FALSE }); // dest is set below.
+				strIndexes.push_back(name - names.data());
 
-																	FileObjectPtr = (ULONG_PTR*)(temp_ControlArea + MACRO_FILEPOINTER_FIELDOFFSET_IN_CONTROLAREA);
-																	IsExFastRef = TRUE;
-																}
-															}
-														}
+				charsNum += name->Length / sizeof(WORD);
+			}
+		}
 
-														return pMemReadCor->ReadMemory(11, FileObjectPtr);
-													Resume_Label_11:
+		eastl::vector<WORD> chars(charsNum);
 
-														if (pMemReadCor->ReadMemory_Succeeded())
-														{
-															pbFileObject = *(BYTE**)pMemReadCor->Buffer;
+		for (auto& r : strReads)
+			r.dest = chars.data() + (ULONG_PTR)r.dest;
 
-															if (IsExFastRef)
-																pbFileObject = (BYTE*)((ULONG_PTR)pbFileObject & (ULONG_PTR)MACRO_MASKOF_EXFASTREF);
+		if (strReads.size())
+			co_await BcAwaiter_ReadMemoryBatch{ strReads.data(), strReads.size() };
 
-															pwImageNameLengthPtr = (WORD*)(pbFileObject + MACRO_FILENAME_FIELDOFFSET_IN_FILEOBJECT);
+		for (size_t j = 0; j < strReads.size(); j++)
+		{
+			if (!strReads[j].ok)
+				continue;
 
-															// Get the Full Name of the Module.
+			const WORD* src = (WORD*)strReads[j].dest;
 
-															return pMemReadCor->ReadMemory(15, pwImageNameLengthPtr);
-														Resume_Label_15:
+			auto& fileName = snapshot->ranges[strIndexes[j]].fileName;
+			fileName.resize(strReads[j].size / sizeof(WORD));
 
-															if (pMemReadCor->ReadMemory_Succeeded())
-															{
-																pwImageNameLengthPtr = (WORD*)pMemReadCor->Buffer;
+			for (size_t k = 0; k < fileName.size(); k++)
+				fileName[k] = (CHAR)(src[k] & 0xFF);
+		}
+	}
 
-																wImageNameLength = *pwImageNameLengthPtr / sizeof(WORD);
+	snapshot->buildTime = __rdtsc() - buildStart;
 
-																if (wImageNameLength != 0 &&
-																	wImageNameLength <= sizeof(szImageName) - 1)
-																{
-																	ImageNameUnicodePtrPtr = (ULONG_PTR*)(pbFileObject +
-																		MACRO_FILENAME_FIELDOFFSET_IN_FILEOBJECT + FIELD_OFFSET(UNICODE_STRING, Buffer));
+	retVal = snapshot;
 
-																	return pMemReadCor->ReadMemory(16, ImageNameUnicodePtrPtr);
-																Resume_Label_16:
+	co_return;
+}
 
-																	if (pMemReadCor->ReadMemory_Succeeded())
-																	{
-																		ImageNameUnicodePtrPtr = (ULONG_PTR*)pMemReadCor->Buffer;
+BcCoroutine Platform::ReadPeHeaders(BOOLEAN& res, PeHeadersInfo& info, ULONG_PTR imageBase) noexcept
+{
+	res = FALSE;
 
-																		pwImageNameUnicodePtr = (WORD*)*ImageNameUnicodePtrPtr;
+	VOID* ptr;
 
-																		if (pwImageNameUnicodePtr != NULL)
-																		{
-																			return pMemReadCor->ReadMemory(17, pwImageNameUnicodePtr, (wImageNameLength + 1) * sizeof(WORD));
-																		Resume_Label_17:
+	// check the DOS header.
 
-																			if (pMemReadCor->ReadMemory_Succeeded())
-																			{
-																				pwImageNameUnicodePtr = (WORD*)pMemReadCor->Buffer;
+	ptr = co_await BcAwaiter_ReadMemory{ imageBase, sizeof(IMAGE_DOS_HEADER) };
+	if (!ptr) co_return;
 
-																				pwWordPtr = pwImageNameUnicodePtr;
-																				pcCharPtr = szImageName;
+	IMAGE_DOS_HEADER* dosHdr = (IMAGE_DOS_HEADER*)ptr;
 
-																				for (ulI = 0; ulI < wImageNameLength; ulI++)
-																					*pcCharPtr++ = (CHAR)((*pwWordPtr++) & 0xFF);
+	if (dosHdr->e_magic != IMAGE_DOS_SIGNATURE ||
+		dosHdr->e_lfarlc < 0x40)
+		co_return;
 
-																				*pcCharPtr = '\0';
-																			}
-																		}
-																	}
-																}
-															}
-														}
-													}
-												}
-											}
-										}
-									}
-								}
-							}
-						}
-					}
-				}
-			}
-		}
+	// check the NT headers.
+
+	ULONG_PTR ntHdrsPtr = imageBase + dosHdr->e_lfanew;
+
+	ptr = co_await BcAwaiter_ReadMemory{ ntHdrsPtr, sizeof(IMAGE_NT_HEADERS64) > sizeof(IMAGE_NT_HEADERS32) ? sizeof(IMAGE_NT_HEADERS64) : sizeof(IMAGE_NT_HEADERS32) };
+	if (!ptr) co_return;
+
+	IMAGE_NT_HEADERS* ntHdrs = (IMAGE_NT_HEADERS*)ptr;
+
+	if (ntHdrs->Signature != IMAGE_NT_SIGNATURE)
+		co_return;
+
+	if (ntHdrs->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC)
+	{
+		info.sizeOfImage = ((IMAGE_NT_HEADERS32*)ntHdrs)->OptionalHeader.SizeOfImage;
+		info.sizeOfNtHeaders = sizeof(IMAGE_NT_HEADERS32);
+		info.dirDebug = ((IMAGE_NT_HEADERS32*)ntHdrs)->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
 	}
-	else
+	else if (ntHdrs->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC)
 	{
-		static WORD* pwImageNameLengthPtr;
-		static WORD wImageNameLength;
-		static WORD* pwWordPtr;
-		static CHAR* pcCharPtr;
-		static ULONG ulI;
-		static WORD* pwImageNameUnicodePtr;
-		static ULONG_PTR* pImageNameUnicodePtrPtr;
-		static ULONG_PTR ImageBase;
-		static IMAGE_DOS_HEADER* pidhDosHdr;
-		static IMAGE_NT_HEADERS* pinhNtHdrs;
-		static LIST_ENTRY* pleListNodePtr;
-		static ULONG_PTR* pImageBasePtr;
-		static LIST_ENTRY* pleThis;
-		static BOOLEAN eraseCacheOn1stAdd;
+		info.sizeOfImage = ((IMAGE_NT_HEADERS64*)ntHdrs)->OptionalHeader.SizeOfImage;
+		info.sizeOfNtHeaders = sizeof(IMAGE_NT_HEADERS64);
+		info.dirDebug = ((IMAGE_NT_HEADERS64*)ntHdrs)->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
+	}
+	else
+		co_return;
 
-		//
-		// PsLoadedModuleList lookups are slow: this cache was introduced later to speed up the process.
-		//
+	info.ntHeaders = ntHdrsPtr;
+	info.fileHeader = ntHdrs->FileHeader;
 
-		class CacheEntry
-		{
-		public:
-			LIST_ENTRY* entry;
-			ULONG_PTR imageBase;
-			ULONG imageSize;
-		};
+	res = TRUE;
 
-		static eastl::vector<CacheEntry>* cache = NULL;
+	co_return;
+}
 
-		if (!cache)
-			cache = new eastl::vector<CacheEntry>(); // allocated in BC's high-irql pool: no need to free.
+BcCoroutine Platform::DiscoverBytePointerPosInModules(CHAR* outputBuffer, ImageDebugInfo* debugInfo, ULONG_PTR pointer) noexcept
+{
+	if (outputBuffer)
+		::strcpy(outputBuffer, "");
 
-		eraseCacheOn1stAdd = TRUE;
+	if (debugInfo)
+		::memset(debugInfo, 0, sizeof(ImageDebugInfo));
 
-		//
-		// KERNEL SPACE.
-		//
+	VOID* ptr;
+	BOOLEAN res;
 
-		pleListNodePtr = (LIST_ENTRY*)params->pvPsLoadedModuleList;
+	ULONG_PTR matchingModuleStart = 0;
+	ULONG matchingModuleLength = 0;
+	PeHeadersInfo hdrs = {};
+	CHAR imageName[256] = { 0 };
 
-		while (TRUE)
-		{
-			if (pleListNodePtr == NULL)
-				break;
+	eastl::vector<NtModule>* ntModules = NULL;
+	NtModule* ntModule = NULL;
 
-			// first iteration on PsLoadedModuleList: check the cache.
+	// reads an unicode string of the specified length in the target and converts it to ascii.
 
-			pleThis = pleListNodePtr;
+	auto copyName = [&imageName](const WORD* src, ULONG len) {
 
-			if (pleThis == (LIST_ENTRY*)params->pvPsLoadedModuleList)
-			{
-				auto ptr = (ULONG_PTR)params->pbBytePointer;
+		CHAR* psz = imageName;
 
-				auto res = eastl::find_if(cache->begin(), cache->end(),
-					[&ptr](const CacheEntry& e) { return ptr >= e.imageBase && ptr < e.imageBase + e.imageSize; });
+		for (ULONG i = 0; i < len; i++)
+			*psz++ = (CHAR)(src[i] & 0xFF);
 
-				if (res != cache->end())
-					pleThis = res->entry;
-			}
+		*psz = '\0';
+	};
 
-			// Check the Module Start Address.
+	// check whether the pointer refers to user memory or kernel memory.
 
-			pImageBasePtr = (ULONG_PTR*)(((BYTE*)pleThis) + MACRO_IMAGEBASE_FIELDOFFSET_IN_DRVSEC);
+	if (pointer < (ULONG_PTR)Platform::UserProbeAddress)
+	{
+		//
+		// USER SPACE.
+		//
 
-			return pMemReadCor->ReadMemory(1, pImageBasePtr);
-		Resume_Label_01:
+		// get the current process: read once per state change.
 
-			if (pMemReadCor->ReadMemory_Succeeded())
-			{
-				pImageBasePtr = (ULONG_PTR*)pMemReadCor->Buffer;
+		ULONG64 kpeb = 0;
 
-				ImageBase = *pImageBasePtr;
+		co_await BcAwaiter_Join{ GetCurrentEprocess(kpeb) };
 
-				// Compare the Image Base and the Specified Pointer.
+		if (kpeb && Root::I->NtModules)
+		{
+			auto fif = eastl::find_if(Root::I->NtModules->begin(), Root::I->NtModules->end(),
+				[&](const eastl::pair<ULONG64, eastl::vector<NtModule>>& e) { return e.first == kpeb; });
 
-				if (((ULONG_PTR)params->pbBytePointer) >= ImageBase)
-				{
-					// Check the DOS Header.
+			if (fif != Root::I->NtModules->end())
+				ntModules = &fif->second;
+		}
 
-					pidhDosHdr = (IMAGE_DOS_HEADER*)ImageBase;
+		// find the VAD range that contains the pointer.
 
-					return pMemReadCor->ReadMemory(2, (BYTE*)pidhDosHdr, sizeof(IMAGE_DOS_HEADER));
-				Resume_Label_02:
+		VadSnapshot* snapshot = NULL;
 
-					if (pMemReadCor->ReadMemory_Succeeded())
-					{
-						pidhDosHdr = (IMAGE_DOS_HEADER*)pMemReadCor->Buffer;
+		if (kpeb)
+			co_await BcAwaiter_Join{ GetVadSnapshot(snapshot, kpeb) };
 
-						if (pidhDosHdr->e_magic == IMAGE_DOS_SIGNATURE &&
-							pidhDosHdr->e_lfarlc >= 0x40)
-						{
-							// Check the NT Headers.
+		const VadRange* range = snapshot ? snapshot->Find(pointer) : NULL;
 
-							pinhNtHdrs = (IMAGE_NT_HEADERS*)(ImageBase + pidhDosHdr->e_lfanew);
+		if (range)
+		{
+			matchingModuleStart = (ULONG_PTR)range->start;
 
-							return pMemReadCor->ReadMemory(3, (BYTE*)pinhNtHdrs, sizeof(IMAGE_NT_HEADERS));
-						Resume_Label_03:
+			co_await BcAwaiter_Join{ ReadPeHeaders(res, hdrs, matchingModuleStart) };
 
-							if (pMemReadCor->ReadMemory_Succeeded())
-							{
-								ULONG temp_Signature;
-								ULONG temp_SizeOfImage;
+			if (res && pointer >= matchingModuleStart && pointer <= matchingModuleStart + hdrs.sizeOfImage - 1)
+			{
+				matchingModuleLength = hdrs.sizeOfImage;
 
-								ifhFileHeader = ((IMAGE_NT_HEADERS*)pMemReadCor->Buffer)->FileHeader; // N.B. This is required later!
-								temp_Signature = ((IMAGE_NT_HEADERS*)pMemReadCor->Buffer)->Signature;
-								temp_SizeOfImage = ((IMAGE_NT_HEADERS*)pMemReadCor->Buffer)->OptionalHeader.SizeOfImage; // we are in the kernel, so OptHdr size is the same as our driver's image.
-								iddDirDebug = ((IMAGE_NT_HEADERS*)pMemReadCor->Buffer)->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
+				// sometimes Windows 10/11 obfuscates the image name.
 
-								if (temp_Signature == IMAGE_NT_SIGNATURE)
-								{
-									// add the image to the cache.
+				::strcpy(imageName, "???");
 
-									if (pleThis == pleListNodePtr) // no cache hit
-									{
-										if (eraseCacheOn1stAdd)
-										{
-											eraseCacheOn1stAdd = FALSE;
-											cache->clear();
-										}
+				// get the full name of the specified module.
 
-										cache->push_back(CacheEntry{ pleThis, ImageBase, temp_SizeOfImage });
-									}
+				if (range->fileName.size() && range->fileName.size() <= sizeof(imageName) - 1)
+					::strcpy(imageName, range->fileName.c_str());
+			}
+		}
+	}
+	else
+	{
+		//
+		// KERNEL SPACE.
+		//
 
-									// Check if the image contains the pointer.
+		if (!KernelModulesCache)
+			KernelModulesCache = new eastl::vector<KernelModulesCacheEntry>(); // allocated in BC's high-irql pool: no need to free.
 
-									if (((ULONG_PTR)params->pbBytePointer) <= ImageBase + temp_SizeOfImage - 1)
-									{
-										// Setup the Variables required later.
+		BOOLEAN eraseCacheOn1stAdd = TRUE;
 
-										pvMatchingModuleStart = (VOID*)ImageBase;
-										ulMatchingModuleLength = temp_SizeOfImage;
-										pbMatchingModuleNtHeaders = (BYTE*)pinhNtHdrs;
+		ULONG_PTR listHead = (ULONG_PTR)Root::I->PsLoadedModuleList;
+		ULONG_PTR listNode = listHead;
 
-										// Sometimes Windows 10/11 obfuscates the image name.
+		while (listNode)
+		{
+			// first iteration on PsLoadedModuleList: check the cache.
 
-										::strcpy(szImageName, "???");
+			ULONG_PTR thisEntry = listNode;
 
-										// Get the Name of the Module.
+			if (thisEntry == listHead)
+			{
+				auto fif = eastl::find_if(KernelModulesCache->begin(), KernelModulesCache->end(),
+					[&pointer](const KernelModulesCacheEntry& e) { return pointer >= e.imageBase && pointer < e.imageBase + e.imageSize; });
 
-										pwImageNameLengthPtr = (WORD*)(((BYTE*)pleThis) + MACRO_IMAGENAME_FIELDOFFSET_IN_DRVSEC);
+				if (fif != KernelModulesCache->end())
+					thisEntry = fif->entry;
+			}
 
-										return pMemReadCor->ReadMemory(4, pwImageNameLengthPtr);
-									Resume_Label_04:
+			// read the image base, the image name and the pointer to the next node at once.
 
-										if (pMemReadCor->ReadMemory_Succeeded())
-										{
-											pwImageNameLengthPtr = (WORD*)pMemReadCor->Buffer;
+			ULONG_PTR imageBase = 0;
+			UNICODE_STRING name = {};
+			ULONG_PTR nextNode = 0;
 
-											wImageNameLength = *pwImageNameLengthPtr / sizeof(WORD);
+			BcReadMemoryRange reads[] = {
+				{ thisEntry + MACRO_IMAGEBASE_FIELDOFFSET_IN_DRVSEC, sizeof(imageBase), &imageBase, FALSE },
+				{ thisEntry + MACRO_IMAGENAME_FIELDOFFSET_IN_DRVSEC, sizeof(name), &name, FALSE },
+				{ listNode + FIELD_OFFSET(LIST_ENTRY, Flink), sizeof(nextNode), &nextNode, FALSE }
+			};
 
-											if (wImageNameLength != 0 &&
-												wImageNameLength <= sizeof(szImageName) - 1)
-											{
-												pImageNameUnicodePtrPtr = (ULONG_PTR*)(((BYTE*)pleThis) +
-													MACRO_IMAGENAME_FIELDOFFSET_IN_DRVSEC + FIELD_OFFSET(UNICODE_STRING, Buffer));
+			co_await BcAwaiter_ReadMemoryBatch{ reads, sizeof(reads) / sizeof(reads[0]) };
 
-												return pMemReadCor->ReadMemory(5, pImageNameUnicodePtrPtr);
-											Resume_Label_05:
+			// compare the image base and the specified pointer.
 
-												if (pMemReadCor->ReadMemory_Succeeded())
-												{
-													pImageNameUnicodePtrPtr = (ULONG_PTR*)pMemReadCor->Buffer;
+			if (reads[0].ok && pointer >= imageBase)
+			{
+				co_await BcAwaiter_Join{ ReadPeHeaders(res, hdrs, imageBase) };
 
-													pwImageNameUnicodePtr = (WORD*)*pImageNameUnicodePtrPtr;
+				if (res)
+				{
+					// add the image to the cache.
 
-													if (pwImageNameUnicodePtr != NULL)
-													{
-														return pMemReadCor->ReadMemory(6, pwImageNameUnicodePtr, (wImageNameLength + 1) * sizeof(WORD));
-													Resume_Label_06:
+					if (thisEntry == listNode) // no cache hit
+					{
+						if (eraseCacheOn1stAdd)
+						{
+							eraseCacheOn1stAdd = FALSE;
+							KernelModulesCache->clear();
+						}
 
-														if (pMemReadCor->ReadMemory_Succeeded())
-														{
-															pwImageNameUnicodePtr = (WORD*)pMemReadCor->Buffer;
+						KernelModulesCache->push_back(KernelModulesCacheEntry{ thisEntry, imageBase, hdrs.sizeOfImage });
+					}
 
-															pwWordPtr = pwImageNameUnicodePtr;
-															pcCharPtr = szImageName;
+					// check if the image contains the pointer.
 
-															for (ulI = 0; ulI < wImageNameLength; ulI++)
-																*pcCharPtr++ = (CHAR)((*pwWordPtr++) & 0xFF);
+					if (pointer <= imageBase + hdrs.sizeOfImage - 1)
+					{
+						matchingModuleStart = imageBase;
+						matchingModuleLength = hdrs.sizeOfImage;
 
-															*pcCharPtr = '\0';
-														}
-													}
-												}
-											}
-										}
+						// sometimes Windows 10/11 obfuscates the image name.
 
-										// Exit from the Loop.
+						::strcpy(imageName, "???");
 
-										break;
-									}
-								}
-							}
+						// get the name of the module.
+
+						ULONG nameLen = name.Length / sizeof(WORD);
+
+						if (reads[1].ok && nameLen != 0 && nameLen <= sizeof(imageName) - 1 && name.Buffer)
+						{
+							ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)name.Buffer, (nameLen + 1) * sizeof(WORD) };
+
+							if (ptr)
+								copyName((WORD*)ptr, nameLen);
 						}
+
+						// exit from the loop.
+
+						break;
 					}
 				}
 			}
 
-			// Get the Pointer to the Next Node.
-
-			return pMemReadCor->ReadMemory(7, (ULONG_PTR*)(((BYTE*)pleListNodePtr) + FIELD_OFFSET(LIST_ENTRY, Flink)));
-		Resume_Label_07:
+			// go to the next node.
 
-			if (!(pMemReadCor->ReadMemory_Succeeded()))
+			if (!reads[2].ok)
 				break;
 
-			pleListNodePtr = *(LIST_ENTRY**)pMemReadCor->Buffer;
+			listNode = nextNode;
 
-			if (pleListNodePtr == NULL ||
-				pleListNodePtr == (LIST_ENTRY*)params->pvPsLoadedModuleList)
+			if (listNode == listHead)
 				break;
 		}
 	}
 
-	// Save the debug info separetely.
+	// read the debug directory and the section headers at once.
 
-	if (params->pidiDebugInfo &&
-		pvMatchingModuleStart && ulMatchingModuleLength)
+	const ULONG debDirsMaxNum = 32; // ntoskrnl of Windows 11 has 4 of these, and Windows XP only 1...
+	IMAGE_DEBUG_DIRECTORY debDirs[debDirsMaxNum];
+	ULONG debDirsNum = 0;
+
+	const ULONG sectionsMaxNum = 96; // max number of sections allowed by the loader.
+	IMAGE_SECTION_HEADER sections[sectionsMaxNum];
+	ULONG sectionsNum = 0;
+
+	if (matchingModuleStart && matchingModuleLength && hdrs.ntHeaders)
 	{
-		params->pidiDebugInfo->startAddr = (ULONG_PTR)pvMatchingModuleStart;
-		params->pidiDebugInfo->length = ulMatchingModuleLength;
+		BcReadMemoryRange reads[2];
+		size_t readsNum = 0;
+
+		if (debugInfo && hdrs.dirDebug.VirtualAddress && hdrs.dirDebug.Size)
+		{
+			debDirsNum = _MIN_(hdrs.dirDebug.Size / (ULONG)sizeof(IMAGE_DEBUG_DIRECTORY), debDirsMaxNum);
+
+			if (debDirsNum)
+				reads[readsNum++] = { matchingModuleStart + hdrs.dirDebug.VirtualAddress, debDirsNum * (ULONG)sizeof(IMAGE_DEBUG_DIRECTORY), debDirs, FALSE };
+		}
 
-		if (iddDirDebug.VirtualAddress && iddDirDebug.Size)
+		if (outputBuffer && hdrs.fileHeader.NumberOfSections)
 		{
-			return pMemReadCor->ReadMemory(22, (VOID*)((ULONG_PTR)pvMatchingModuleStart + iddDirDebug.VirtualAddress), iddDirDebug.Size);
-		Resume_Label_22:
+			sectionsNum = _MIN_((ULONG)hdrs.fileHeader.NumberOfSections, sectionsMaxNum);
+
+			reads[readsNum++] = { hdrs.ntHeaders + hdrs.sizeOfNtHeaders, sectionsNum * (ULONG)sizeof(IMAGE_SECTION_HEADER), sections, FALSE };
+		}
 
-			if (pMemReadCor->ReadMemory_Succeeded())
+		if (readsNum)
+			co_await BcAwaiter_ReadMemoryBatch{ reads, readsNum };
+
+		for (size_t i = 0; i < readsNum; i++)
+			if (!reads[i].ok)
 			{
-				const static int iddDebDir_size = 32; // ntoskrnl of Windows 11 has 4 of these, and Windows XP only 1...
-				static IMAGE_DEBUG_DIRECTORY iddDebDir[iddDebDir_size];
-				static ULONG nDebDir;
-				static int i;
+				if (reads[i].dest == debDirs)
+					debDirsNum = 0;
+				else
+					sectionsNum = 0;
+			}
+	}
 
-				IMAGE_DEBUG_DIRECTORY* temp_pDebDir;
-				temp_pDebDir = (IMAGE_DEBUG_DIRECTORY*)pMemReadCor->Buffer;
+	// save the debug info separately.
 
-				nDebDir = iddDirDebug.Size / sizeof(IMAGE_DEBUG_DIRECTORY);
-				if (nDebDir > iddDebDir_size)
-					nDebDir = iddDebDir_size;
+	if (debugInfo &&
+		matchingModuleStart && matchingModuleLength)
+	{
+		debugInfo->startAddr = matchingModuleStart;
+		debugInfo->length = matchingModuleLength;
 
-				::memcpy(iddDebDir, temp_pDebDir, nDebDir * sizeof(IMAGE_DEBUG_DIRECTORY));
+		for (ULONG i = 0; i < debDirsNum; i++)
+		{
+			if (debDirs[i].Type == IMAGE_DEBUG_TYPE_CODEVIEW)
+			{
+				ptr = co_await BcAwaiter_ReadMemory{ matchingModuleStart + debDirs[i].AddressOfRawData, debDirs[i].SizeOfData < 512 ? debDirs[i].SizeOfData : 512 };
 
-				for (i = 0; i < nDebDir; i++)
+				if (ptr)
 				{
-					if (iddDebDir[i].Type == IMAGE_DEBUG_TYPE_CODEVIEW)
-					{
-						return pMemReadCor->ReadMemory(23,
-							(VOID*)((ULONG_PTR)pvMatchingModuleStart + iddDebDir[i].AddressOfRawData),
-							iddDebDir[i].SizeOfData < 512 ? iddDebDir[i].SizeOfData : 512);
-					Resume_Label_23:
-
-						if (pMemReadCor->ReadMemory_Succeeded())
-						{
-							auto temp_pbCV = (BYTE*)pMemReadCor->Buffer;
+					auto pbCV = (BYTE*)ptr;
 
-							DWORD sig = *(DWORD*)temp_pbCV;
+					DWORD sig = *(DWORD*)pbCV;
 
-							if (sig == 'SDSR')
-							{
-								BYTE* guid = temp_pbCV + sizeof(DWORD);
-								DWORD* age = (DWORD*)(guid + 16);
+					if (sig == 'SDSR')
+					{
+						BYTE* guid = pbCV + sizeof(DWORD);
+						DWORD* age = (DWORD*)(guid + 16);
 
-								CHAR* pdbn = (CHAR*)((BYTE*)age + sizeof(DWORD));
-								ULONG nfn = iddDebDir[i].SizeOfData - (ULONG)((ULONG_PTR)pdbn - (ULONG_PTR)temp_pbCV);
+						CHAR* pdbn = (CHAR*)((BYTE*)age + sizeof(DWORD));
+						ULONG nfn = debDirs[i].SizeOfData - (ULONG)((ULONG_PTR)pdbn - (ULONG_PTR)pbCV);
 
-								if (nfn > sizeof(params->pidiDebugInfo->szPdb) - 1)
-									nfn = sizeof(params->pidiDebugInfo->szPdb) - 1;
+						if (nfn > sizeof(debugInfo->szPdb) - 1)
+							nfn = sizeof(debugInfo->szPdb) - 1;
 
-								::memcpy(params->pidiDebugInfo->guid, guid, 16);
+						::memcpy(debugInfo->guid, guid, 16);
 
-								params->pidiDebugInfo->age = *age;
+						debugInfo->age = *age;
 
-								::memset(params->pidiDebugInfo->szPdb, 0, sizeof(params->pidiDebugInfo->szPdb));
-								::memcpy(params->pidiDebugInfo->szPdb, pdbn, nfn);
+						::memset(debugInfo->szPdb, 0, sizeof(debugInfo->szPdb));
+						::memcpy(debugInfo->szPdb, pdbn, nfn);
 
-								break;
-							}
-						}
+						break;
 					}
 				}
 			}
@@ -838,39 +761,37 @@ MemoryReaderCoroutineState* Platform::DiscoverBytePointerPosInModules(MemoryRead
 
 	// compensate with NtModules.
 
-	if (pvNtModules && pvMatchingModuleStart)
+	if (ntModules && matchingModuleStart)
 	{
-		auto fif = eastl::find_if(pvNtModules->begin(), pvNtModules->end(),
-			[&](const NtModule& e) { return e.dllBase == (ULONG64)(ULONG_PTR)pvMatchingModuleStart; });
+		auto fif = eastl::find_if(ntModules->begin(), ntModules->end(),
+			[&](const NtModule& e) { return e.dllBase == (ULONG64)matchingModuleStart; });
 
-		if (fif != pvNtModules->end())
-		{
-			pNtModule = fif;
-		}
+		if (fif != ntModules->end())
+			ntModule = fif;
 	}
 
-	if (pNtModule && (!::strlen(szImageName) || !::strcmp(szImageName, "???")))
+	if (ntModule && (!::strlen(imageName) || !::strcmp(imageName, "???")))
 	{
-		ulMatchingModuleLength = pNtModule->sizeOfImage;
-		if (::strlen(pNtModule->dllName))
-			::strcpy(szImageName, pNtModule->dllName);
+		matchingModuleLength = ntModule->sizeOfImage;
+		if (::strlen(ntModule->dllName))
+			::strcpy(imageName, ntModule->dllName);
 	}
 
-	if (params->pidiDebugInfo && !::strlen(params->pidiDebugInfo->szPdb) && pNtModule)
+	if (debugInfo && !::strlen(debugInfo->szPdb) && ntModule)
 	{
-		params->pidiDebugInfo->startAddr = (ULONG_PTR)pNtModule->dllBase;
-		params->pidiDebugInfo->length = pNtModule->sizeOfImage;
-		::memcpy(params->pidiDebugInfo->guid, pNtModule->pdbGuid, 16);
-		params->pidiDebugInfo->age = pNtModule->pdbAge;
-		::strcpy(params->pidiDebugInfo->szPdb, pNtModule->pdbName);
+		debugInfo->startAddr = (ULONG_PTR)ntModule->dllBase;
+		debugInfo->length = ntModule->sizeOfImage;
+		::memcpy(debugInfo->guid, ntModule->pdbGuid, 16);
+		debugInfo->age = ntModule->pdbAge;
+		::strcpy(debugInfo->szPdb, ntModule->pdbName);
 	}
 
 	// sometimes newer versions of Windows obfuscate the module name: compensate with pdb name, if possible.
 
-	if (params->pidiDebugInfo && !::strcmp(szImageName, "???") && ::strlen(params->pidiDebugInfo->szPdb))
+	if (debugInfo && !::strcmp(imageName, "???") && ::strlen(debugInfo->szPdb))
 	{
-		static CHAR sz0[sizeof(params->pidiDebugInfo->szPdb)];
-		::strcpy(sz0, params->pidiDebugInfo->szPdb);
+		CHAR sz0[sizeof(debugInfo->szPdb)];
+		::strcpy(sz0, debugInfo->szPdb);
 
 		CHAR* psz = &sz0[::strlen(sz0) - 1];
 
@@ -883,131 +804,74 @@ MemoryReaderCoroutineState* Platform::DiscoverBytePointerPosInModules(MemoryRead
 		psz++;
 
 		if (::strlen(psz))
-			::strcpy(szImageName, psz);
+			::strcpy(imageName, psz);
 	}
 
-	// Check whether there is a Match.
+	// check whether there is a match.
 
-	if (params->pszOutputBuffer &&
-		pvMatchingModuleStart && ulMatchingModuleLength &&
-		strlen(szImageName))
-	{
-		static IMAGE_SECTION_HEADER* pishSectionList;
-		static ULONG ulI;
-		static IMAGE_SECTION_HEADER* pishThis;
-		static ULONG_PTR Start, End, Offset;
-		static CHAR* pszImageNameToBePrinted;
-		static BOOLEAN bPreserveModuleFileExtension;
-		static CHAR szSectionName[64];
-
-		bPreserveModuleFileExtension = FALSE; // TRUE
-
-		// Set the Pointer to the Image Name String.
-
-		pszImageNameToBePrinted = &szImageName[strlen(szImageName) - 1];
-
-		for (; pszImageNameToBePrinted >= szImageName; pszImageNameToBePrinted--)
-			if (*pszImageNameToBePrinted == '.' && bPreserveModuleFileExtension == FALSE)
-				*pszImageNameToBePrinted = '\0';
-			else if (*pszImageNameToBePrinted == '\\' ||
-				*pszImageNameToBePrinted == '/')
-				break;
-
-		pszImageNameToBePrinted++;
-
-		if (strlen(pszImageNameToBePrinted))
-		{
-			if (!pbMatchingModuleNtHeaders)
-			{
-				// Compose the Required String without Section Information.
-
-				Offset = ((ULONG_PTR)params->pbBytePointer) - ((ULONG_PTR)pvMatchingModuleStart);
-
-				if (Offset)
-				{
-					sprintf(params->pszOutputBuffer, "%s+%.8X",
-						pszImageNameToBePrinted, (ULONG32)Offset);
-				}
-				else
-				{
-					sprintf(params->pszOutputBuffer, "%s",
-						pszImageNameToBePrinted);
-				}
-			}
-			else
-			{
-				// Check the Sections of the Image.
+	if (!outputBuffer ||
+		!matchingModuleStart || !matchingModuleLength ||
+		!::strlen(imageName))
+		co_return;
 
-				pishSectionList = (IMAGE_SECTION_HEADER*)(((BYTE*)pbMatchingModuleNtHeaders) + ulSizeofNtHeaders);
+	// set the pointer to the image name string.
 
-				return pMemReadCor->ReadMemory(8, (BYTE*)pishSectionList, ifhFileHeader.NumberOfSections * sizeof(IMAGE_SECTION_HEADER));
-			Resume_Label_08:
+	CHAR* imageNameToBePrinted = &imageName[::strlen(imageName) - 1];
 
-				if (pMemReadCor->ReadMemory_Succeeded())
-				{
-					pishSectionList = (IMAGE_SECTION_HEADER*)pMemReadCor->Buffer;
+	for (; imageNameToBePrinted >= imageName; imageNameToBePrinted--)
+		if (*imageNameToBePrinted == '.')
+			*imageNameToBePrinted = '\0';
+		else if (*imageNameToBePrinted == '\\' ||
+			*imageNameToBePrinted == '/')
+			break;
 
-					// Iterate through the Section List Items.
+	imageNameToBePrinted++;
 
-					for (ulI = 0; ulI < ifhFileHeader.NumberOfSections; ulI++)
-					{
-						pishThis = &pishSectionList[ulI];
-
-						if (pishThis->SizeOfRawData == 0)
-							continue;
+	if (!::strlen(imageNameToBePrinted))
+		co_return;
 
-						Start = ((ULONG_PTR)pvMatchingModuleStart) + pishThis->VirtualAddress;
-						End = Start + pishThis->SizeOfRawData - 1;
+	// check the sections of the image.
 
-						if (((ULONG_PTR)params->pbBytePointer) >= Start &&
-							((ULONG_PTR)params->pbBytePointer) <= End)
-						{
-							Offset = ((ULONG_PTR)params->pbBytePointer) - Start;
+	for (ULONG i = 0; i < sectionsNum; i++)
+	{
+		IMAGE_SECTION_HEADER* section = &sections[i];
 
-							// Compose the Required String.
+		if (section->SizeOfRawData == 0)
+			continue;
 
-							memset(szSectionName, 0, sizeof(szSectionName));
-							memcpy(szSectionName, pishThis->Name, IMAGE_SIZEOF_SHORT_NAME);
+		ULONG_PTR start = matchingModuleStart + section->VirtualAddress;
+		ULONG_PTR end = start + section->SizeOfRawData - 1;
 
-							if (Offset)
-							{
-								sprintf(params->pszOutputBuffer, "%s!%s+%.8X",
-									pszImageNameToBePrinted, szSectionName, (ULONG32)Offset);
-							}
-							else
-							{
-								sprintf(params->pszOutputBuffer, "%s!%s",
-									pszImageNameToBePrinted, szSectionName);
-							}
+		if (pointer >= start && pointer <= end)
+		{
+			ULONG_PTR offset = pointer - start;
 
-							// Return to the Caller.
+			// compose the required string.
 
-							return pMemReadCor->ReadMemory_End();
-						}
-					}
+			CHAR sectionName[64];
 
-					// Compose the Required String without Section Information.
+			::memset(sectionName, 0, sizeof(sectionName));
+			::memcpy(sectionName, section->Name, IMAGE_SIZEOF_SHORT_NAME);
 
-					Offset = ((ULONG_PTR)params->pbBytePointer) - ((ULONG_PTR)pvMatchingModuleStart);
+			if (offset)
+				::sprintf(outputBuffer, "%s!%s+%.8X", imageNameToBePrinted, sectionName, (ULONG32)offset);
+			else
+				::sprintf(outputBuffer, "%s!%s", imageNameToBePrinted, sectionName);
 
-					if (Offset)
-					{
-						sprintf(params->pszOutputBuffer, "%s+%.8X",
-							pszImageNameToBePrinted, (ULONG32)Offset);
-					}
-					else
-					{
-						sprintf(params->pszOutputBuffer, "%s",
-							pszImageNameToBePrinted);
-					}
-				}
-			}
+			co_return;
 		}
 	}
 
-	// Return to the Caller.
+	// compose the required string without section information.
+
+	ULONG_PTR offset = pointer - matchingModuleStart;
 
-	return pMemReadCor->ReadMemory_End();
+	if (offset)
+		::sprintf(outputBuffer, "%s+%.8X", imageNameToBePrinted, (ULONG32)offset);
+	else
+		::sprintf(outputBuffer, "%s", imageNameToBePrinted);
+
+	co_return;
 }
 
 VOID* Platform::GetPcrAddress()
@@ -1072,7 +936,7 @@ eastl::string Platform::CalculateKernelOffsets(VOID* symbols)
 	BCSFILE_DATATYPE_MEMBER notFound = {};
 	notFound.offset = -1;
 
-	auto getMember = [&symbols, &notFound](const char* expectedType, const char** types, const char** members) -> const BCSFILE_DATATYPE_MEMBER* {
+	auto getMember = [&symbols, &notFound](const char* expectedType, const auto& types, const auto& members) -> const BCSFILE_DATATYPE_MEMBER* { // N.B. references: GCC does not decay the temporary arrays of the callers.
 
 		for (int i = 0; types[i]; i++)
 		{
@@ -1448,7 +1312,7 @@ BOOLEAN Platform::TryGetKernelDebugInfoWithoutSymbols(IN PDRIVER_OBJECT pDriverO
 
 			auto ndeb = deb.Size / sizeof(IMAGE_DEBUG_DIRECTORY);
 
-			for (int i = 0; i < ndeb; i++)
+			for (int i = 0; i < (int)ndeb; i++)
 			{
 				if (dir[i].Type == IMAGE_DEBUG_TYPE_CODEVIEW)
 				{
@@ -1519,15 +1383,12 @@ BcCoroutine Platform::GetCurrentImageFileName(eastl::string& retVal) noexcept
 
 	// read the string.
 
-	VOID* ptr;
+	ULONG64 eprocess = 0;
 
-	ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)GetPcrAddress() + MACRO_KTEBPTR_FIELDOFFSET_IN_PCR, sizeof(VOID*) };
-	if (!ptr) co_return;
+	co_await BcAwaiter_Join{ GetCurrentEprocess(eprocess) };
+	if (!eprocess) co_return;
 
-	ptr = co_await BcAwaiter_ReadMemory{ *(ULONG_PTR*)ptr + MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB, sizeof(VOID*) };
-	if (!ptr) co_return;
-
-	ptr = co_await BcAwaiter_ReadMemory{ *(ULONG_PTR*)ptr + offset, (size_t)size };
+	VOID* ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)eprocess + offset, (size_t)size };
 	if (!ptr) co_return;
 
 	CHAR buffer[32] = { 0 };
@@ -1635,7 +1496,7 @@ VOID Platform::GetModuleDebugInfo(ULONG64 dllBase, BYTE* pdbGuid, DWORD& pdbAge,
 
 				auto ndeb = deb->Size / sizeof(IMAGE_DEBUG_DIRECTORY);
 
-				for (int i = 0; i < ndeb && i < 64; i++)
+				for (int i = 0; i < (int)ndeb && i < 64; i++)
 				{
 					if (dir[i].Type == IMAGE_DEBUG_TYPE_CODEVIEW)
 					{
@@ -1936,15 +1797,51 @@ VOID Platform::CreateProcessNotifyRoutine(HANDLE ParentId, HANDLE ProcessId, BOO
 		NtModulesAccess _access_(TRUE, "Platform::CreateProcessNotifyRoutine"); // N.B. no calls to BC's allocator OUTSIDE OF this scope (including calls to STL/EASTL).
 
 		int pos = -1;
-		auto& mods = GetNtModulesByProcess((ULONG64)(ULONG_PTR)process, &pos);
+		GetNtModulesByProcess((ULONG64)(ULONG_PTR)process, &pos);
 		if (pos < 0) return;
 
 		Root::I->NtModules->erase(Root::I->NtModules->begin() + pos);
 	}
 }
 
+VOID Platform::GetKernelUnwindSnapshot(IN PDRIVER_OBJECT pDriverObject)
+{
+	size_t poolStart = Allocator::Perf_TotalAllocatedSize;
+
+	// iterate through PsLoadedModuleList, starting from our entry: the DllBase of the list head is not an image and is discarded by SnapshotModule.
+
+	auto head = (LIST_ENTRY*)pDriverObject->DriverSection;
+	auto entry = head;
+
+	for (int i = 0; i < 4096; i++)
+	{
+		auto base = *(ULONG_PTR*)((ULONG_PTR)entry + MACRO_IMAGEBASE_FIELDOFFSET_IN_DRVSEC);
+
+		if (base >= (ULONG_PTR)UserProbeAddress)
+			UnwindTables::SnapshotModule(base);
+
+		entry = entry->Flink;
+		if (entry == head)
+			break;
+	}
+
+	// print a debug string.
+
+	::DbgPrint("Platform::GetKernelUnwindSnapshot -> %i entries, allocated %i bytes.",
+		Root::I->UnwindInfo ? (LONG32)Root::I->UnwindInfo->entriesNum : 0,
+		(LONG32)((LONG_PTR)Allocator::Perf_TotalAllocatedSize - (LONG_PTR)poolStart));
+}
+
 VOID Platform::LoadImageNotifyRoutine(PUNICODE_STRING FullImageName, HANDLE ProcessId, PIMAGE_INFO ImageInfo)
 {
+	// kernel modules: take a snapshot of their unwind info for the stack walker.
+
+	if (!ProcessId && ImageInfo && ImageInfo->ImageBase && ImageInfo->SystemModeImage)
+	{
+		UnwindTables::SnapshotModule((ULONG_PTR)ImageInfo->ImageBase);
+		return;
+	}
+
 	if (!ProcessId || !ImageInfo || !ImageInfo->ImageBase ||
 		(ULONG_PTR)ImageInfo->ImageBase >= (ULONG_PTR)UserProbeAddress || !ImageInfo->ImageSize)
 		return;
@@ -1988,7 +1885,7 @@ VOID Platform::LoadImageNotifyRoutine(PUNICODE_STRING FullImageName, HANDLE Proc
 
 		VOID Add(ULONG64 dllBase)
 		{
-			if (index >= size / sizeof(ULONG64)) return;
+			if (index >= (int)(size / sizeof(ULONG64))) return;
 
 			ptr[index++] = dllBase;
 		}
@@ -2099,17 +1996,29 @@ VOID Platform::LoadImageNotifyRoutine(PUNICODE_STRING FullImageName, HANDLE Proc
 
 BcCoroutine Platform::GetCurrentEprocess(ULONG64& dest) noexcept
 {
-	dest = 0;
+	// the current thread is already in the state change, and its process doesn't change until the OS is resumed.
+
+	dest = Root::I->CurrentEprocess;
+
+	if (dest)
+		co_return;
 
 	VOID* ptr;
 
-	ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)GetPcrAddress() + MACRO_KTEBPTR_FIELDOFFSET_IN_PCR, sizeof(VOID*) };
-	if (!ptr) co_return;
+	ULONG_PTR thread = (ULONG_PTR)Root::I->StateChange.Thread;
+
+	if (!thread)
+	{
+		ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)GetPcrAddress() + MACRO_KTEBPTR_FIELDOFFSET_IN_PCR, sizeof(VOID*) };
+		if (!ptr) co_return;
+
+		thread = *(ULONG_PTR*)ptr;
+	}
 
-	ptr = co_await BcAwaiter_ReadMemory{ *(ULONG_PTR*)ptr + MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB, sizeof(VOID*) };
+	ptr = co_await BcAwaiter_ReadMemory{ thread + MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB, sizeof(VOID*) };
 	if (!ptr) co_return;
 
-	dest = *(ULONG_PTR*)ptr;
+	dest = Root::I->CurrentEprocess = *(ULONG_PTR*)ptr;
 
 	co_return;
 }
@@ -2121,14 +2030,14 @@ BcCoroutine Platform::GetWow64Peb(ULONG64& dest, ULONG64 eproc) noexcept
 	VOID* ptr;
 
 	if (MACRO_WOW64_PROCESS_FIELDOFFSET_IN_EPROCESS >= 0)
-		if (ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)eproc + MACRO_WOW64_PROCESS_FIELDOFFSET_IN_EPROCESS, sizeof(VOID*) })
+		if ((ptr = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)eproc + MACRO_WOW64_PROCESS_FIELDOFFSET_IN_EPROCESS, sizeof(VOID*) }))
 		{
 			ULONG_PTR wowProc = *(ULONG_PTR*)ptr;
 
 			if (wowProc)
 			{
 				if (MACRO_WOW64_PEB_FIELDOFFSET_IN_WOW64PROCESS >= 0)
-					if (ptr = co_await BcAwaiter_ReadMemory{ wowProc + MACRO_WOW64_PEB_FIELDOFFSET_IN_WOW64PROCESS, sizeof(VOID*) })
+					if ((ptr = co_await BcAwaiter_ReadMemory{ wowProc + MACRO_WOW64_PEB_FIELDOFFSET_IN_WOW64PROCESS, sizeof(VOID*) }))
 						wowProc = *(ULONG_PTR*)ptr;
 
 				dest = wowProc;
@@ -2170,16 +2079,16 @@ BcCoroutine Platform::RefreshNtModulesForProc0() noexcept
 
 		ULONG32 arch = _6432_(64, 32);
 
-		if (ptr = co_await BcAwaiter_ReadMemory{ listNodePtr + MACRO_IMAGEBASE_FIELDOFFSET_IN_DRVSEC, sizeof(VOID*) })
+		if ((ptr = co_await BcAwaiter_ReadMemory{ listNodePtr + MACRO_IMAGEBASE_FIELDOFFSET_IN_DRVSEC, sizeof(VOID*) }))
 		{
 			imageBase = *(ULONG_PTR*)ptr;
 
-			if (ptr = co_await BcAwaiter_ReadMemory{ imageBase, sizeof(IMAGE_DOS_HEADER) })
+			if ((ptr = co_await BcAwaiter_ReadMemory{ imageBase, sizeof(IMAGE_DOS_HEADER) }))
 			{
 				if (((IMAGE_DOS_HEADER*)ptr)->e_magic == IMAGE_DOS_SIGNATURE &&
 					((IMAGE_DOS_HEADER*)ptr)->e_lfarlc >= 0x40)
 				{
-					if (ptr = co_await BcAwaiter_ReadMemory{ imageBase + ((IMAGE_DOS_HEADER*)ptr)->e_lfanew, sizeof(IMAGE_NT_HEADERS) })
+					if ((ptr = co_await BcAwaiter_ReadMemory{ imageBase + ((IMAGE_DOS_HEADER*)ptr)->e_lfanew, sizeof(IMAGE_NT_HEADERS) }))
 					{
 						if (((IMAGE_NT_HEADERS*)ptr)->Signature == IMAGE_NT_SIGNATURE)
 						{
@@ -2191,7 +2100,7 @@ BcCoroutine Platform::RefreshNtModulesForProc0() noexcept
 
 							BOOLEAN found = FALSE;
 
-							for (int i = 0; i < mods->size(); i++)
+							for (int i = 0; i < (int)mods->size(); i++)
 								if ((*mods)[i].dllBase == imageBase && (*mods)[i].sizeOfImage == sizeOfImage)
 								{
 									found = TRUE;
@@ -2203,7 +2112,7 @@ BcCoroutine Platform::RefreshNtModulesForProc0() noexcept
 							{
 								// get the image name.
 
-								if (ptr = co_await BcAwaiter_ReadMemory{ listNodePtr + MACRO_IMAGENAME_FIELDOFFSET_IN_DRVSEC, sizeof(UNICODE_STRING) })
+								if ((ptr = co_await BcAwaiter_ReadMemory{ listNodePtr + MACRO_IMAGENAME_FIELDOFFSET_IN_DRVSEC, sizeof(UNICODE_STRING) }))
 								{
 									ULONG nameLen = ((UNICODE_STRING*)ptr)->Length / sizeof(WORD);
 									ULONG_PTR nameBuff = (ULONG_PTR)((UNICODE_STRING*)ptr)->Buffer;
@@ -2211,7 +2120,7 @@ BcCoroutine Platform::RefreshNtModulesForProc0() noexcept
 									if (nameLen != 0 &&
 										nameLen <= sizeof(imageName) - 1)
 									{
-										if (ptr = co_await BcAwaiter_ReadMemory{ nameBuff, (nameLen + 1) * sizeof(WORD) })
+										if ((ptr = co_await BcAwaiter_ReadMemory{ nameBuff, (nameLen + 1) * sizeof(WORD) }))
 										{
 											WORD* wordPtr = (WORD*)ptr;
 											CHAR* charPtr = imageName;
@@ -2231,7 +2140,7 @@ BcCoroutine Platform::RefreshNtModulesForProc0() noexcept
 
 								if (dirDebug.VirtualAddress && dirDebug.Size)
 								{
-									if (ptr = co_await BcAwaiter_ReadMemory{ imageBase + dirDebug.VirtualAddress, dirDebug.Size })
+									if ((ptr = co_await BcAwaiter_ReadMemory{ imageBase + dirDebug.VirtualAddress, dirDebug.Size }))
 									{
 										const static int iddDebDir_size = 32; // ntoskrnl of Windows 11 has 4 of these, and Windows XP only 1...
 										IMAGE_DEBUG_DIRECTORY iddDebDir[iddDebDir_size];
@@ -2242,12 +2151,12 @@ BcCoroutine Platform::RefreshNtModulesForProc0() noexcept
 
 										::memcpy(iddDebDir, ptr, nDebDir * sizeof(IMAGE_DEBUG_DIRECTORY));
 
-										for (int i = 0; i < nDebDir; i++)
+										for (int i = 0; i < (int)nDebDir; i++)
 										{
 											if (iddDebDir[i].Type == IMAGE_DEBUG_TYPE_CODEVIEW)
 											{
-												if (ptr = co_await BcAwaiter_ReadMemory{ imageBase + iddDebDir[i].AddressOfRawData,
-													iddDebDir[i].SizeOfData < 512 ? iddDebDir[i].SizeOfData : 512 })
+												if ((ptr = co_await BcAwaiter_ReadMemory{ imageBase + iddDebDir[i].AddressOfRawData,
+													iddDebDir[i].SizeOfData < 512 ? iddDebDir[i].SizeOfData : 512 }))
 												{
 													auto temp_pbCV = (BYTE*)ptr;
 
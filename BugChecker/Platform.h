@@ -81,15 +81,34 @@ public:
 	CHAR pdbName[64] = { 0 };
 };
 
-class DiscoverBytePointerPosInModules_Params
+class VadRange
 {
 public:
-	OUT CHAR* pszOutputBuffer;
-	OUT ImageDebugInfo* pidiDebugInfo;
-	IN BYTE* pbBytePointer;
-	IN VOID* pvPsLoadedModuleList;
-	IN VOID* pvMmUserProbeAddress;
-	IN VOID* pvPCRAddress;
+	ULONG64 start = 0;
+	ULONG64 end = 0; // inclusive.
+	ULONG64 node = 0;
+	eastl::string fileName; // empty if the range doesn't map a file.
+};
+
+class VadSnapshot // the VAD ranges of a process, sorted by start address: built once per break-in.
+{
+public:
+	ULONG64 eprocess = 0;
+	ULONG nodesNum = 0;
+	ULONG64 buildTime = 0; // in rdtsc ticks.
+	eastl::vector<VadRange> ranges;
+
+	const VadRange* Find(ULONG64 address) const;
+};
+
+class PeHeadersInfo
+{
+public:
+	ULONG_PTR ntHeaders;
+	ULONG sizeOfNtHeaders;
+	ULONG sizeOfImage;
+	IMAGE_FILE_HEADER fileHeader;
+	IMAGE_DATA_DIRECTORY dirDebug;
 };
 
 class Platform
@@ -100,7 +119,8 @@ public:
 
 	static ImageDebugInfo KernelDebugInfo;
 
-	static MemoryReaderCoroutineState* DiscoverBytePointerPosInModules(MemoryReaderCoroutineState* pMemReadCor);
+	static BcCoroutine DiscoverBytePointerPosInModules(CHAR* outputBuffer, ImageDebugInfo* debugInfo, ULONG_PTR pointer) noexcept;
+	static BcCoroutine GetVadSnapshot(VadSnapshot*& retVal, ULONG64 eprocess) noexcept;
 
 	static VOID* GetPcrAddress();
 	static VOID* GetCurrentThread();
@@ -114,6 +134,7 @@ public:
 	static BcCoroutine GetIrql(LONG& retVal) noexcept;
 
 	static VOID GetModulesSnapshot();
+	static VOID GetKernelUnwindSnapshot(IN PDRIVER_OBJECT pDriverObject);
 
 	static VOID CreateProcessNotifyRoutine(HANDLE ParentId, HANDLE ProcessId, BOOLEAN Create);
 	static VOID LoadImageNotifyRoutine(PUNICODE_STRING FullImageName, HANDLE ProcessId, PIMAGE_INFO ImageInfo);
@@ -125,6 +146,10 @@ public:
 
 private:
 
+	static BcCoroutine ReadPeHeaders(BOOLEAN& res, PeHeadersInfo& info, ULONG_PTR imageBase) noexcept;
+	static BcCoroutine ReadPointers(eastl::vector<ULONG_PTR>& values, const eastl::vector<ULONG_PTR>& addrs) noexcept;
+	static BOOLEAN DecodeVadNode(ULONG64& start, ULONG64& end, const BYTE* vad);
+
 	static VOID GetModuleDebugInfo(ULONG64 dllBase, BYTE* pdbGuid, DWORD& pdbAge, CHAR(*pdbName)[256], ULONG32& arch);
 	static eastl::vector<NtModule>& GetNtModulesByProcess(ULONG64 p, int* ppos = NULL);
 	static VOID EnumUserModules(ULONG_PTR prc, VOID* context, BOOLEAN(*callback)(VOID* context, ULONG64 dllBase, ULONG32 sizeOfImage, CHAR(*fullDllName)[256]));
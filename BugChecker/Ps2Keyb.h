@@ -57,7 +57,7 @@ public:
 #define MACRO_SCANCODE_Acc0   0x28		// '
 #define MACRO_SCANCODE_Acc1   0x29		// `
 #define MACRO_SCANCODE_LShift 0x2A		// Left Shift
-#define MACRO_SCANCODE_BSlash 0x2B		// \ 
+#define MACRO_SCANCODE_BSlash 0x2B		// Backslash
 #define MACRO_SCANCODE_Z      0x2C		// Z      
 #define MACRO_SCANCODE_X      0x2D		// X      
 #define MACRO_SCANCODE_C      0x2E		// C      
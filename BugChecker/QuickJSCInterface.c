@@ -7,7 +7,7 @@
 
 #include "CrtFill.h"
 
-#include "QuickJS\quickjs-libc.h"
+#include "QuickJS/quickjs-libc.h"
 
 #include "QuickJSCInterface.h"
 #include "QuickJSCppInterface.h"
@@ -21,6 +21,27 @@ static JSContext* ctx = NULL;
 
 static LONG QJS_InitState = 0;
 
+static JSValue QJS_Compiled[QJS_COMPILED_MAX]; // the functions returned by QJS_Compile.
+static BOOL QJS_CompiledUsed[QJS_COMPILED_MAX];
+
+static QJS_ASYNC_OP* QJS_CurrentOp = NULL; // where _bc_async_op_ stores the operation requested by the script.
+
+static unsigned __int64 QJS_BudgetTicks = 0; // set by QJS_SetBudget: 0 means no limit.
+static unsigned __int64 QJS_ConsumedTicks = 0;
+static unsigned __int64 QJS_SliceStart = 0; // rdtsc when BC entered QuickJS (the time spent in the KD round-trips of the async operations is not counted).
+static BOOL QJS_TimedOut = FALSE;
+
+typedef struct QJS_SCRIPT_CACHE_ENTRY
+{
+	BOOL used;
+	unsigned __int64 hash;
+	size_t len;
+	JSValue bytecode;
+} QJS_SCRIPT_CACHE_ENTRY;
+
+static QJS_SCRIPT_CACHE_ENTRY QJS_ScriptsCache[QJS_SCRIPTS_CACHE_SIZE]; // the bytecode of the scripts run by QJS_EvalScript, keyed by the hash of their source.
+static int QJS_ScriptsCacheNext = 0;
+
 static const char* TagToStr(int64_t tag)
 {
 	switch (tag)
@@ -43,28 +64,215 @@ static const char* TagToStr(int64_t tag)
 	}
 }
 
-void QJS_SetGlobalStringProp(const char* name, const char* value)
+// --------- Registers: exposed as accessors of the global object, that read and write the context directly. ---------
+
+static JSValue js_bc_reg_get(JSContext* ctx, JSValueConst this_val, int magic)
+{
+	unsigned __int64 value;
+
+	if (!_bc_getreg(magic, &value))
+		return JS_UNDEFINED;
+
+	return JS_NewBigUint64(ctx, value);
+}
+
+static JSValue js_bc_reg_set(JSContext* ctx, JSValueConst this_val, JSValueConst val, int magic)
 {
+	int64_t value;
+
+	if (JS_ToInt64Ext(ctx, &value, val))
+		return JS_EXCEPTION;
+
+	if (!_bc_setreg(magic, (unsigned __int64)value))
+		return JS_ThrowTypeError(ctx, "Unable to write register.");
+
+	return JS_UNDEFINED;
+}
+
+static JSValue js_bc_is32bitcompat_get(JSContext* ctx, JSValueConst this_val)
+{
+	return JS_NewBool(ctx, _bc_is32bitcompat());
+}
+
+static void QJS_DefineRegs(void)
+{
+	int i, j;
+	char* p;
+	char name[16];
+	JSAtom atom;
 	JSValue global_obj;
 
 	global_obj = JS_GetGlobalObject(ctx);
 
-	JS_SetPropertyStr(ctx, global_obj, name, JS_NewString(ctx, value));
+	for (i = 0; i < QJSRegNamesNum; i++)
+	{
+		for (j = 0; j < 2; j++) // upper and lower case.
+		{
+			snprintf(name, sizeof(name), "%s", QJSRegNames[i]);
+
+			if (j == 1)
+				for (p = name; *p; p++)
+					if (*p >= 'A' && *p <= 'Z')
+						*p += 'a' - 'A';
+
+			atom = JS_NewAtom(ctx, name);
+
+			JS_DefinePropertyGetSet(ctx, global_obj, atom,
+				JS_NewCFunction2(ctx, (JSCFunction*)js_bc_reg_get, name, 0, JS_CFUNC_getter_magic, i),
+				JS_NewCFunction2(ctx, (JSCFunction*)js_bc_reg_set, name, 1, JS_CFUNC_setter_magic, i),
+				JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE);
+
+			JS_FreeAtom(ctx, atom);
+		}
+	}
+
+	atom = JS_NewAtom(ctx, "is32bitCompat");
+
+	JS_DefinePropertyGetSet(ctx, global_obj, atom,
+		JS_NewCFunction2(ctx, (JSCFunction*)js_bc_is32bitcompat_get, "is32bitCompat", 0, JS_CFUNC_getter, 0),
+		JS_UNDEFINED,
+		JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE);
+
+	JS_FreeAtom(ctx, atom);
+
+	JS_FreeValue(ctx, global_obj);
+}
+
+// --------- Memory: the async operations are passed in binary form and the data is returned in typed arrays. ---------
+
+static JSValue QJS_NewTypedArray(JSContext* ctx, const void* data, int count, int dataSize)
+{
+	JSValue global_obj, ctor, buffer, ret;
+
+	global_obj = JS_GetGlobalObject(ctx);
+
+	ctor = JS_GetPropertyStr(ctx, global_obj,
+		dataSize == 1 ? "Uint8Array" : dataSize == 2 ? "Uint16Array" : dataSize == 4 ? "Uint32Array" : "BigUint64Array");
+
+	buffer = JS_NewArrayBufferCopy(ctx, (const uint8_t*)data, count * dataSize);
+
+	ret = JS_CallConstructor(ctx, ctor, 1, &buffer);
 
+	JS_FreeValue(ctx, buffer);
+	JS_FreeValue(ctx, ctor);
 	JS_FreeValue(ctx, global_obj);
+
+	return ret;
 }
 
-int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __int64* retValU64, BOOL quiet)
+static BOOL QJS_GetMemArgs(JSContext* ctx, JSValueConst* argv, int64_t* address, int64_t* count, int64_t* dataSize) // arguments: address, count, dataSize.
 {
-	int retVal;
-	BOOL readRet;
-	JSValue vexp;
-	BOOL quietBcAsync = FALSE;
+	if (JS_ToInt64Ext(ctx, address, argv[0]) ||
+		JS_ToInt64Ext(ctx, count, argv[1]) ||
+		JS_ToInt64Ext(ctx, dataSize, argv[2]))
+		return FALSE;
 
-	retVal = 0;
-	*retValU64 = 0;
+	if (*dataSize != 1 && *dataSize != 2 && *dataSize != 4 && *dataSize != 8)
+		return FALSE;
+
+	return *count > 0 && *count * *dataSize <= QJS_ASYNC_OP_MAX_DATA;
+}
+
+static JSValue js_bc_readmem_cached(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) // returns null if the memory is not in the cache of the pages read in this break-in.
+{
+	int64_t address, count, dataSize;
+	unsigned char data[QJS_ASYNC_OP_MAX_DATA];
+
+	if (argc < 3 || !QJS_GetMemArgs(ctx, argv, &address, &count, &dataSize))
+		return JS_NULL;
+
+	if (!_bc_readcache((unsigned __int64)address, (unsigned int)(count * dataSize), data))
+		return JS_NULL;
+
+	return QJS_NewTypedArray(ctx, data, (int)count, (int)dataSize);
+}
+
+static JSValue js_bc_async_op(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) // arguments: op, address, count, dataSize, contents (WriteMem only).
+{
+	int i;
+	int64_t op, address = 0, count = 0, dataSize = 0, item;
+	JSValue v;
+
+	if (!QJS_CurrentOp || argc < 4 ||
+		JS_ToInt64Ext(ctx, &op, argv[0]) ||
+		(op != QJS_ASYNC_OP_SETCONTEXT && !QJS_GetMemArgs(ctx, argv + 1, &address, &count, &dataSize)))
+		return JS_ThrowTypeError(ctx, "Invalid async operation.");
+
+	if (op == QJS_ASYNC_OP_WRITEMEM)
+	{
+		if (argc < 5)
+			return JS_ThrowTypeError(ctx, "Invalid async operation.");
 
-	// initialize QuickJS.
+		for (i = 0; i < count; i++)
+		{
+			v = JS_GetPropertyUint32(ctx, argv[4], i);
+
+			if (JS_ToInt64Ext(ctx, &item, v))
+			{
+				JS_FreeValue(ctx, v);
+				return JS_EXCEPTION;
+			}
+
+			JS_FreeValue(ctx, v);
+
+			memcpy(QJS_CurrentOp->data + i * dataSize, &item, (size_t)dataSize); // warning: truncates.
+		}
+	}
+
+	QJS_CurrentOp->op = (int)op;
+
+	if (op != QJS_ASYNC_OP_SETCONTEXT)
+	{
+		QJS_CurrentOp->address = (unsigned __int64)address;
+		QJS_CurrentOp->count = (int)count;
+		QJS_CurrentOp->dataSize = (int)dataSize;
+	}
+
+	return JS_UNDEFINED;
+}
+
+static void QJS_DefineMemFns(void)
+{
+	JSValue global_obj;
+
+	global_obj = JS_GetGlobalObject(ctx);
+
+	JS_SetPropertyStr(ctx, global_obj, "_bc_readmem_cached_", JS_NewCFunction(ctx, js_bc_readmem_cached, "_bc_readmem_cached_", 3));
+	JS_SetPropertyStr(ctx, global_obj, "_bc_async_op_", JS_NewCFunction(ctx, js_bc_async_op, "_bc_async_op_", 5));
+
+	JS_FreeValue(ctx, global_obj);
+}
+
+// ---------
+
+static int QJS_InterruptHandler(JSRuntime* rt, void* opaque) // called periodically by the interpreter: when it returns 1, the script is stopped by an uncatchable exception.
+{
+	if (QJS_BudgetTicks && QJS_ConsumedTicks + (__rdtsc() - QJS_SliceStart) > QJS_BudgetTicks)
+	{
+		QJS_TimedOut = TRUE;
+		return 1;
+	}
+
+	return 0;
+}
+
+void QJS_SetBudget(unsigned __int64 ticks)
+{
+	QJS_BudgetTicks = ticks;
+	QJS_ConsumedTicks = 0;
+	QJS_TimedOut = FALSE;
+}
+
+unsigned __int64 QJS_GetConsumed(BOOL* timedOut)
+{
+	*timedOut = QJS_TimedOut;
+	return QJS_ConsumedTicks;
+}
+
+static BOOL QJS_Init(void)
+{
+	unsigned __int64 budgetTicks;
+	JSValue vret;
 
 	if (!QJS_InitState)
 	{
@@ -73,6 +281,8 @@ int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __
 		rt = JS_NewRuntime();
 		if (rt)
 		{
+			JS_SetInterruptHandler(rt, QJS_InterruptHandler, NULL);
+
 			ctx = JS_NewContext(rt);
 			if (ctx)
 			{
@@ -83,21 +293,41 @@ int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __
 				JS_AddIntrinsicOperators(ctx);
 				JS_EnableBignumExt(ctx, TRUE);
 
-				JS_FreeValue(ctx, JS_Eval(ctx, QJSStartupScript, strlen(QJSStartupScript), "", JS_EVAL_TYPE_GLOBAL));
+				QJS_DefineRegs();
+				QJS_DefineMemFns();
+
+				// the startup script defines the functions used by every evaluation: it is never interrupted by the budget of the caller.
+
+				budgetTicks = QJS_BudgetTicks;
+				QJS_BudgetTicks = 0;
+
+				vret = JS_Eval(ctx, QJSStartupScript, strlen(QJSStartupScript), "", JS_EVAL_TYPE_GLOBAL);
 
-				QJS_InitState = 2;
+				QJS_BudgetTicks = budgetTicks;
+
+				if (JS_IsException(vret))
+					js_std_dump_error(ctx);
+				else
+					QJS_InitState = 2;
+
+				JS_FreeValue(ctx, vret);
 			}
 		}
 	}
 
-	if (QJS_InitState != 2)
-		return QJS_EVAL_ERROR_INIT;
+	return QJS_InitState == 2;
+}
 
-	// evaluate the expression.
+static int QJS_Complete(JSValue vexp, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet) // vexp is the value returned by the evaluated script or by the called function.
+{
+	int retVal;
+	BOOL readRet;
+	BOOL quietBcAsync = FALSE;
 
-	readRet = TRUE;
+	retVal = 0;
+	*retValU64 = 0;
 
-	vexp = JS_Eval(ctx, src, strlen(src), "", JS_EVAL_TYPE_GLOBAL);
+	readRet = TRUE;
 
 	_bc_resetstdout();
 
@@ -113,6 +343,17 @@ int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __
 
 	js_std_loop(ctx);
 
+	QJS_CurrentOp = NULL;
+
+	if (QJS_TimedOut) // the script was interrupted by QJS_InterruptHandler: there is no return value and no pending operation.
+	{
+		asyncOp->op = QJS_ASYNC_OP_NONE;
+		readRet = FALSE;
+	}
+
+	if (asyncOp->op != QJS_ASYNC_OP_NONE)
+		quietBcAsync = TRUE;
+
 	// get the return value object.
 
 	if (readRet)
@@ -120,7 +361,6 @@ int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __
 		JSValue val = JS_UNDEFINED;
 		JSValue ret = JS_UNDEFINED;
 		JSValue tag = JS_UNDEFINED;
-		JSValue asy = JS_UNDEFINED;
 		JSValue retStr = JS_UNDEFINED;
 		JSValue retU64 = JS_UNDEFINED;
 
@@ -140,22 +380,8 @@ int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __
 
 				retStr = JS_GetPropertyStr(ctx, val, QJS_EVAL_RET_STR_PROP_NAME);
 
-				asy = JS_GetPropertyStr(ctx, val, QJS_EVAL_ASYNC_ARGS_PROP_NAME);
-
 				retU64 = JS_GetPropertyStr(ctx, val, QJS_EVAL_RET_U64_PROP_NAME);
 
-				if (JS_IsString(asy))
-				{
-					const char* str = JS_ToCString(ctx, asy);
-
-					if (str)
-					{
-						snprintf(asyncArgs, asyncArgsMaxSize, "%s", str);
-						quietBcAsync = TRUE;
-						JS_FreeCString(ctx, str);
-					}
-				}
-
 				if (!JS_IsString(retU64))
 					quiet = FALSE;
 				else
@@ -202,7 +428,6 @@ int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __
 		JS_FreeValue(ctx, val);
 		JS_FreeValue(ctx, tag);
 		JS_FreeValue(ctx, ret);
-		JS_FreeValue(ctx, asy);
 		JS_FreeValue(ctx, retStr);
 		JS_FreeValue(ctx, retU64);
 	}
@@ -222,11 +447,242 @@ int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __
 		strcpy(QJSNotImplLog, "");
 	}
 
+	// update the time spent in QuickJS.
+
+	QJS_ConsumedTicks += __rdtsc() - QJS_SliceStart;
+
 	// return to the caller.
 
 	return retVal;
 }
 
+int QJS_Eval(const char* src, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet)
+{
+	*retValU64 = 0;
+	asyncOp->op = QJS_ASYNC_OP_NONE;
+
+	if (!QJS_Init())
+		return QJS_EVAL_ERROR_INIT;
+
+	QJS_SliceStart = __rdtsc(); // the initialization is not counted in the budget.
+
+	QJS_CurrentOp = asyncOp;
+
+	return QJS_Complete(JS_Eval(ctx, src, strlen(src), "", JS_EVAL_TYPE_GLOBAL), asyncOp, retValU64, quiet);
+}
+
+int QJS_Resolve(const void* data, int count, int dataSize, BOOL ok, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet) // resolves the promise of the async operation: with a typed array if data is specified, otherwise with a boolean.
+{
+	JSValue global_obj, eval_obj, resolve, arg, vret;
+
+	QJS_SliceStart = __rdtsc();
+
+	*retValU64 = 0;
+	asyncOp->op = QJS_ASYNC_OP_NONE;
+
+	if (QJS_InitState != 2)
+		return QJS_EVAL_ERROR_INIT;
+
+	global_obj = JS_GetGlobalObject(ctx);
+
+	eval_obj = JS_GetPropertyStr(ctx, global_obj, QJS_EVAL_RET_OBJ_NAME);
+
+	resolve = JS_GetPropertyStr(ctx, eval_obj, "resolve");
+
+	JS_SetPropertyStr(ctx, eval_obj, "resolve", JS_NULL);
+	JS_SetPropertyStr(ctx, eval_obj, "reject", JS_NULL);
+
+	arg = data && ok ? QJS_NewTypedArray(ctx, data, count, dataSize) : JS_NewBool(ctx, ok);
+
+	QJS_CurrentOp = asyncOp;
+
+	vret = JS_Call(ctx, resolve, JS_UNDEFINED, 1, &arg);
+
+	JS_FreeValue(ctx, arg);
+	JS_FreeValue(ctx, resolve);
+	JS_FreeValue(ctx, eval_obj);
+	JS_FreeValue(ctx, global_obj);
+
+	return QJS_Complete(vret, asyncOp, retValU64, quiet);
+}
+
+// --------- QJS_EvalScript: the Script Window text is compiled only when it changes, then its cached bytecode is run. ---------
+
+static unsigned __int64 QJS_HashStr(const char* psz, size_t len) // FNV-1a.
+{
+	unsigned __int64 hash = 0xCBF29CE484222325;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		hash ^= (unsigned char)psz[i];
+		hash *= 0x100000001B3;
+	}
+
+	return hash;
+}
+
+int QJS_EvalScript(const char* src, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet)
+{
+	// N.B. the script is compiled inside a block: like in the previous direct eval, "let" and "const" are local to each run (so that the
+	// script can be run again) while the functions and the "var"s are defined in the global object (Annex B.3.3 semantics).
+
+	static const char prefix[] = "\"use math\"; void 0; {";
+	static const char suffix[] = "\n}";
+
+	int i;
+	size_t len;
+	unsigned __int64 hash;
+	char* code;
+	JSValue bytecode, global_obj, eval_obj, vret, fn;
+
+	*retValU64 = 0;
+	asyncOp->op = QJS_ASYNC_OP_NONE;
+
+	if (!QJS_Init())
+		return QJS_EVAL_ERROR_INIT;
+
+	QJS_SliceStart = __rdtsc(); // the initialization is not counted in the budget.
+
+	QJS_CurrentOp = asyncOp;
+
+	len = strlen(src);
+	hash = QJS_HashStr(src, len);
+
+	// compile the script, if it is not in the cache.
+
+	for (i = 0; i < QJS_SCRIPTS_CACHE_SIZE; i++)
+		if (QJS_ScriptsCache[i].used && QJS_ScriptsCache[i].hash == hash && QJS_ScriptsCache[i].len == len)
+			break;
+
+	if (i == QJS_SCRIPTS_CACHE_SIZE)
+	{
+		code = (char*)js_malloc(ctx, sizeof(prefix) - 1 + len + sizeof(suffix));
+		if (!code)
+			return QJS_Complete(JS_ThrowOutOfMemory(ctx), asyncOp, retValU64, quiet);
+
+		memcpy(code, prefix, sizeof(prefix) - 1);
+		memcpy(code + sizeof(prefix) - 1, src, len);
+		memcpy(code + sizeof(prefix) - 1 + len, suffix, sizeof(suffix));
+
+		bytecode = JS_Eval(ctx, code, sizeof(prefix) - 1 + len + sizeof(suffix) - 1, "", JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+
+		js_free(ctx, code);
+
+		if (JS_IsException(bytecode)) // prints the syntax error.
+			return QJS_Complete(bytecode, asyncOp, retValU64, quiet);
+
+		i = QJS_ScriptsCacheNext;
+		QJS_ScriptsCacheNext = (QJS_ScriptsCacheNext + 1) % QJS_SCRIPTS_CACHE_SIZE;
+
+		if (QJS_ScriptsCache[i].used)
+			JS_FreeValue(ctx, QJS_ScriptsCache[i].bytecode);
+
+		QJS_ScriptsCache[i].used = TRUE;
+		QJS_ScriptsCache[i].hash = hash;
+		QJS_ScriptsCache[i].len = len;
+		QJS_ScriptsCache[i].bytecode = bytecode;
+	}
+
+	// run the bytecode and store its return value (or its exception) in the eval object.
+
+	global_obj = JS_GetGlobalObject(ctx);
+
+	eval_obj = JS_NewObject(ctx);
+	JS_SetPropertyStr(ctx, eval_obj, QJS_EVAL_TAG_PROP_NAME, JS_TRUE);
+	JS_SetPropertyStr(ctx, global_obj, QJS_EVAL_RET_OBJ_NAME, JS_DupValue(ctx, eval_obj));
+
+	vret = JS_EvalFunction(ctx, JS_DupValue(ctx, QJS_ScriptsCache[i].bytecode));
+
+	if (JS_IsException(vret))
+	{
+		vret = JS_GetException(ctx);
+		fn = JS_GetPropertyStr(ctx, global_obj, "SetExceptionRetValue");
+	}
+	else
+	{
+		JS_SetPropertyStr(ctx, eval_obj, QJS_EVAL_RET_PROP_NAME, JS_DupValue(ctx, vret));
+		fn = JS_GetPropertyStr(ctx, global_obj, "CheckReturnValue");
+	}
+
+	bytecode = JS_Call(ctx, fn, JS_UNDEFINED, 1, &vret);
+
+	JS_FreeValue(ctx, fn);
+	JS_FreeValue(ctx, vret);
+	JS_FreeValue(ctx, eval_obj);
+	JS_FreeValue(ctx, global_obj);
+
+	return QJS_Complete(bytecode, asyncOp, retValU64, quiet);
+}
+
+// --------- QJS_Compile and QJS_Call: the source is parsed and compiled only once, then the function is called with the new arguments. ---------
+
+int QJS_Compile(const char* src)
+{
+	int i;
+	JSValue fn;
+
+	if (!QJS_Init())
+		return -1;
+
+	for (i = 0; i < QJS_COMPILED_MAX; i++)
+		if (!QJS_CompiledUsed[i])
+			break;
+
+	if (i == QJS_COMPILED_MAX)
+	{
+		printf("Too many compiled expressions.\n");
+		return -1;
+	}
+
+	fn = JS_Eval(ctx, src, strlen(src), "", JS_EVAL_TYPE_GLOBAL);
+
+	_bc_resetstdout();
+
+	if (JS_IsException(fn))
+	{
+		js_std_dump_error(ctx);
+		return -1;
+	}
+	else if (!JS_IsFunction(ctx, fn))
+	{
+		JS_FreeValue(ctx, fn);
+		return -1;
+	}
+
+	QJS_Compiled[i] = fn;
+	QJS_CompiledUsed[i] = TRUE;
+
+	return i;
+}
+
+int QJS_Call(int fnIndex, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet)
+{
+	QJS_SliceStart = __rdtsc();
+
+	*retValU64 = 0;
+	asyncOp->op = QJS_ASYNC_OP_NONE;
+
+	if (QJS_InitState != 2 ||
+		fnIndex < 0 || fnIndex >= QJS_COMPILED_MAX || !QJS_CompiledUsed[fnIndex])
+		return QJS_EVAL_ERROR_INIT;
+
+	QJS_CurrentOp = asyncOp;
+
+	return QJS_Complete(JS_Call(ctx, QJS_Compiled[fnIndex], JS_UNDEFINED, 0, NULL), asyncOp, retValU64, quiet);
+}
+
+void QJS_FreeCompiled(int fnIndex)
+{
+	if (QJS_InitState != 2 ||
+		fnIndex < 0 || fnIndex >= QJS_COMPILED_MAX || !QJS_CompiledUsed[fnIndex])
+		return;
+
+	JS_FreeValue(ctx, QJS_Compiled[fnIndex]);
+
+	QJS_CompiledUsed[fnIndex] = FALSE;
+}
+
 // --------- NOT_IMPLEMENTED function definition: we need to log any not implemented function invoked by QJS. ---------
 
 void NOT_IMPLEMENTED(const char* psz)
@@ -247,6 +703,8 @@ void NOT_IMPLEMENTED(const char* psz)
 
 // --------- Functions imported by QuickJS and implemented: (the others are in "QuickJSCppInterface.cpp") ---------
 
+#ifndef BC_HOSTSIM // on the host, QuickJS is linked with the C library.
+
 #define _DENORM		(-2)	/* C9X only */
 #define _FINITE		(-1)
 #define _INFCODE	1
@@ -776,3 +1234,5 @@ DWORD __stdcall _bc_GetTimeZoneInformation(__out LPTIME_ZONE_INFORMATION lpTimeZ
 	NOT_IMPLEMENTED("GetTimeZoneInformation");
 	return 0;
 }
+
+#endif
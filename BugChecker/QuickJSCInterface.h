@@ -8,12 +8,41 @@
 #endif
 
 QJSCI_EXTERN void NOT_IMPLEMENTED(const char* psz);
+#ifndef BC_HOSTSIM
 QJSCI_EXTERN FILE _bc__iob[_IOB_ENTRIES];
+#endif
 
 typedef int BOOL;
 
-QJSCI_EXTERN int QJS_Eval(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __int64* retValU64, BOOL quiet);
-QJSCI_EXTERN void QJS_SetGlobalStringProp(const char* name, const char* value);
+#define QJS_ASYNC_OP_NONE 0 // N.B. the values are used also by the startup script.
+#define QJS_ASYNC_OP_READMEM 1
+#define QJS_ASYNC_OP_WRITEMEM 2
+#define QJS_ASYNC_OP_SETCONTEXT 3
+
+#define QJS_ASYNC_OP_MAX_DATA (2 * 1024)
+
+typedef struct QJS_ASYNC_OP // async operation requested by the script through _bc_async_op_: processed by BC, then the promise is resolved by QJS_Resolve.
+{
+	int op;
+	unsigned __int64 address;
+	int count;
+	int dataSize;
+	unsigned char data[QJS_ASYNC_OP_MAX_DATA]; // WriteMem contents.
+} QJS_ASYNC_OP;
+
+QJSCI_EXTERN int QJS_Eval(const char* src, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet);
+QJSCI_EXTERN int QJS_EvalScript(const char* src, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet);
+
+QJSCI_EXTERN int QJS_Compile(const char* src);
+QJSCI_EXTERN int QJS_Call(int fnIndex, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet);
+QJSCI_EXTERN int QJS_Resolve(const void* data, int count, int dataSize, BOOL ok, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet);
+QJSCI_EXTERN void QJS_FreeCompiled(int fnIndex);
+
+QJSCI_EXTERN void QJS_SetBudget(unsigned __int64 ticks); // rdtsc ticks that the next evaluation (including its async operations) can spend in QuickJS: 0 means no limit.
+QJSCI_EXTERN unsigned __int64 QJS_GetConsumed(BOOL* timedOut); // rdtsc ticks spent in QuickJS since the last QJS_SetBudget.
+
+#define QJS_COMPILED_MAX 256
+#define QJS_SCRIPTS_CACHE_SIZE 8
 
 #define QJS_EVAL_ERROR_INIT 1
 #define QJS_EVAL_SUCCESS_RETVALU64 2
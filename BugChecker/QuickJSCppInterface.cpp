@@ -67,7 +67,10 @@ DWORD SaveFPUState::cr0Reg;
 // Expanded stack wrappers:
 //
 
-extern "C" ULONG_PTR esOld = 0, esNew = 0, esFunction = 0, esParam = 0;
+extern "C"
+{
+	ULONG_PTR esOld = 0, esNew = 0, esFunction = 0, esParam = 0; // accessed by the assembly code.
+}
 
 #ifdef _AMD64_
 extern "C" VOID ESCall(VOID);
@@ -98,8 +101,7 @@ class QJS_Eval_ES_Params
 {
 public:
 	const char* src;
-	char* asyncArgs;
-	int asyncArgsMaxSize;
+	QJS_ASYNC_OP* asyncOp;
 	unsigned __int64* retValU64;
 	BOOL quiet;
 
@@ -109,12 +111,12 @@ public:
 static VOID QJS_Eval_ES_Execute()
 {
 	QJS_Eval_ES_Params* params = (QJS_Eval_ES_Params*)esParam;
-	params->retVal = ::QJS_Eval(params->src, params->asyncArgs, params->asyncArgsMaxSize, params->retValU64, params->quiet);
+	params->retVal = ::QJS_Eval(params->src, params->asyncOp, params->retValU64, params->quiet);
 }
 
-static int QJS_Eval_ES(const char* src, char* asyncArgs, int asyncArgsMaxSize, unsigned __int64* retValU64, BOOL quiet)
+static int QJS_Eval_ES(const char* src, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet)
 {
-	QJS_Eval_ES_Params* params = new QJS_Eval_ES_Params{ src, asyncArgs, asyncArgsMaxSize, retValU64, quiet, 0 };
+	QJS_Eval_ES_Params* params = new QJS_Eval_ES_Params{ src, asyncOp, retValU64, quiet, 0 };
 
 	ES_CALL(QJS_Eval_ES_Execute, params);
 
@@ -123,35 +125,269 @@ static int QJS_Eval_ES(const char* src, char* asyncArgs, int asyncArgsMaxSize, u
 	return ret;
 }
 
-// -- QJS_SetGlobalStringProp_ES --
+// -- QJS_EvalScript_ES --
+
+class QJS_EvalScript_ES_Params
+{
+public:
+	const char* src;
+	QJS_ASYNC_OP* asyncOp;
+	unsigned __int64* retValU64;
+	BOOL quiet;
+
+	int retVal;
+};
+
+static VOID QJS_EvalScript_ES_Execute()
+{
+	QJS_EvalScript_ES_Params* params = (QJS_EvalScript_ES_Params*)esParam;
+	params->retVal = ::QJS_EvalScript(params->src, params->asyncOp, params->retValU64, params->quiet);
+}
+
+static int QJS_EvalScript_ES(const char* src, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet)
+{
+	QJS_EvalScript_ES_Params* params = new QJS_EvalScript_ES_Params{ src, asyncOp, retValU64, quiet, 0 };
+
+	ES_CALL(QJS_EvalScript_ES_Execute, params);
+
+	auto ret = params->retVal;
+	delete params;
+	return ret;
+}
+
+// -- QJS_Compile_ES --
 
-class QJS_SetGlobalStringProp_ES_Params
+class QJS_Compile_ES_Params
 {
 public:
-	const char* name;
-	const char* value;
+	const char* src;
+
+	int retVal;
 };
 
-static VOID QJS_SetGlobalStringProp_ES_Execute()
+static VOID QJS_Compile_ES_Execute()
 {
-	QJS_SetGlobalStringProp_ES_Params* params = (QJS_SetGlobalStringProp_ES_Params*)esParam;
-	::QJS_SetGlobalStringProp(params->name, params->value);
+	QJS_Compile_ES_Params* params = (QJS_Compile_ES_Params*)esParam;
+	params->retVal = ::QJS_Compile(params->src);
 }
 
-static void QJS_SetGlobalStringProp_ES(const char* name, const char* value)
+static int QJS_Compile_ES(const char* src)
 {
-	QJS_SetGlobalStringProp_ES_Params* params = new QJS_SetGlobalStringProp_ES_Params{ name, value };
+	QJS_Compile_ES_Params* params = new QJS_Compile_ES_Params{ src, 0 };
 
-	ES_CALL(QJS_SetGlobalStringProp_ES_Execute, params);
+	ES_CALL(QJS_Compile_ES_Execute, params);
 
+	auto ret = params->retVal;
 	delete params;
+	return ret;
+}
+
+// -- QJS_Call_ES --
+
+class QJS_Call_ES_Params
+{
+public:
+	int fnIndex;
+	QJS_ASYNC_OP* asyncOp;
+	unsigned __int64* retValU64;
+	BOOL quiet;
+
+	int retVal;
+};
+
+static VOID QJS_Call_ES_Execute()
+{
+	QJS_Call_ES_Params* params = (QJS_Call_ES_Params*)esParam;
+	params->retVal = ::QJS_Call(params->fnIndex, params->asyncOp, params->retValU64, params->quiet);
+}
+
+static int QJS_Call_ES(int fnIndex, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet)
+{
+	QJS_Call_ES_Params* params = new QJS_Call_ES_Params{ fnIndex, asyncOp, retValU64, quiet, 0 };
+
+	ES_CALL(QJS_Call_ES_Execute, params);
+
+	auto ret = params->retVal;
+	delete params;
+	return ret;
+}
+
+// -- QJS_Resolve_ES --
+
+class QJS_Resolve_ES_Params
+{
+public:
+	const void* data;
+	int count;
+	int dataSize;
+	BOOL ok;
+	QJS_ASYNC_OP* asyncOp;
+	unsigned __int64* retValU64;
+	BOOL quiet;
+
+	int retVal;
+};
+
+static VOID QJS_Resolve_ES_Execute()
+{
+	QJS_Resolve_ES_Params* params = (QJS_Resolve_ES_Params*)esParam;
+	params->retVal = ::QJS_Resolve(params->data, params->count, params->dataSize, params->ok, params->asyncOp, params->retValU64, params->quiet);
+}
+
+static int QJS_Resolve_ES(const void* data, int count, int dataSize, BOOL ok, QJS_ASYNC_OP* asyncOp, unsigned __int64* retValU64, BOOL quiet)
+{
+	QJS_Resolve_ES_Params* params = new QJS_Resolve_ES_Params{ data, count, dataSize, ok, asyncOp, retValU64, quiet, 0 };
+
+	ES_CALL(QJS_Resolve_ES_Execute, params);
+
+	auto ret = params->retVal;
+	delete params;
+	return ret;
+}
+
+// -- QJS_FreeCompiled_ES --
+
+static VOID QJS_FreeCompiled_ES_Execute()
+{
+	::QJS_FreeCompiled((int)esParam);
+}
+
+static void QJS_FreeCompiled_ES(int fnIndex)
+{
+	ES_CALL(QJS_FreeCompiled_ES_Execute, fnIndex);
+}
+
+//
+// Registers exposed to the scripts: the accessors defined by "QuickJSCInterface.c" read and write the context passed to Eval or Call.
+//
+
+const char* QJSRegNames[] = { // C linkage from "QuickJSCppInterface.h".
+	"RAX", "RBX", "RCX", "RDX", "RSI", "RDI", "RSP",
+	"RBP", "R8", "R9", "R10", "R11", "R12", "R13",
+	"R14", "R15", "RIP", "EAX", "EBX", "ECX", "EDX",
+	"ESI", "EDI", "ESP", "EBP", "EIP" };
+
+extern "C" const int QJSRegNamesNum = sizeof(QJSRegNames) / sizeof(QJSRegNames[0]);
+
+static BYTE* QJSContext = NULL;
+static ULONG QJSContextLen = 0;
+static BOOLEAN QJSIs32bitCompat = FALSE;
+static BOOLEAN QJSContextChanged = FALSE; // a register was written: the context must be sent to the kernel.
+
+static VOID* GetRegValuePtr(int index, size_t* psz)
+{
+	if (!QJSContext || index < 0 || index >= QJSRegNamesNum)
+		return NULL;
+
+	ZydisRegister reg = X86Step::StringToZydisReg(QJSRegNames[index]);
+
+	if (reg != ZYDIS_REGISTER_NONE)
+	{
+		VOID* preg = X86Step::ZydisRegToCtxRegValuePtr((CONTEXT*)QJSContext, reg, psz);
+
+		if (preg && (*psz == 4 || *psz == 8))
+			return preg;
+	}
+
+	return NULL;
+}
+
+extern "C" int __stdcall _bc_getreg(int index, unsigned __int64* value)
+{
+	size_t sz = 0;
+	VOID* preg = GetRegValuePtr(index, &sz);
+
+	if (!preg)
+		return FALSE;
+
+	*value = sz == 4 ? *(ULONG32*)preg : *(ULONG64*)preg;
+
+	return TRUE;
+}
+
+extern "C" int __stdcall _bc_setreg(int index, unsigned __int64 value)
+{
+	size_t sz = 0;
+	VOID* preg = GetRegValuePtr(index, &sz);
+
+	if (!preg)
+		return FALSE;
+
+	if (_6432_(TRUE, FALSE) && QJSIs32bitCompat && sz == 8) // Unable to change 64-bit register in 32-bit mode.
+		return FALSE;
+
+	if (sz == 8)
+		*(ULONG64*)preg = value;
+	else
+		*(ULONG32*)preg = (ULONG32)value;
+
+	QJSContextChanged = TRUE;
+
+	return TRUE;
+}
+
+extern "C" int __stdcall _bc_is32bitcompat()
+{
+	return QJSIs32bitCompat;
+}
+
+extern "C" int __stdcall _bc_readcache(unsigned __int64 address, unsigned int size, void* dest) // reads the memory only if all its pages were already read in this break-in.
+{
+	while (size)
+	{
+		ULONG chunkSize = _MIN_(size, PAGE_SIZE - (ULONG)(address & (PAGE_SIZE - 1)));
+
+		if (!Root::I->ReadCache.Read(address, dest, chunkSize))
+			return FALSE;
+
+		Root::I->ReadCache.Perf_HitsNum++;
+
+		address += chunkSize;
+		dest = (BYTE*)dest + chunkSize;
+		size -= chunkSize;
+	}
+
+	return TRUE;
+}
+
+static VOID SetCurrentContext(BYTE* context, ULONG contextLen, BOOLEAN is32bitCompat)
+{
+	QJSContext = context;
+	QJSContextLen = contextLen;
+	QJSIs32bitCompat = is32bitCompat;
+	QJSContextChanged = FALSE;
+}
+
+//
+// Time budget of the evaluations:
+//
+
+ULONG64 QuickJSCppInterface::LastTicks = 0;
+BOOLEAN QuickJSCppInterface::LastTimedOut = FALSE;
+
+static VOID BeginBudget(ULONG budgetMs) // the budget is in rdtsc ticks: the calibration may be unavailable, in which case there is no limit.
+{
+	::QJS_SetBudget((ULONG64)budgetMs * Root::I->RdtscTicksPerMs);
+}
+
+static VOID EndBudget(ULONG budgetMs, BOOLEAN quiet)
+{
+	BOOL timedOut = FALSE;
+
+	QuickJSCppInterface::LastTicks = ::QJS_GetConsumed(&timedOut);
+	QuickJSCppInterface::LastTimedOut = timedOut ? TRUE : FALSE;
+
+	Root::I->Perf_JsLatency.Add(QuickJSCppInterface::LastTicks);
+
+	if (timedOut && !quiet)
+		_bc_printf("Script interrupted: it exceeded its time budget of %u ms.\n", budgetMs);
 }
 
 //
 // Implementation of the QuickJSCppInterface class:
 //
 
-extern "C" const char* QJSStartupScript = R"bcX(
+const char* QJSStartupScript = R"bcX(
 
 function QJSPrint( valueToPrint )
 {
@@ -382,6 +618,11 @@ function CheckReturnValue ()
 	}
 }
 
+function SetExceptionRetValue(e)
+{
+	_bc_eval_.ret = "Throw: " + e;
+}
+
 function ThrowEx(e)
 {
 	_bc_eval_.ret = "Throw: " + e;
@@ -427,13 +668,20 @@ async function ReadMem(address, size, dataSize)
 	if ( dataSize * size > 2 * 1024 )
 		ThrowEx( "Argument 'size' is too big." );
 
-	var ret = await new Promise( function(resolve, reject) {
+	// the pages read in this break-in are returned without suspending the script.
+
+	var ret = _bc_readmem_cached_( address, size, dataSize );
+
+	if ( ret !== null )
+		return ret;
+
+	ret = await new Promise( function(resolve, reject) {
 		_bc_eval_.resolve = resolve;
 		_bc_eval_.reject = reject;
-		_bc_eval_.async_args = "ReadMem" + "$delim$" + address + "$delim$" + size + "$delim$" + dataSize;
+		_bc_async_op_( 1 /* QJS_ASYNC_OP_READMEM */, address, size, dataSize );
 	});
 
-	if ( ! Array.isArray( ret ) || ! ret.length )
+	if ( ret === false || ! ret.length )
 		ThrowEx( "Unable to read memory." );
 
 	return ret;
@@ -447,7 +695,7 @@ async function WriteMem(address, dataSize, contents)
 	if ( dataSize != 1 && dataSize != 2 && dataSize != 4 && dataSize != 8 )
 		ThrowEx( "Argument 'dataSize' must be 1, 2, 4 or 8." );
 
-	if ( ! Array.isArray( contents ) )
+	if ( ! Array.isArray( contents ) && ! ArrayBuffer.isView( contents ) )
 		ThrowEx( "Argument 'contents' must be an array." );
 
 	if ( ! contents.length )
@@ -456,17 +704,13 @@ async function WriteMem(address, dataSize, contents)
 	if ( dataSize * contents.length > 2 * 1024 )
 		ThrowEx( "Argument 'contents' is too big." );
 
-	var c = "";
 	for ( var i = 0; i < contents.length; i ++ )
-	{
 		CheckIntArg(contents[i], "item #" + i + " in contents");
-		c += contents[i] + ( i == contents.length - 1 ? "" : "$delim$" );
-	}
 
 	var ret = await new Promise( function(resolve, reject) {
 		_bc_eval_.resolve = resolve;
 		_bc_eval_.reject = reject;
-		_bc_eval_.async_args = "WriteMem" + "$delim$" + address + "$delim$" + dataSize + "$delim$" + c;
+		_bc_async_op_( 2 /* QJS_ASYNC_OP_WRITEMEM */, address, contents.length, dataSize, contents );
 	});
 
 	if ( ret !== true )
@@ -501,10 +745,19 @@ async function WriteReg(regName, value)
 	if ( ! found )
 		ThrowEx( "Argument 'regName' must be a valid register name." );
 
+	try
+	{
+		globalThis[regName] = value;
+	}
+	catch (e)
+	{
+		ThrowEx( "Unable to write register." );
+	}
+
 	var ret = await new Promise( function(resolve, reject) {
 		_bc_eval_.resolve = resolve;
 		_bc_eval_.reject = reject;
-		_bc_eval_.async_args = "WriteReg" + "$delim$" + regName + "$delim$" + value;
+		_bc_async_op_( 3 /* QJS_ASYNC_OP_SETCONTEXT */, 0, 0, 0 );
 	});
 
 	if ( ret !== true )
@@ -531,233 +784,218 @@ BcCoroutine QuickJSCppInterface::Eval(const CHAR* psz, BYTE* context, ULONG cont
 		}
 	};
 
-	auto AddReg = [&context](const CHAR* regName, eastl::string& str) {
+	// the registers are read and written by the accessors directly in the context.
 
-		ZydisRegister reg = X86Step::StringToZydisReg(regName);
+	SetCurrentContext(context, contextLen, is32bitCompat);
 
-		if (reg != ZYDIS_REGISTER_NONE)
-		{
-			size_t sz = 0;
-			VOID* preg = X86Step::ZydisRegToCtxRegValuePtr((CONTEXT*)context, reg, &sz);
+	// call QuickJS.
 
-			if (preg && (sz == 4 || sz == 8))
-			{
-				eastl::string name = regName;
+	auto s = eastl::string(psz);
+
+	s.trim();
+	s.rtrim(";");
 
-				for (int i = 0; i < 2; i++)
-				{
-					if (i == 1) Utils::ToLower(name);
+	eastl::unique_ptr<QJS_ASYNC_OP> asyncOp(new QJS_ASYNC_OP());
 
-					str += name + " = 0x" + Utils::HexToString(sz == 4 ? *(ULONG32*)preg : *(ULONG64*)preg, sz) + "n; ";
-				}
-			}
-		}
-	};
+	BeginBudget(Root::I->JsBudgetMs);
 
-	auto AddRegs = [&AddReg](eastl::string& str) {
+	if (!wrapInAsyncFn) // the script is compiled only when its text changes: its bytecode is cached and keyed by a hash of its contents.
+		qjsRet = ::QJS_EvalScript_ES(s.c_str(), asyncOp.get(), &qjsRetU64, quiet);
+	else
+		qjsRet = ::QJS_Eval_ES((
+			"_bc_eval_ = {" QJS_EVAL_TAG_PROP_NAME ":true}; "
+			"(async function() "
+			"{ "
+			"\"use math\"; "
+			"try { "
+			"_bc_eval_." QJS_EVAL_RET_PROP_NAME " = (" + s + "); "
+			"CheckReturnValue (); "
+			"} "
+			"catch(e) { _bc_eval_." QJS_EVAL_RET_PROP_NAME " = \"Throw: \" + e; } "
+			"})(); "
+			).c_str(), asyncOp.get(), &qjsRetU64, quiet);
 
-		const CHAR* regs[] = {
-			"RAX", "RBX", "RCX", "RDX", "RSI", "RDI", "RSP",
-			"RBP", "R8", "R9", "R10", "R11", "R12", "R13",
-			"R14", "R15", "RIP", "EAX", "EBX", "ECX", "EDX",
-			"ESI", "EDI", "ESP", "EBP", "EIP" };
+	CheckRet();
 
-		for (const CHAR* reg : regs)
-			AddReg(reg, str);
-	};
+	// process all the async operation requests.
 
-	// update the QJS context.
+	co_await BcAwaiter_Join{ ProcessAsyncOps(*asyncOp, pRetVal, quiet) };
 
-	eastl::string c = "_bc_eval_ = void 0; ";
+	// send the registers changed by the script.
 
-	c += eastl::string("is32bitCompat = ") + (is32bitCompat ? "true" : "false") + "; ";
+	co_await BcAwaiter_Join{ FlushContext() };
 
-	AddRegs(c);
+	EndBudget(Root::I->JsBudgetMs, quiet);
 
-	eastl::vector<CHAR> asyncArgs(512, 0);
+	// remove last line if empty + refresh ui.
 
-	::QJS_Eval_ES(c.c_str(), asyncArgs.data(), asyncArgs.size(), &qjsRetU64, TRUE);
+	Root::I->LogWindow.AddString("", FALSE, !quiet);
 
-	// call QuickJS.
+	// return.
+
+	co_return;
+}
+
+LONG QuickJSCppInterface::Compile(const CHAR* psz) noexcept
+{
+	SaveFPUState __fpu_state__;
+
+	// the function has the same body of the wrapper in Eval.
 
 	auto s = eastl::string(psz);
 
 	s.trim();
 	s.rtrim(";");
 
-	::memset(asyncArgs.data(), 0, asyncArgs.size());
+	BeginBudget(0); // nothing is executed here, except the expression that creates the function.
 
-	if (!wrapInAsyncFn)
-		::QJS_SetGlobalStringProp_ES("_bc_script_", s.c_str());
-
-	qjsRet = ::QJS_Eval_ES((
-		"_bc_eval_ = {" QJS_EVAL_TAG_PROP_NAME ":true}; "
-		+ eastl::string(wrapInAsyncFn ? "(async function() " : "") +
+	LONG fn = ::QJS_Compile_ES((
+		"(async function() "
 		"{ "
 		"\"use math\"; "
+		"_bc_eval_ = {" QJS_EVAL_TAG_PROP_NAME ":true}; "
 		"try { "
-		"_bc_eval_." QJS_EVAL_RET_PROP_NAME " = "
-		+ eastl::string(wrapInAsyncFn ? "(" + s + "); " : "eval('\"use math\"; void 0; ' + _bc_script_); ") +
+		"_bc_eval_." QJS_EVAL_RET_PROP_NAME " = (" + s + "); "
 		"CheckReturnValue (); "
 		"} "
 		"catch(e) { _bc_eval_." QJS_EVAL_RET_PROP_NAME " = \"Throw: \" + e; } "
-		"} "
-		+ eastl::string(wrapInAsyncFn ? ")(); " : "")
-		).c_str(), asyncArgs.data(), asyncArgs.size(), &qjsRetU64, quiet);
+		"})"
+		).c_str());
 
-	CheckRet();
-
-	// process all the async operation requests.
+	Root::I->LogWindow.AddString("", FALSE, FALSE);
 
-	while (::strlen(asyncArgs.data()))
-	{
-		// determine which async op was requested and its arguments.
-
-		auto v = Utils::Tokenize(eastl::string(asyncArgs.data()), "$delim$");
+	return fn;
+}
 
-		::memset(asyncArgs.data(), 0, asyncArgs.size());
+VOID QuickJSCppInterface::FreeCompiled(LONG fn) noexcept
+{
+	SaveFPUState __fpu_state__;
 
-		s = "";
-		eastl::string addJsCode = "";
+	if (fn >= 0)
+		::QJS_FreeCompiled_ES(fn);
+}
 
-		if (v[0] == "ReadMem" && v.size() == 4)
-		{
-			s = "[";
+BcCoroutine QuickJSCppInterface::Call(LONG fn, BYTE* context, ULONG contextLen, BOOLEAN is32bitCompat, NullableU64* pRetVal /*= NULL*/, BOOLEAN quiet /*= FALSE*/, ULONG budgetMs /*= 0*/) noexcept
+{
+	SaveFPUState __fpu_state__;
 
-			auto dataSz = (size_t)::BC_strtoui64(v[3].c_str(), NULL, 10);
+	// no scripts are parsed on this path: the function reads the registers through the accessors.
 
-			if (dataSz == 1 || dataSz == 2 || dataSz == 4 || dataSz == 8)
-			{
-				auto sz = dataSz * (size_t)::BC_strtoui64(v[2].c_str(), NULL, 10);
-
-				if (sz)
-				{
-					BYTE* pb = (BYTE*)co_await BcAwaiter_ReadMemory{
-						(ULONG_PTR)::BC_strtoui64(v[1].c_str(), NULL, 10),
-						sz };
-
-					if (pb)
-						for (int i = 0; i < sz; i += dataSz)
-							s += "0x" + Utils::HexToString(dataSz == 1 ? pb[i] : dataSz == 2 ? *(WORD*)&pb[i] : dataSz == 4 ? *(DWORD*)&pb[i] : *(QWORD*)&pb[i], dataSz) +
-							(dataSz == 8 ? "n" : "") +
-							(i != sz - dataSz ? "," : "");
-				}
-			}
+	SetCurrentContext(context, contextLen, is32bitCompat);
 
-			s += "]";
-		}
-		else if (v[0] == "WriteMem" && v.size() > 3)
-		{
-			s = "false";
+	ULONG64 qjsRetU64 = 0;
 
-			auto address = (ULONG_PTR)::BC_strtoui64(v[1].c_str(), NULL, 10);
-			auto dataSz = (size_t)::BC_strtoui64(v[2].c_str(), NULL, 10);
+	eastl::unique_ptr<QJS_ASYNC_OP> asyncOp(new QJS_ASYNC_OP());
 
-			if (dataSz == 1 || dataSz == 2 || dataSz == 4 || dataSz == 8)
-			{
-				eastl::vector<BYTE> data;
+	if (!budgetMs)
+		budgetMs = Root::I->JsBudgetMs;
 
-				for (int i = 3; i < v.size(); i++)
-				{
-					ULONG64 item = ::BC_strtoui64(v[i].c_str(), NULL, 10);
+	BeginBudget(budgetMs);
 
-					const BYTE* start = (BYTE*)&item; // warning: truncates.
+	int qjsRet = ::QJS_Call_ES(fn, asyncOp.get(), &qjsRetU64, quiet);
 
-					data.insert(data.end(), start, start + dataSz);
-				}
+	if (pRetVal && (qjsRet & QJS_EVAL_SUCCESS_RETVALU64))
+	{
+		pRetVal->value = qjsRetU64;
+		pRetVal->isNull = FALSE;
+	}
 
-				BOOLEAN res = FALSE;
+	// process all the async operation requests.
 
-				co_await BcAwaiter_Join{ Cmd::WriteMemory(address, data.data(), data.size(), res) };
+	co_await BcAwaiter_Join{ ProcessAsyncOps(*asyncOp, pRetVal, quiet) };
 
-				if (res)
-					s = "true";
-			}
-		}
-		else if (v[0] == "WriteReg" && v.size() == 3)
-		{
-			s = "false";
+	// send the registers changed by the function.
 
-			auto& regName = v[1];
-			auto val = (ULONG64)::BC_strtoui64(v[2].c_str(), NULL, 10);
+	co_await BcAwaiter_Join{ FlushContext() };
 
-			VOID* preg = NULL;
-			size_t sz = 0;
+	EndBudget(budgetMs, quiet);
 
-			ZydisRegister reg = X86Step::StringToZydisReg(regName.c_str());
-			if (reg != ZYDIS_REGISTER_NONE)
-			{
-				preg = X86Step::ZydisRegToCtxRegValuePtr((CONTEXT*)context, reg, &sz);
-			}
+	// remove last line if empty + refresh ui.
 
-			if (_6432_(TRUE, FALSE) && is32bitCompat && sz == 8) // Unable to change 64-bit register in 32-bit mode.
-			{
-				preg = NULL;
-				sz = 0;
-			}
+	Root::I->LogWindow.AddString("", FALSE, !quiet);
 
-			if (preg && (sz == 4 || sz == 8))
-			{
-				// set the new value in the context.
+	// return.
 
-				if (sz == 8)
-					*(ULONG64*)preg = val;
-				else
-					*(ULONG32*)preg = (ULONG32)val;
+	co_return;
+}
 
-				// set the new context.
+BcCoroutine QuickJSCppInterface::ProcessAsyncOps(QJS_ASYNC_OP& asyncOp, NullableU64* pRetVal, BOOLEAN quiet) noexcept // N.B. the FPU state is saved by the caller.
+{
+	ULONG64 qjsRetU64 = 0;
+	int qjsRet = 0;
 
-				if (co_await BcAwaiter_StateManipulate{
-				[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+	while (asyncOp.op != QJS_ASYNC_OP_NONE)
+	{
+		// the arguments were validated and converted by _bc_async_op_.
 
-					if (SecondBuffer->pData != NULL && contextLen > 0 && SecondBuffer->MaxLength >= contextLen)
-					{
-						pState->ApiNumber = DbgKdSetContextApi;
+		const VOID* data = NULL;
+		BOOLEAN ok = FALSE;
 
-						::memcpy(SecondBuffer->pData, context, contextLen);
-						SecondBuffer->Length = contextLen;
-					}
-				},
-				[](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+		ULONG size = (ULONG)(asyncOp.count * asyncOp.dataSize);
 
-					return pState->ApiNumber == DbgKdSetContextApi && NT_SUCCESS(pState->ReturnStatus);
-				} })
-				{
-					s = "true";
+		if (asyncOp.op == QJS_ASYNC_OP_READMEM)
+		{
+			data = co_await BcAwaiter_ReadMemory{ (ULONG_PTR)asyncOp.address, size };
 
-					AddRegs(addJsCode);
-				}
-			}
+			ok = data != NULL;
+		}
+		else if (asyncOp.op == QJS_ASYNC_OP_WRITEMEM)
+		{
+			co_await BcAwaiter_Join{ Cmd::WriteMemory(asyncOp.address, asyncOp.data, size, ok) };
+		}
+		else if (asyncOp.op == QJS_ASYNC_OP_SETCONTEXT)
+		{
+			co_await BcAwaiter_Join{ FlushContext(&ok) };
 		}
 		else
 		{
 			_bc_printf("Error: unrecognized async operation request.\n");
 		}
 
-		// resolve the promise passing our return value.
+		// resolve the promise passing our return value: the data is copied in a typed array.
 
-		if (s.size())
+		qjsRet = ::QJS_Resolve_ES(data, asyncOp.count, asyncOp.dataSize, ok, &asyncOp, &qjsRetU64, quiet);
+
+		if (pRetVal && (qjsRet & QJS_EVAL_SUCCESS_RETVALU64))
 		{
-			qjsRet = ::QJS_Eval_ES((
-				addJsCode +
-				"{ "
-				"let resolve = _bc_eval_.resolve; "
-				"_bc_eval_.resolve = null; "
-				"_bc_eval_.reject = null; "
-				"_bc_eval_.async_args = null; "
-				"resolve(" + s + "); "
-				"} "
-				).c_str(), asyncArgs.data(), asyncArgs.size(), &qjsRetU64, quiet);
-
-			CheckRet();
+			pRetVal->value = qjsRetU64;
+			pRetVal->isNull = FALSE;
 		}
 	}
 
-	// remove last line if empty + refresh ui.
+	co_return;
+}
 
-	Root::I->LogWindow.AddString("", FALSE, !quiet);
+BcCoroutine QuickJSCppInterface::FlushContext(BOOLEAN* pRes /*= NULL*/) noexcept
+{
+	BOOLEAN res = TRUE;
 
-	// return.
+	if (QJSContextChanged && QJSContext)
+	{
+		res = co_await BcAwaiter_StateManipulate{
+		[&](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+			if (SecondBuffer->pData != NULL && QJSContextLen > 0 && SecondBuffer->MaxLength >= QJSContextLen)
+			{
+				pState->ApiNumber = DbgKdSetContextApi;
+
+				::memcpy(SecondBuffer->pData, QJSContext, QJSContextLen);
+				SecondBuffer->Length = QJSContextLen;
+			}
+		},
+		[](DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer) {
+
+			return pState->ApiNumber == DbgKdSetContextApi && NT_SUCCESS(pState->ReturnStatus);
+		} };
+
+		if (res)
+			QJSContextChanged = FALSE;
+		else if (!pRes)
+			_bc_printf("Unable to set the context.\n");
+	}
+
+	if (pRes)
+		*pRes = res;
 
 	co_return;
 }
@@ -766,6 +1004,8 @@ BcCoroutine QuickJSCppInterface::Eval(const CHAR* psz, BYTE* context, ULONG cont
 // Definitions of functions imported by QuickJS, that require some form of integration with BC:
 //
 
+#ifndef BC_HOSTSIM // on the host, QuickJS allocates from the C library.
+
 extern "C" void* __stdcall malloc(__in size_t _Size)
 {
 	auto prevStart0to99 = Allocator::Start0to99;
@@ -802,6 +1042,8 @@ extern "C" void* __stdcall realloc(__in_opt void* _Memory, __in size_t _NewSize)
 	return newMem;
 }
 
+#endif
+
 extern "C" int __stdcall _bc_printf_impl(const char* _Format, va_list ap)
 {
 	const int bufferSize = 512;
@@ -827,6 +1069,8 @@ extern "C" int __stdcall _bc_printf(__in_z __format_string const char* _Format,
 	return ret;
 }
 
+#ifndef BC_HOSTSIM // on the host, QuickJS is linked with the C library.
+
 extern "C" int __stdcall _bc_vsnprintf(__out_ecount(_MaxCount) char* s, __in size_t n, __in_z __format_string const char* format, va_list ap)
 {
 	if (s && n)
@@ -1130,3 +1374,5 @@ extern "C" double __stdcall _bc_trunc(__in double _X)
 	else
 		return (__int64)_X;
 }
+
+#endif
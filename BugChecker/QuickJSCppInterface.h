@@ -2,6 +2,8 @@
 #define QUICKJSCPPINTERFACE_H
 
 #ifdef __cplusplus
+struct QJS_ASYNC_OP;
+
 class NullableU64
 {
 public:
@@ -14,6 +16,18 @@ class QuickJSCppInterface
 public:
 
 	static BcCoroutine Eval(const CHAR* psz, BYTE* context, ULONG contextLen, BOOLEAN is32bitCompat, NullableU64* pRetVal = NULL, BOOLEAN quiet = FALSE, BOOLEAN wrapInAsyncFn = TRUE) noexcept;
+
+	static LONG Compile(const CHAR* psz) noexcept; // compiles the expression into a function that can be called without parsing it again: returns -1 on error.
+	static VOID FreeCompiled(LONG fn) noexcept;
+	static BcCoroutine Call(LONG fn, BYTE* context, ULONG contextLen, BOOLEAN is32bitCompat, NullableU64* pRetVal = NULL, BOOLEAN quiet = FALSE, ULONG budgetMs = 0) noexcept; // budgetMs: 0 means Root::JsBudgetMs.
+
+	static ULONG64 LastTicks; // rdtsc ticks spent in QuickJS by the last Eval or Call (the KD round-trips of its async operations are not counted).
+	static BOOLEAN LastTimedOut; // the last Eval or Call exceeded its time budget and was interrupted.
+
+private:
+
+	static BcCoroutine ProcessAsyncOps(QJS_ASYNC_OP& asyncOp, NullableU64* pRetVal, BOOLEAN quiet) noexcept;
+	static BcCoroutine FlushContext(BOOLEAN* pRes = NULL) noexcept; // sends the context to the kernel if a register was written by the script.
 };
 #endif
 
@@ -25,13 +39,21 @@ public:
 
 QJSCPPI_EXTERN void __stdcall _bc_resetstdout();
 
+QJSCPPI_EXTERN int __stdcall _bc_getreg(int index, unsigned __int64* value); // index in QJSRegNames; returns FALSE if the register is not available.
+QJSCPPI_EXTERN int __stdcall _bc_setreg(int index, unsigned __int64 value);
+QJSCPPI_EXTERN int __stdcall _bc_is32bitcompat();
+
+QJSCPPI_EXTERN int __stdcall _bc_readcache(unsigned __int64 address, unsigned int size, void* dest);
+
 QJSCPPI_EXTERN const char* QJSStartupScript;
 
+QJSCPPI_EXTERN const char* QJSRegNames[];
+QJSCPPI_EXTERN const int QJSRegNamesNum;
+
 #define QJS_EVAL_RET_OBJ_NAME "_bc_eval_"
 #define QJS_EVAL_TAG_PROP_NAME "_bc_eval_object_"
 #define QJS_EVAL_RET_PROP_NAME "ret"
 #define QJS_EVAL_RET_STR_PROP_NAME "retStr"
 #define QJS_EVAL_RET_U64_PROP_NAME "retU64"
-#define QJS_EVAL_ASYNC_ARGS_PROP_NAME "async_args"
 
 #endif
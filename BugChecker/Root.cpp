@@ -132,9 +132,112 @@ VOID Root::CalculateRdtscTimeouts() // =fixfix= RDTSC is not ideal/reliable here
 	ULONG64 diff = __rdtsc() - rdtscStart;
 
 	CursorBlinkTime = diff * 3;
+	RdtscTicksPerMs = diff / 100;
 	VideoRestoreBufferTimeOut = diff / 2;
 }
 
+VOID BreakPointList::insert(iterator it, BreakPoint&& bp)
+{
+	ULONG pos = (ULONG)(it - bps.begin());
+	ULONG64 address = bp.address;
+
+	bps.insert(it, eastl::move(bp));
+
+	// shift the positions of the following breakpoints, then insert the new entry after the ones with the same address and a lower position.
+
+	for (IndexEntry& e : index)
+		if (e.pos >= pos)
+			e.pos++;
+
+	for (LONG& p : drPos)
+		if (p >= (LONG)pos)
+			p++;
+
+	if (bps[pos].drIndex >= 0)
+		drPos[bps[pos].drIndex] = pos;
+
+	auto i = LowerBound(address);
+
+	while (i != index.end() && i->address == address && i->pos < pos)
+		i++;
+
+	index.insert(i, { address, pos });
+}
+
+VOID BreakPointList::erase(iterator it)
+{
+	ULONG pos = (ULONG)(it - bps.begin());
+	ULONG64 address = it->address;
+
+	bps.erase(it);
+
+	for (auto i = LowerBound(address); i != index.end() && i->address == address; i++)
+		if (i->pos == pos)
+		{
+			index.erase(i);
+			break;
+		}
+
+	for (IndexEntry& e : index)
+		if (e.pos > pos)
+			e.pos--;
+
+	for (LONG& p : drPos)
+		if (p == (LONG)pos)
+			p = -1;
+		else if (p > (LONG)pos)
+			p--;
+}
+
+VOID BreakPointList::clear()
+{
+	bps.clear();
+	index.clear();
+
+	for (LONG& p : drPos)
+		p = -1;
+}
+
+VOID BreakPointList::FindInRange(ULONG64 start, ULONG64 end, eastl::vector<BreakPoint*>& out)
+{
+	for (auto i = LowerBound(start); i != index.end() && i->address < end; i++)
+		out.push_back(&bps[i->pos]);
+}
+
+BreakPoint* BreakPointList::Find(ULONG64 address)
+{
+	auto i = LowerBound(address);
+
+	return i != index.end() && i->address == address ? &bps[i->pos] : NULL;
+}
+
+BreakPoint* BreakPointList::FindHw(ULONG64 dr6)
+{
+	LONG pos = -1;
+
+	for (LONG i = 0; i < 4; i++)
+		if ((dr6 & (1 << i)) && drPos[i] >= 0 && (pos < 0 || drPos[i] < pos))
+			pos = drPos[i];
+
+	return pos >= 0 ? &bps[pos] : NULL;
+}
+
+LONG BreakPointList::GetFreeDrIndex()
+{
+	for (LONG i = 0; i < 4; i++)
+		if (drPos[i] < 0)
+			return i;
+
+	return -1;
+}
+
+eastl::vector<BreakPointList::IndexEntry>::iterator BreakPointList::LowerBound(ULONG64 address)
+{
+	Perf_LookupsNum++;
+
+	return eastl::lower_bound(index.begin(), index.end(), address, [this](const IndexEntry& e, ULONG64 a) { Perf_ComparesNum++; return e.address < a; });
+}
+
 BpTrace& BpTrace::Get()
 {
 	int index = -1;
@@ -151,7 +254,7 @@ BpTrace& BpTrace::Get()
 		Root::I->BpTraces.insert(Root::I->BpTraces.begin(),
 			eastl::pair<ULONG64, BpTrace>(Root::I->StateChange.Thread, BpTrace()));
 
-		size_t dim = 3 * _MAX_(Root::I->StateChange.Processor + 1, Root::I->StateChange.NumberProcessors);
+		size_t dim = 3 * _MAX_((ULONG)Root::I->StateChange.Processor + 1, Root::I->StateChange.NumberProcessors);
 
 		Root::I->BpTraces.resize(dim);
 	}
@@ -15,17 +15,20 @@
 #include "LogWnd.h"
 #include "Cmd.h"
 #include "CodeWnd.h"
+#include "DbgPrintRing.h"
+#include "PageCache.h"
+#include "DecodeCache.h"
+#include "UnwindTables.h"
+#include "KdTrace.h"
+#include "Logpoint.h"
 
 #include <EASTL/vector.h>
 #include <EASTL/unique_ptr.h>
 
 #define ALLOCATOR_START_0TO99_NTMODULES 60
-#define ALLOCATOR_START_0TO99_LOG 40
 #define ALLOCATOR_START_0TO99_QUICKJS 20
 
-#define LOG_WINDOW_CONTENTS_MAX_SIZE (1*1024*1024)
-
-typedef enum _DEBUGGER_STATE
+typedef enum _DEBUGGER_STATE : int
 {
 	DEBST_UNKNOWN,
 	DEBST_STATE_CHANGED,
@@ -55,12 +58,81 @@ public:
 	ULONG64 ethread = 0;
 
 	eastl::string when;
+	LONG whenFn = -1; // "when" compiled by QuickJSCppInterface::Compile.
+	ULONG whenBudgetMs = 0; // 0 means Root::JsBudgetMs.
+	ULONG whenTimeoutsNum = 0; // consecutive evaluations of "when" interrupted: the breakpoint is disabled after MaxWhenTimeouts.
+
+	static constexpr ULONG MaxWhenTimeouts = 3;
 
 	BOOLEAN skip = FALSE;
 
 	BOOLEAN isStepBp = FALSE;
 
 	eastl::string cmd;
+
+	Logpoint log; // set by BPL: the hit is logged natively and no break in happens.
+
+	LONG drIndex = -1; // hardware breakpoint (BPM, BPX -hw, BPL -hw): index of DR0-DR3. Nothing is written in memory and no single step is required to recreate it.
+	BYTE drRw = DrRwExecute; // R/W and LEN fields in DR7.
+	BYTE drLen = 0;
+
+	static constexpr BYTE DrRwExecute = 0;
+	static constexpr BYTE DrRwWrite = 1;
+	static constexpr BYTE DrRwReadWrite = 3;
+
+	ULONG sampleEvery = 0; // "-every N": the conditions are evaluated at one hit out of N.
+	ULONG sampleRate = 0; // "-rate X/s": the conditions are evaluated at most X times per second.
+	ULONG sampleCounter = 0;
+	ULONG64 sampleWindowStart = 0; // in rdtsc ticks.
+	ULONG sampleWindowHits = 0;
+
+	ULONG64 hitsNum = 0; // statistics shown by BL.
+	ULONG64 trueNum = 0; // hits that broke in or were logged.
+	ULONG64 sampledOutNum = 0; // hits filtered by the sampling, without evaluating the conditions.
+	ULONG64 condTicks = 0; // cumulative cost of the logpoint and of the WHEN expression, in rdtsc ticks.
+	LONG lastCpu = -1;
+};
+
+class BreakPointList // the breakpoints in the order shown by BL, plus an index sorted by address for the lookups done at each state change.
+{
+public:
+
+	typedef eastl::vector<BreakPoint>::iterator iterator;
+
+	iterator begin() { return bps.begin(); }
+	iterator end() { return bps.end(); }
+
+	size_t size() const { return bps.size(); }
+	BreakPoint& operator[](size_t i) { return bps[i]; }
+
+	VOID push_back(BreakPoint&& bp) { insert(bps.end(), eastl::move(bp)); }
+	VOID insert(iterator pos, BreakPoint&& bp);
+	VOID erase(iterator pos);
+	VOID clear();
+
+	VOID FindInRange(ULONG64 start, ULONG64 end, eastl::vector<BreakPoint*>& out); // appends the breakpoints in [start, end), sorted by address and then by position.
+	BreakPoint* Find(ULONG64 address); // the first breakpoint at this address, or NULL.
+	BreakPoint* FindHw(ULONG64 dr6); // the first hardware breakpoint whose B0-B3 bit is set in DR6, or NULL.
+
+	LONG GetFreeDrIndex(); // -1 if DR0-DR3 are all used.
+
+	ULONG64 Perf_LookupsNum = 0; // binary searches of the index.
+	ULONG64 Perf_ComparesNum = 0; // index entries compared by the binary searches.
+
+private:
+
+	struct IndexEntry
+	{
+		ULONG64 address;
+		ULONG pos; // in "bps".
+	};
+
+	eastl::vector<IndexEntry>::iterator LowerBound(ULONG64 address);
+
+	eastl::vector<BreakPoint> bps;
+	eastl::vector<IndexEntry> index; // sorted by address and then by position: updated in O(n), without sorting, when a breakpoint is added or removed.
+
+	LONG drPos[4] = { -1, -1, -1, -1 }; // position of the breakpoint that uses DR0-DR3, or -1: looked up at each single step.
 };
 
 class BpTrace
@@ -146,9 +218,11 @@ public: // window
 	RegsWnd RegsWindow;
 	DisasmWnd DisasmWindow;
 	LogWnd LogWindow;
-	InputLine InputLine;
+	::InputLine InputLine;
 	CodeWnd CodeWindow;
 
+	DbgPrintRing DbgPrints;
+
 	eastl::string CurrentImageFileName = "";
 	LONG CurrentIrql = -1;
 
@@ -157,6 +231,7 @@ public: // cursor
 	VOID CalculateRdtscTimeouts();
 
 	ULONG64 CursorBlinkTime = 0;
+	ULONG64 RdtscTicksPerMs = 0;
 
 	LONG CursorDisplayX = -1;
 	LONG CursorDisplayY = -1;
@@ -170,7 +245,7 @@ public: // cursor
 	LONG CodeCursorX = 2;
 	LONG CodeCursorY = 14;
 
-	CursorFocus CursorFocus = CursorFocus::Log;
+	::CursorFocus CursorFocus = ::CursorFocus::Log;
 
 public: // Wnd::CheckDivLineYs function
 
@@ -183,6 +258,12 @@ public: // nt modules
 
 	eastl::vector<eastl::pair<ULONG64, eastl::vector<NtModule>>>* NtModules = NULL; // we don't use map or multimap because they require rbtree_node_base which is defined in an EASTL implementation file.
 
+	UnwindTables* UnwindInfo = NULL; // allocated in BC's high-irql pool the first time a kernel module is added.
+
+	eastl::vector<eastl::unique_ptr<VadSnapshot>> VadSnapshots; // cleared when the debugger returns control to the OS.
+
+	ULONG64 CurrentEprocess = 0; // ApcState.Process of StateChange.Thread, read once per state change: cleared when the debugger returns control to the OS.
+
 	BcSpinLock DebuggerLock; // WARNING!! this also blocks IPIs sent by the kernel to freeze the processors, thus blocking entry into the KD.
 
 	BOOLEAN ProcessNotifyCreated = FALSE;
@@ -204,11 +285,37 @@ public: // trace/bp
 
 	LONG BpHitIndex = -1;
 
+public: // kd statistics
+
+	ULONG64 Perf_BreakInsNum = 0;
+	ULONG64 Perf_KdRoundTripsNum = 0;
+	ULONG64 Perf_KdRoundTripsByApi[DbgKdMaximumManipulate - DbgKdMinimumManipulate] = { 0 };
+
+	ULONG64 Perf_BpOpsNum = 0; // breakpoints written or restored through BcAwaiter_BreakPoints.
+	ULONG64 Perf_BpOpsBatchesNum = 0;
+	ULONG64 Perf_BpOpsTime = 0; // in rdtsc ticks.
+
+	ULONG64 Perf_BpHitsNum = 0; // software breakpoints: each hit requires another debugger entry (the single step that recreates the breakpoint).
+	ULONG64 Perf_BpRearmStepsNum = 0;
+	ULONG64 Perf_HwBpHitsNum = 0; // hardware breakpoints: one debugger entry per hit.
+
+	ULONG64 Perf_BpFilteredNum = 0; // hits discarded by the thread/process filters (-t, -p, -kt, -kp).
+	ULONG64 Perf_BpFilterRoundTripsNum = 0; // KD round-trips spent by the thread/process filters.
+
+	KdTrace KdEvents;
+
+	LatencyHistogram Perf_JsLatency; // time spent in QuickJS by each evaluation.
+
 public: // others
 
 	BYTE ExpandedStack[128 * 1024]; // used by QuickJS.
 
-	eastl::vector<BreakPoint> BreakPoints;
+	BreakPointList BreakPoints;
+
+	ULONG64 HwDr7 = 0; // DR7 of the hardware breakpoints, set on all the processors by DbgKdContinueApi2.
+	BOOLEAN HwDr7Set = FALSE; // a hardware breakpoint was set: the continue requests must carry DR7 from now on.
+
+	ULONG JsBudgetMs = 1000; // time budget of the javascript evaluations (0 means no limit): a BPX WHEN expression can have its own.
 
 	eastl::vector<eastl::unique_ptr<Cmd>> Cmds;
 
@@ -220,6 +327,10 @@ public: // others
 
 	MemoryReaderCoroutineState MemReadCor;
 
+	PageCache ReadCache;
+
+	DecodeCache DecodedInstrs; // used by the disassembler window and by the stepping code.
+
 	ULONG64 PsLoadedModuleList = 0;
 
 	eastl::allocator eastl_allocator;
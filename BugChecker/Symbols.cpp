@@ -121,7 +121,6 @@ const BCSFILE_DATATYPE_MEMBER* Symbols::GetDatatypeMember(VOID* symbols, const B
 		return NULL;
 
 	auto mbs = (BCSFILE_DATATYPE_MEMBER*)((BYTE*)symbols + header->datatypeMembers);
-	int mbsNum = header->datatypeMembersSize / sizeof(BCSFILE_DATATYPE_MEMBER);
 
 	CHAR* names = (CHAR*)((BYTE*)symbols + header->names);
 
@@ -129,7 +128,7 @@ const BCSFILE_DATATYPE_MEMBER* Symbols::GetDatatypeMember(VOID* symbols, const B
 
 	mbs += datatype->firstMember;
 
-	for (int i = 0; i < datatype->numOfMembers; i++)
+	for (int i = 0; i < (int)datatype->numOfMembers; i++)
 		if (!::strcmp(memberName, names + mbs[i].name))
 		{
 			if (expectedType && ::strcmp(expectedType, names + mbs[i].datatype))
@@ -2,7 +2,7 @@
 
 #include "BugChecker.h"
 
-#include "..\pdb\headers\bcsfile.h"
+#include "../pdb/headers/bcsfile.h"
 
 class Symbols
 {
@@ -0,0 +1,367 @@
+#include "UnwindTables.h"
+
+#include "Root.h"
+#include "Platform.h"
+
+#include <ntimage.h>
+
+class PdataEntry // RUNTIME_FUNCTION.
+{
+public:
+	ULONG begin;
+	ULONG end;
+	ULONG unwindInfo;
+};
+
+static BOOLEAN DigestUnwindInfo(ULONG64 base, ULONG sizeOfImage, const PdataEntry& pe, UnwindEntry& e)
+{
+	const ULONG maxChainLen = 8;
+
+	e.begin = pe.begin;
+	e.end = pe.end;
+	e.frameSize = 0;
+	e.rbpSave = -1;
+	e.prologSize = 0;
+	e.frameOffset = 0;
+	e.flags = 0;
+
+	if (pe.begin >= pe.end || pe.end > sizeOfImage)
+		return FALSE;
+
+	// process the codes in unwind order: the codes of this function and then the codes of its parents in the chain, whose prologs were executed before.
+
+	ULONG offset = 0; // from the base of the frame.
+	ULONG rva = pe.unwindInfo;
+
+	for (ULONG chainLen = 0; ; chainLen++)
+	{
+		if (chainLen >= maxChainLen || rva + 4 > sizeOfImage)
+			return FALSE;
+
+		const BYTE* ui = (const BYTE*)(base + rva);
+
+		BYTE version = ui[0] & 7;
+		BYTE flags = ui[0] >> 3;
+		ULONG codesNum = ui[2];
+
+		if ((version != 1 && version != 2) || rva + 4 + codesNum * 2 + sizeof(PdataEntry) > sizeOfImage)
+			return FALSE;
+
+		if (!chainLen)
+			e.prologSize = ui[1];
+
+		const USHORT* slots = (const USHORT*)(ui + 4);
+
+		for (ULONG k = 0; k < codesNum; )
+		{
+			BYTE op = (slots[k] >> 8) & 0xF;
+			BYTE info = slots[k] >> 12;
+
+			switch (op)
+			{
+			case 0: // UWOP_PUSH_NONVOL
+				if (info == 5 && e.rbpSave < 0) e.rbpSave = offset;
+				offset += 8;
+				k += 1;
+				break;
+
+			case 1: // UWOP_ALLOC_LARGE
+				if (k + (info ? 2 : 1) >= codesNum) return FALSE;
+				offset += info ? *(const ULONG*)&slots[k + 1] : slots[k + 1] * 8;
+				k += info ? 3 : 2;
+				break;
+
+			case 2: // UWOP_ALLOC_SMALL
+				offset += info * 8 + 8;
+				k += 1;
+				break;
+
+			case 3: // UWOP_SET_FPREG: only RBP can be tracked by the walker.
+				if ((ui[3] & 0xF) != 5) return FALSE;
+				e.flags |= UnwindEntry::FlagFramePointer;
+				e.frameOffset = ui[3] >> 4;
+				offset = 0; // like RtlVirtualUnwind: the allocations after "lea rbp" in the prolog are discarded and the base becomes RBP - frameOffset * 16.
+				e.rbpSave = -1;
+				k += 1;
+				break;
+
+			case 4: // UWOP_SAVE_NONVOL
+				if (k + 1 >= codesNum) return FALSE;
+				if (info == 5 && e.rbpSave < 0) e.rbpSave = slots[k + 1] * 8;
+				k += 2;
+				break;
+
+			case 5: // UWOP_SAVE_NONVOL_FAR
+				if (k + 2 >= codesNum) return FALSE;
+				if (info == 5 && e.rbpSave < 0) e.rbpSave = *(const ULONG*)&slots[k + 1];
+				k += 3;
+				break;
+
+			case 6: // UWOP_EPILOG (version 2) or UWOP_SAVE_XMM (version 1).
+				k += version == 2 ? 1 : 2;
+				break;
+
+			case 7: // UWOP_SAVE_XMM_FAR
+				k += 3;
+				break;
+
+			case 8: // UWOP_SAVE_XMM128
+				k += 2;
+				break;
+
+			case 9: // UWOP_SAVE_XMM128_FAR
+				k += 3;
+				break;
+
+			case 10: // UWOP_PUSH_MACHFRAME: always the last code.
+				e.flags |= UnwindEntry::FlagMachineFrame | (info ? UnwindEntry::FlagErrorCode : 0);
+				e.frameSize = offset;
+				return TRUE;
+
+			default:
+				return FALSE;
+			}
+		}
+
+		// is there a parent function?
+
+		if (!(flags & 4)) // UNW_FLAG_CHAININFO
+			break;
+
+		rva = ((const PdataEntry*)(ui + 4 + ((codesNum + 1) & ~1) * 2))->unwindInfo;
+	}
+
+	e.frameSize = offset;
+
+	return TRUE;
+}
+
+BOOLEAN UnwindEpilog::Match(UnwindEpilog& ep, const BYTE* code, ULONG len, ULONG64 ip, ULONG64 funcBegin, ULONG64 funcEnd)
+{
+	ep.fromRbp = FALSE;
+	ep.rspDelta = 0;
+	ep.popsNum = 0;
+	ep.rbpPop = -1;
+
+	ULONG i = 0;
+
+	auto has = [&](ULONG n) { return i + n <= len; };
+
+	// "add rsp, imm" or "lea rsp, [rbp+disp]".
+
+	if (has(4) && code[0] == 0x48 && code[1] == 0x83 && code[2] == 0xC4)
+	{
+		ep.rspDelta = (CHAR)code[3];
+		i = 4;
+	}
+	else if (has(7) && code[0] == 0x48 && code[1] == 0x81 && code[2] == 0xC4)
+	{
+		ep.rspDelta = *(const LONG*)&code[3];
+		i = 7;
+	}
+	else if (has(4) && code[0] == 0x48 && code[1] == 0x8D && code[2] == 0x65)
+	{
+		ep.fromRbp = TRUE;
+		ep.rspDelta = (CHAR)code[3];
+		i = 4;
+	}
+	else if (has(7) && code[0] == 0x48 && code[1] == 0x8D && code[2] == 0xA5)
+	{
+		ep.fromRbp = TRUE;
+		ep.rspDelta = *(const LONG*)&code[3];
+		i = 7;
+	}
+
+	BOOLEAN adjust = i != 0;
+
+	// the pops of the nonvolatile registers.
+
+	while (TRUE)
+	{
+		if (has(1) && code[i] >= 0x58 && code[i] <= 0x5F)
+		{
+			if (code[i] == 0x5D)
+				ep.rbpPop = ep.popsNum;
+
+			i += 1;
+		}
+		else if (has(2) && code[i] == 0x41 && code[i + 1] >= 0x58 && code[i + 1] <= 0x5F)
+			i += 2;
+		else
+			break;
+
+		ep.popsNum++;
+	}
+
+	// "ret", or a tail call out of the function, after at least one epilog instruction.
+
+	if (has(1) && (code[i] == 0xC3 || code[i] == 0xC2))
+		return TRUE;
+	else if (has(2) && code[i] == 0xF3 && code[i + 1] == 0xC3)
+		return TRUE;
+
+	if (!adjust && !ep.popsNum)
+		return FALSE;
+
+	ULONG64 target = 0;
+
+	if (has(5) && code[i] == 0xE9)
+		target = ip + i + 5 + *(const LONG*)&code[i + 1];
+	else if (has(2) && code[i] == 0xEB)
+		target = ip + i + 2 + (CHAR)code[i + 1];
+	else if (has(2) && code[i] == 0xFF && (code[i + 1] & 0x38) == 0x20) // jmp r/m.
+		return TRUE;
+	else if (has(3) && code[i] == 0x48 && code[i + 1] == 0xFF && (code[i + 2] & 0x38) == 0x20) // rex.w jmp r/m.
+		return TRUE;
+	else
+		return FALSE;
+
+	return target < funcBegin || target >= funcEnd;
+}
+
+VOID UnwindTables::SnapshotModule(ULONG64 base)
+{
+#ifdef _AMD64_
+
+	// the session images (and the images being unloaded) are not mapped in this context.
+
+	if (!::MmIsAddressValid((PVOID)base))
+		return;
+
+	ULONG sizeOfImage = 0;
+	IMAGE_DATA_DIRECTORY dirPdata = {};
+
+	__try
+	{
+		IMAGE_DOS_HEADER* pdh = (IMAGE_DOS_HEADER*)base;
+
+		if (pdh->e_magic != IMAGE_DOS_SIGNATURE)
+			return;
+
+		IMAGE_NT_HEADERS64* pnth = (IMAGE_NT_HEADERS64*)(base + pdh->e_lfanew);
+
+		if (!::MmIsAddressValid(pnth) ||
+			pnth->Signature != IMAGE_NT_SIGNATURE ||
+			pnth->OptionalHeader.Magic != IMAGE_NT_OPTIONAL_HDR64_MAGIC)
+			return;
+
+		sizeOfImage = pnth->OptionalHeader.SizeOfImage;
+		dirPdata = pnth->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+	}
+	__except (EXCEPTION_EXECUTE_HANDLER)
+	{
+		return;
+	}
+
+	ULONG num = dirPdata.Size / sizeof(PdataEntry);
+
+	if (!num || dirPdata.VirtualAddress + dirPdata.Size > sizeOfImage)
+		return;
+
+	// digest the entries in a temporary buffer, outside of the lock: the pages of the image may need to be paged in.
+
+	UnwindEntry* digest = (UnwindEntry*)::ExAllocatePool(NonPagedPool, num * sizeof(UnwindEntry));
+	if (!digest)
+		return;
+
+	ULONG digestNum = 0;
+
+	__try
+	{
+		const PdataEntry* pdata = (const PdataEntry*)(base + dirPdata.VirtualAddress);
+
+		for (ULONG i = 0; i < num; i++)
+			if (DigestUnwindInfo(base, sizeOfImage, pdata[i], digest[digestNum]))
+				digestNum++;
+	}
+	__except (EXCEPTION_EXECUTE_HANDLER)
+	{
+		digestNum = 0;
+	}
+
+	// add the module, replacing the unloaded modules in the same range.
+
+	if (digestNum)
+	{
+		NtModulesAccess _access_(TRUE, "UnwindTables::SnapshotModule"); // N.B. no calls to BC's allocator OUTSIDE OF this scope (including calls to STL/EASTL).
+
+		if (!Root::I->UnwindInfo)
+			Root::I->UnwindInfo = new UnwindTables(); // allocated in BC's high-irql pool: no need to free.
+
+		UnwindTables& t = *Root::I->UnwindInfo;
+
+		for (int i = (int)t.modules.size() - 1; i >= 0; i--)
+			if (t.modules[i].base < base + sizeOfImage && t.modules[i].base + t.modules[i].size > base)
+			{
+				t.entriesNum -= t.modules[i].entries.size();
+				t.modules.erase(t.modules.begin() + i);
+			}
+
+		if (t.entriesNum + digestNum <= MaxEntriesNum)
+		{
+			auto pos = t.modules.begin();
+			while (pos != t.modules.end() && pos->base < base)
+				pos++;
+
+			UnwindModule mod;
+
+			mod.base = base;
+			mod.size = sizeOfImage;
+			mod.entries.assign(digest, digest + digestNum);
+
+			t.modules.insert(pos, eastl::move(mod));
+
+			t.entriesNum += digestNum;
+		}
+	}
+
+	::ExFreePool(digest);
+
+#endif
+}
+
+const UnwindModule* UnwindTables::FindModule(ULONG64 address)
+{
+	LONG start = 0;
+	LONG end = (LONG)modules.size() - 1;
+
+	while (start <= end)
+	{
+		LONG middle = start + (end - start) / 2;
+
+		const UnwindModule& m = modules[middle];
+
+		if (address < m.base)
+			end = middle - 1;
+		else if (address >= m.base + m.size)
+			start = middle + 1;
+		else
+			return &m;
+	}
+
+	return NULL;
+}
+
+const UnwindEntry* UnwindTables::FindEntry(const UnwindModule& mod, ULONG64 address)
+{
+	ULONG rva = (ULONG)(address - mod.base);
+
+	LONG start = 0;
+	LONG end = (LONG)mod.entries.size() - 1;
+
+	while (start <= end)
+	{
+		LONG middle = start + (end - start) / 2;
+
+		const UnwindEntry& e = mod.entries[middle];
+
+		if (rva < e.begin)
+			end = middle - 1;
+		else if (rva >= e.end)
+			start = middle + 1;
+		else
+			return &e;
+	}
+
+	return NULL;
+}
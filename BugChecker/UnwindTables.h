@@ -0,0 +1,63 @@
+#pragma once
+
+#include "BugChecker.h"
+
+#include <EASTL/vector.h>
+
+class UnwindEntry // the unwind info of a function, digested when the module is loaded: enough to unwind a frame whose IP is after the prolog.
+{
+public:
+
+	ULONG begin; // rva.
+	ULONG end;
+	ULONG frameSize; // from the RSP after the prolog (or from the frame register minus the frame offset) to the return address (or to the machine frame).
+	LONG rbpSave; // where the prolog saved RBP, from the same base, or -1.
+	BYTE prologSize;
+	BYTE frameOffset; // in bytes / 16.
+	BYTE flags;
+
+	static constexpr BYTE FlagFramePointer = 1; // RBP is the frame register.
+	static constexpr BYTE FlagMachineFrame = 2; // the return address and the caller RSP are in a machine frame (interrupts and exceptions).
+	static constexpr BYTE FlagErrorCode = 4; // the machine frame has an error code.
+};
+
+class UnwindEpilog // an interrupted frame stopped in an epilog, recognized like RtlVirtualUnwind does.
+{
+public:
+
+	static constexpr ULONG MaxCodeLen = 32; // the bytes to read at the IP.
+
+	BOOLEAN fromRbp; // "lea rsp,[rbp+disp]": the stack pointer is RBP + rspDelta, otherwise RSP + rspDelta.
+	LONG rspDelta;
+	ULONG popsNum;
+	LONG rbpPop; // the index of "pop rbp", or -1.
+
+	static BOOLEAN Match(UnwindEpilog& ep, const BYTE* code, ULONG len, ULONG64 ip, ULONG64 funcBegin, ULONG64 funcEnd); // optional add/lea rsp, pops, then ret or a jmp out of the function.
+};
+
+class UnwindModule
+{
+public:
+
+	ULONG64 base = 0;
+	ULONG size = 0;
+	eastl::vector<UnwindEntry> entries; // sorted by begin, like the exception directory.
+};
+
+class UnwindTables // snapshot of the exception directories (.pdata) of the kernel modules, taken at PASSIVE_LEVEL: the walker never reads them through KD, since they may be paged out.
+{
+public:
+
+	static constexpr ULONG MaxEntriesNum = 96 * 1024; // the modules beyond this limit are not added.
+
+	static VOID SnapshotModule(ULONG64 base); // at PASSIVE_LEVEL. Replaces any module overlapping this image.
+
+	const UnwindModule* FindModule(ULONG64 address);
+	const UnwindEntry* FindEntry(const UnwindModule& mod, ULONG64 address);
+
+	ULONG entriesNum = 0;
+
+private:
+
+	eastl::vector<UnwindModule> modules; // sorted by base.
+};
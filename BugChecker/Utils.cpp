@@ -120,7 +120,7 @@ CHAR* Utils::ParseStructuredFile(IN BYTE* pbFile, IN ULONG ulSize, IN ULONG ulTa
 
 		pszLineStart = p;
 
-		for (i = 0; i < sizeof((*paOutput)) / sizeof(CHAR); i++)
+		for (i = 0; i < (int)(sizeof((*paOutput)) / sizeof(CHAR)); i++)
 		{
 			if (p > pszEnd)
 			{
@@ -204,8 +204,8 @@ eastl::string Utils::GuidToString(BYTE* guid)
 
 	GUID* g = (GUID*)guid;
 
-	::sprintf(buffer, "{%08lX-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX}",
-		g->Data1, g->Data2, g->Data3,
+	::sprintf(buffer, "{%08X-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX}",
+		(ULONG32)g->Data1, g->Data2, g->Data3,
 		g->Data4[0], g->Data4[1], g->Data4[2], g->Data4[3],
 		g->Data4[4], g->Data4[5], g->Data4[6], g->Data4[7]);
 
@@ -301,7 +301,7 @@ eastl::string Utils::I64ToString(LONG64 i64)
 {
 	CHAR buffer[80] = "";
 
-	::sprintf(buffer, "%I64d", i64);
+	::sprintf(buffer, "%lld", i64);
 
 	return buffer;
 }
@@ -155,7 +155,7 @@ void Wnd::DrawAll_End()
 				if (c == (nrmClr << 8) + 0x20)
 					c = (hlpClr << 8) + (c & 0xff);
 			}
-			else if (y == Root::I->RegsDisasmDivLineY || y == Root::I->DisasmCodeDivLineY || y == Root::I->CodeLogDivLineY)
+			else if ((LONG)y == Root::I->RegsDisasmDivLineY || (LONG)y == Root::I->DisasmCodeDivLineY || (LONG)y == Root::I->CodeLogDivLineY) // the div lines can be < 0.
 			{
 				if (c == (nrmClr << 8) + 0x20)
 					c = (hrzClr << 8) + 0xC4;
@@ -297,7 +297,7 @@ void Wnd::DrawAll_Final()
 			{
 				*front = *back;
 
-				Glyph::Draw(*front & 0xFF, *front >> 8, x, y, Root::I->VideoAddr, centerX, centerY, x == Root::I->CursorDisplayX && y == Root::I->CursorDisplayY);
+				Glyph::Draw(*front & 0xFF, *front >> 8, x, y, Root::I->VideoAddr, centerX, centerY, (LONG)x == Root::I->CursorDisplayX && (LONG)y == Root::I->CursorDisplayY);
 			}
 
 			front++;
@@ -312,7 +312,15 @@ void Wnd::Draw()
 	for (ULONG y = destY0; y <= destY1; y++)
 	{
 		ULONG index = (y - destY0) + posY;
-		const CHAR* ptr = index < contents.size() ? GetLineToDraw(index).c_str() : NULL;
+
+		eastl::string line;
+		const CHAR* ptr = NULL;
+
+		if (index < GetLinesNum())
+		{
+			line = GetLineToDraw(index);
+			ptr = line.c_str();
+		}
 
 		BYTE clr = nrmClr;
 
@@ -425,6 +433,11 @@ void Wnd::DrawString(const CHAR* psz, ULONG x, ULONG y, BYTE clr /*= 0x07*/, ULO
 	}
 }
 
+ULONG Wnd::GetLinesNum()
+{
+	return contents.size();
+}
+
 eastl::string Wnd::GetLineToDraw(ULONG index)
 {
 	return contents[index];
@@ -439,7 +452,7 @@ eastl::string Wnd::HighlightHexNumber(eastl::string& pattern, LONG index, LONG*
 	if (!text.size())
 		return "";
 
-	for (int i = 0; i < text.size(); i++)
+	for (int i = 0; i < (int)text.size(); i++)
 	{
 		if (text[i] >= 'a' && text[i] <= 'f')
 			text[i] -= 'a' - 'A';
@@ -482,7 +495,7 @@ eastl::string Wnd::HighlightHexNumber(eastl::string& pattern, LONG index, LONG*
 					pos = 0;
 				}
 
-				if (pos == text.size())
+				if (pos == (int)text.size())
 				{
 					pos = 0;
 
@@ -502,7 +515,7 @@ eastl::string Wnd::HighlightHexNumber(eastl::string& pattern, LONG index, LONG*
 						if (!IsHex(c3)) break;
 					}
 
-					if (x2 != x + 1 || x3 != (LONG)x - text.size())
+					if (x2 != x + 1 || x3 != (LONG)x - (LONG)text.size())
 						if (x3 + 1 >= 0 && x2 - 1 < Root::I->WndWidth)
 						{
 							matches.emplace_back(y, x3 + 1, x2 - 1);
@@ -522,7 +535,7 @@ eastl::string Wnd::HighlightHexNumber(eastl::string& pattern, LONG index, LONG*
 
 	eastl::string retVal;
 
-	for (int i = 0; i < matches.size(); i++)
+	for (int i = 0; i < (int)matches.size(); i++)
 	{
 		auto& m = matches[i];
 
@@ -711,7 +724,7 @@ VOID Wnd::CheckDivLineYs(LONG* keep /*= NULL*/)
 
 	// make sure that the various "DivLines" are properly arranged.
 
-	for (int i = 0; i < v.size(); i++)
+	for (int i = 0; i < (int)v.size(); i++)
 		if (v[i].canBeMoved && *v[i].py - *v[i - 1].py < 4)
 			*v[i].py = *v[i - 1].py + 4;
 
@@ -723,7 +736,7 @@ VOID Wnd::CheckDivLineYs(LONG* keep /*= NULL*/)
 	{
 		int index = 0;
 
-		for (int i = 0; i < v.size(); i++)
+		for (int i = 0; i < (int)v.size(); i++)
 			if (v[i].canBeMoved && v[i].py == keep)
 			{
 				index = i;
@@ -795,7 +808,7 @@ VOID Wnd::CheckDivLineYs(LONG* keep /*= NULL*/)
 	}
 	else
 	{
-		for (int i = 0; i < v.size(); i++)
+		for (int i = 0; i < (int)v.size(); i++)
 			if (*v[i].py != Root::I->PrevLayout[i]) // WARNING: we assume here that Root::I->PrevLayout.size() == v.size().
 			{
 				layoutChanged = TRUE;
@@ -818,7 +831,7 @@ VOID Wnd::CheckDivLineYs(LONG* keep /*= NULL*/)
 
 		LONG CodeCursorY = 0;
 
-		for (int i = 0; i < v.size(); i++)
+		for (int i = 0; i < (int)v.size(); i++)
 			if (v[i].py == &Root::I->CodeLogDivLineY)
 			{
 				CodeCursorY = *v[i - 1].py + 1;
@@ -24,6 +24,7 @@ public:
 	static void Draw_InputLine(BOOLEAN eraseBackground);
 
 	virtual void Draw();
+	virtual ULONG GetLinesNum();
 	virtual eastl::string GetLineToDraw(ULONG index);
 
 	ULONG destX0 = 0; // set in DrawAll_Start
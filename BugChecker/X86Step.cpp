@@ -40,6 +40,7 @@ VOID* X86Step::ZydisRegToCtxRegValuePtr(
 	case ZYDIS_REGISTER_ESP: pval = _6432_(&ctx->Rsp, &ctx->Esp); *psz = 4; break;
 	case ZYDIS_REGISTER_EBP: pval = _6432_(&ctx->Rbp, &ctx->Ebp); *psz = 4; break;
 	case ZYDIS_REGISTER_EIP: pval = _6432_(&ctx->Rip, &ctx->Eip); *psz = 4; break;
+	default: break;
 	}
 
 	return pval;
@@ -184,6 +185,9 @@ JumpInstrType X86Step::CalculateStepDestination(
 						}
 					}
 					break;
+
+					default:
+						break;
 					}
 				}
 			}
@@ -272,6 +276,7 @@ JumpInstrType X86Step::CalculateStepDestination(
 		case ZYDIS_MNEMONIC_JCXZ: v = *(USHORT*)p; break;
 		case ZYDIS_MNEMONIC_JECXZ: v = *(ULONG32*)p; break;
 		case ZYDIS_MNEMONIC_JRCXZ: v = *(ULONG64*)p; break;
+		default: break;
 		}
 
 		if (!v &&
@@ -312,6 +317,9 @@ JumpInstrType X86Step::CalculateStepDestination(
 		case ZYDIS_MNEMONIC_LOOPNE:
 			jump = v != 1 && !(ctx->EFlags & ZYDIS_CPUFLAG_ZF);
 			break;
+
+		default:
+			break;
 		}
 
 		if (jump &&
@@ -0,0 +1,426 @@
+#include <stdio.h>
+#include <time.h>
+#include <execinfo.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "KernelFill.h"
+#include "SimTarget.h"
+
+//
+// Globals of the kernel.
+//
+
+KUSER_SHARED_DATA HostSim_SharedUserData = {};
+
+static BOOLEAN DebuggerNotPresent = TRUE;
+static BOOLEAN DebuggerEnabled = TRUE;
+
+PBOOLEAN KdDebuggerNotPresent = &DebuggerNotPresent;
+PBOOLEAN KdDebuggerEnabled = &DebuggerEnabled;
+
+thread_local UCHAR* HostSim_Pcr = NULL;
+thread_local ULONG HostSim_Processor = 0;
+thread_local BOOLEAN HostSim_InterruptsEnabled = TRUE;
+
+//
+// Debug output and pool.
+//
+
+extern "C" ULONG DbgPrint(PCSTR Format, ...)
+{
+	va_list ap;
+	va_start(ap, Format);
+	::vfprintf(stderr, Format, ap);
+	va_end(ap);
+
+	::fputc('\n', stderr);
+
+	return STATUS_SUCCESS;
+}
+
+extern "C" PVOID ExAllocatePool(POOL_TYPE PoolType, SIZE_T NumberOfBytes)
+{
+	return ::malloc(NumberOfBytes);
+}
+
+extern "C" VOID ExFreePool(PVOID P)
+{
+	::free(P);
+}
+
+//
+// Processors and time.
+//
+
+extern "C" LARGE_INTEGER KeQueryPerformanceCounter(PLARGE_INTEGER PerformanceFrequency)
+{
+	timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	if (PerformanceFrequency)
+		PerformanceFrequency->QuadPart = 10000000;
+
+	LARGE_INTEGER ret;
+	ret.QuadPart = (LONGLONG)ts.tv_sec * 10000000 + ts.tv_nsec / 100;
+
+	return ret;
+}
+
+extern "C" ULONG KeQueryMaximumProcessorCountEx(USHORT GroupNumber)
+{
+	return SimTarget::ProcessorsNum;
+}
+
+extern "C" ULONG KeGetCurrentProcessorNumberEx(PPROCESSOR_NUMBER ProcNumber)
+{
+	if (ProcNumber)
+	{
+		ProcNumber->Group = 0;
+		ProcNumber->Number = (UCHAR)HostSim_Processor;
+		ProcNumber->Reserved = 0;
+	}
+
+	return HostSim_Processor;
+}
+
+//
+// Strings and images.
+//
+
+extern "C" VOID RtlInitUnicodeString(PUNICODE_STRING DestinationString, PCWSTR SourceString)
+{
+	USHORT len = 0;
+
+	if (SourceString)
+		while (SourceString[len])
+			len++;
+
+	DestinationString->Length = len * sizeof(WCHAR);
+	DestinationString->MaximumLength = DestinationString->Length + sizeof(WCHAR);
+	DestinationString->Buffer = (PWSTR)SourceString;
+}
+
+extern "C" PVOID RtlImageDirectoryEntryToData(PVOID Base, BOOLEAN MappedAsImage, USHORT DirectoryEntry, PULONG Size)
+{
+	auto dos = (IMAGE_DOS_HEADER*)Base;
+	if (dos->e_magic != IMAGE_DOS_SIGNATURE)
+		return NULL;
+
+	auto nth = (IMAGE_NT_HEADERS*)((BYTE*)Base + dos->e_lfanew);
+	if (nth->Signature != IMAGE_NT_SIGNATURE || DirectoryEntry >= nth->OptionalHeader.NumberOfRvaAndSizes)
+		return NULL;
+
+	auto& dir = nth->OptionalHeader.DataDirectory[DirectoryEntry];
+	if (!dir.VirtualAddress)
+		return NULL;
+
+	*Size = dir.Size;
+
+	return (BYTE*)Base + dir.VirtualAddress;
+}
+
+//
+// Memory manager: the host memory is always valid, the synthetic address space only where it maps a host object.
+//
+
+extern "C" PVOID MmMapIoSpace(PHYSICAL_ADDRESS PhysicalAddress, SIZE_T NumberOfBytes, MEMORY_CACHING_TYPE CacheType)
+{
+	return ::calloc(1, NumberOfBytes); // the framebuffer.
+}
+
+extern "C" VOID MmUnmapIoSpace(PVOID BaseAddress, SIZE_T NumberOfBytes)
+{
+	::free(BaseAddress);
+}
+
+extern "C" BOOLEAN MmIsAddressValid(PVOID VirtualAddress)
+{
+	return SimTarget::I && SimTarget::I->IsHostMapped((ULONG64)VirtualAddress);
+}
+
+extern "C" PMDL IoAllocateMdl(PVOID VirtualAddress, ULONG Length, BOOLEAN SecondaryBuffer, BOOLEAN ChargeQuota, PIRP Irp)
+{
+	auto mdl = (PMDL)::calloc(1, sizeof(MDL));
+
+	mdl->StartVa = VirtualAddress;
+	mdl->ByteCount = Length;
+
+	return mdl;
+}
+
+extern "C" VOID IoFreeMdl(PMDL Mdl)
+{
+	::free(Mdl);
+}
+
+extern "C" VOID MmProbeAndLockPages(PMDL MemoryDescriptorList, KPROCESSOR_MODE AccessMode, LOCK_OPERATION Operation)
+{
+}
+
+extern "C" VOID MmUnlockPages(PMDL MemoryDescriptorList)
+{
+}
+
+extern "C" PVOID MmMapLockedPagesSpecifyCache(PMDL MemoryDescriptorList, KPROCESSOR_MODE AccessMode, MEMORY_CACHING_TYPE CacheType, PVOID RequestedAddress, ULONG BugCheckOnFailure, ULONG Priority)
+{
+	return MemoryDescriptorList->StartVa;
+}
+
+extern "C" VOID MmUnmapLockedPages(PVOID BaseAddress, PMDL MemoryDescriptorList)
+{
+}
+
+extern "C" NTSTATUS MmProtectMdlSystemAddress(PMDL MemoryDescriptorList, ULONG NewProtect)
+{
+	return STATUS_SUCCESS;
+}
+
+//
+// I/O manager.
+//
+
+extern "C" NTSTATUS IoCreateDevice(PDRIVER_OBJECT DriverObject, ULONG DeviceExtensionSize, PUNICODE_STRING DeviceName, ULONG DeviceType, ULONG DeviceCharacteristics, BOOLEAN Exclusive, PDEVICE_OBJECT* DeviceObject)
+{
+	*DeviceObject = (PDEVICE_OBJECT)::calloc(1, sizeof(DEVICE_OBJECT));
+
+	return STATUS_SUCCESS;
+}
+
+extern "C" VOID IoDeleteDevice(PDEVICE_OBJECT DeviceObject)
+{
+	::free(DeviceObject);
+}
+
+extern "C" NTSTATUS IoCreateSymbolicLink(PUNICODE_STRING SymbolicLinkName, PUNICODE_STRING DeviceName)
+{
+	return STATUS_SUCCESS;
+}
+
+extern "C" NTSTATUS IoDeleteSymbolicLink(PUNICODE_STRING SymbolicLinkName)
+{
+	return STATUS_SUCCESS;
+}
+
+extern "C" VOID IoCompleteRequest(PIRP Irp, char PriorityBoost)
+{
+}
+
+extern "C" PIO_STACK_LOCATION IoGetCurrentIrpStackLocation(PIRP Irp)
+{
+	return &Irp->CurrentStackLocation;
+}
+
+//
+// Processes: there are no processes to attach to.
+//
+
+extern "C" NTSTATUS PsSetCreateProcessNotifyRoutine(PCREATE_PROCESS_NOTIFY_ROUTINE NotifyRoutine, BOOLEAN Remove)
+{
+	return STATUS_SUCCESS;
+}
+
+extern "C" NTSTATUS PsSetLoadImageNotifyRoutine(PLOAD_IMAGE_NOTIFY_ROUTINE NotifyRoutine)
+{
+	return STATUS_SUCCESS;
+}
+
+extern "C" NTSTATUS PsRemoveLoadImageNotifyRoutine(PLOAD_IMAGE_NOTIFY_ROUTINE NotifyRoutine)
+{
+	return STATUS_SUCCESS;
+}
+
+extern "C" NTSTATUS PsLookupProcessByProcessId(HANDLE ProcessId, PEPROCESS* Process)
+{
+	return STATUS_INVALID_PARAMETER;
+}
+
+extern "C" VOID KeStackAttachProcess(PRKPROCESS PROCESS, VOID* ApcState)
+{
+}
+
+extern "C" VOID KeUnstackDetachProcess(VOID* ApcState)
+{
+}
+
+extern "C" VOID ObDereferenceObject(PVOID Object)
+{
+}
+
+extern "C" NTSTATUS ZwQuerySystemInformation(int SystemInformationClass, PVOID SystemInformation, ULONG SystemInformationLength, PULONG ReturnLength)
+{
+	return STATUS_NOT_IMPLEMENTED;
+}
+
+//
+// Files: a table of files registered by the simulator, by NT path.
+//
+
+struct HostSimFile
+{
+	std::vector<BYTE> data;
+};
+
+static std::map<std::string, HostSimFile>* Files = NULL;
+
+VOID HostSim_AddFile(const CHAR* ntPath, const VOID* data, ULONG size)
+{
+	if (!Files)
+		Files = new std::map<std::string, HostSimFile>();
+
+	(*Files)[ntPath].data.assign((const BYTE*)data, (const BYTE*)data + size);
+}
+
+extern "C" NTSTATUS ZwCreateFile(PHANDLE FileHandle, ACCESS_MASK DesiredAccess, POBJECT_ATTRIBUTES ObjectAttributes, PIO_STATUS_BLOCK IoStatusBlock, PLARGE_INTEGER AllocationSize, ULONG FileAttributes, ULONG ShareAccess, ULONG CreateDisposition, ULONG CreateOptions, PVOID EaBuffer, ULONG EaLength)
+{
+	std::string path;
+
+	for (USHORT i = 0; i < ObjectAttributes->ObjectName->Length / sizeof(WCHAR); i++)
+		path += (CHAR)ObjectAttributes->ObjectName->Buffer[i];
+
+	if (!Files || Files->find(path) == Files->end())
+		return STATUS_OBJECT_NAME_NOT_FOUND;
+
+	*FileHandle = &(*Files)[path];
+
+	return STATUS_SUCCESS;
+}
+
+extern "C" NTSTATUS ZwQueryInformationFile(HANDLE FileHandle, PIO_STATUS_BLOCK IoStatusBlock, PVOID FileInformation, ULONG Length, FILE_INFORMATION_CLASS FileInformationClass)
+{
+	if (FileInformationClass != FileStandardInformation || Length < sizeof(FILE_STANDARD_INFORMATION))
+		return STATUS_INVALID_PARAMETER;
+
+	auto info = (FILE_STANDARD_INFORMATION*)FileInformation;
+
+	::memset(info, 0, sizeof(*info));
+	info->EndOfFile.QuadPart = ((HostSimFile*)FileHandle)->data.size();
+	info->AllocationSize = info->EndOfFile;
+
+	return STATUS_SUCCESS;
+}
+
+extern "C" NTSTATUS ZwReadFile(HANDLE FileHandle, HANDLE Event, PVOID ApcRoutine, PVOID ApcContext, PIO_STATUS_BLOCK IoStatusBlock, PVOID Buffer, ULONG Length, PLARGE_INTEGER ByteOffset, PULONG Key)
+{
+	auto& data = ((HostSimFile*)FileHandle)->data;
+
+	ULONG64 offset = ByteOffset ? ByteOffset->QuadPart : 0;
+	ULONG64 len = offset < data.size() ? _MIN_(Length, data.size() - offset) : 0;
+
+	::memcpy(Buffer, data.data() + offset, len);
+
+	IoStatusBlock->Status = STATUS_SUCCESS;
+	IoStatusBlock->Information = len;
+
+	return len || !Length ? STATUS_SUCCESS : STATUS_END_OF_FILE;
+}
+
+extern "C" NTSTATUS ZwClose(HANDLE Handle)
+{
+	return STATUS_SUCCESS;
+}
+
+//
+// Intrinsics.
+//
+
+extern "C" void _enable(void)
+{
+	HostSim_InterruptsEnabled = TRUE;
+}
+
+extern "C" void _disable(void)
+{
+	HostSim_InterruptsEnabled = FALSE;
+}
+
+extern "C" unsigned long long __readeflags(void)
+{
+	return HostSim_InterruptsEnabled ? 0x202 : 0x002;
+}
+
+extern "C" unsigned long long __readgsqword(unsigned long Offset)
+{
+	if (!HostSim_Pcr)
+		::HostSim_FatalError("__readgsqword: no PCR for this thread.");
+
+	return *(unsigned long long*)(HostSim_Pcr + Offset);
+}
+
+extern "C" void __outdword(unsigned short Port, unsigned long Data)
+{
+}
+
+extern "C" unsigned long __indword(unsigned short Port)
+{
+	return 0;
+}
+
+extern "C" void HostSim_FatalError(const char* msg)
+{
+	::fprintf(stderr, "HostSim: fatal error: %s\n", msg);
+
+	void* frames[64];
+	::backtrace_symbols_fd(frames, ::backtrace(frames, 64), 2);
+
+	::fflush(stderr);
+	::abort();
+}
+
+static void OnFault(int sig) // an access violation in BugChecker: __try and __except are not implemented on the host.
+{
+	::HostSim_FatalError(sig == SIGSEGV ? "segmentation fault." : "bus error.");
+}
+
+static struct FaultHandler
+{
+	FaultHandler()
+	{
+		::signal(SIGSEGV, OnFault);
+		::signal(SIGBUS, OnFault);
+	}
+} faultHandler;
+
+//
+// Functions of "AsmForAmd64.asm".
+//
+
+static ULONG64 Gdt[8] =
+{
+	0,
+	0,
+	0x00209B0000000000, // 0x10: kernel code, 64 bit.
+	0x00CF93000000FFFF, // 0x18: kernel data.
+	0x00CFFB000000FFFF, // 0x23: user code, 32 bit.
+	0x00CFF3000000FFFF, // 0x2B: user data.
+	0x0020FB0000000000, // 0x33: user code, 64 bit.
+	0,
+};
+
+extern "C" VOID Amd64_sgdt(BYTE* dest)
+{
+	*(USHORT*)dest = sizeof(Gdt) - 1;
+	*(ULONG64*)(dest + 2) = (ULONG64)Gdt;
+}
+
+extern "C" BYTE Amd64_ReadKeyb()
+{
+	return SimTarget::I ? SimTarget::I->ReadKeyb() : 0;
+}
+
+extern "C" VOID BreakInAndDeleteBreakPoints()
+{
+	if (SimTarget::I)
+		SimTarget::I->BreakIn((ULONG64)&BreakInAndDeleteBreakPoints);
+}
+
+extern "C" ULONG_PTR esFunction;
+
+extern "C" VOID ESCall()
+{
+	((VOID(*)())esFunction)(); // the host stack is large enough: no need to switch to the expanded stack.
+}
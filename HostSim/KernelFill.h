@@ -0,0 +1,13 @@
+#pragma once
+
+#include <ntddk.h>
+
+//
+// Simulator side of the kernel APIs implemented in "KernelFill.cpp".
+//
+
+VOID HostSim_AddFile(const CHAR* ntPath, const VOID* data, ULONG size); // makes the file available to ZwCreateFile and ZwReadFile.
+
+extern thread_local UCHAR* HostSim_Pcr; // the base of the GS segment of the simulated processor running the thread.
+extern thread_local ULONG HostSim_Processor;
+extern thread_local BOOLEAN HostSim_InterruptsEnabled;
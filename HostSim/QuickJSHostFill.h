@@ -0,0 +1,14 @@
+//
+// Host counterpart of "QuickJSDeclFill.h": it is included before any other header when compiling QuickJS and its users.
+//
+
+#ifndef QUICKJSHOSTFILL_H
+#define QUICKJSHOSTFILL_H
+
+//
+// The definition commented out in quickjs.h (see "QuickJSDeclFill.h"): the host heap is in the lower half of the address space.
+//
+
+#define JS_VALUE_GET_PTR(v)  ((void *)((intptr_t)(v) & 0x0000FFFFFFFFFFFFull))
+
+#endif
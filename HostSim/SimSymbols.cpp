@@ -0,0 +1,131 @@
+#include "SimSymbols.h"
+
+SimSymbols::SimSymbols(const CHAR* pdbName)
+{
+	PdbName = pdbName;
+
+	// a guid derived from the name: each module has its own.
+
+	for (int i = 0; pdbName[i]; i++)
+		Guid[i % 16] = (BYTE)(Guid[i % 16] * 31 + pdbName[i]);
+}
+
+SimSymbols SimSymbols::Kernel()
+{
+	SimSymbols s{ "ntkrnlmp.pdb" };
+
+	s.AddDatatype("_LIST_ENTRY", 0x10, {
+		{ "Flink", "_LIST_ENTRY *", 0x00 },
+		{ "Blink", "_LIST_ENTRY *", 0x08 } });
+
+	s.AddDatatype("_CLIENT_ID", 0x10, {
+		{ "UniqueProcess", "void *", 0x00 },
+		{ "UniqueThread", "void *", 0x08 } });
+
+	s.AddDatatype("_KPROCESS", 0x438, {
+		{ "ThreadListHead", "_LIST_ENTRY", 0x30 } });
+
+	s.AddDatatype("_KTHREAD", 0x430, {
+		{ "KernelStack", "void *", 0x58 },
+		{ "ContextSwitches", "ulong", 0x154 },
+		{ "State", "uchar", 0x184 },
+		{ "Teb", "void *", 0xF0 },
+		{ "Win32Thread", "void *", 0x1C0 },
+		{ "ThreadListEntry", "_LIST_ENTRY", 0x2F8 } });
+
+	s.AddDatatype("_ETHREAD", 0x898, {
+		{ "Tcb", "_KTHREAD", 0x00 },
+		{ "Cid", "_CLIENT_ID", 0x478 } });
+
+	return s;
+}
+
+VOID SimSymbols::AddPublic(const CHAR* name, ULONG rva, ULONG length)
+{
+	Publics.push_back({ name, rva, length });
+}
+
+VOID SimSymbols::AddDatatype(const CHAR* name, ULONG length, std::vector<Member> members)
+{
+	Datatype dt{ name, length, {} };
+
+	for (const Member& m : members)
+		dt.members.push_back({ m.name, m.datatype, m.offset });
+
+	Datatypes.push_back(dt);
+}
+
+std::vector<BYTE> SimSymbols::Build() const
+{
+	// the names: the offset 0 is the empty string.
+
+	std::string names(1, '\0');
+
+	auto addName = [&](const std::string& n) -> ULONG {
+		ULONG offset = (ULONG)names.size();
+		names += n;
+		names += '\0';
+		return offset;
+	};
+
+	// the tables, sorted as Symbols.cpp expects them.
+
+	std::vector<Public> publics = Publics;
+	std::sort(publics.begin(), publics.end(), [](const Public& a, const Public& b) { return a.rva < b.rva; });
+
+	std::vector<Datatype> datatypes = Datatypes;
+	std::sort(datatypes.begin(), datatypes.end(), [](const Datatype& a, const Datatype& b) { return ::strcmp(a.name.c_str(), b.name.c_str()) < 0; });
+
+	std::vector<BCSFILE_PUBLIC_SYMBOL> pubs;
+
+	for (const Public& p : publics)
+		pubs.push_back({ addName(p.name), p.rva, p.length });
+
+	std::vector<BCSFILE_DATATYPE> dts;
+	std::vector<BCSFILE_DATATYPE_MEMBER> mbs;
+
+	for (const Datatype& d : datatypes)
+	{
+		dts.push_back({ addName(d.name), 0, d.length, 0, (ULONG)mbs.size(), (ULONG)d.members.size() });
+
+		for (const MemberDef& m : d.members)
+			mbs.push_back({ addName(m.name), addName(m.datatype), m.offset, 0 });
+	}
+
+	// the file: the header, the tables, then the names.
+
+	BCSFILE_HEADER header = {};
+
+	header.magic = BCSFILE_HEADER_SIGNATURE;
+	header.version = BCSFILE_HEADER_VERSION;
+	::memcpy(header.guid, Guid, sizeof(Guid));
+	header.age = Age;
+
+	ULONG pos = sizeof(header);
+
+	header.publicSymbols = pos;
+	header.publicSymbolsSize = (ULONG)(pubs.size() * sizeof(BCSFILE_PUBLIC_SYMBOL));
+	pos += header.publicSymbolsSize;
+
+	header.datatypes = pos;
+	header.datatypesSize = (ULONG)(dts.size() * sizeof(BCSFILE_DATATYPE));
+	pos += header.datatypesSize;
+
+	header.datatypeMembers = pos;
+	header.datatypeMembersSize = (ULONG)(mbs.size() * sizeof(BCSFILE_DATATYPE_MEMBER));
+	pos += header.datatypeMembersSize;
+
+	header.names = pos;
+	header.namesSize = (ULONG)names.size();
+	pos += header.namesSize;
+
+	std::vector<BYTE> file(pos);
+
+	::memcpy(file.data(), &header, sizeof(header));
+	::memcpy(file.data() + header.publicSymbols, pubs.data(), header.publicSymbolsSize);
+	::memcpy(file.data() + header.datatypes, dts.data(), header.datatypesSize);
+	::memcpy(file.data() + header.datatypeMembers, mbs.data(), header.datatypeMembersSize);
+	::memcpy(file.data() + header.names, names.data(), header.namesSize);
+
+	return file;
+}
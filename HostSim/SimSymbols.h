@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "BugChecker.h"
+
+#include "Symbols.h"
+
+//
+// Builder of the BCS symbol files of the simulated modules: the same layout that the Symbol Loader writes from a PDB file
+// (see "bcsfile.h"), with the public symbols sorted by address and the datatypes sorted by name.
+//
+
+class SimSymbols
+{
+public:
+
+	struct Member
+	{
+		const CHAR* name;
+		const CHAR* datatype; // as written by the Symbol Loader, e.g. "_LIST_ENTRY" or "void *".
+		ULONG offset;
+	};
+
+	SimSymbols(const CHAR* pdbName);
+
+	static SimSymbols Kernel(); // the datatypes of ntoskrnl that the commands look up (THREAD, PROC...), with the Windows 10 x64 layout.
+
+	VOID AddPublic(const CHAR* name, ULONG rva, ULONG length);
+	VOID AddDatatype(const CHAR* name, ULONG length, std::vector<Member> members);
+
+	std::vector<BYTE> Build() const;
+
+	std::string PdbName;
+	BYTE Guid[16] = {};
+	ULONG Age = 1;
+
+private:
+
+	struct Public
+	{
+		std::string name;
+		ULONG rva;
+		ULONG length;
+	};
+
+	struct MemberDef
+	{
+		std::string name;
+		std::string datatype;
+		ULONG offset;
+	};
+
+	struct Datatype
+	{
+		std::string name;
+		ULONG length;
+		std::vector<MemberDef> members;
+	};
+
+	std::vector<Public> Publics;
+	std::vector<Datatype> Datatypes;
+};
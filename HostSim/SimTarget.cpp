@@ -0,0 +1,1007 @@
+#include "SimTarget.h"
+#include "KernelFill.h"
+
+#include "Root.h"
+#include "Cmd.h"
+#include "Ps2Keyb.h"
+
+#include <stdio.h>
+
+//
+// Offsets in the kernel structures, normally calculated by CalculateKernelOffsets from the kernel symbols (see "Platform.cpp").
+//
+
+extern int MACRO_SELFPTR_FIELDOFFSET_IN_PCR;
+extern int MACRO_KTEBPTR_FIELDOFFSET_IN_PCR;
+extern int MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB;
+extern int MACRO_IMAGEBASE_FIELDOFFSET_IN_DRVSEC;
+extern int MACRO_IMAGENAME_FIELDOFFSET_IN_DRVSEC;
+extern int MACRO_IRQL_FIELDOFFSET_IN_PCR;
+
+// the values of Windows 10 x64: the synthetic structures have the same layout.
+
+static constexpr int PcrSelfOffset = 0x18;
+static constexpr int PcrIrqlOffset = 0x50;
+static constexpr int PcrCurrentThreadOffset = 0x188;
+static constexpr int ThreadProcessOffset = 0xB8;
+static constexpr int LdrDllBaseOffset = 0x30;
+static constexpr int LdrSizeOfImageOffset = 0x40;
+static constexpr int LdrFullDllNameOffset = 0x48;
+static constexpr int LdrBaseDllNameOffset = 0x58;
+static constexpr int LdrEntrySize = 0x120;
+
+static constexpr ULONG64 KernelBaseAddress = 0xFFFFF80000000000;
+static constexpr ULONG KernelImageSize = 0x200000;
+
+static constexpr ULONG64 StackBase = 0xFFFFF88000100000; // the kernel stack of the current thread: Rsp is in the middle.
+static constexpr ULONG StackSize = 0x10000;
+
+static constexpr ULONG SpecialRegistersSize = 0xF0; // KSPECIAL_REGISTERS, at the address 2 of the control space.
+
+static constexpr ULONG IdleTimeoutsMax = 64; // consecutive timeouts with an empty key queue before failing the test.
+
+SimTarget* SimTarget::I = NULL;
+
+extern "C" VOID BreakInAndDeleteBreakPoints();
+
+//
+// Initialization: the kernel structures of the processors, then BugChecker, as in DriverEntry.
+//
+
+static const CHAR* KernelBcsName = "ntkrnlmp.bcs";
+
+static const CHAR* ConfigSettings =
+	"settings\r\n"
+	"\tframebuffer\r\n"
+	"\t\twidth\r\n"
+	"\t\t\t1024\r\n"
+	"\t\theight\r\n"
+	"\t\t\t768\r\n"
+	"\t\taddress\r\n"
+	"\t\t\tF0000000\r\n"
+	"\t\tstride\r\n"
+	"\t\t\t0\r\n";
+
+SimTarget::SimTarget(const SimSymbols& kernelSymbols /*= SimSymbols::Kernel()*/)
+{
+	if (I)
+		::HostSim_FatalError("only one SimTarget per process: BugChecker keeps its state in globals.");
+
+	I = this;
+
+	// the processors: each one has a PCR with its self pointer, its IRQL and its current thread.
+
+	for (int p = 0; p < ProcessorsNum; p++)
+	{
+		Pcr[p] = (BYTE*)::calloc(1, PAGE_SIZE);
+		MapHost(Pcr[p], PAGE_SIZE);
+
+		BYTE* thread = (BYTE*)::calloc(1, PAGE_SIZE);
+		MapHost(thread, PAGE_SIZE);
+
+		*(ULONG64*)(Pcr[p] + PcrSelfOffset) = (ULONG64)Pcr[p];
+		*(ULONG64*)(Pcr[p] + PcrCurrentThreadOffset) = (ULONG64)thread;
+
+		Context[p].SegCs = 0x10;
+		Context[p].SegDs = Context[p].SegEs = Context[p].SegSs = 0x18;
+		Context[p].EFlags = 0x202;
+		Context[p].ContextFlags = 0x10001F; // CONTEXT_ALL
+	}
+
+	HostSim_Pcr = Pcr[0];
+	HostSim_Processor = 0;
+
+	MACRO_SELFPTR_FIELDOFFSET_IN_PCR = PcrSelfOffset;
+	MACRO_KTEBPTR_FIELDOFFSET_IN_PCR = PcrCurrentThreadOffset;
+	MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB = ThreadProcessOffset;
+	MACRO_IMAGEBASE_FIELDOFFSET_IN_DRVSEC = LdrDllBaseOffset;
+	MACRO_IMAGENAME_FIELDOFFSET_IN_DRVSEC = LdrFullDllNameOffset;
+	MACRO_IRQL_FIELDOFFSET_IN_PCR = PcrIrqlOffset;
+
+	// the loaded modules list, with the kernel image.
+
+	PsLoadedModuleList = (LIST_ENTRY*)::calloc(1, sizeof(LIST_ENTRY));
+	PsLoadedModuleList->Flink = PsLoadedModuleList->Blink = PsLoadedModuleList;
+	MapHost(PsLoadedModuleList, sizeof(LIST_ENTRY));
+
+	KernelBase = AddModule("ntoskrnl.exe", KernelBaseAddress, KernelImageSize, &kernelSymbols);
+
+	// the stack of the current thread.
+
+	Map(StackBase, StackSize);
+
+	for (int p = 0; p < ProcessorsNum; p++)
+		Context[p].Rsp = StackBase + StackSize / 2;
+
+	// the INT3 and the RET of the function in "AsmForAmd64.asm".
+
+	BYTE* bk = Map((ULONG64)&::BreakInAndDeleteBreakPoints, 2);
+	bk[0] = 0xCC;
+	bk[1] = 0xC3;
+
+	// the scancodes of the characters, as translated by Ps2Keyb.
+
+	for (int shift = 0; shift <= 1; shift++)
+		for (BYTE s = 1; s < 0x80; s++)
+		{
+			BOOLEAN shiftState = shift, ctrlState = FALSE, altState = FALSE;
+
+			Keys.push_back({ s, -1 });
+
+			USHORT ascii = Ps2Keyb::ReadAscii(shiftState, ctrlState, altState);
+			BYTE chr = ascii & 0xFF;
+
+			if (chr >= 32 && chr < 128 && !CharToKey[chr])
+				CharToKey[chr] = s | (shift ? 0x100 : 0);
+		}
+
+	Keys.clear();
+
+	// BugChecker initialization.
+
+	Allocator::Init();
+
+	Platform::UserProbeAddress = (PVOID)MM_USER_PROBE_ADDRESS;
+
+	std::string config = std::string("symbols\r\n\t") + KernelBcsName + "\r\n" + ConfigSettings;
+	::HostSim_AddFile("\\SystemRoot\\BugChecker\\BugChecker.dat", config.c_str(), (ULONG)config.size());
+
+	std::vector<BYTE> bcs = kernelSymbols.Build();
+	::HostSim_AddFile((std::string("\\SystemRoot\\BugChecker\\") + KernelBcsName).c_str(), bcs.data(), (ULONG)bcs.size());
+
+	// the debug info of the kernel image, as read by TryGetKernelDebugInfoWithoutSymbols.
+
+	Platform::KernelDebugInfo.startAddr = KernelBase;
+	Platform::KernelDebugInfo.length = KernelImageSize;
+	::memcpy(Platform::KernelDebugInfo.guid, kernelSymbols.Guid, 16);
+	Platform::KernelDebugInfo.age = kernelSymbols.Age;
+	::strcpy(Platform::KernelDebugInfo.szPdb, kernelSymbols.PdbName.c_str());
+
+	Root::I = new Root();
+
+	Cmd_Startup::CreateInstances();
+
+	// the snapshot of the user modules taken by GetModulesSnapshot: there are no processes in the simulated system.
+
+	Root::I->NtModules = new eastl::vector<eastl::pair<ULONG64, eastl::vector<NtModule>>>();
+
+	if (!Root::I->fbStride && Root::I->fbWidth)
+		Root::I->fbStride = Root::I->fbWidth * 4;
+
+	Root::I->fbMapSize = Root::I->fbWidth * Root::I->fbHeight * 4;
+
+	PHYSICAL_ADDRESS pAddr;
+	pAddr.QuadPart = Root::I->fbAddress;
+
+	Root::I->VideoAddr = (unsigned int*)::MmMapIoSpace(pAddr, Root::I->fbMapSize, MmNonCached);
+}
+
+SimTarget::~SimTarget()
+{
+	// BugChecker shutdown, as in DrvUnload.
+
+	if (Root::I)
+	{
+		if (Root::I->BreakPoints.size())
+			::BreakInAndDeleteBreakPoints();
+
+		::MmUnmapIoSpace(Root::I->VideoAddr, Root::I->fbMapSize);
+
+		delete Root::I;
+		Root::I = NULL;
+	}
+
+	Allocator::Uninit();
+
+	// the synthetic address space.
+
+	for (auto& r : Regions)
+		if (r.second.owned)
+			::free(r.second.ptr);
+
+	Regions.clear();
+
+	I = NULL; // N.B. the PCRs stay mapped: the C++ library still frees with the operator delete of BugChecker, which reads the IRQL.
+}
+
+//
+// Synthetic address space.
+//
+
+BYTE* SimTarget::Map(ULONG64 address, ULONG64 size)
+{
+	BYTE* ptr = (BYTE*)::calloc(1, size);
+
+	Regions[address] = { size, ptr, TRUE };
+
+	return ptr;
+}
+
+VOID SimTarget::MapHost(VOID* ptr, ULONG64 size)
+{
+	// whole pages, as in the kernel: BugChecker reads a window of the page around the requested bytes (see PageCache).
+
+	ULONG64 start = (ULONG64)ptr & ~(ULONG64)(PAGE_SIZE - 1);
+	ULONG64 end = ((ULONG64)ptr + size + PAGE_SIZE - 1) & ~(ULONG64)(PAGE_SIZE - 1);
+
+	for (ULONG64 page = start; page < end; page += PAGE_SIZE)
+	{
+		ULONG64 offset;
+
+		if (!FindRegion(page, &offset))
+			Regions[page] = { PAGE_SIZE, (BYTE*)page, FALSE };
+	}
+}
+
+VOID SimTarget::Unmap(ULONG64 address)
+{
+	auto it = Regions.find(address);
+
+	if (it != Regions.end())
+	{
+		if (it->second.owned)
+			::free(it->second.ptr);
+
+		Regions.erase(it);
+	}
+}
+
+SimTarget::Region* SimTarget::FindRegion(ULONG64 address, ULONG64* offset)
+{
+	auto it = Regions.upper_bound(address);
+
+	if (it == Regions.begin())
+		return NULL;
+
+	it--;
+
+	if (address - it->first >= it->second.size)
+		return NULL;
+
+	*offset = address - it->first;
+
+	return &it->second;
+}
+
+BOOLEAN SimTarget::IsHostMapped(ULONG64 address)
+{
+	ULONG64 offset;
+	Region* r = FindRegion(address, &offset);
+
+	return r && !r->owned;
+}
+
+ULONG SimTarget::Read(ULONG64 address, VOID* dest, ULONG size)
+{
+	ULONG done = 0;
+
+	while (done < size)
+	{
+		ULONG64 offset;
+		Region* r = FindRegion(address + done, &offset);
+		if (!r)
+			break;
+
+		ULONG len = (ULONG)_MIN_(size - done, r->size - offset);
+
+		::memcpy((BYTE*)dest + done, r->ptr + offset, len);
+		done += len;
+	}
+
+	return done;
+}
+
+ULONG SimTarget::Write(ULONG64 address, const VOID* src, ULONG size)
+{
+	ULONG done = 0;
+
+	while (done < size)
+	{
+		ULONG64 offset;
+		Region* r = FindRegion(address + done, &offset);
+		if (!r)
+			break;
+
+		ULONG len = (ULONG)_MIN_(size - done, r->size - offset);
+
+		::memcpy(r->ptr + offset, (const BYTE*)src + done, len);
+		done += len;
+	}
+
+	return done;
+}
+
+//
+// Modules: an image with the DOS and NT headers, and its entry in PsLoadedModuleList.
+//
+
+ULONG64 SimTarget::AddModule(const CHAR* name, ULONG64 base, ULONG sizeOfImage, const SimSymbols* symbols /*= NULL*/)
+{
+	BYTE* image;
+
+	if (base)
+		image = Map(base, sizeOfImage);
+	else
+	{
+		sizeOfImage = (sizeOfImage + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+		image = (BYTE*)::aligned_alloc(PAGE_SIZE, sizeOfImage); // N.B. never freed: the regions of MapHost are not owned.
+		::memset(image, 0, sizeOfImage);
+
+		base = (ULONG64)image;
+		MapHost(image, sizeOfImage);
+	}
+
+	auto dos = (IMAGE_DOS_HEADER*)image;
+	dos->e_magic = IMAGE_DOS_SIGNATURE;
+	dos->e_lfarlc = 0x40;
+	dos->e_lfanew = 0x80;
+
+	auto nth = (IMAGE_NT_HEADERS64*)(image + dos->e_lfanew);
+	nth->Signature = IMAGE_NT_SIGNATURE;
+	nth->FileHeader.Machine = IMAGE_FILE_MACHINE_AMD64;
+	nth->FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER64);
+	nth->OptionalHeader.Magic = IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+	nth->OptionalHeader.ImageBase = base;
+	nth->OptionalHeader.SizeOfImage = sizeOfImage;
+	nth->OptionalHeader.SizeOfHeaders = PAGE_SIZE;
+	nth->OptionalHeader.SectionAlignment = PAGE_SIZE;
+	nth->OptionalHeader.FileAlignment = 0x200;
+	nth->OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+
+	// the CodeView debug info, which matches the image with its symbol file.
+
+	if (symbols)
+	{
+		const ULONG debugDirRva = 0x400;
+		const ULONG codeViewRva = debugDirRva + sizeof(IMAGE_DEBUG_DIRECTORY);
+
+		nth->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG] = { debugDirRva, sizeof(IMAGE_DEBUG_DIRECTORY) };
+
+		BYTE* cv = image + codeViewRva;
+
+		*(DWORD*)cv = 'SDSR';
+		::memcpy(cv + sizeof(DWORD), symbols->Guid, 16);
+		*(DWORD*)(cv + sizeof(DWORD) + 16) = symbols->Age;
+		::strcpy((CHAR*)cv + sizeof(DWORD) * 2 + 16, symbols->PdbName.c_str());
+
+		auto dir = (IMAGE_DEBUG_DIRECTORY*)(image + debugDirRva);
+
+		dir->Type = IMAGE_DEBUG_TYPE_CODEVIEW;
+		dir->SizeOfData = (ULONG)(sizeof(DWORD) * 2 + 16 + symbols->PdbName.size() + 1);
+		dir->AddressOfRawData = codeViewRva;
+	}
+
+	// the entry: the names are UNICODE_STRINGs, with the buffer after the entry.
+
+	BYTE* entry = (BYTE*)::calloc(1, LdrEntrySize + 256 * sizeof(WCHAR));
+	MapHost(entry, LdrEntrySize + 256 * sizeof(WCHAR));
+
+	WCHAR* nameBuffer = (WCHAR*)(entry + LdrEntrySize);
+	USHORT len = 0;
+
+	for (; name[len] && len < 255; len++)
+		nameBuffer[len] = name[len];
+
+	UNICODE_STRING us = { (USHORT)(len * sizeof(WCHAR)), (USHORT)((len + 1) * sizeof(WCHAR)), nameBuffer };
+
+	*(ULONG64*)(entry + LdrDllBaseOffset) = base;
+	*(ULONG*)(entry + LdrSizeOfImageOffset) = sizeOfImage;
+	*(UNICODE_STRING*)(entry + LdrFullDllNameOffset) = us;
+	*(UNICODE_STRING*)(entry + LdrBaseDllNameOffset) = us;
+
+	// insert it at the tail of the list.
+
+	LIST_ENTRY* links = (LIST_ENTRY*)entry;
+
+	links->Flink = PsLoadedModuleList;
+	links->Blink = PsLoadedModuleList->Blink;
+	PsLoadedModuleList->Blink->Flink = links;
+	PsLoadedModuleList->Blink = links;
+
+	return base;
+}
+
+VOID SimTarget::SetPdata(ULONG64 base, const IMAGE_RUNTIME_FUNCTION_ENTRY* entries, ULONG num, ULONG rva)
+{
+	IMAGE_DOS_HEADER dos;
+	Read(base, &dos, sizeof(dos));
+
+	ULONG64 dirAddress = base + dos.e_lfanew + FIELD_OFFSET(IMAGE_NT_HEADERS64, OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION]);
+
+	IMAGE_DATA_DIRECTORY dir = { rva, (ULONG)(num * sizeof(IMAGE_RUNTIME_FUNCTION_ENTRY)) };
+
+	Write(dirAddress, &dir, sizeof(dir));
+	Write(base + rva, entries, dir.Size);
+}
+
+//
+// Calls to BugChecker and callbacks into the simulator.
+//
+
+BcCall::BcCall()
+{
+	prevInts = HostSim_InterruptsEnabled;
+	::_disable();
+	prevIrql = HostSim_Pcr[PcrIrqlOffset];
+	HostSim_Pcr[PcrIrqlOffset] = HIGH_LEVEL;
+}
+
+BcCall::~BcCall()
+{
+	HostSim_Pcr[PcrIrqlOffset] = prevIrql;
+	if (prevInts) ::_enable();
+}
+
+HostCall::HostCall()
+{
+	prevInts = HostSim_InterruptsEnabled;
+	::_enable();
+	prevIrql = HostSim_Pcr[PcrIrqlOffset];
+	HostSim_Pcr[PcrIrqlOffset] = PASSIVE_LEVEL;
+}
+
+HostCall::~HostCall()
+{
+	HostSim_Pcr[PcrIrqlOffset] = prevIrql;
+	if (!prevInts) ::_disable();
+}
+
+VOID SimTarget::Count(BOOLEAN sent, ULONG api, ULONG bytesRead)
+{
+	Counters* c[2] = { &Total, CurrentCmd >= 0 ? &Cmds[CurrentCmd].counters : NULL };
+
+	for (Counters* p : c)
+		if (p)
+		{
+			if (sent)
+			{
+				p->packetsSent++;
+
+				if (api)
+				{
+					p->roundTrips++;
+					p->bytesRead += bytesRead;
+					p->largestRead = _MAX_(p->largestRead, bytesRead);
+				}
+			}
+			else
+			{
+				p->packetsReceived++;
+				p->byApi[api]++;
+			}
+		}
+}
+
+//
+// Events.
+//
+
+VOID SimTarget::ReportException(NTSTATUS code, ULONG64 pc, ULONG64 dr6)
+{
+	CONTEXT& ctx = Context[CurrentProcessor];
+
+	ctx.Rip = pc;
+
+	HostSim_Pcr = Pcr[CurrentProcessor];
+	HostSim_Processor = CurrentProcessor;
+
+	DBGKD_ANY_WAIT_STATE_CHANGE sc = {};
+
+	sc.NewState = DbgKdExceptionStateChange;
+	sc.ProcessorLevel = 6;
+	sc.Processor = (USHORT)CurrentProcessor;
+	sc.NumberProcessors = ProcessorsNum;
+	sc.Thread = *(ULONG64*)(Pcr[CurrentProcessor] + PcrCurrentThreadOffset);
+	sc.ProgramCounter = pc;
+
+	sc.u.Exception.ExceptionRecord.ExceptionCode = code;
+	sc.u.Exception.ExceptionRecord.ExceptionAddress = pc;
+	sc.u.Exception.FirstChance = TRUE;
+
+	if (code == STATUS_BREAKPOINT)
+	{
+		sc.u.Exception.ExceptionRecord.NumberParameters = 1;
+		sc.u.Exception.ExceptionRecord.ExceptionInformation[0] = BREAKPOINT_BREAK;
+	}
+
+	auto& cr = sc.AnyControlReport.Amd64ControlReport;
+
+	cr.Dr6 = dr6;
+	cr.Dr7 = LastDr7;
+	cr.EFlags = ctx.EFlags;
+	cr.InstructionCount = (USHORT)Read(pc, cr.InstructionStream, DBGKD_MAXSTREAM);
+	cr.SegCs = ctx.SegCs;
+	cr.SegDs = ctx.SegDs;
+	cr.SegEs = ctx.SegEs;
+	cr.SegFs = ctx.SegFs;
+
+	KD_BUFFER first = { sizeof(sc), sizeof(sc), 0, (PUCHAR)&sc };
+	KD_BUFFER second = { 0, 0, 0, NULL };
+	KD_CONTEXT kdContext = {};
+
+	{
+		BcCall _call_;
+		::KdSendPacket(KdPacketType7_Ie_StateChange64, &first, &second, &kdContext);
+	}
+
+	Count(TRUE, 0, 0);
+
+	Session();
+}
+
+VOID SimTarget::Session()
+{
+	static DBGKD_MANIPULATE_STATE64 state;
+	static BYTE data[PACKET_MAX_SIZE];
+
+	ULONG idle = 0;
+
+	while (TRUE)
+	{
+		KD_BUFFER first = { 0, sizeof(state), 0, (PUCHAR)&state };
+		KD_BUFFER second = { 0, (USHORT)(PACKET_MAX_SIZE - sizeof(state)), 0, data };
+		ULONG payload = 0;
+		KD_CONTEXT kdContext = {};
+
+		KD_RECV_CODE code;
+
+		{
+			BcCall _call_;
+			code = ::KdReceivePacket(KdPacketType2_Ie_StateManipulate, &first, &second, &payload, &kdContext);
+		}
+
+		if (code != KD_RECV_CODE_OK)
+		{
+			Total.timeouts++;
+
+			if (CurrentCmd >= 0)
+				Cmds[CurrentCmd].counters.timeouts++;
+
+			if (Keys.empty() && ++idle > IdleTimeoutsMax)
+				::HostSim_FatalError("BugChecker is waiting for a key, but the key queue is empty: end the input with a command that resumes the target.");
+
+			continue;
+		}
+
+		idle = 0;
+
+		Count(FALSE, state.ApiNumber, 0);
+
+		if (!Execute(&state, &second, payload))
+			return;
+
+		first.Length = sizeof(state);
+
+		{
+			BcCall _call_;
+			::KdSendPacket(KdPacketType2_Ie_StateManipulate, &first, &second, &kdContext);
+		}
+
+		Count(TRUE, state.ApiNumber, state.ApiNumber == DbgKdReadVirtualMemoryApi ? second.Length : 0);
+	}
+}
+
+BOOLEAN SimTarget::Execute(DBGKD_MANIPULATE_STATE64* pState, KD_BUFFER* second, ULONG payload)
+{
+	ULONG processor = pState->Processor < ProcessorsNum ? pState->Processor : CurrentProcessor;
+
+	pState->ReturnStatus = STATUS_SUCCESS;
+
+	switch (pState->ApiNumber)
+	{
+	case DbgKdReadVirtualMemoryApi:
+	{
+		auto& r = pState->u.ReadMemory;
+
+		// as KdpReadVirtualMemory: a request larger than the packet buffer is truncated and succeeds.
+
+		ULONG count = _MIN_(_MIN_(r.TransferCount, (ULONG)second->MaxLength), ReadTransferMax);
+
+		if (count && (r.TargetBaseAddress & ~(ULONG64)(PAGE_SIZE - 1)) != ((r.TargetBaseAddress + count - 1) & ~(ULONG64)(PAGE_SIZE - 1)))
+			PageCrossingReads++;
+
+		ReadAddresses.push_back(r.TargetBaseAddress);
+
+		r.ActualBytesRead = Read(r.TargetBaseAddress, second->pData, count);
+		second->Length = (USHORT)r.ActualBytesRead;
+
+		if (r.ActualBytesRead != count)
+			pState->ReturnStatus = STATUS_UNSUCCESSFUL;
+	}
+	break;
+
+	case DbgKdWriteVirtualMemoryApi:
+	{
+		auto& w = pState->u.WriteMemory;
+
+		w.ActualBytesWritten = Write(w.TargetBaseAddress, second->pData, _MIN_(w.TransferCount, payload));
+		second->Length = 0;
+
+		if (w.ActualBytesWritten != w.TransferCount)
+			pState->ReturnStatus = STATUS_UNSUCCESSFUL;
+	}
+	break;
+
+	case DbgKdGetContextApi:
+	{
+		::memcpy(second->pData, &Context[processor], sizeof(CONTEXT));
+		second->Length = sizeof(CONTEXT);
+	}
+	break;
+
+	case DbgKdSetContextApi:
+	{
+		::memcpy(&Context[processor], second->pData, _MIN_(payload, sizeof(CONTEXT)));
+		second->Length = 0;
+	}
+	break;
+
+	case DbgKdWriteBreakPointApi:
+	{
+		auto& b = pState->u.WriteBreakPoint;
+
+		BYTE original = 0;
+		BYTE int3 = 0xCC;
+
+		b.BreakPointHandle = 0;
+
+		// as in KdpAddBreakpoint, a second breakpoint at the same address is refused ("attempt to set breakpoint twice").
+
+		BOOLEAN twice = FALSE;
+
+		for (KdBreakPoint& bp : KdBreakPoints)
+			if (bp.used && bp.address == b.BreakPointAddress)
+				twice = TRUE;
+
+		if (twice || !Read(b.BreakPointAddress, &original, 1) || !Write(b.BreakPointAddress, &int3, 1))
+		{
+			pState->ReturnStatus = STATUS_UNSUCCESSFUL;
+			break;
+		}
+
+		size_t i = 0;
+
+		while (i < KdBreakPoints.size() && KdBreakPoints[i].used)
+			i++;
+
+		if (i == KdBreakPoints.size())
+			KdBreakPoints.push_back({});
+
+		KdBreakPoints[i] = { b.BreakPointAddress, original, TRUE };
+
+		b.BreakPointHandle = (ULONG)i + 1;
+	}
+	break;
+
+	case DbgKdRestoreBreakPointApi:
+	{
+		ULONG handle = pState->u.RestoreBreakPoint.BreakPointHandle;
+
+		if (!handle || handle > KdBreakPoints.size() || !KdBreakPoints[handle - 1].used)
+		{
+			pState->ReturnStatus = STATUS_UNSUCCESSFUL;
+			break;
+		}
+
+		KdBreakPoint& bp = KdBreakPoints[handle - 1];
+
+		Write(bp.address, &bp.original, 1);
+		bp.used = FALSE;
+	}
+	break;
+
+	case DbgKdReadControlSpaceApi:
+	case DbgKdWriteControlSpaceApi:
+	{
+		BOOLEAN read = pState->ApiNumber == DbgKdReadControlSpaceApi;
+
+		auto& r = pState->u.ReadMemory; // same layout of WriteMemory.
+
+		if (r.TargetBaseAddress != 2) // only the KSPECIAL_REGISTERS are supported.
+		{
+			pState->ReturnStatus = STATUS_UNSUCCESSFUL;
+			second->Length = 0;
+			break;
+		}
+
+		ULONG count = _MIN_(r.TransferCount, SpecialRegistersSize);
+
+		if (read)
+		{
+			::memcpy(second->pData, ControlSpace[processor], count);
+			second->Length = (USHORT)count;
+		}
+		else
+		{
+			count = _MIN_(count, payload);
+			::memcpy(ControlSpace[processor], second->pData, count);
+			second->Length = 0;
+		}
+
+		r.ActualBytesRead = count;
+	}
+	break;
+
+	case DbgKdGetVersionApi:
+	{
+		auto& v = pState->u.GetVersion64;
+
+		v.MajorVersion = 0xF;
+		v.MinorVersion = 19041;
+		v.ProtocolVersion = 6;
+		v.KdSecondaryVersion = 2;
+		v.Flags = 0x47; // DBGKD_VERS_FLAG_MP | DATA | PTR64 | NOMM | PARTITIONS
+		v.MachineType = IMAGE_FILE_MACHINE_AMD64;
+		v.MaxPacketType = 12;
+		v.MaxStateChange = (UCHAR)(DbgKdMaximumStateChange - DbgKdMinimumStateChange);
+		v.MaxManipulate = (UCHAR)(DbgKdMaximumManipulate - DbgKdMinimumManipulate);
+		v.KernBase = KernelBase;
+		v.PsLoadedModuleList = (ULONG64)PsLoadedModuleList;
+		v.DebuggerDataList = 0;
+
+		second->Length = 0;
+	}
+	break;
+
+	case DbgKdContinueApi:
+	case DbgKdContinueApi2:
+	{
+		LastContinueApi = pState->ApiNumber;
+
+		if (pState->ApiNumber == DbgKdContinueApi2)
+		{
+			LastTraceFlag = pState->u.Continue2.AnyControlSet.Amd64ControlSet.TraceFlag != 0;
+			LastDr7 = pState->u.Continue2.AnyControlSet.Amd64ControlSet.Dr7;
+		}
+		else
+		{
+			LastTraceFlag = FALSE;
+		}
+	}
+	return FALSE;
+
+	default:
+	{
+		pState->ReturnStatus = STATUS_NOT_IMPLEMENTED;
+		second->Length = 0;
+	}
+	break;
+	}
+
+	return TRUE;
+}
+
+VOID SimTarget::BreakIn(ULONG64 pc)
+{
+	ReportException(STATUS_BREAKPOINT, pc, 0);
+}
+
+VOID SimTarget::HitBreakPoint(ULONG64 pc)
+{
+	// KD deletes the breakpoint at PC before reporting the exception.
+
+	for (KdBreakPoint& bp : KdBreakPoints)
+		if (bp.used && bp.address == pc)
+		{
+			Write(bp.address, &bp.original, 1);
+			bp.used = FALSE;
+		}
+
+	ReportException(STATUS_BREAKPOINT, pc, 0);
+}
+
+VOID SimTarget::HitHwBreakPoint(ULONG64 pc, ULONG drIndex)
+{
+	ReportException(STATUS_SINGLE_STEP, pc, 1ull << drIndex);
+}
+
+VOID SimTarget::SingleStep()
+{
+	ReportException(STATUS_SINGLE_STEP, Context[CurrentProcessor].Rip, 0x4000);
+}
+
+ULONG SimTarget::KdBreakPointsNum()
+{
+	ULONG num = 0;
+
+	for (KdBreakPoint& bp : KdBreakPoints)
+		if (bp.used)
+			num++;
+
+	return num;
+}
+
+//
+// Execution: the instructions are not executed, but the program counter follows the relative jumps and calls.
+//
+
+ULONG64 SimTarget::StepTarget(ULONG64 pc)
+{
+	BYTE bytes[ZYDIS_MAX_INSTRUCTION_LENGTH] = {};
+	ULONG len = Read(pc, bytes, sizeof(bytes));
+
+	ZydisDecoder decoder;
+	ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
+
+	ZydisDecodedInstruction instr;
+	ZydisDecodedOperand ops[ZYDIS_MAX_OPERAND_COUNT_VISIBLE];
+
+	if (!ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, bytes, len, &instr, ops, ZYDIS_MAX_OPERAND_COUNT_VISIBLE, ZYDIS_DFLAG_VISIBLE_OPERANDS_ONLY)))
+		return pc + 1;
+
+	ULONG64 next = pc + instr.length;
+
+	if ((instr.mnemonic == ZYDIS_MNEMONIC_JMP || instr.mnemonic == ZYDIS_MNEMONIC_CALL) &&
+		ops[0].type == ZYDIS_OPERAND_TYPE_IMMEDIATE && ops[0].imm.is_relative)
+	{
+		ZyanU64 dest = 0;
+		ZydisCalcAbsoluteAddress(&instr, &ops[0], pc, &dest);
+
+		if (instr.mnemonic == ZYDIS_MNEMONIC_CALL)
+		{
+			Context[CurrentProcessor].Rsp -= 8;
+			Write(Context[CurrentProcessor].Rsp, &next, sizeof(next));
+		}
+
+		return dest;
+	}
+
+	if (instr.mnemonic == ZYDIS_MNEMONIC_RET)
+	{
+		ULONG64 ret = 0;
+
+		if (Read(Context[CurrentProcessor].Rsp, &ret, sizeof(ret)) == sizeof(ret))
+		{
+			Context[CurrentProcessor].Rsp += 8;
+			return ret;
+		}
+	}
+
+	return next;
+}
+
+ULONG64 SimTarget::Run(ULONG64 maxEvents)
+{
+	ULONG64 steps = 0;
+
+	while (LastTraceFlag && steps < maxEvents)
+	{
+		Context[CurrentProcessor].Rip = StepTarget(Context[CurrentProcessor].Rip);
+		Context[CurrentProcessor].EFlags &= ~0x100ull; // TF
+
+		steps++;
+
+		SingleStep();
+	}
+
+	return steps;
+}
+
+VOID SimTarget::DebugPrint(ULONG processor, const CHAR* msg)
+{
+	HostSim_Pcr = Pcr[processor];
+	HostSim_Processor = processor;
+
+	DBGKD_DEBUG_IO io = {};
+
+	io.ApiNumber = DbgKdPrintStringApi;
+	io.ProcessorLevel = 6;
+	io.Processor = (USHORT)processor;
+	io.u.PrintString.LengthOfString = (ULONG)::strlen(msg);
+
+	KD_BUFFER first = { sizeof(io), sizeof(io), 0, (PUCHAR)&io };
+	KD_BUFFER second = { (USHORT)io.u.PrintString.LengthOfString, (USHORT)io.u.PrintString.LengthOfString, 0, (PUCHAR)msg };
+	KD_CONTEXT kdContext = {};
+
+	BcCall _call_;
+	::KdSendPacket(KdPacketType3_Ie_DebugIO, &first, &second, &kdContext);
+}
+
+//
+// Keyboard.
+//
+
+VOID SimTarget::PressKey(BYTE scancode)
+{
+	Keys.push_back({ scancode, -1 });
+}
+
+VOID SimTarget::Type(const CHAR* line)
+{
+	for (const CHAR* p = line; *p; p++)
+	{
+		USHORT key = CharToKey[(BYTE)*p & 0x7F];
+
+		if (!key)
+			::HostSim_FatalError("SimTarget::Type: character not in the keyboard layout.");
+
+		if (key & 0x100)
+			PressKey(MACRO_SCANCODE_LShift);
+
+		PressKey((BYTE)key);
+
+		if (key & 0x100)
+			PressKey(MACRO_SCANCODE_LShift | 0x80);
+	}
+
+	Cmds.push_back({ line, {} });
+
+	Keys.push_back({ MACRO_SCANCODE_ENTER, (LONG)Cmds.size() - 1 });
+}
+
+VOID SimTarget::CloseCmd()
+{
+	CurrentCmd = -1;
+}
+
+BYTE SimTarget::ReadKeyb()
+{
+	// BugChecker reads the next key after the command of the previous line has completed.
+
+	HostCall _call_;
+
+	CloseCmd();
+
+	if (Keys.empty())
+		return 0;
+
+	Key k = Keys.front();
+	Keys.pop_front();
+
+	if (k.cmdIndex >= 0)
+		CurrentCmd = k.cmdIndex;
+
+	return k.scancode;
+}
+
+const SimTarget::CmdCounters* SimTarget::GetCmd(const CHAR* cmd)
+{
+	for (auto it = Cmds.rbegin(); it != Cmds.rend(); it++)
+		if (it->cmd == cmd)
+			return &*it;
+
+	return NULL;
+}
+
+//
+// Screen.
+//
+
+std::string SimTarget::GetScreenLine(ULONG y)
+{
+	std::string line;
+
+	if (y < Root::I->WndHeight)
+		for (ULONG x = 0; x < Root::I->WndWidth; x++)
+		{
+			CHAR c = (CHAR)(Root::I->FrontBuffer[y * Root::I->WndWidth + x] & 0xFF);
+			line += c ? c : ' ';
+		}
+
+	return line;
+}
+
+BOOLEAN SimTarget::ScreenContains(const CHAR* text)
+{
+	for (ULONG y = 0; y < Root::I->WndHeight; y++)
+		if (GetScreenLine(y).find(text) != std::string::npos)
+			return TRUE;
+
+	return FALSE;
+}
+
+std::string SimTarget::GetLogLines()
+{
+	std::string ret;
+
+	ULONG num = Root::I->LogWindow.GetLinesNum();
+
+	for (ULONG i = 0; i < num; i++)
+	{
+		ret += Root::I->LogWindow.GetLineToDraw(i).c_str();
+		ret += '\n';
+	}
+
+	return ret;
+}
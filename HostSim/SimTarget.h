@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <deque>
+
+#include "BugChecker.h"
+
+#include "DbgKd.h"
+#include "KdCom.h"
+
+#include "SimSymbols.h"
+
+//
+// Simulated KD target: it plays the part of NTOSKRNL, calling KdSendPacket and KdReceivePacket of BugChecker and executing the
+// DBGKD_MANIPULATE_STATE64 requests against a synthetic address space, module list and processor state.
+//
+// The synthetic address space is made of regions: a region either owns its memory (for example, an image at a kernel address)
+// or maps a host object at its own address, for the structures that BugChecker dereferences directly (the PCR and PsLoadedModuleList).
+//
+
+class SimTarget
+{
+public:
+
+	static SimTarget* I;
+
+	static constexpr int ProcessorsNum = 4;
+	static constexpr ULONG ControlSpaceSize = 0x400;
+
+	SimTarget(const SimSymbols& kernelSymbols = SimSymbols::Kernel()); // initializes BugChecker, as DriverEntry does.
+	~SimTarget();
+
+	// synthetic address space.
+
+	BYTE* Map(ULONG64 address, ULONG64 size); // zero filled; returns the memory of the region.
+	VOID MapHost(VOID* ptr, ULONG64 size); // the region is the host object itself, i.e. the host pages that contain it.
+	VOID Unmap(ULONG64 address);
+
+	ULONG Read(ULONG64 address, VOID* dest, ULONG size); // returns the number of bytes read, up to the first unmapped byte.
+	ULONG Write(ULONG64 address, const VOID* src, ULONG size);
+
+	BOOLEAN IsHostMapped(ULONG64 address); // the structures that BugChecker dereferences directly (see MmIsAddressValid).
+
+	ULONG ReadTransferMax = PACKET_MAX_SIZE; // the largest DbgKdReadVirtualMemoryApi transfer, for simulating a kernel with a smaller buffer.
+	ULONG64 PageCrossingReads = 0; // DbgKdReadVirtualMemoryApi requests that span two pages.
+	std::vector<ULONG64> ReadAddresses; // the address of each DbgKdReadVirtualMemoryApi request, for counting the reads of a structure.
+
+	// modules and images.
+
+	ULONG64 AddModule(const CHAR* name, ULONG64 base, ULONG sizeOfImage, const SimSymbols* symbols = NULL); // maps the image with its PE headers and links it in PsLoadedModuleList.
+	// base 0: the image is allocated in the host memory and mapped at its own address, for the code that reads the images directly at PASSIVE_LEVEL (the unwind snapshot).
+	VOID SetPdata(ULONG64 base, const IMAGE_RUNTIME_FUNCTION_ENTRY* entries, ULONG num, ULONG rva); // writes the exception directory of the image.
+
+	// processor state.
+
+	CONTEXT Context[ProcessorsNum] = {};
+	BYTE ControlSpace[ProcessorsNum][ControlSpaceSize] = {};
+	ULONG CurrentProcessor = 0;
+
+	// events: each one is a KD session, i.e. a state change followed by the manipulate requests of BugChecker, up to its continue request.
+
+	VOID BreakIn(ULONG64 pc); // hardcoded INT3 at "pc" (as in DbgBreakPoint).
+	VOID HitBreakPoint(ULONG64 pc); // a breakpoint written by BugChecker.
+	VOID HitHwBreakPoint(ULONG64 pc, ULONG drIndex);
+	VOID SingleStep();
+
+	ULONG64 Run(ULONG64 maxEvents); // single steps while the last continue request has the trace flag set; returns the number of steps.
+
+	VOID DebugPrint(ULONG processor, const CHAR* msg); // DbgPrint of the kernel: a DebugIO packet. Can be called concurrently by several host threads, one per processor.
+
+	// keyboard.
+
+	VOID Type(const CHAR* line); // the keystrokes of the line, followed by ENTER.
+	VOID PressKey(BYTE scancode);
+	BYTE ReadKeyb(); // called by BugChecker through Amd64_ReadKeyb.
+
+	// the last continue request.
+
+	ULONG LastContinueApi = 0;
+	BOOLEAN LastTraceFlag = FALSE;
+	ULONG64 LastDr7 = 0;
+
+	// KD breakpoints.
+
+	struct KdBreakPoint
+	{
+		ULONG64 address;
+		BYTE original;
+		BOOLEAN used;
+	};
+
+	std::vector<KdBreakPoint> KdBreakPoints; // the handle is the index plus one.
+
+	ULONG KdBreakPointsNum();
+
+	// counters.
+
+	struct Counters
+	{
+		ULONG64 packetsSent = 0; // KdSendPacket calls.
+		ULONG64 packetsReceived = 0; // KdReceivePacket calls returning a packet.
+		ULONG64 timeouts = 0;
+		ULONG64 roundTrips = 0; // manipulate requests answered.
+		ULONG64 bytesRead = 0;
+		ULONG64 largestRead = 0; // the largest DbgKdReadVirtualMemoryApi response.
+		std::map<ULONG, ULONG64> byApi;
+	};
+
+	Counters Total;
+
+	struct CmdCounters
+	{
+		std::string cmd;
+		Counters counters;
+	};
+
+	std::vector<CmdCounters> Cmds; // one entry for each typed line, from its ENTER to the next key read.
+
+	const CmdCounters* GetCmd(const CHAR* cmd); // the last execution of the command.
+
+	// the contents of the screen.
+
+	std::string GetScreenLine(ULONG y);
+	BOOLEAN ScreenContains(const CHAR* text);
+
+	std::string GetLogLines(); // the lines of the log window.
+
+private:
+
+	struct Region
+	{
+		ULONG64 size;
+		BYTE* ptr;
+		BOOLEAN owned;
+	};
+
+	std::map<ULONG64, Region> Regions; // by start address.
+
+	Region* FindRegion(ULONG64 address, ULONG64* offset);
+
+	struct Key
+	{
+		BYTE scancode;
+		LONG cmdIndex; // >= 0 for the ENTER of a typed line.
+	};
+
+	std::deque<Key> Keys;
+
+	USHORT CharToKey[128] = {}; // scancode, plus 0x100 if SHIFT is required.
+
+	LONG CurrentCmd = -1;
+
+	VOID CloseCmd();
+	VOID Count(BOOLEAN sent, ULONG api, ULONG bytesRead);
+
+	LIST_ENTRY* PsLoadedModuleList = NULL;
+	BYTE* Pcr[ProcessorsNum] = {};
+	ULONG64 KernelBase = 0;
+
+	VOID ReportException(NTSTATUS code, ULONG64 pc, ULONG64 dr6);
+	VOID Session();
+	BOOLEAN Execute(DBGKD_MANIPULATE_STATE64* pState, KD_BUFFER* second, ULONG payload); // FALSE for the continue requests.
+
+	ULONG64 StepTarget(ULONG64 pc);
+};
+
+//
+// Calls to BugChecker: the kernel calls KdSendPacket and KdReceivePacket with the interrupts disabled and at HIGH_LEVEL.
+// The tests use BcCall also to call the BugChecker objects directly, on the processor of the last event.
+//
+
+class BcCall
+{
+public:
+	BcCall();
+	~BcCall();
+
+private:
+	BOOLEAN prevInts;
+	BYTE prevIrql;
+};
+
+class HostCall // the inverse of BcCall, for the callbacks of BugChecker into the simulator: the C++ library allocates with the operator new of BugChecker.
+{
+public:
+	HostCall();
+	~HostCall();
+
+private:
+	BOOLEAN prevInts;
+	BYTE prevIrql;
+};
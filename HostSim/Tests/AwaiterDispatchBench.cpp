@@ -0,0 +1,195 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include "Cmd.h"
+#include "Root.h"
+
+//
+// The dispatch of the awaiters on each KD packet: the virtual Prepare and Complete of the awaiter, compared with the chain of
+// string compares on the name of the awaiter that was used before. An awaiter defined here, outside BugChecker, is driven
+// by the same dispatch in a simulated session.
+//
+
+static constexpr ULONG DispatchesNum = 10000000;
+static constexpr ULONG VersionsNum = 1000;
+
+// a new awaiter: ProcessAwaiter and KdSendPacket don't know about it.
+
+struct GetVersionAwaiter : BcAwaiter_StateManipulateBase
+{
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes)
+	{
+		pState->ApiNumber = DbgKdGetVersionApi;
+		pState->ReturnStatus = STATUS_PENDING;
+
+		SecondBuffer->Length = 0;
+
+		return RequestPrepared(pState, SecondBuffer, PayloadBytes);
+	}
+
+	virtual void Complete(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer)
+	{
+		retVal = pState->ApiNumber == DbgKdGetVersionApi && NT_SUCCESS(pState->ReturnStatus);
+
+		if (retVal)
+			version = pState->u.GetVersion64;
+	}
+
+	DBGKD_GET_VERSION64 version = {};
+};
+
+class Cmd_GETVERSION : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "GETVERSION"; }
+	virtual const CHAR* GetDesc() { return "Reads the version of the kernel, many times."; }
+	virtual const CHAR* GetSyntax() { return "GETVERSION"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		ULONG ok = 0;
+		USHORT minor = 0;
+
+		for (ULONG i = 0; i < VersionsNum; i++)
+		{
+			GetVersionAwaiter awaiter;
+
+			if (co_await awaiter)
+			{
+				ok++;
+				minor = awaiter.version.MinorVersion;
+			}
+		}
+
+		CHAR buffer[64];
+		::sprintf(buffer, "GETVERSION: %u of %u, build %u.", ok, VersionsNum, minor);
+		Print(buffer);
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_GETVERSION)
+
+// the dispatch before the virtual methods: ProcessAwaiter and KdSendPacket compared the name of the awaiter with each known name.
+
+static const CHAR* AwaiterNames[] = {
+	"BcAwaiter_StateManipulate",
+	"BcAwaiter_DiscoverPosInModules",
+	"BcAwaiter_RecvTimeout",
+	"BcAwaiter_ReadMemory",
+	"BcAwaiter_ReadMemoryBatch",
+	"BcAwaiter_Join"
+};
+
+static ULONG DispatchByName(const CHAR* function)
+{
+	for (ULONG i = 0; i < (sizeof(AwaiterNames) / sizeof(AwaiterNames[0])); i++)
+		if (!::strcmp(function, AwaiterNames[i]))
+			return i;
+
+	return (ULONG)-1;
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x10);
+
+	// the awaiter defined above, in a session: each co_await is a round trip.
+
+	double start = Now();
+
+	t.Type("GETVERSION");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	double elapsed = Now() - start;
+
+	const SimTarget::CmdCounters* c = t.GetCmd("GETVERSION");
+
+	CHECK(c && c->counters.byApi.count(DbgKdGetVersionApi) && c->counters.byApi.at(DbgKdGetVersionApi) == VersionsNum);
+	CHECK(t.GetLogLines().find("GETVERSION: 1000 of 1000, build 19041.") != std::string::npos);
+
+	::printf("GETVERSION: %u round trips in %.3f s (%.0f ns per round trip, simulator included).\n",
+		VersionsNum, elapsed, elapsed * 1e9 / VersionsNum);
+
+	// the dispatch alone: ProcessAwaiter, then the response to Complete, as in KdReceivePacket and KdSendPacket. Before, the
+	// same request and response were reached after comparing the name of the awaiter, in both places: the first name in
+	// the chain was the best case and the last one the worst.
+
+	{
+		BcCall _call_;
+
+		DBGKD_MANIPULATE_STATE64 state = {};
+		BYTE data[16];
+		KD_BUFFER second = {};
+		second.MaxLength = sizeof(data);
+		second.pData = data;
+		ULONG payload = 0;
+
+		GetVersionAwaiter awaiter;
+
+		ULONG ok = 0;
+
+		start = Now();
+
+		for (ULONG i = 0; i < DispatchesNum; i++)
+		{
+			Root::I->AwaiterPtr = &awaiter;
+
+			if (BcAwaiterBase::ProcessAwaiter(&state, &second, &payload) == ProcessAwaiterRetVal::Ok)
+			{
+				state.ReturnStatus = STATUS_SUCCESS;
+				const_cast<BcAwaiterBase*>(Root::I->AwaiterPtr)->Complete(&state, &second);
+
+				ok += awaiter.retVal;
+			}
+		}
+
+		double virtualCalls = Now() - start;
+
+		CHECK(ok == DispatchesNum);
+
+		::printf("Prepare and Complete: %.1f ns per packet.\n", virtualCalls * 1e9 / DispatchesNum);
+
+		for (ULONG n : { 0u, (ULONG)(sizeof(AwaiterNames) / sizeof(AwaiterNames[0])) - 1 })
+		{
+			const CHAR* volatile function = AwaiterNames[n];
+
+			ok = 0;
+
+			start = Now();
+
+			for (ULONG i = 0; i < DispatchesNum; i++)
+			{
+				Root::I->DebuggerState = DEBST_COROUTINE;
+
+				if (DispatchByName(function) == n)
+					awaiter.GetVersionAwaiter::Prepare(&state, &second, &payload);
+
+				state.ReturnStatus = STATUS_SUCCESS;
+
+				if (DispatchByName(function) == n)
+				{
+					awaiter.GetVersionAwaiter::Complete(&state, &second);
+					ok += awaiter.retVal;
+				}
+			}
+
+			elapsed = Now() - start;
+
+			CHECK(ok == DispatchesNum);
+
+			::printf("String compares, %s: %.1f ns per packet.\n", AwaiterNames[n], elapsed * 1e9 / DispatchesNum);
+		}
+
+		Root::I->AwaiterPtr = NULL;
+		Root::I->DebuggerState = DEBST_CONTINUE;
+	}
+
+	return Finish();
+}
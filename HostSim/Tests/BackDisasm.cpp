@@ -0,0 +1,323 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Cmd.h"
+#include "Root.h"
+
+//
+// Backward disassembly over a blob of x64 code (three functions with long immediates containing opcode bytes, SSE and AVX
+// instructions, prefixes, INT3 padding and a jump table between the second and the third function), preceded by misleading
+// bytes. The blob is in the kernel image twice: the first copy has its function starts in the public symbols, the second one has
+// none and is scrolled through from PC, with the boundaries decoded forward.
+//
+
+static constexpr ULONG64 KernelAddress = 0xFFFFF80000000000;
+
+static constexpr ULONG SymBlobRva = 0x10000; // with fn1, fn2 and fn3 in the public symbols.
+static constexpr ULONG BlobRva = 0x20000; // without symbols.
+
+static const BYTE Blob[] =
+{
+	0x53, 0x56, 0x48, 0x83, 0xEC, 0x28, 0x48, 0x89, 0xCB, 0x48, 0xB8, 0xE8, 0xE8, 0xE8, 0xE8, 0xE8,
+	0xE8, 0xE8, 0xE8, 0x48, 0x89, 0x43, 0x10, 0x48, 0x8D, 0x35, 0x78, 0x56, 0x34, 0x12, 0x8B, 0x84,
+	0x93, 0xF0, 0xFF, 0xFF, 0x7F, 0x3D, 0xE9, 0x00, 0x00, 0x00, 0x75, 0x0D, 0xC7, 0x44, 0x24, 0x20,
+	0x0B, 0x0F, 0x0B, 0x0F, 0xE8, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xB6, 0x0B, 0x85, 0xC9, 0x0F, 0x44,
+	0xC1, 0x69, 0xC0, 0x93, 0x01, 0x00, 0x01, 0x48, 0x83, 0xC4, 0x28, 0x5E, 0x5B, 0xC3, 0xCC, 0xCC,
+	0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0x48, 0x89, 0x5C, 0x24, 0x08, 0x57, 0x48, 0x83, 0xEC, 0x20, 0xF3,
+	0x0F, 0x6F, 0x01, 0x66, 0x0F, 0xEF, 0xC9, 0x66, 0x0F, 0x74, 0xC1, 0x66, 0x0F, 0xD7, 0xC0, 0x0F,
+	0xBC, 0xC0, 0xF0, 0x0F, 0xC1, 0x02, 0xF3, 0xA4, 0x0F, 0x1F, 0x04, 0x00, 0x2E, 0x66, 0x0F, 0x1F,
+	0x04, 0x00, 0x48, 0x8D, 0x3D, 0x00, 0x01, 0x00, 0x00, 0xFF, 0x24, 0xC7, 0x85, 0xC0, 0xE8, 0x48,
+	0x85, 0xC0, 0xE8, 0x48, 0xB8, 0x48, 0xFF, 0x25, 0x0F, 0x0F, 0x0F, 0x0F, 0xC3, 0xC3, 0xC3, 0xC3,
+	0xC3, 0xC3, 0x48, 0x8B, 0xE9, 0xE9, 0xE9, 0xE9, 0xE9, 0xE9, 0xE9, 0xE9, 0x48, 0x83, 0xEC, 0x48,
+	0x65, 0x48, 0x89, 0x04, 0x25, 0x88, 0x01, 0x00, 0x00, 0xC5, 0xFE, 0x6F, 0x01, 0xC5, 0xFD, 0xFE,
+	0x42, 0x20, 0xC4, 0xC1, 0x7E, 0x7F, 0x00, 0xC5, 0xF8, 0x77, 0x4F, 0x8B, 0x8C, 0xDA, 0x78, 0x56,
+	0x34, 0x12, 0x66, 0x90, 0x48, 0x0F, 0xA4, 0xD0, 0x07, 0x48, 0x83, 0xC4, 0x48, 0xC3, 0xCC, 0xCC,
+	0xCC, 0xCC,
+};
+
+static constexpr ULONG Fn1 = 0x00, Fn2 = 0x55, Fn3 = 0xAC;
+static constexpr ULONG JumpTable = 0x8C; // up to fn3.
+
+// the instruction starts (as given by a disassembler of the assembled source): fn1 with its padding, fn2 up to its
+// "jmp [rdi+rax*8]" (followed by the jump table) and fn3 with its padding.
+
+static const ULONG Fn1Boundaries[] = { 0x00, 0x01, 0x02, 0x06, 0x09, 0x13, 0x17, 0x1E, 0x25, 0x2A, 0x2C, 0x34, 0x39, 0x3C, 0x3E, 0x41,
+	0x47, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50, 0x51, 0x52, 0x53, 0x54 };
+static const ULONG Fn2Boundaries[] = { 0x55, 0x5A, 0x5B, 0x5F, 0x63, 0x67, 0x6B, 0x6F, 0x72, 0x76, 0x78, 0x7C, 0x82, 0x89 };
+static const ULONG Fn3Boundaries[] = { 0xAC, 0xB0, 0xB9, 0xBD, 0xC2, 0xC7, 0xCA, 0xD2, 0xD4, 0xD9, 0xDD, 0xDE, 0xDF, 0xE0, 0xE1 };
+
+// a test command: scrolls the disassembler window as CTRL+UP/DOWN and CTRL+PGUP/PGDN do, and records the addresses shown.
+
+static constexpr ULONG MaxViews = 256;
+static constexpr ULONG MaxLines = 32;
+
+struct View
+{
+	ULONG64 addresses[MaxLines];
+	ULONG num;
+	ULONG64 kdReads; // during the scrolling.
+};
+
+static View Views[MaxViews];
+static ULONG ViewsNum = 0;
+
+class Cmd_SCROLL : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "SCROLL"; }
+	virtual const CHAR* GetDesc() { return "Scrolls the disassembler window."; }
+	virtual const CHAR* GetSyntax() { return "SCROLL lines"; } // 0: the current position.
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		eastl::string s = params.cmd;
+
+		s.trim();
+
+		LONG navigate = (LONG)::strtol(s.c_str() + ::strlen("SCROLL"), NULL, 10);
+
+		ULONG64 reads = SimTarget::I->ReadAddresses.size();
+
+		co_await BcAwaiter_Join{ Root::I->DisasmWindow.Disasm(params.context, params.is32bitCompat, 0, navigate ? navigate : DisasmWnd::NAVIGATE_PRESERVE_POS) };
+
+		if (ViewsNum == MaxViews)
+			co_return;
+
+		View& v = Views[ViewsNum++];
+
+		v.num = 0;
+		v.kdReads = SimTarget::I->ReadAddresses.size() - reads;
+
+		for (auto& line : Root::I->DisasmWindow.contents) // the lines of the symbol names have no address.
+		{
+			size_t pos = line.find("0010:");
+
+			if (pos != eastl::string::npos && v.num < MaxLines)
+				v.addresses[v.num++] = ::strtoull(line.c_str() + pos + 5, NULL, 16);
+		}
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_SCROLL)
+
+static std::vector<ULONG64> Truth(ULONG64 base)
+{
+	std::vector<ULONG64> ret;
+
+	for (ULONG o : Fn1Boundaries) ret.push_back(base + o);
+	for (ULONG o : Fn2Boundaries) ret.push_back(base + o);
+	for (ULONG o : Fn3Boundaries) ret.push_back(base + o);
+
+	return ret;
+}
+
+static LONG IndexOf(const std::vector<ULONG64>& truth, ULONG64 address)
+{
+	for (size_t i = 0; i < truth.size(); i++)
+		if (truth[i] == address)
+			return (LONG)i;
+
+	return -1;
+}
+
+static BOOLEAN IsRun(const std::vector<ULONG64>& truth, const View& v) // consecutive instruction starts.
+{
+	if (!v.num)
+		return FALSE;
+
+	LONG i = IndexOf(truth, v.addresses[0]);
+
+	if (i < 0)
+		return FALSE;
+
+	for (ULONG j = 1; j < v.num; j++)
+		if (i + j >= truth.size() || truth[i + j] != v.addresses[j])
+			return FALSE;
+
+	return TRUE;
+}
+
+int main()
+{
+	SimSymbols symbols = SimSymbols::Kernel();
+
+	symbols.AddPublic("fn1", SymBlobRva + Fn1, Fn2 - Fn1);
+	symbols.AddPublic("fn2", SymBlobRva + Fn2, Fn3 - Fn2);
+	symbols.AddPublic("fn3", SymBlobRva + Fn3, sizeof(Blob) - Fn3);
+
+	SimTarget t(symbols);
+
+	WriteCode(t, 0x40);
+
+	// the blobs, each one after 0x200 bytes of the jump table of fn2 repeated (which don't resynchronize at the blob) and
+	// followed by more of them. The second one has an INT3 just before it.
+
+	BYTE junk[0x200];
+
+	for (ULONG i = 0; i < sizeof(junk); i++)
+		junk[i] = Blob[JumpTable + i % (Fn3 - JumpTable)];
+
+	for (ULONG rva : { SymBlobRva, BlobRva })
+	{
+		t.Write(KernelAddress + rva - sizeof(junk), junk, sizeof(junk));
+		t.Write(KernelAddress + rva, Blob, sizeof(Blob));
+		t.Write(KernelAddress + rva + sizeof(Blob), junk, sizeof(junk));
+	}
+
+	const BYTE int3 = 0xCC;
+	t.Write(KernelAddress + BlobRva - 1, &int3, 1);
+
+	// the lengths decoded by BugChecker agree with the boundaries.
+
+	{
+		BcCall _call_;
+
+		ZydisDecodedInstruction instr;
+		ZydisDecodedOperand ops[ZYDIS_MAX_OPERAND_COUNT_VISIBLE];
+
+		std::vector<ULONG64> truth = Truth(0);
+		truth.push_back(JumpTable);
+		truth.push_back(sizeof(Blob));
+
+		std::sort(truth.begin(), truth.end());
+
+		ULONG mismatches = 0;
+
+		for (size_t i = 0; i + 1 < truth.size(); i++)
+		{
+			if (truth[i] == JumpTable)
+				continue;
+
+			BOOLEAN ok = Root::I->DecodedInstrs.Decode(KernelAddress + SymBlobRva + truth[i], FALSE, Blob + truth[i], sizeof(Blob) - (ULONG)truth[i], instr, ops);
+
+			mismatches += !ok || instr.length != truth[i + 1] - truth[i];
+		}
+
+		CHECK(mismatches == 0);
+	}
+
+	// with the symbols: from the last instruction of fn3 and of fn1, up to their starts, one line at a time. The decoding
+	// starts at the function starts, not in the jump table or in the immediates.
+
+	std::vector<ULONG64> truth = Truth(KernelAddress + SymBlobRva);
+
+	CHAR cmd[128];
+
+	struct Scroll
+	{
+		ULONG from;
+		ULONG to;
+	};
+
+	for (Scroll s : { Scroll{ 0xDD, Fn3 }, Scroll{ 0x4D, Fn1 } })
+	{
+		ULONG first = ViewsNum;
+
+		::sprintf(cmd, "U %llX", KernelAddress + SymBlobRva + s.from);
+		t.Type(cmd);
+		t.Type("SCROLL 0");
+
+		LONG from = IndexOf(truth, KernelAddress + SymBlobRva + s.from);
+		LONG to = IndexOf(truth, KernelAddress + SymBlobRva + s.to);
+
+		for (LONG i = from; i > to; i--)
+			t.Type("SCROLL -1");
+
+		t.Type("X");
+		t.BreakIn(CodeAddress);
+
+		CHECK((LONG)(ViewsNum - first) == from - to + 1);
+
+		for (ULONG v = first; v < ViewsNum; v++)
+		{
+			CHECK(IsRun(truth, Views[v]));
+			CHECK(Views[v].num && Views[v].addresses[0] == truth[from - (v - first)]);
+		}
+	}
+
+	// one line up from fn3: the end of the jump table, cut at fn3.
+
+	::sprintf(cmd, "U %llX", KernelAddress + SymBlobRva + Fn3);
+	t.Type(cmd);
+	t.Type("SCROLL -1");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(Views[ViewsNum - 1].num >= 2);
+	CHECK(Views[ViewsNum - 1].addresses[0] < KernelAddress + SymBlobRva + Fn3 && Views[ViewsNum - 1].addresses[0] >= KernelAddress + SymBlobRva + JumpTable);
+	CHECK(Views[ViewsNum - 1].addresses[1] == KernelAddress + SymBlobRva + Fn3);
+
+	// a page up from the end of fn2: the first line shown before becomes the line after the last one.
+
+	{
+		ULONG first = ViewsNum;
+
+		::sprintf(cmd, "U %llX", KernelAddress + SymBlobRva + 0x89);
+		t.Type(cmd);
+		t.Type("SCROLL 0");
+		t.Type("SCROLL -4"); // the height of the window.
+
+		t.Type("X");
+		t.BreakIn(CodeAddress);
+
+		CHECK(ViewsNum - first == 2);
+		CHECK(Views[first].num == 4);
+		CHECK(IsRun(truth, Views[first + 1]));
+
+		LONG i = IndexOf(truth, KernelAddress + SymBlobRva + 0x89);
+		CHECK(Views[first + 1].num && Views[first + 1].addresses[0] == truth[i - 4]);
+	}
+
+	// without symbols, from PC: forward, then back to PC through the boundaries decoded forward. Only the first line up reads
+	// memory (the bytes before the view).
+
+	truth = Truth(KernelAddress + BlobRva);
+
+	{
+		ULONG first = ViewsNum;
+
+		t.Type("SCROLL 0");
+
+		for (ULONG i = 0; i < 20; i++)
+			t.Type("SCROLL 1");
+
+		for (ULONG i = 0; i < 20; i++)
+			t.Type("SCROLL -1");
+
+		t.Type("X");
+		t.BreakIn(KernelAddress + BlobRva - 1);
+
+		CHECK(ViewsNum - first == 41);
+
+		ULONG64 backReads = 0;
+
+		for (ULONG v = 0; v <= 20; v++)
+		{
+			View& fwd = Views[first + v];
+			View& back = Views[first + 40 - v];
+
+			CHECK(IsRun(truth, fwd));
+			CHECK(fwd.num && fwd.addresses[0] == truth[v]);
+
+			CHECK(back.num == fwd.num && !::memcmp(back.addresses, fwd.addresses, fwd.num * sizeof(ULONG64)));
+
+			if (v < 20)
+				backReads += back.kdReads;
+		}
+
+		CHECK(backReads <= 1);
+	}
+
+	if (!Failures)
+		::printf("%u views checked.\n", ViewsNum);
+
+	return Finish();
+}
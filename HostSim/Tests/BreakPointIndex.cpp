@@ -0,0 +1,366 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Cmd.h"
+#include "Root.h"
+
+//
+// The index of the breakpoints by address, with 10k breakpoints: random insertions and removals compared with a plain vector,
+// the range queries of each state change compared with a linear scan, then the state changes and the disassembler window with
+// 10k breakpoints set in the debugger. The lookups are checked by the entries that they compare; the times are only printed.
+//
+
+static constexpr ULONG64 BplAddress = CodeAddress + 0x10;
+static constexpr ULONG64 DisasmAddress = 0xFFFFF80000002000; // "mov eax, imm32" instructions, each with a breakpoint.
+static constexpr ULONG64 FarAddress = 0xFFFFF80000100000; // the other breakpoints, in 1 MB.
+
+static constexpr ULONG BpsNum = 10000;
+static constexpr ULONG QueriesNum = 100000;
+static constexpr ULONG HitsNum = 500;
+
+static ULONG Seed = 12345;
+
+static ULONG Rand()
+{
+	Seed = Seed * 1103515245 + 12345;
+	return Seed >> 8;
+}
+
+static ULONG64 Log2Ceil(ULONG64 n) // the compares of a binary search of n entries, at most.
+{
+	ULONG64 r = 0;
+
+	while ((1ULL << r) < n + 1)
+		r++;
+
+	return r;
+}
+
+static BreakPoint MakeBp(ULONG64 address)
+{
+	BreakPoint bp;
+	bp.address = address;
+	return bp;
+}
+
+// the positions of the breakpoints in [start, end), sorted by address and then by position.
+
+static std::vector<size_t> ScanRange(const std::vector<ULONG64>& model, ULONG64 start, ULONG64 end)
+{
+	std::vector<std::pair<ULONG64, size_t>> r;
+
+	for (size_t i = 0; i < model.size(); i++)
+		if (model[i] >= start && model[i] < end)
+			r.push_back({ model[i], i });
+
+	std::sort(r.begin(), r.end());
+
+	std::vector<size_t> ret;
+	for (auto& e : r)
+		ret.push_back(e.second);
+	return ret;
+}
+
+static VOID TestList()
+{
+	BcCall _call_;
+
+	BreakPointList list;
+	std::vector<ULONG64> model; // the addresses, in the order of the list.
+
+	auto check = [&]() -> BOOLEAN {
+
+		if (list.size() != model.size())
+			return FALSE;
+
+		for (size_t i = 0; i < model.size(); i++)
+			if (list[i].address != model[i])
+				return FALSE;
+
+		return TRUE;
+	};
+
+	// the breakpoints appended by BPX (with duplicated addresses), some inserted at random positions (as the step bp, at the
+	// beginning), then removals and insertions again. N.B. each insertion and removal moves the following BreakPoint objects.
+
+	for (ULONG i = 0; i < BpsNum; i++)
+	{
+		ULONG64 address = FarAddress + (Rand() % 0x8000) * 0x20;
+		size_t pos = i % 64 ? model.size() : Rand() % (model.size() + 1);
+
+		list.insert(list.begin() + pos, MakeBp(address));
+		model.insert(model.begin() + pos, address);
+	}
+
+	CHECK(check());
+
+	for (ULONG i = 0; i < BpsNum / 64; i++)
+	{
+		size_t pos = Rand() % model.size();
+
+		list.erase(list.begin() + pos);
+		model.erase(model.begin() + pos);
+	}
+
+	for (ULONG i = 0; i < BpsNum / 64; i++)
+	{
+		ULONG64 address = FarAddress + (Rand() % 0x8000) * 0x20;
+
+		list.push_back(MakeBp(address));
+		model.push_back(address);
+	}
+
+	CHECK(check());
+
+	// Find returns the first breakpoint (in the order of the list) at the address.
+
+	std::vector<LONG> first(0x8000, -1);
+
+	for (size_t i = model.size(); i-- > 0; )
+		first[(model[i] - FarAddress) / 0x20] = (LONG)i;
+
+	ULONG findMismatches = 0;
+
+	for (ULONG i = 0; i < 0x8000; i++)
+	{
+		BreakPoint* bp = list.Find(FarAddress + i * 0x20);
+
+		if (first[i] < 0 ? bp != NULL : bp != &list[first[i]])
+			findMismatches++;
+	}
+
+	CHECK(findMismatches == 0);
+
+	// the range queries, as done at each state change (PC - 63 to PC + 64) and by the disassembler window (a larger range).
+
+	ULONG rangeMismatches = 0;
+
+	for (ULONG i = 0; i < 2000; i++)
+	{
+		ULONG64 start = FarAddress + Rand() % 0x100000;
+		ULONG64 end = start + (i & 1 ? 127 : Rand() % 0x1000);
+
+		eastl::vector<BreakPoint*> out;
+		list.FindInRange(start, end, out);
+
+		std::vector<size_t> expected = ScanRange(model, start, end);
+
+		BOOLEAN same = out.size() == expected.size();
+
+		for (size_t j = 0; same && j < out.size(); j++)
+			same = out[j] == &list[expected[j]];
+
+		rangeMismatches += !same;
+	}
+
+	CHECK(rangeMismatches == 0);
+
+	// the cost of the query of each state change, with the index and with the previous linear scan.
+
+	eastl::vector<BreakPoint*> out;
+	ULONG64 found = 0;
+
+	ULONG64 compares = list.Perf_ComparesNum;
+
+	double start = Now();
+
+	for (ULONG i = 0; i < QueriesNum; i++)
+	{
+		ULONG64 pc = FarAddress + Rand() % 0x100000;
+
+		out.clear();
+		list.FindInRange(pc - 63, pc + 64, out);
+		found += out.size();
+	}
+
+	double indexTime = (Now() - start) / QueriesNum;
+
+	compares = list.Perf_ComparesNum - compares;
+
+	ULONG64 scanned = 0;
+
+	start = Now();
+
+	for (ULONG i = 0; i < QueriesNum / 100; i++)
+	{
+		ULONG64 pc = FarAddress + Rand() % 0x100000;
+
+		out.clear();
+		for (BreakPoint& bp : list)
+			if (bp.address > pc - 64 && bp.address < pc + 64)
+				out.push_back(&bp);
+		scanned += out.size();
+	}
+
+	double scanTime = (Now() - start) / (QueriesNum / 100);
+
+	CHECK(found && scanned);
+	CHECK(compares <= QueriesNum * Log2Ceil(list.size())); // the linear scan compares all the breakpoints.
+
+	::printf("%u breakpoints: range query %.0f ns and %.1f compares with the index, %.0f ns with a linear scan.\n",
+		(ULONG)list.size(), indexTime * 1e9, (double)compares / QueriesNum, scanTime * 1e9);
+
+	// removal of all the breakpoints, mostly from the end.
+
+	while (list.size())
+	{
+		size_t pos = list.size() % 64 ? list.size() - 1 : Rand() % list.size();
+
+		list.erase(list.begin() + pos);
+		model.erase(model.begin() + pos);
+	}
+
+	CHECK(list.Find(model.size() ? model[0] : FarAddress) == NULL);
+}
+
+struct HitsResult // per hit.
+{
+	double time;
+	double roundTrips;
+	double lookups; // of the breakpoints by address.
+	double compares;
+};
+
+static HitsResult HitBpl(SimTarget& t)
+{
+	ULONG64 roundTrips = t.Total.roundTrips;
+	ULONG64 lookups, compares;
+
+	{
+		BcCall _call_;
+		lookups = Root::I->BreakPoints.Perf_LookupsNum;
+		compares = Root::I->BreakPoints.Perf_ComparesNum;
+	}
+
+	double start = Now();
+
+	for (ULONG i = 0; i < HitsNum; i++)
+	{
+		t.Context[0].Rip = BplAddress;
+		t.Context[0].Rax = i;
+
+		t.HitBreakPoint(BplAddress);
+		CHECK(t.LastTraceFlag);
+
+		t.Run(1);
+	}
+
+	double time = (Now() - start) / HitsNum;
+
+	BcCall _call_;
+
+	return { time, (double)(t.Total.roundTrips - roundTrips) / HitsNum,
+		(double)(Root::I->BreakPoints.Perf_LookupsNum - lookups) / HitsNum, (double)(Root::I->BreakPoints.Perf_ComparesNum - compares) / HitsNum };
+}
+
+int main()
+{
+	SimTarget t;
+
+	TestList(); // N.B. the list allocates from the heap of BugChecker.
+
+	WriteCode(t, 0x40);
+
+	CHAR cmd[256];
+
+	::sprintf(cmd, "BPL %llX \"%%x\" rax", BplAddress);
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	// the hits of a logpoint (a state change and a single step each), without and with 10k other breakpoints.
+
+	HitsResult hit = HitBpl(t);
+
+	// the other breakpoints: as if set by BPX, each one with the INT3 that KD writes in place of the first byte of the instruction.
+
+	BYTE* disasm = t.Map(DisasmAddress, PAGE_SIZE * 2);
+
+	for (ULONG i = 0; i < PAGE_SIZE * 2 / 5; i++)
+	{
+		BYTE* instr = disasm + i * 5;
+		instr[0] = 0xCC;
+		instr[1] = (BYTE)i;
+		instr[2] = 0x33;
+		instr[3] = 0x22;
+		instr[4] = 0x11;
+	}
+
+	{
+		BcCall _call_;
+
+		for (ULONG i = 0; i < BpsNum; i++)
+		{
+			BreakPoint bp;
+
+			if (i < PAGE_SIZE * 2 / 5)
+			{
+				bp.address = DisasmAddress + i * 5;
+				bp.prevByte = 0xB8; // mov eax, imm32.
+			}
+			else
+			{
+				bp.address = FarAddress + (Rand() % 0x8000) * 0x20;
+				bp.prevByte = 0x90;
+			}
+
+			bp.handle = 0x1000 + i;
+			bp.cmd = "BPX";
+
+			Root::I->BreakPoints.push_back(eastl::move(bp));
+		}
+
+		CHECK(Root::I->BreakPoints.size() == BpsNum + 1);
+	}
+
+	HitsResult hitMany = HitBpl(t);
+
+	{
+		BcCall _call_;
+
+		BreakPoint* bp = Root::I->BreakPoints.Find(BplAddress);
+
+		CHECK(bp && bp->log.Perf_HitsNum == HitsNum * 2);
+	}
+
+	// the cost of a state change must not depend on the number of the breakpoints far from PC: the same lookups, each one a
+	// binary search, and the same KD round-trips.
+
+	CHECK(hit.lookups > 0 && hitMany.lookups == hit.lookups);
+	CHECK(hitMany.compares <= hitMany.lookups * Log2Ceil(BpsNum + 1));
+	CHECK(hitMany.roundTrips == hit.roundTrips);
+
+	::printf("Logpoint hit: %.1f us and %.1f compares with 1 breakpoint, %.1f us and %.1f compares with %u breakpoints (%.1f lookups).\n",
+		hit.time * 1e6, hit.compares, hitMany.time * 1e6, hitMany.compares, BpsNum + 1, hitMany.lookups);
+
+	// the disassembler window hides the INT3s of the breakpoints in its range.
+
+	::sprintf(cmd, "U %llX", DisasmAddress + 5 * 10);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	ULONG movLines = 0, int3Lines = 0;
+
+	for (ULONG y = 0; y < 100; y++)
+	{
+		std::string line = t.GetScreenLine(y);
+
+		std::transform(line.begin(), line.end(), line.begin(), ::tolower);
+
+		movLines += line.find(" b8") != std::string::npos && line.find(" mov ") != std::string::npos;
+		int3Lines += line.find(" cc") != std::string::npos || line.find("int3") != std::string::npos;
+	}
+
+	CHECK(movLines >= 4); // the height of the window.
+	CHECK(int3Lines == 0);
+
+	return Finish();
+}
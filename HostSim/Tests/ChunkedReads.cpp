@@ -0,0 +1,101 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+//
+// The chunks of DEBST_MEMREADCOR: as large as the packet buffer of the kernel allows, never across a page boundary,
+// continued after a short response and failed as a whole when a page in the middle is not readable.
+//
+
+static constexpr ULONG64 DataAddress = 0xFFFFF80000010000; // in the image of the kernel.
+static constexpr ULONG64 HoleAddress = 0xFFFFF80000400000; // a page, followed by an unmapped one.
+
+static ULONG64 Reads(SimTarget& t, const CHAR* cmd)
+{
+	const SimTarget::CmdCounters* c = t.GetCmd(cmd);
+
+	if (!c || !c->counters.byApi.count(DbgKdReadVirtualMemoryApi))
+		return 0;
+
+	ULONG64 reads = c->counters.byApi.at(DbgKdReadVirtualMemoryApi);
+
+	::printf("%-32s %3llu reads, %5llu bytes, largest %4llu.\n", cmd, reads, c->counters.bytesRead, c->counters.largestRead);
+
+	return reads;
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x10);
+
+	static BYTE data[0x3000];
+	for (int i = 0; i < (int)sizeof(data); i++) data[i] = (BYTE)(i >> 4);
+	t.Write(DataAddress, data, sizeof(data));
+
+	t.Map(HoleAddress, PAGE_SIZE);
+
+	// 8KB at a page boundary: two chunks per page, since the packet buffer is slightly smaller than a page. With the
+	// previous fixed 1KB chunks, this took 8 reads.
+
+	// each command in its own session: the page cache is emptied at the continue.
+
+	t.Type("DB FFFFF80000010000 -l 2000");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(Reads(t, "DB FFFFF80000010000 -l 2000") == 4);
+
+	std::string log = t.GetLogLines();
+
+	CHECK(log.find("FFFFF80000011FF0  FF FF FF FF") != std::string::npos);
+	CHECK(log.find("FFFFF80000011000  00 00 00 00") != std::string::npos);
+
+	// 1KB across a page boundary: one chunk on each side.
+
+	t.Type("DB FFFFF80000010F00 -l 400");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(Reads(t, "DB FFFFF80000010F00 -l 400") == 2);
+	CHECK(t.GetLogLines().find("FFFFF800000112F0  2F 2F 2F 2F") != std::string::npos);
+
+	CHECK(t.PageCrossingReads == 0);
+
+	// a kernel returning at most 512 bytes for each request: the chunks are continued from where the response stopped,
+	// and the next windows are not larger than the response.
+
+	t.ReadTransferMax = 512;
+
+	t.Type("DB FFFFF80000012000 -l 1000");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(Reads(t, "DB FFFFF80000012000 -l 1000") == 8);
+	CHECK(t.GetCmd("DB FFFFF80000012000 -l 1000")->counters.largestRead == 512);
+
+	log = t.GetLogLines();
+
+	CHECK(log.find("FFFFF80000012800  80 80 80 80") != std::string::npos);
+	CHECK(log.find("FFFFF80000012FF0  FF FF FF FF") != std::string::npos);
+
+	t.ReadTransferMax = PACKET_MAX_SIZE;
+
+	// the second page is not mapped: the whole read fails, and no more chunks are requested after the failed one. The size learned
+	// above was forgotten at the continue request: the first page is read in full-size windows.
+
+	t.Type("DB FFFFF80000400000 -l 2000");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(Reads(t, "DB FFFFF80000400000 -l 2000") == 3); // the first page in two windows, then the failed one.
+	CHECK(t.GetCmd("DB FFFFF80000400000 -l 2000")->counters.largestRead > 512);
+
+	log = t.GetLogLines();
+
+	CHECK(log.find("Unable to read memory.") != std::string::npos);
+	CHECK(log.find("FFFFF80000400000  00 00 00 00") == std::string::npos);
+
+	return Finish();
+}
@@ -0,0 +1,166 @@
+#include "TestUtils.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "Root.h"
+
+//
+// DbgPrint from all the processors at the same time: one host thread for each processor calls KdSendPacket, as a chatty
+// driver does, then a break in drains the rings in the log window. The cost of a message is compared with the cost of
+// LogWnd::AddString, which was called for each message before the rings.
+//
+
+static constexpr ULONG RoundsNum = 200;
+static constexpr ULONG MsgsPerRound = 1000; // for each processor: less than a ring can hold.
+static constexpr ULONG NoisyEvery = 10; // one message out of 10 is muted.
+
+struct Producer
+{
+	SimTarget* target;
+	ULONG processor;
+	ULONG first;
+	ULONG num;
+};
+
+static void* ProducerThread(void* param) // no C++ library allocations here: the operator new of BugChecker needs a PCR.
+{
+	Producer* p = (Producer*)param;
+
+	CHAR msg[64];
+
+	for (ULONG i = p->first; i < p->first + p->num; i++)
+	{
+		if (i % NoisyEvery == NoisyEvery - 1)
+			::sprintf(msg, "Noisy: %u\n", i);
+		else
+			::sprintf(msg, "Cpu %u msg %u\n", p->processor, i);
+
+		p->target->DebugPrint(p->processor, msg);
+	}
+
+	return NULL;
+}
+
+static VOID RunProducers(SimTarget& t, ULONG first, ULONG num)
+{
+	pthread_t threads[SimTarget::ProcessorsNum];
+	Producer producers[SimTarget::ProcessorsNum];
+
+	for (ULONG p = 0; p < SimTarget::ProcessorsNum; p++)
+	{
+		producers[p] = { &t, p, first, num };
+		::pthread_create(&threads[p], NULL, ProducerThread, &producers[p]);
+	}
+
+	for (ULONG p = 0; p < SimTarget::ProcessorsNum; p++)
+		::pthread_join(threads[p], NULL);
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x10);
+
+	t.Type("DBGPRINT -mute noisy");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(!::strcmp(Root::I->DbgPrints.GetFilter(0), "noisy"));
+
+	// the benchmark: the producers run concurrently, the consumer only at the break ins.
+
+	double producing = 0, draining = 0;
+	ULONG lastSeen[SimTarget::ProcessorsNum];
+	BOOLEAN ordered = TRUE;
+
+	for (ULONG p = 0; p < SimTarget::ProcessorsNum; p++)
+		lastSeen[p] = (ULONG)-1;
+
+	for (ULONG r = 0; r < RoundsNum; r++)
+	{
+		double start = Now();
+		RunProducers(t, r * MsgsPerRound, MsgsPerRound);
+		producing += Now() - start;
+
+		start = Now();
+		t.Type("X");
+		t.BreakIn(CodeAddress);
+		draining += Now() - start;
+
+		// the messages of each processor are in the log window in the order in which they were printed.
+
+		BcCall _call_;
+
+		LogLines& lines = Root::I->LogWindow.lines;
+
+		for (ULONG i = 0; i < lines.Size(); i++)
+		{
+			ULONG cpu, n;
+
+			if (::sscanf(lines.Get(i), "Cpu %u msg %u", &cpu, &n) != 2 || cpu >= SimTarget::ProcessorsNum)
+				continue;
+
+			if (n < r * MsgsPerRound)
+				continue; // a previous round.
+
+			if (lastSeen[cpu] != (ULONG)-1 && n <= lastSeen[cpu])
+				ordered = FALSE;
+
+			lastSeen[cpu] = n;
+		}
+	}
+
+	CHECK(ordered);
+
+	for (ULONG p = 0; p < SimTarget::ProcessorsNum; p++)
+		CHECK(lastSeen[p] == RoundsNum * MsgsPerRound - 2); // the last message is muted.
+
+	const ULONG sent = RoundsNum * MsgsPerRound * SimTarget::ProcessorsNum;
+	const ULONG muted = sent / NoisyEvery;
+
+	DbgPrintRing& ring = Root::I->DbgPrints;
+
+	CHECK(ring.Perf_MsgsNum == sent - muted);
+	CHECK(ring.Perf_FilteredNum == muted);
+	CHECK(ring.Perf_DroppedNum == 0);
+	CHECK(t.GetLogLines().find("Noisy") == std::string::npos);
+
+	::printf("%u producers, %u messages: %.1f ns per message (wall clock), drained in %.3f s.\n",
+		SimTarget::ProcessorsNum, sent, producing * 1e9 / sent, draining);
+
+	// the rings are bounded: without a break in, the messages that don't fit are counted and the user is told.
+
+	RunProducers(t, 0, 10 * MsgsPerRound);
+
+	CHECK(ring.Perf_DroppedNum > 0);
+	CHECK(ring.Perf_MsgsNum + ring.Perf_FilteredNum + ring.Perf_DroppedNum == sent + 10 * MsgsPerRound * SimTarget::ProcessorsNum);
+
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(t.GetLogLines().find("DbgPrint message(s) dropped") != std::string::npos);
+
+	// the path before the rings: a LogWnd::AddString for each message, on the printing processor.
+
+	{
+		BcCall _call_;
+
+		CHAR msg[64];
+
+		double start = Now();
+
+		for (ULONG i = 0; i < sent; i++)
+		{
+			::sprintf(msg, "Cpu 0 msg %u", i);
+			Root::I->LogWindow.AddString(msg);
+		}
+
+		double elapsed = Now() - start;
+
+		::printf("LogWnd::AddString: %.1f ns per message (single producer).\n", elapsed * 1e9 / sent);
+	}
+
+	return Finish();
+}
@@ -0,0 +1,176 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Cmd.h"
+#include "Root.h"
+
+//
+// A trace of 1000 single steps ("T") in a loop of canned instructions: the instructions are decoded once and then taken from the
+// decode cache at each state change and by the disassembler window. Then the cost of a lookup against a decoding, and the
+// invalidation of the cache when the code is modified by EB or by the target.
+//
+
+static constexpr ULONG64 LoopAddress = CodeAddress + 0x100; // after the hardcoded INT3 at LoopAddress - 1.
+
+static constexpr ULONG StepsNum = 1000;
+
+static const BYTE Loop[] =
+{
+	0x48, 0x83, 0xC0, 0x01, // add rax, 1
+	0x48, 0xFF, 0xC1, // inc rcx
+	0x48, 0x31, 0xD2, // xor rdx, rdx
+	0x90, // nop
+	0x48, 0x85, 0xC0, // test rax, rax
+	0xEB, 0xF0, // jmp LoopAddress
+};
+
+static std::string ScreenLineAt(SimTarget& t, ULONG64 address) // the line of the disassembler window of the address, in lowercase.
+{
+	CHAR addr[32];
+	::sprintf(addr, "%llX", address);
+
+	for (ULONG y = 0; y < 100; y++)
+	{
+		std::string line = t.GetScreenLine(y);
+
+		if (line.find(addr) != std::string::npos && line.find("0010:") != std::string::npos)
+		{
+			std::transform(line.begin(), line.end(), line.begin(), ::tolower);
+			return line;
+		}
+	}
+
+	return "";
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x200);
+
+	const BYTE int3 = 0xCC;
+	t.Write(LoopAddress - 1, &int3, 1);
+	t.Write(LoopAddress, Loop, sizeof(Loop));
+
+	t.Type("PERF -reset");
+	t.Type("X");
+	t.BreakIn(LoopAddress - 1);
+
+	// the trace: each T is a state change, followed by the drawing of the interface.
+
+	for (ULONG i = 0; i < StepsNum; i++)
+		t.Type("T");
+	t.Type("X");
+
+	double start = Now();
+
+	t.BreakIn(LoopAddress - 1);
+	ULONG64 steps = t.Run(StepsNum + 1);
+
+	double traceTime = Now() - start;
+
+	CHECK(steps == StepsNum);
+	CHECK(t.Context[0].Rip == LoopAddress + 11); // 1000 % 6 = 4: "test rax, rax".
+
+	ULONG64 hits, misses;
+
+	{
+		BcCall _call_;
+
+		hits = Root::I->DecodedInstrs.Perf_HitsNum;
+		misses = Root::I->DecodedInstrs.Perf_MissesNum;
+	}
+
+	// the misses are the instructions seen for the first time (the loop and the ones after it, shown by the window):
+	// they don't grow with the number of steps.
+
+	CHECK(misses < 64);
+	CHECK(hits > StepsNum * 2);
+
+	::printf("Trace of %u steps: %.0f us per step, decode cache %llu hits and %llu misses (%.1f decodings per step).\n",
+		StepsNum, traceTime * 1e6 / (StepsNum + 1), hits, misses, (double)misses / StepsNum);
+
+	// the cost of the lookup, against the decoding of the same instructions, in the order of the trace.
+
+	std::vector<ULONG> offsets;
+
+	for (ULONG i = 0, o = 0; i < StepsNum; i++)
+	{
+		offsets.push_back(o);
+		o = o == 14 ? 0 : o + (o == 0 ? 4 : o == 10 ? 1 : 3);
+	}
+
+	{
+		BcCall _call_;
+
+		ZydisDecodedInstruction instr;
+		ZydisDecodedOperand ops[ZYDIS_MAX_OPERAND_COUNT_VISIBLE];
+
+		ULONG rounds = 100;
+		ULONG lengths = 0;
+
+		ULONG64 lookupHits = Root::I->DecodedInstrs.Perf_HitsNum;
+		ULONG64 lookupMisses = Root::I->DecodedInstrs.Perf_MissesNum;
+
+		start = Now();
+
+		for (ULONG r = 0; r < rounds; r++)
+			for (ULONG o : offsets)
+				if (Root::I->DecodedInstrs.Decode(LoopAddress + o, FALSE, Loop + o, sizeof(Loop) - o, instr, ops))
+					lengths += instr.length;
+
+		double cacheTime = (Now() - start) / (rounds * StepsNum);
+
+		lookupHits = Root::I->DecodedInstrs.Perf_HitsNum - lookupHits;
+		lookupMisses = Root::I->DecodedInstrs.Perf_MissesNum - lookupMisses;
+
+		ZydisDecoder decoder;
+		::ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
+
+		start = Now();
+
+		for (ULONG r = 0; r < rounds; r++)
+			for (ULONG o : offsets)
+				if (ZYAN_SUCCESS(::ZydisDecoderDecodeFull(&decoder, Loop + o, sizeof(Loop) - o, &instr, ops, ZYDIS_MAX_OPERAND_COUNT_VISIBLE, ZYDIS_DFLAG_VISIBLE_OPERANDS_ONLY)))
+					lengths -= instr.length;
+
+		double decodeTime = (Now() - start) / (rounds * StepsNum);
+
+		CHECK(lengths == 0); // the cached instructions are the decoded ones.
+		CHECK(lookupHits == rounds * StepsNum && lookupMisses == 0); // the times are only printed: no decoding for the lookups.
+
+		::printf("Instruction: %.0f ns from the cache, %.0f ns decoded.\n", cacheTime * 1e9, decodeTime * 1e9);
+	}
+
+	// EB writes the memory through KD: the instruction at PC is decoded again ("add rax, 1" becomes "sub rax, 1").
+
+	CHAR cmd[128];
+	::sprintf(cmd, "EB %llX -v 48 83 E8 01", LoopAddress);
+
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(LoopAddress - 1);
+
+	t.Type("X");
+	t.BreakIn(LoopAddress - 1);
+
+	CHECK(ScreenLineAt(t, LoopAddress).find("sub") != std::string::npos);
+
+	// the target modifies its code: the bytes differ from the cached ones ("inc rcx" becomes "dec rcx").
+
+	const BYTE dec[] = { 0x48, 0xFF, 0xC9 };
+	t.Write(LoopAddress + 4, dec, sizeof(dec));
+
+	t.Type("X");
+	t.BreakIn(LoopAddress - 1);
+
+	CHECK(ScreenLineAt(t, LoopAddress + 4).find("dec") != std::string::npos);
+
+	return Finish();
+}
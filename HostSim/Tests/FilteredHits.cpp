@@ -0,0 +1,216 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <string>
+
+#include "Cmd.h"
+#include "Root.h"
+#include "Platform.h"
+
+//
+// The thread and process filters of the breakpoints (-kt and -kp) on shared code hit by another processor: the KD round-trips of
+// each discarded hit, against a hit of a breakpoint without filters, and the break-in when the filter matches.
+//
+
+extern int MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB;
+
+static constexpr ULONG64 ThreadBpAddress = CodeAddress + 0x10; // BPX -kt.
+static constexpr ULONG64 ProcessBpAddress = CodeAddress + 0x20; // BPX -kp.
+
+static constexpr ULONG64 ProcessA = 0xFFFFE00000A00000; // the process of the thread of processor 0.
+static constexpr ULONG64 ProcessB = 0xFFFFE00000B00000; // the one of processor 1.
+
+static constexpr ULONG HitsNum = 500;
+
+struct HitsResult
+{
+	ULONG64 roundTrips; // of the hits and of their re-arm steps.
+	ULONG64 filterRoundTrips;
+	ULONG64 filtered;
+	ULONG notStepped; // hits that broke in.
+};
+
+static HitsResult Hit(SimTarget& t, ULONG64 address)
+{
+	ULONG64 filterRoundTrips, filtered;
+
+	{
+		BcCall _call_;
+		filterRoundTrips = Root::I->Perf_BpFilterRoundTripsNum;
+		filtered = Root::I->Perf_BpFilteredNum;
+	}
+
+	HitsResult r = { t.Total.roundTrips, 0, 0, 0 };
+
+	for (ULONG i = 0; i < HitsNum; i++)
+	{
+		t.Context[t.CurrentProcessor].Rip = address;
+
+		t.HitBreakPoint(address);
+
+		if (!t.LastTraceFlag)
+		{
+			r.notStepped++;
+			break;
+		}
+
+		t.Run(1);
+	}
+
+	r.roundTrips = t.Total.roundTrips - r.roundTrips;
+
+	{
+		BcCall _call_;
+		r.filterRoundTrips = Root::I->Perf_BpFilterRoundTripsNum - filterRoundTrips;
+		r.filtered = Root::I->Perf_BpFilteredNum - filtered;
+	}
+
+	return r;
+}
+
+// a test command: the current process, with the KD round-trips spent to get it.
+
+static ULONG64 EprocValue = 0;
+static ULONG64 EprocRoundTrips = 0;
+static ULONG64 EprocFirstRoundTrips = 0; // of the first EPROC of the state change.
+static ULONG64 EprocStateChange = 0;
+static ULONG64 EprocCalls = 0;
+
+class Cmd_EPROC : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "EPROC"; }
+	virtual const CHAR* GetDesc() { return "Gets the current process."; }
+	virtual const CHAR* GetSyntax() { return "EPROC"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		ULONG64 roundTrips = Root::I->Perf_KdRoundTripsNum;
+
+		co_await BcAwaiter_Join{ Platform::GetCurrentEprocess(EprocValue) };
+
+		EprocRoundTrips = Root::I->Perf_KdRoundTripsNum - roundTrips;
+
+		if (EprocStateChange != Root::I->Perf_BreakInsNum) // incremented at each state change.
+		{
+			EprocStateChange = Root::I->Perf_BreakInsNum;
+			EprocFirstRoundTrips = EprocRoundTrips;
+		}
+
+		EprocCalls++;
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_EPROC)
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x40);
+
+	// the current threads of processors 0 and 1, and their processes.
+
+	ULONG64 threads[2] = {};
+
+	for (ULONG p = 0; p < 2; p++)
+	{
+		t.CurrentProcessor = p;
+
+		t.Type("X");
+		t.BreakIn(CodeAddress);
+
+		BcCall _call_;
+		threads[p] = Root::I->StateChange.Thread;
+	}
+
+	CHECK(threads[0] && threads[1] && threads[0] != threads[1]);
+
+	t.Write(threads[0] + MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB, &ProcessA, sizeof(ProcessA));
+	t.Write(threads[1] + MACRO_KPEBPTR_FIELDOFFSET_IN_KTEB, &ProcessB, sizeof(ProcessB));
+
+	// the breakpoints, set on processor 0: one for its thread, one for its process, one without filters that doesn't break in.
+
+	CHAR cmd[256];
+
+	t.CurrentProcessor = 0;
+
+	::sprintf(cmd, "BPX %llX -kt %llX", ThreadBpAddress, threads[0]);
+	t.Type(cmd);
+	::sprintf(cmd, "BPX %llX -kp %llX", ProcessBpAddress, ProcessA);
+	t.Type(cmd);
+	::sprintf(cmd, "BPL %llX \"%%x\" rax", CodeAddress + 0x30);
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	// the hits on processor 1: the filters discard them.
+
+	t.CurrentProcessor = 1;
+
+	HitsResult byThread = Hit(t, ThreadBpAddress);
+	HitsResult byProcess = Hit(t, ProcessBpAddress);
+	HitsResult logpoint = Hit(t, CodeAddress + 0x30);
+
+	CHECK(!byThread.notStepped && !byProcess.notStepped && !logpoint.notStepped);
+
+	CHECK(byThread.filtered == HitsNum);
+	CHECK(byProcess.filtered == HitsNum);
+	CHECK(logpoint.filtered == 0);
+
+	// the thread filter compares StateChange.Thread; the process filter reads only ApcState.Process of that thread, once per state change.
+
+	CHECK(byThread.filterRoundTrips == 0);
+	CHECK(byProcess.filterRoundTrips == HitsNum);
+
+	CHECK(byThread.roundTrips <= logpoint.roundTrips);
+	CHECK(byProcess.roundTrips == byThread.roundTrips + HitsNum);
+
+	::printf("Round-trips per discarded hit: %.2f with -kt (%.2f for the filter), %.2f with -kp (%.2f for the filter); %.2f for a logpoint hit.\n",
+		(double)byThread.roundTrips / HitsNum, (double)byThread.filterRoundTrips / HitsNum,
+		(double)byProcess.roundTrips / HitsNum, (double)byProcess.filterRoundTrips / HitsNum,
+		(double)logpoint.roundTrips / HitsNum);
+
+	// the hits on processor 0 break in and run the typed commands. The process read by the filter is reused by the commands of the
+	// same state change.
+
+	t.CurrentProcessor = 0;
+
+	ULONG64 eprocCalls = EprocCalls;
+
+	t.Type("EPROC");
+	t.Type("X");
+	t.Context[0].Rip = ThreadBpAddress;
+	t.HitBreakPoint(ThreadBpAddress);
+
+	CHECK(EprocCalls == eprocCalls + 1);
+	CHECK(EprocValue == ProcessA && EprocRoundTrips == 1);
+
+	t.Run(1);
+
+	t.Type("EPROC");
+	t.Type("X");
+	t.Context[0].Rip = ProcessBpAddress;
+	t.HitBreakPoint(ProcessBpAddress);
+
+	CHECK(EprocCalls == eprocCalls + 2);
+	CHECK(EprocValue == ProcessA && EprocRoundTrips == 0);
+
+	t.Run(1);
+
+	// without a filter, the first command reads it and the second one doesn't.
+
+	t.Type("EPROC");
+	t.Type("EPROC");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(EprocCalls == eprocCalls + 4);
+	CHECK(EprocValue == ProcessA && EprocFirstRoundTrips == 1 && EprocRoundTrips == 0);
+
+	return Finish();
+}
@@ -0,0 +1,175 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "Cmd.h"
+#include "Root.h"
+
+//
+// The pool of the coroutine frames: its LIFO order and its fallback to the heap, then the allocations of each state change of
+// a logpoint and of a break-in session, i.e. the arena allocations that remain and those that the frames would have made.
+//
+
+static constexpr ULONG64 BplAddress = CodeAddress + 0x10;
+
+static constexpr ULONG HitsNum = 500;
+
+struct AllocsResult
+{
+	ULONG64 stateChanges;
+	ULONG64 arenaAllocs; // Allocator::Perf_AllocCallsNum.
+	ULONG64 poolFrames;
+	ULONG64 heapFrames;
+	LONG64 liveAllocs; // the arena allocations not freed.
+};
+
+static AllocsResult Snapshot()
+{
+	BcCall _call_;
+
+	return { Root::I->Perf_BreakInsNum, Allocator::Perf_AllocCallsNum, BcFramePool::Perf_PoolAllocsNum, BcFramePool::Perf_HeapAllocsNum,
+		(LONG64)Allocator::Perf_AllocationsNum };
+}
+
+static AllocsResult Delta(const AllocsResult& start)
+{
+	AllocsResult end = Snapshot();
+
+	return { end.stateChanges - start.stateChanges, end.arenaAllocs - start.arenaAllocs, end.poolFrames - start.poolFrames,
+		end.heapFrames - start.heapFrames, end.liveAllocs - start.liveAllocs };
+}
+
+static VOID TestPool()
+{
+	BcCall _call_;
+
+	// the frames freed out of order are released with the frames above them.
+
+	VOID* a = BcFramePool::Alloc(40);
+	VOID* b = BcFramePool::Alloc(100);
+	VOID* c = BcFramePool::Alloc(8);
+
+	CHECK(((ULONG_PTR)a & 15) == 0 && (BYTE*)b >= (BYTE*)a + 48 && (BYTE*)c >= (BYTE*)b + 112);
+
+	BcFramePool::Free(b);
+
+	VOID* d = BcFramePool::Alloc(8);
+	CHECK(d > c); // b is still below c.
+
+	BcFramePool::Free(d);
+	BcFramePool::Free(c);
+
+	VOID* e = BcFramePool::Alloc(8);
+	CHECK(e == b); // c, d and b popped.
+
+	BcFramePool::Free(e);
+	BcFramePool::Free(a);
+
+	CHECK(BcFramePool::Alloc(16) == a);
+	BcFramePool::Free(a);
+
+	// a full pool: the frame comes from the heap, and the pool is reused when the frames are freed.
+
+	ULONG64 heapFrames = BcFramePool::Perf_HeapAllocsNum;
+
+	std::vector<VOID*> frames;
+
+	while (BcFramePool::Perf_HeapAllocsNum == heapFrames)
+		frames.push_back(BcFramePool::Alloc(4000));
+
+	CHECK(frames.size() == BcFramePool::PoolSize / (4000 + BcFramePool::HeaderSize) + 1);
+
+	VOID* heapFrame = frames.back();
+	frames.pop_back();
+
+	CHECK(heapFrame < a || heapFrame >= (BYTE*)a + BcFramePool::PoolSize);
+
+	BcFramePool::Free(heapFrame);
+
+	while (frames.size())
+	{
+		BcFramePool::Free(frames.back());
+		frames.pop_back();
+	}
+
+	CHECK(BcFramePool::Alloc(16) == a);
+	BcFramePool::Free(a);
+}
+
+static AllocsResult HitBpl(SimTarget& t)
+{
+	AllocsResult start = Snapshot();
+
+	for (ULONG i = 0; i < HitsNum; i++)
+	{
+		t.Context[0].Rip = BplAddress;
+		t.Context[0].Rax = i;
+
+		t.HitBreakPoint(BplAddress);
+		CHECK(t.LastTraceFlag);
+
+		t.Run(1);
+	}
+
+	return Delta(start);
+}
+
+static VOID Print(const CHAR* what, const AllocsResult& r)
+{
+	double n = (double)r.stateChanges;
+
+	::printf("%s: %.1f arena allocations per state change with the pool, %.1f without (%.1f frames).\n",
+		what, r.arenaAllocs / n, (r.arenaAllocs + r.poolFrames + r.heapFrames) / n, (r.poolFrames + r.heapFrames) / n);
+}
+
+int main()
+{
+	SimTarget t;
+
+	TestPool();
+
+	WriteCode(t, 0x40);
+
+	CHAR cmd[256];
+
+	::sprintf(cmd, "BPL %llX \"%%x\" rax", BplAddress);
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	// the hits of a logpoint: the frames of the state change and of the re-arm step come from the pool. The first batch fills
+	// the caches of BugChecker; the second one must not leak.
+
+	AllocsResult warmup = HitBpl(t);
+	AllocsResult hits = HitBpl(t);
+
+	CHECK(warmup.stateChanges == HitsNum * 2 && hits.stateChanges == HitsNum * 2);
+	CHECK(hits.heapFrames == 0);
+	CHECK(hits.poolFrames >= hits.stateChanges);
+	CHECK(hits.liveAllocs == 0);
+
+	Print("Logpoint", hits);
+
+	// a break-in with some commands.
+
+	AllocsResult start = Snapshot();
+
+	::sprintf(cmd, "U %llX", CodeAddress);
+	t.Type(cmd);
+	t.Type("R");
+	t.Type("STACK");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	AllocsResult session = Delta(start);
+
+	CHECK(session.stateChanges == 1);
+	CHECK(session.heapFrames == 0);
+	CHECK(session.poolFrames > 0);
+
+	Print("Break-in with U, R and STACK", session);
+
+	return Finish();
+}
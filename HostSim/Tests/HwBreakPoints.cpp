@@ -0,0 +1,182 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <string>
+
+#include "Cmd.h"
+#include "Root.h"
+
+//
+// Hardware breakpoints on the simulated target: the debug registers written in the control space of each processor and in the
+// DR7 of the continue requests, one debugger entry per hit of a hardware logpoint (against two for a software one, whose
+// hit is followed by the single step that writes it again), the counters of PERF, RF at PC when the stop was caused by
+// something else, a data breakpoint and BC.
+//
+
+static constexpr ULONG64 HwAddress = CodeAddress + 0x10;
+static constexpr ULONG64 SwAddress = CodeAddress + 0x20;
+static constexpr ULONG64 DataAddress = 0xFFFFF88000020000;
+
+static constexpr ULONG KernelDr0Offset = 0x20; // in KSPECIAL_REGISTERS, after Cr0, Cr2, Cr3 and Cr4.
+
+static constexpr ULONG HitsNum = 1000;
+
+static VOID Execute(SimTarget& t, const CHAR* cmd)
+{
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+}
+
+static ULONG64 GetDr(SimTarget& t, ULONG processor, ULONG index)
+{
+	return *(ULONG64*)&t.ControlSpace[processor][KernelDr0Offset + index * 8];
+}
+
+struct HitsResult
+{
+	ULONG64 entries; // KD sessions: the hits and the single steps.
+	ULONG64 roundTrips;
+};
+
+static HitsResult Hit(SimTarget& t, ULONG64 address, LONG drIndex)
+{
+	HitsResult r = { 0, t.Total.roundTrips };
+
+	for (ULONG i = 0; i < HitsNum; i++)
+	{
+		t.Context[0].Rip = address;
+		t.Context[0].Rax = i;
+		t.Context[0].EFlags = 0x202;
+
+		if (drIndex >= 0)
+		{
+			t.HitHwBreakPoint(address, drIndex);
+
+			CHECK(t.Context[0].EFlags & 0x10000); // RF: the instruction is executed without hitting the breakpoint again.
+		}
+		else
+		{
+			t.HitBreakPoint(address);
+		}
+
+		r.entries += 1 + t.Run(1);
+	}
+
+	r.roundTrips = t.Total.roundTrips - r.roundTrips;
+
+	return r;
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x40);
+
+	CHAR cmd[256];
+
+	// a hardware logpoint: nothing is written in memory, DR0 and DR7 are set on every processor.
+
+	::sprintf(cmd, "BPL %llX -hw \"hw %%x\" rax", HwAddress);
+	Execute(t, cmd);
+
+	CHECK(t.KdBreakPointsNum() == 0);
+
+	for (ULONG p = 0; p < SimTarget::ProcessorsNum; p++)
+		CHECK(GetDr(t, p, 0) == HwAddress);
+
+	CHECK((t.LastDr7 & 0x3) == 0x1); // L0.
+	CHECK(((t.LastDr7 >> 16) & 0xF) == 0); // execute, 1 byte.
+
+	// the same logpoint in memory.
+
+	::sprintf(cmd, "BPL %llX \"sw %%x\" rax", SwAddress);
+	Execute(t, cmd);
+
+	CHECK(t.KdBreakPointsNum() == 1);
+
+	Execute(t, "PERF -reset");
+
+	HitsResult sw = Hit(t, SwAddress, -1);
+	HitsResult hw = Hit(t, HwAddress, 0);
+
+	CHECK(hw.entries == HitsNum);
+	CHECK(sw.entries == HitsNum * 2);
+	CHECK(hw.roundTrips < sw.roundTrips);
+
+	::printf("Hardware logpoint: %.2f entries and %.2f round trips per hit.\n", (double)hw.entries / HitsNum, (double)hw.roundTrips / HitsNum);
+	::printf("Software logpoint: %.2f entries and %.2f round trips per hit.\n", (double)sw.entries / HitsNum, (double)sw.roundTrips / HitsNum);
+
+	t.Type("PERF");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	::sprintf(cmd, "Breakpoint hits: %u software (%u re-arm steps, 2.00 entries per hit), %u hardware (1 entry per hit).", HitsNum, HitsNum, HitsNum);
+	CHECK(t.GetLogLines().find(cmd) != std::string::npos);
+
+	std::string log = t.GetLogLines();
+	::sprintf(cmd, "hw %x", HitsNum - 1);
+	CHECK(log.find(cmd) != std::string::npos);
+	::sprintf(cmd, "sw %x", HitsNum - 1);
+	CHECK(log.find(cmd) != std::string::npos);
+
+	// a single step that stops at the hardware logpoint: RF is set, otherwise the processor would stop again at the same PC
+	// instead of executing the instruction.
+
+	t.Context[0].Rip = HwAddress;
+	t.Context[0].EFlags = 0x202;
+	t.Type("X");
+	t.SingleStep();
+
+	CHECK(t.Context[0].EFlags & 0x10000);
+
+	// PC moved to the hardware logpoint by a command during a break-in.
+
+	t.Context[0].EFlags = 0x202;
+
+	::sprintf(cmd, "R RIP -v %llX", HwAddress);
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(t.Context[0].Rip == HwAddress);
+	CHECK(t.Context[0].EFlags & 0x10000);
+
+	// a data breakpoint on DR1: a write of 4 bytes, which breaks in.
+
+	::sprintf(cmd, "BPM %llX -w -l 4", DataAddress);
+	Execute(t, cmd);
+
+	for (ULONG p = 0; p < SimTarget::ProcessorsNum; p++)
+		CHECK(GetDr(t, p, 1) == DataAddress);
+
+	CHECK((t.LastDr7 & 0xC) == 0x4); // L1.
+	CHECK(((t.LastDr7 >> 20) & 0xF) == 0xD); // LEN1 = 4 bytes (11b), RW1 = write (01b).
+
+	t.Context[0].Rip = CodeAddress + 0x30; // the instruction after the write.
+	t.Context[0].EFlags = 0x202;
+	t.Type("X");
+	t.HitHwBreakPoint(CodeAddress + 0x30, 1);
+
+	CHECK(t.GetLogLines().find("Break due to BPM") != std::string::npos);
+	CHECK(!(t.Context[0].EFlags & 0x10000)); // data breakpoints are traps.
+
+	// BC removes all of them: DR7 is cleared, and so is the software breakpoint in memory.
+
+	t.Type("BC *");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK((t.LastDr7 & 0xFF) == 0);
+	CHECK(t.KdBreakPointsNum() == 0);
+
+	{
+		BcCall _call_;
+		CHECK(Root::I->BreakPoints.size() == 0);
+		CHECK(Root::I->BreakPoints.GetFreeDrIndex() == 0);
+	}
+
+	return Finish();
+}
@@ -0,0 +1,97 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+//
+// Round trips of the KD protocol: a break in, a memory dump, a breakpoint set and hit, then the continue.
+//
+
+static constexpr ULONG64 DataAddress = 0xFFFFF80000002000;
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x40);
+
+	BYTE data[0x100];
+	for (int i = 0; i < (int)sizeof(data); i++) data[i] = (BYTE)i;
+	t.Write(DataAddress, data, sizeof(data));
+
+	// first session: the dump is answered by one read of the displayed bytes, the breakpoint is written at the continue.
+
+	t.Type("DB FFFFF80000002000");
+	t.Type("EB FFFFF80000002000 -v AA BB");
+	t.Type("R RAX -v 1234");
+	t.Type("BPX FFFFF80000001010");
+	t.Type("X");
+
+	t.BreakIn(CodeAddress);
+
+	CHECK(t.LastContinueApi != 0);
+	CHECK(t.Total.packetsSent > 0 && t.Total.packetsReceived > 0);
+	CHECK(t.Total.roundTrips + 0 == t.Total.packetsSent - 1); // the state change packet is not a round trip.
+
+	BYTE b = 0;
+
+	const SimTarget::CmdCounters* db = t.GetCmd("DB FFFFF80000002000");
+	CHECK(db != NULL);
+
+	if (db)
+	{
+		::printf("DB: %llu round trips, %llu bytes read.\n", db->counters.roundTrips, db->counters.bytesRead);
+
+		CHECK(db->counters.roundTrips >= 1);
+		CHECK(db->counters.byApi.count(DbgKdReadVirtualMemoryApi));
+		CHECK(db->counters.bytesRead >= 0x10);
+	}
+
+	CHECK(t.GetLogLines().find("FFFFF80000002000  00 01 02 03") != std::string::npos);
+
+	// the writes: memory with WriteVirtualMemory and the register with SetContext.
+
+	t.Read(DataAddress, &b, 1);
+	CHECK(b == 0xAA);
+
+	const SimTarget::CmdCounters* eb = t.GetCmd("EB FFFFF80000002000 -v AA BB");
+	CHECK(eb && eb->counters.byApi.count(DbgKdWriteVirtualMemoryApi));
+
+	const SimTarget::CmdCounters* r = t.GetCmd("R RAX -v 1234");
+	CHECK(r && r->counters.byApi.count(DbgKdSetContextApi));
+	CHECK(t.Context[0].Rax == 0x1234);
+
+	CHECK(t.KdBreakPointsNum() == 1);
+
+	t.Read(CodeAddress + 0x10, &b, 1);
+	CHECK(b == 0xCC);
+
+	// second session: the breakpoint hit; KD deletes it before reporting the exception.
+
+	t.Type("X");
+
+	t.HitBreakPoint(CodeAddress + 0x10);
+
+	t.Read(CodeAddress + 0x10, &b, 1);
+	CHECK(b == 0x90);
+
+	// BugChecker steps over the instruction and writes the breakpoint again in the single step session.
+
+	CHECK(t.LastTraceFlag);
+	CHECK(t.Run(1) == 1);
+	CHECK(!t.LastTraceFlag);
+
+	t.Read(CodeAddress + 0x10, &b, 1);
+	CHECK(b == 0xCC);
+	CHECK(t.Context[0].Rip == CodeAddress + 0x11);
+
+	const SimTarget::CmdCounters* x = t.GetCmd("X");
+	CHECK(x != NULL);
+
+	::printf("Total: %llu packets sent, %llu received, %llu round trips, %llu timeouts.\n",
+		t.Total.packetsSent, t.Total.packetsReceived, t.Total.roundTrips, t.Total.timeouts);
+
+	for (auto& c : t.Cmds)
+		::printf("  %-24s %6llu round trips\n", c.cmd.c_str(), c.counters.roundTrips);
+
+	return Finish();
+}
@@ -0,0 +1,208 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include "Root.h"
+
+//
+// The KD packet trace: the events in the ring, their csv encoding, the latency histograms, and the trace of a simulated
+// session dumped by PERF -dump.
+//
+
+static constexpr ULONG64 DataAddress = 0xFFFFF80000010000;
+
+struct NopAwaiter : BcAwaiterRetVal<NoReturnValue> // an awaiter that is never prepared, for the awaiter type of the events.
+{
+	virtual ProcessAwaiterRetVal Prepare(DBGKD_MANIPULATE_STATE64* pState, PKD_BUFFER SecondBuffer, PULONG PayloadBytes) { return ProcessAwaiterRetVal::Ok; }
+	virtual BcAwaiterType GetType() { return BcAwaiterType::ReadMemoryBatch; }
+};
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x10);
+
+	static BYTE data[0x2000];
+	t.Write(DataAddress, data, sizeof(data));
+
+	{
+		BcCall _call_;
+
+		// the ring: after more events than it can hold, it has the newest ones, from the oldest.
+
+		KdTrace trace;
+
+		BYTE buffer[0x100];
+		KD_BUFFER second = {};
+		second.MaxLength = sizeof(buffer);
+		second.pData = buffer;
+
+		const ULONG eventsNum = KdTrace::EventsNum * 2 + 100;
+
+		for (ULONG i = 0; i < eventsNum; i++)
+		{
+			second.Length = (USHORT)(i & 0xFF);
+			trace.Add(i & 1, KdPacketType2_Ie_StateManipulate, 0x3100 + (i & 0x3F), i % 3 ? &second : NULL);
+		}
+
+		CHECK(trace.Size() == KdTrace::EventsNum);
+
+		BOOLEAN ordered = TRUE;
+
+		for (ULONG j = 0; j < trace.Size(); j++)
+		{
+			const KdTrace::Event& e = trace.Get(j);
+			ULONG i = eventsNum - KdTrace::EventsNum + j;
+
+			if (e.isSend != (i & 1) ||
+				e.packetType != KdPacketType2_Ie_StateManipulate ||
+				e.apiNumber != 0x3100 + (i & 0x3F) ||
+				e.bytes != (i % 3 ? (i & 0xFF) : 0) ||
+				e.awaiterType != BcAwaiterType::None ||
+				(j && e.tsc < trace.Get(j - 1).tsc))
+			{
+				ordered = FALSE;
+			}
+		}
+
+		CHECK(ordered);
+
+		// the awaiter of the event is the one that the debugger is waiting on.
+
+		NopAwaiter awaiter;
+
+		trace.Clear();
+		CHECK(trace.Size() == 0);
+
+		Root::I->AwaiterPtr = &awaiter;
+		trace.Add(FALSE, KdPacketType2_Ie_StateManipulate, DbgKdReadVirtualMemoryApi, &second);
+		Root::I->AwaiterPtr = NULL;
+		trace.Add(TRUE, KdPacketType7_Ie_StateChange64, DbgKdExceptionStateChange, NULL);
+
+		CHECK(trace.Size() == 2);
+		CHECK(trace.Get(0).awaiterType == BcAwaiterType::ReadMemoryBatch);
+		CHECK(trace.Get(1).awaiterType == BcAwaiterType::None);
+
+		// the csv encoding: tsc,delta,direction,packet type,api,bytes,awaiter.
+
+		KdTrace::Event e = {};
+
+		e.tsc = 1000500;
+		e.packetType = KdPacketType2_Ie_StateManipulate;
+		e.apiNumber = DbgKdReadVirtualMemoryApi;
+		e.bytes = 0xF68;
+		e.isSend = TRUE;
+		e.awaiterType = BcAwaiterType::ReadMemory;
+
+		CHAR line[128];
+
+		KdTrace::Format(line, e, 1000000);
+		CHECK(!::strcmp(line, "1000500,500,send,2,3130,3944,ReadMemory"));
+
+		e.isSend = FALSE;
+		e.awaiterType = BcAwaiterType::Join;
+
+		KdTrace::Format(line, e, 0); // the first event: no delta.
+		CHECK(!::strcmp(line, "1000500,0,recv,2,3130,3944,Join"));
+
+		for (BYTE type = (BYTE)BcAwaiterType::None; type <= (BYTE)BcAwaiterType::Join; type++)
+			CHECK(::strcmp(KdTrace::GetAwaiterName((BcAwaiterType)type), "None") || type == (BYTE)BcAwaiterType::None);
+
+		// the histogram: with 1000 ticks per ms, a tick is a microsecond.
+
+		ULONG64 ticksPerMs = Root::I->RdtscTicksPerMs;
+		Root::I->RdtscTicksPerMs = 1000;
+
+		LatencyHistogram h;
+
+		h.Add(0);
+		h.Add(1);
+		h.Add(3);
+		h.Add(3);
+		h.Add(1000);
+		h.Add(1ULL << 40);
+
+		CHECK(h.num == 6);
+		CHECK(h.buckets[0] == 1 && h.buckets[1] == 1 && h.buckets[2] == 2 && h.buckets[10] == 1);
+		CHECK(h.buckets[LatencyHistogram::BucketsNum - 1] == 1);
+		CHECK(h.maxTicks == 1ULL << 40);
+		CHECK(h.totalTicks == 1007 + (1ULL << 40));
+
+		CHAR histogram[256];
+
+		h.Format(histogram, sizeof(histogram));
+		CHECK(!::strcmp(histogram, "<1us:1 <2us:1 <4us:2 <1024us:1 >=4194304us:1 "));
+
+		h.Format(histogram, 20); // only the buckets that fit.
+		CHECK(!::strcmp(histogram, "<1us:1 <2us:1 "));
+
+		// the round trips: from a request to the response.
+
+		trace.Clear();
+
+		trace.Add(FALSE, KdPacketType2_Ie_StateManipulate, DbgKdReadVirtualMemoryApi, NULL);
+		trace.Add(TRUE, KdPacketType2_Ie_StateManipulate, DbgKdReadVirtualMemoryApi, NULL);
+		trace.Add(TRUE, KdPacketType7_Ie_StateChange64, DbgKdExceptionStateChange, NULL); // not a response.
+
+		CHECK(trace.RoundTrips.num == 1);
+
+		Root::I->RdtscTicksPerMs = ticksPerMs;
+	}
+
+	// a session: the dump has a request and a response for each read of the command.
+
+	t.Type("PERF -reset");
+	t.Type("DB FFFFF80000010000 -l 2000");
+	t.Type("PERF -dump");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	ULONG64 reads = t.GetCmd("DB FFFFF80000010000 -l 2000")->counters.byApi.at(DbgKdReadVirtualMemoryApi);
+
+	std::string log = t.GetLogLines();
+
+	size_t pos = log.find("tsc,delta,direction,packet type,api,bytes,awaiter\n");
+	CHECK(pos != std::string::npos);
+
+	ULONG requests = 0, responses = 0, bytes = 0, badLines = 0;
+
+	for (pos = log.find('\n', pos) + 1; pos < log.size(); pos = log.find('\n', pos) + 1)
+	{
+		std::string line = log.substr(pos, log.find('\n', pos) - pos);
+
+		if (line[0] == ':')
+			break; // the next command.
+
+		ULONG64 tsc, delta;
+		CHAR dir[8], awaiter[32];
+		ULONG type, api, size;
+
+		if (::sscanf(line.c_str(), "%llu,%llu,%4[a-z],%u,%X,%u,%31s", &tsc, &delta, dir, &type, &api, &size, awaiter) != 7)
+		{
+			badLines++;
+			continue;
+		}
+
+		if (type != KdPacketType2_Ie_StateManipulate || api != DbgKdReadVirtualMemoryApi)
+			continue;
+
+		CHECK(!::strcmp(awaiter, "ReadMemory") || !::strcmp(awaiter, "ReadMemoryBatch"));
+
+		if (!::strcmp(dir, "recv"))
+			requests++;
+		else
+		{
+			responses++;
+			bytes += size;
+		}
+	}
+
+	::printf("DB: %llu reads in the simulator, %u requests and %u responses (%u bytes) in the trace.\n", reads, requests, responses, bytes);
+
+	CHECK(badLines == 0);
+	CHECK(requests == reads && responses == reads);
+	CHECK(bytes >= 0x2000);
+
+	return Finish();
+}
@@ -0,0 +1,122 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include "Root.h"
+
+//
+// A million DbgPrint lines: first appended directly to the log window, then sent by the kernel on all the processors and
+// moved to the log window at each break in.
+//
+
+static constexpr ULONG LinesNum = 1000000;
+static constexpr ULONG LinesPerBreakIn = 800; // for each processor: less than a ring can hold.
+
+// the lines in the log window are consecutive, up to the last one sent.
+
+static VOID CheckSequence(const LogLines& lines, ULONG last)
+{
+	ULONG prev = 0;
+	ULONG num = 0;
+
+	for (ULONG i = 0; i < lines.Size(); i++)
+	{
+		ULONG n;
+
+		if (::sscanf(lines.Get(i), "DbgPrint line %u", &n) != 1)
+			continue;
+
+		if (num && n != prev + 1)
+		{
+			::fprintf(stderr, "line %u follows line %u.\n", n, prev);
+			Failures++;
+			return;
+		}
+
+		prev = n;
+		num++;
+	}
+
+	CHECK(num > 0);
+	CHECK(prev == last);
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x10);
+
+	LogWnd& log = Root::I->LogWindow;
+
+	// the log window alone: each line, once the window is full, evicts the oldest one.
+
+	double start = Now();
+	ULONG kept = 0;
+
+	{
+		BcCall _call_;
+
+		CHAR line[64];
+
+		for (ULONG i = 0; i < LinesNum; i++)
+		{
+			::sprintf(line, "DbgPrint line %u", i);
+			log.AddString(line);
+
+			CHECK(log.lines.Size() <= LogLines::MaxLinesNum);
+		}
+
+		CHECK(log.GetLinesNum() == log.lines.Size());
+
+		CheckSequence(log.lines, LinesNum - 1);
+		CHECK(log.GetLineToDraw(log.GetLinesNum() - 1) == "DbgPrint line 999999");
+
+		kept = log.lines.Size();
+		log.Clear();
+	}
+
+	double elapsed = Now() - start;
+
+	::printf("LogWnd::AddString: %u lines in %.3f s (%.0f ns per line), %u lines kept.\n",
+		LinesNum, elapsed, elapsed * 1e9 / LinesNum, kept);
+
+	// the same lines through KdSendPacket, spread on all the processors.
+
+	start = Now();
+
+	ULONG breakInsNum = 0;
+
+	for (ULONG sent = 0; sent < LinesNum; )
+	{
+		for (ULONG i = 0; i < LinesPerBreakIn * SimTarget::ProcessorsNum && sent < LinesNum; i++, sent++)
+		{
+			CHAR line[64];
+			::sprintf(line, "DbgPrint line %u\n", sent);
+
+			t.DebugPrint(sent % SimTarget::ProcessorsNum, line);
+		}
+
+		t.Type("X");
+		t.BreakIn(CodeAddress);
+
+		breakInsNum++;
+	}
+
+	elapsed = Now() - start;
+
+	::printf("KdSendPacket: %u lines in %.3f s, %u break ins.\n", LinesNum, elapsed, breakInsNum);
+
+	{
+		BcCall _call_;
+
+		CHECK(Root::I->DbgPrints.Perf_MsgsNum == LinesNum);
+		CHECK(Root::I->DbgPrints.Perf_DroppedNum == 0);
+
+		CheckSequence(log.lines, LinesNum - 1);
+	}
+
+	CHECK(t.GetLogLines().find("dropped") == std::string::npos);
+
+	return Finish();
+}
@@ -0,0 +1,183 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "Cmd.h"
+#include "Root.h"
+
+//
+// Native logpoints (BPL) against the JavaScript logpoints (BPX WHEN expression that prints and returns 0), hit thousands of
+// times on the simulated target: the QuickJS evaluations and the KD round-trips of each hit (the times are only printed). Then the lines in the log window, a memory
+// argument and the field width limit of the value specs.
+//
+
+static constexpr ULONG64 BplAddress = CodeAddress + 0x10;
+static constexpr ULONG64 JsAddress = CodeAddress + 0x20;
+static constexpr ULONG64 MemAddress = CodeAddress + 0x30;
+static constexpr ULONG64 WidthAddress = CodeAddress + 0x38;
+
+static constexpr ULONG64 StackAddress = 0xFFFFF88000010000;
+
+static constexpr ULONG HitsNum = 2000;
+
+static VOID Execute(SimTarget& t, const CHAR* cmd)
+{
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+}
+
+struct HitsResult
+{
+	double time; // per hit.
+	double roundTrips; // per hit.
+	ULONG64 jsEvals; // evaluations of QuickJS, of all the hits.
+};
+
+static ULONG64 JsEvalsNum()
+{
+	BcCall _call_;
+	return Root::I->Perf_JsLatency.num;
+}
+
+static HitsResult Hit(SimTarget& t, ULONG64 address)
+{
+	ULONG64 roundTrips = t.Total.roundTrips;
+	ULONG64 jsEvals = JsEvalsNum();
+	double start = Now();
+
+	for (ULONG i = 0; i < HitsNum; i++)
+	{
+		t.Context[0].Rip = address;
+		t.Context[0].Rax = i;
+		t.Context[0].Rcx = i * 3;
+		t.Context[0].Rdx = 0x1000 + i;
+
+		t.HitBreakPoint(address);
+		CHECK(t.LastTraceFlag); // no break in.
+
+		t.Run(1);
+	}
+
+	double time = (Now() - start) / HitsNum;
+
+	return { time, (double)(t.Total.roundTrips - roundTrips) / HitsNum, JsEvalsNum() - jsEvals };
+}
+
+static ULONG64 LogpointHits(ULONG64 address)
+{
+	BcCall _call_;
+
+	BreakPoint* bp = Root::I->BreakPoints.Find(address);
+
+	return bp ? bp->log.Perf_HitsNum : ~0ULL;
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x40);
+
+	CHAR cmd[256];
+
+	// the native logpoint.
+
+	::sprintf(cmd, "BPL %llX \"nr %%x a1 %%x a2 %%x\" rax, rcx, rdx + 1", BplAddress);
+	Execute(t, cmd);
+
+	HitsResult bpl = Hit(t, BplAddress);
+
+	CHECK(LogpointHits(BplAddress) == HitsNum);
+
+	t.Type("X");
+	t.BreakIn(CodeAddress); // the ring is drained into the log window.
+
+	std::string log = t.GetLogLines();
+
+	::sprintf(cmd, "nr %x a1 %x a2 %x", HitsNum - 1, (HitsNum - 1) * 3, 0x1000 + HitsNum);
+	CHECK(log.find(cmd) != std::string::npos);
+
+	// the same logpoint in JavaScript: the QuickJS "print" writes to the host stdout, which is discarded.
+
+	::sprintf(cmd, "BPX %llX WHEN (print('nr ' + rax.toString(16) + ' a1 ' + rcx.toString(16) + ' a2 ' + (rdx + 1).toString(16)), 0)", JsAddress);
+	Execute(t, cmd);
+
+	::fflush(stdout);
+	int out = ::dup(1);
+	int null = ::open("/dev/null", O_WRONLY);
+	::dup2(null, 1);
+
+	HitsResult js = Hit(t, JsAddress);
+
+	::fflush(stdout);
+	::dup2(out, 1);
+	::close(null);
+	::close(out);
+
+	{
+		BcCall _call_;
+
+		BreakPoint* bp = Root::I->BreakPoints.Find(JsAddress);
+
+		CHECK(bp && bp->hitsNum == HitsNum && bp->trueNum == 0);
+	}
+
+	CHECK(bpl.jsEvals == 0);
+	CHECK(js.jsEvals == HitsNum);
+	CHECK(bpl.roundTrips <= js.roundTrips);
+
+	::printf("BPL: %.1f us and %.1f round trips per hit (%.0f hits/s).\n", bpl.time * 1e6, bpl.roundTrips, 1 / bpl.time);
+	::printf("BPX WHEN: %.1f us and %.1f round trips per hit (%.0f hits/s).\n", js.time * 1e6, js.roundTrips, 1 / js.time);
+
+	// a memory argument, read from the stack of the target.
+
+	BYTE* stack = t.Map(StackAddress, PAGE_SIZE);
+	*(ULONG*)(stack + 8) = 0xCAFE1234;
+
+	::sprintf(cmd, "BPL %llX \"arg %%08X\" dword [rsp+8]", MemAddress);
+	Execute(t, cmd);
+
+	t.Context[0].Rip = MemAddress;
+	t.Context[0].Rsp = StackAddress;
+	t.HitBreakPoint(MemAddress);
+	t.Run(1);
+
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(t.GetLogLines().find("arg CAFE1234") != std::string::npos);
+
+	// the width of a value spec is limited to Logpoint::MaxWidth.
+
+	::sprintf(cmd, "BPL %llX \"%%100x\" rax", WidthAddress);
+	Execute(t, cmd);
+
+	CHECK(t.ScreenContains("Field width too large")); // N.B. the "%I64d" of Utils::I64ToString is a field width for the C library of the host.
+
+	{
+		BcCall _call_;
+		CHECK(Root::I->BreakPoints.Find(WidthAddress) == NULL);
+	}
+
+	::sprintf(cmd, "BPL %llX \"w=%%20x|\" rax", WidthAddress);
+	Execute(t, cmd);
+
+	t.Context[0].Rip = WidthAddress;
+	t.Context[0].Rax = 0xABC;
+	t.HitBreakPoint(WidthAddress);
+	t.Run(1);
+
+	CHECK(LogpointHits(WidthAddress) == 1);
+
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(t.GetLogLines().find("w=                 abc|") != std::string::npos);
+
+	return Finish();
+}
@@ -0,0 +1,340 @@
+#include "TestUtils.h"
+#include "KernelFill.h"
+
+#include <stdio.h>
+
+#include "Cmd.h"
+#include "Root.h"
+
+//
+// DiscoverBytePointerPosInModules on kernel drivers and on user images: the module, section and offset of each address,
+// and the reads that it takes. The VAD tree of the process is read once per break in, whatever the number of addresses.
+//
+
+extern int MACRO_STARTINGVPN_FIELDOFFSET_IN_VAD;
+extern int MACRO_ENDINGVPN_FIELDOFFSET_IN_VAD;
+extern int MACRO_LEFTLINK_FIELDOFFSET_IN_VAD;
+extern int MACRO_RIGHTLINK_FIELDOFFSET_IN_VAD;
+extern int MACRO_CONTROLAREA_FIELDOFFSET_IN_VAD;
+extern int MACRO_SIZEOF_VPN_IN_VAD;
+extern int MACRO_SIZEOF_VAD;
+extern int MACRO_FILEOBJECT_FIELDOFFSET_IN_CONTROLAREA;
+extern int MACRO_FILENAME_FIELDOFFSET_IN_FILEOBJECT;
+extern int MACRO_VADROOT_FIELDOFFSET_IN_KPEB;
+
+static constexpr ULONG64 DriversAddress = 0xFFFFF80001000000;
+static constexpr ULONG64 ProcessAddress = 0xFFFFE00000100000;
+static constexpr ULONG64 NodesAddress = 0xFFFFE00000200000; // one VAD node per page.
+static constexpr ULONG64 FilesAddress = 0xFFFFE00000400000; // control areas, file objects and names.
+static constexpr ULONG64 UserAddress = 0x7FF800000000;
+
+static constexpr ULONG DriversNum = 16;
+static constexpr ULONG VadsNum = 31; // a complete tree of 5 levels; the even ones map an image.
+static constexpr ULONG ImageSize = 0x10000;
+
+static constexpr int ThreadProcessOffset = 0xB8; // as in SimTarget.
+static constexpr int PcrCurrentThreadOffset = 0x188;
+static constexpr int VadRootOffset = 0x7D8;
+static constexpr int FileBlockSize = 0x200;
+
+// a test command: the position of each address, one per line.
+
+class Cmd_WHERE : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "WHERE"; }
+	virtual const CHAR* GetDesc() { return "Displays the module, section and offset of addresses."; }
+	virtual const CHAR* GetSyntax() { return "WHERE address [address ...]"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		const CHAR* psz = params.cmd.c_str() + ::strlen("WHERE");
+
+		while (TRUE)
+		{
+			CHAR* end;
+			ULONG64 address = ::strtoull(psz, &end, 16);
+
+			if (end == psz)
+				break;
+
+			psz = end;
+
+			CHAR pos[350];
+			ImageDebugInfo debugInfo;
+
+			co_await BcAwaiter_Join{ Platform::DiscoverBytePointerPosInModules(pos, &debugInfo, (ULONG_PTR)address) };
+
+			CHAR line[400];
+			::sprintf(line, "%016llX: %s", address, ::strlen(pos) ? pos : "-");
+			Print(line);
+		}
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_WHERE)
+
+// the section headers after the NT headers written by SimTarget::AddModule: .text at 0x1000 and .data at 0x3000.
+
+static VOID AddSections(SimTarget& t, ULONG64 base)
+{
+	IMAGE_SECTION_HEADER sections[2] = {};
+
+	::memcpy(sections[0].Name, ".text", 5);
+	sections[0].VirtualAddress = 0x1000;
+	sections[0].SizeOfRawData = sections[0].Misc.VirtualSize = 0x2000;
+
+	::memcpy(sections[1].Name, ".data", 5);
+	sections[1].VirtualAddress = 0x3000;
+	sections[1].SizeOfRawData = sections[1].Misc.VirtualSize = 0x1000;
+
+	ULONG64 nth = base + 0x80;
+
+	WORD num = 2;
+	t.Write(nth + FIELD_OFFSET(IMAGE_NT_HEADERS64, FileHeader.NumberOfSections), &num, sizeof(num));
+	t.Write(nth + sizeof(IMAGE_NT_HEADERS64), sections, sizeof(sections));
+}
+
+static VOID MapUserImage(SimTarget& t, ULONG64 base)
+{
+	BYTE* image = t.Map(base, ImageSize);
+
+	auto dos = (IMAGE_DOS_HEADER*)image;
+	dos->e_magic = IMAGE_DOS_SIGNATURE;
+	dos->e_lfarlc = 0x40;
+	dos->e_lfanew = 0x80;
+
+	auto nth = (IMAGE_NT_HEADERS64*)(image + dos->e_lfanew);
+	nth->Signature = IMAGE_NT_SIGNATURE;
+	nth->FileHeader.Machine = IMAGE_FILE_MACHINE_AMD64;
+	nth->FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER64);
+	nth->OptionalHeader.Magic = IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+	nth->OptionalHeader.ImageBase = base;
+	nth->OptionalHeader.SizeOfImage = ImageSize;
+
+	AddSections(t, base);
+}
+
+// the VAD tree: the node of the VAD in the middle of [first, last] is the root of the subtree.
+
+static ULONG64 BuildVads(SimTarget& t, LONG first, LONG last)
+{
+	if (first > last)
+		return 0;
+
+	LONG i = (first + last) / 2;
+
+	ULONG64 node = NodesAddress + i * PAGE_SIZE;
+	ULONG64 start = UserAddress + i * 0x100000;
+
+	ULONG64 left = BuildVads(t, first, i - 1);
+	ULONG64 right = BuildVads(t, i + 1, last);
+
+	ULONG64 startVpn = start >> 12;
+	ULONG64 endVpn = (start + ImageSize - 1) >> 12;
+	ULONG64 controlArea = i % 2 ? 0 : FilesAddress + i * FileBlockSize;
+
+	t.Write(node + MACRO_LEFTLINK_FIELDOFFSET_IN_VAD, &left, sizeof(left));
+	t.Write(node + MACRO_RIGHTLINK_FIELDOFFSET_IN_VAD, &right, sizeof(right));
+	t.Write(node + MACRO_STARTINGVPN_FIELDOFFSET_IN_VAD, &startVpn, sizeof(startVpn));
+	t.Write(node + MACRO_ENDINGVPN_FIELDOFFSET_IN_VAD, &endVpn, sizeof(endVpn));
+	t.Write(node + MACRO_CONTROLAREA_FIELDOFFSET_IN_VAD, &controlArea, sizeof(controlArea));
+
+	if (controlArea)
+	{
+		// the file: ControlArea -> FileObject -> FileName.
+
+		ULONG64 fileObject = controlArea + 0x80;
+		ULONG64 nameBuffer = controlArea + 0x100;
+
+		t.Write(controlArea + MACRO_FILEOBJECT_FIELDOFFSET_IN_CONTROLAREA, &fileObject, sizeof(fileObject));
+
+		CHAR name[64];
+		::sprintf(name, "\\Windows\\System32\\lib%02u.dll", i);
+
+		WCHAR wname[64];
+		USHORT len = 0;
+
+		for (; name[len]; len++)
+			wname[len] = name[len];
+
+		t.Write(nameBuffer, wname, len * sizeof(WCHAR));
+
+		UNICODE_STRING us = { (USHORT)(len * sizeof(WCHAR)), (USHORT)(len * sizeof(WCHAR)), (WCHAR*)nameBuffer };
+		t.Write(fileObject + MACRO_FILENAME_FIELDOFFSET_IN_FILEOBJECT, &us, sizeof(us));
+
+		MapUserImage(t, start);
+	}
+
+	return node;
+}
+
+static ULONG64 ReadsIn(SimTarget& t, ULONG64 start, ULONG64 size)
+{
+	ULONG64 n = 0;
+
+	for (ULONG64 a : t.ReadAddresses)
+		if (a >= start && a < start + size)
+			n++;
+
+	return n;
+}
+
+static std::string Where(ULONG64 address)
+{
+	CHAR sz[32];
+	::sprintf(sz, "%016llX: ", address);
+	return sz;
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x10);
+
+	// the drivers, after the kernel in PsLoadedModuleList.
+
+	for (ULONG i = 0; i < DriversNum; i++)
+	{
+		CHAR name[64];
+		::sprintf(name, "\\SystemRoot\\System32\\drivers\\drv%02u.sys", i);
+
+		ULONG64 base = t.AddModule(name, DriversAddress + i * 0x100000, ImageSize);
+		AddSections(t, base);
+	}
+
+	// the current process, with its VAD tree (the Windows XP layout, where the file is reached through the control area).
+
+	MACRO_LEFTLINK_FIELDOFFSET_IN_VAD = 0x00;
+	MACRO_RIGHTLINK_FIELDOFFSET_IN_VAD = 0x08;
+	MACRO_STARTINGVPN_FIELDOFFSET_IN_VAD = 0x18;
+	MACRO_ENDINGVPN_FIELDOFFSET_IN_VAD = 0x20;
+	MACRO_CONTROLAREA_FIELDOFFSET_IN_VAD = 0x30;
+	MACRO_SIZEOF_VPN_IN_VAD = 8;
+	MACRO_SIZEOF_VAD = 0x40;
+	MACRO_FILEOBJECT_FIELDOFFSET_IN_CONTROLAREA = 0x40;
+	MACRO_FILENAME_FIELDOFFSET_IN_FILEOBJECT = 0x58;
+	MACRO_VADROOT_FIELDOFFSET_IN_KPEB = VadRootOffset;
+
+	t.Map(ProcessAddress, PAGE_SIZE);
+	t.Map(NodesAddress, VadsNum * PAGE_SIZE);
+	t.Map(FilesAddress, (VadsNum * FileBlockSize + PAGE_SIZE - 1) & ~(ULONG64)(PAGE_SIZE - 1)); // whole pages, as BugChecker reads page windows.
+
+	ULONG64 root = BuildVads(t, 0, VadsNum - 1);
+	t.Write(ProcessAddress + VadRootOffset, &root, sizeof(root));
+
+	ULONG64 thread = *(ULONG64*)(HostSim_Pcr + PcrCurrentThreadOffset);
+	*(ULONG64*)(thread + ThreadProcessOffset) = ProcessAddress;
+
+	// the kernel: the image without sections, the drivers with them, then an address outside the modules.
+
+	std::string cmd = "WHERE FFFFF80000021000 FFFFF8FF00000000";
+
+	for (ULONG i = 0; i < DriversNum; i++)
+	{
+		CHAR sz[64];
+		::sprintf(sz, " %llX %llX", DriversAddress + i * 0x100000 + 0x1010, DriversAddress + i * 0x100000 + 0x3000);
+		cmd += sz;
+	}
+
+	t.Type(cmd.c_str());
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	std::string log = t.GetLogLines();
+
+	CHECK(log.find(Where(0xFFFFF80000021000) + "ntoskrnl+00021000") != std::string::npos);
+	CHECK(log.find(Where(0xFFFFF8FF00000000) + "-") != std::string::npos);
+
+	for (ULONG i = 0; i < DriversNum; i++)
+	{
+		CHAR sz[64];
+
+		::sprintf(sz, "drv%02u!.text+00000010", i);
+		CHECK(log.find(Where(DriversAddress + i * 0x100000 + 0x1010) + sz) != std::string::npos);
+
+		::sprintf(sz, "drv%02u!.data", i);
+		CHECK(log.find(Where(DriversAddress + i * 0x100000 + 0x3000) + sz + "\n") != std::string::npos);
+	}
+
+	const SimTarget::CmdCounters* c = t.GetCmd(cmd.c_str());
+
+	ULONG64 kernelReads = c ? c->counters.byApi.at(DbgKdReadVirtualMemoryApi) : 0;
+
+	::printf("%u kernel addresses: %llu reads, %llu round trips.\n", 2 + 2 * DriversNum, kernelReads, c ? c->counters.roundTrips : 0);
+
+	// the same driver in a new break in: the module cache skips the list walk.
+
+	CHAR last[64];
+	::sprintf(last, "WHERE %llX", DriversAddress + (DriversNum - 1) * 0x100000 + 0x1010);
+
+	t.Type(last);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	ULONG64 lastReads = t.GetCmd(last)->counters.byApi.at(DbgKdReadVirtualMemoryApi);
+
+	::printf("the last driver, from the module cache: %llu reads.\n", lastReads);
+
+	CHECK(lastReads <= 2); // the cached entry, then the headers of the image.
+
+	CHECK(t.GetLogLines().find(Where(DriversAddress + (DriversNum - 1) * 0x100000 + 0x1010) + "drv15!.text+00000010") != std::string::npos);
+
+	// the user images: one address, then all of them, in the same break in. The tree is read once.
+
+	cmd = "WHERE";
+
+	for (ULONG i = 0; i < VadsNum; i++)
+	{
+		CHAR sz[32];
+		::sprintf(sz, " %llX", UserAddress + i * 0x100000 + 0x1020);
+		cmd += sz;
+	}
+
+	CHAR first[64];
+	::sprintf(first, "WHERE %llX", UserAddress + 0x1020);
+
+	t.ReadAddresses.clear();
+
+	t.Type(first);
+	t.Type(cmd.c_str());
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	log = t.GetLogLines();
+	for (ULONG i = 0; i < VadsNum; i++)
+	{
+		CHAR sz[64];
+
+		if (i % 2)
+			::strcpy(sz, "-");
+		else
+			::sprintf(sz, "lib%02u!.text+00000020", i);
+
+		CHECK(log.find(Where(UserAddress + i * 0x100000 + 0x1020) + sz) != std::string::npos);
+	}
+
+	ULONG64 nodeReads = ReadsIn(t, NodesAddress, VadsNum * PAGE_SIZE);
+	ULONG64 userReads = t.GetCmd(cmd.c_str())->counters.byApi.at(DbgKdReadVirtualMemoryApi);
+
+	::printf("%u user addresses: %llu reads; %llu reads of the %u VAD nodes in the break in.\n", VadsNum, userReads, nodeReads, VadsNum);
+
+	CHECK(nodeReads == VadsNum); // a walk of the tree for each address would read 4 or 5 nodes for each one.
+	CHECK(t.GetCmd(first)->counters.byApi.count(DbgKdReadVirtualMemoryApi));
+
+	// a new break in takes a new snapshot.
+
+	t.ReadAddresses.clear();
+
+	t.Type(first);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(ReadsIn(t, NodesAddress, VadsNum * PAGE_SIZE) == VadsNum);
+
+	return Finish();
+}
@@ -0,0 +1,231 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <string>
+
+#include "Cmd.h"
+#include "Root.h"
+#include "QuickJSCppInterface.h"
+
+//
+// Pathological scripts under the time budget of the JavaScript evaluations: each one must be interrupted once it has spent its
+// budget (set by JSBUDGET), and the next evaluation must work normally. Then a WHEN expression that never returns, with its
+// own budget (BPX -budget): it is considered false twice, then its breakpoint is disabled and BugChecker breaks in.
+// N.B. the times are only printed: the preemption of the host counts against the budget, so only its lower bound is checked.
+//
+
+static constexpr ULONG64 BpAddress = CodeAddress + 0x10;
+
+static constexpr ULONG GlobalBudgetMs = 50;
+static constexpr ULONG BpBudgetMs = 20;
+
+// a test command: evaluates its argument and records the result, the ticks consumed and the wall clock time.
+
+struct EvalResult
+{
+	BOOLEAN timedOut;
+	BOOLEAN isNull;
+	ULONG64 value;
+	ULONG64 ticks;
+	double time;
+};
+
+static EvalResult LastEval = {};
+
+class Cmd_EVALTIME : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "EVALTIME"; }
+	virtual const CHAR* GetDesc() { return "Evaluates an expression and records its time."; }
+	virtual const CHAR* GetSyntax() { return "EVALTIME js-expression"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		NullableU64 nu64;
+
+		eastl::string s = params.cmd;
+
+		s.trim();
+		s = s.substr(::strlen("EVALTIME"));
+
+		double start = Now();
+
+		co_await BcAwaiter_Join{ QuickJSCppInterface::Eval(s.c_str(), params.context, params.contextLen, params.is32bitCompat, &nu64, TRUE) };
+
+		LastEval = { QuickJSCppInterface::LastTimedOut, nu64.isNull, nu64.value, QuickJSCppInterface::LastTicks, Now() - start };
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_EVALTIME)
+
+static const CHAR* Pathological[] =
+{
+	"(function() { for (;;); })()",
+	"(function() { for (;;) { try { for (;;); } catch (e) {} } })()", // the exception of the interrupt handler cannot be caught.
+	"(function() { let s = 0; for (let i = 0; ; i++) s += Math.sqrt(i); })()",
+	"(function() { let f = function(n) { return n < 2 ? n : f(n - 1) + f(n - 2); }; return f(60); })()",
+	"(function() { let o = {}; for (let i = 0; ; i++) { o['k' + (i % 1000)] = String(i).repeat(8); } })()",
+	"(function() { let a = []; for (let i = 0; ; i++) { a.push(i); if (a.length > 4096) a = a.filter(x => x & 1); } })()",
+};
+
+static VOID Eval(SimTarget& t, const CHAR* expr)
+{
+	std::string cmd = std::string("EVALTIME ") + expr;
+
+	t.Type(cmd.c_str());
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x40);
+
+	CHECK(Root::I->RdtscTicksPerMs != 0); // otherwise the budget is not enforced.
+
+	// the first evaluation initializes QuickJS: its startup script is not interrupted even by a budget of a few ticks.
+
+	ULONG64 ticksPerMs = Root::I->RdtscTicksPerMs;
+
+	t.Type("JSBUDGET 1");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	{
+		BcCall _call_;
+		Root::I->RdtscTicksPerMs = 1;
+	}
+
+	Eval(t, Pathological[0]);
+
+	CHECK(LastEval.timedOut);
+
+	{
+		BcCall _call_;
+		Root::I->RdtscTicksPerMs = ticksPerMs;
+	}
+
+	t.Type("JSBUDGET 0");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	Eval(t, "6 * 7");
+
+	CHECK(!LastEval.timedOut);
+	CHECK(!LastEval.isNull && LastEval.value == 42);
+
+	CHAR budget[32];
+	::sprintf(budget, "JSBUDGET %u", GlobalBudgetMs);
+
+	t.Type(budget);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(Root::I->JsBudgetMs == GlobalBudgetMs);
+
+	ULONG64 budgetTicks = (ULONG64)GlobalBudgetMs * Root::I->RdtscTicksPerMs;
+
+	for (const CHAR* expr : Pathological)
+	{
+		Eval(t, expr);
+
+		CHECK(LastEval.timedOut);
+		CHECK(LastEval.isNull);
+		CHECK(LastEval.ticks >= budgetTicks);
+
+		::printf("%-100s interrupted after %.1f ms.\n", expr, LastEval.time * 1000);
+
+		// the interpreter is usable after the interrupt.
+
+		Eval(t, "6 * 7");
+
+		CHECK(!LastEval.timedOut);
+		CHECK(!LastEval.isNull && LastEval.value == 42);
+	}
+
+	// a WHEN expression that exceeds its own budget: it is false for the first MaxWhenTimeouts - 1 hits.
+
+	CHAR bpx[128];
+	::sprintf(bpx, "BPX %llX -budget %u WHEN (function() { for (;;); })()", BpAddress, BpBudgetMs);
+
+	t.Type(bpx);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(t.KdBreakPointsNum() == 1);
+
+	for (ULONG i = 0; i < BreakPoint::MaxWhenTimeouts; i++)
+	{
+		BOOLEAN last = i == BreakPoint::MaxWhenTimeouts - 1;
+
+		if (last)
+			t.Type("X"); // BugChecker breaks in.
+
+		t.Context[0].Rip = BpAddress;
+
+		double start = Now();
+		t.HitBreakPoint(BpAddress);
+		double time = Now() - start;
+
+		CHECK(QuickJSCppInterface::LastTimedOut);
+
+		::printf("WHEN interrupted after %.1f ms.\n", time * 1000);
+
+		if (!last)
+		{
+			CHECK(t.LastTraceFlag); // continued without breaking in.
+			t.Run(1);
+		}
+	}
+
+	{
+		BcCall _call_;
+
+		BreakPoint* bp = Root::I->BreakPoints.Find(BpAddress);
+
+		CHECK(bp != NULL);
+
+		if (bp)
+		{
+			CHECK(bp->skip);
+			CHECK(bp->whenTimeoutsNum == BreakPoint::MaxWhenTimeouts);
+			CHECK(bp->hitsNum == BreakPoint::MaxWhenTimeouts);
+			CHECK(bp->trueNum == 1);
+		}
+	}
+
+	std::string log = t.GetLogLines();
+
+	CHECK(log.find("exceeded its time budget too many times in a row") != std::string::npos);
+
+	// the disabled breakpoint is skipped without evaluating its expression.
+
+	t.Context[0].Rip = BpAddress;
+
+	double start = Now();
+	t.HitBreakPoint(BpAddress);
+	double time = Now() - start;
+
+	CHECK(t.LastTraceFlag);
+
+	::printf("Disabled breakpoint skipped in %.1f ms.\n", time * 1000);
+
+	t.Run(1);
+
+	{
+		BcCall _call_;
+
+		BreakPoint* bp = Root::I->BreakPoints.Find(BpAddress);
+
+		CHECK(bp && bp->trueNum == 1);
+		CHECK(bp && bp->hitsNum == BreakPoint::MaxWhenTimeouts + 1 && bp->whenTimeoutsNum == BreakPoint::MaxWhenTimeouts);
+	}
+
+	return Finish();
+}
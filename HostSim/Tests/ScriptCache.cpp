@@ -0,0 +1,159 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <string>
+
+#include "Cmd.h"
+#include "Root.h"
+#include "QuickJSCppInterface.h"
+#include "QuickJSCInterface.h"
+
+//
+// The Script Window text, run as by F1 (QuickJSCppInterface::Eval with wrapInAsyncFn=FALSE): it is compiled only when it changes,
+// then its cached bytecode is executed. A library of helper functions is run again and again, and the cache is made to evict its
+// entries with more scripts than it can hold.
+//
+
+static constexpr ULONG HelpersNum = 400;
+static constexpr ULONG RunsNum = 50;
+
+static std::string Library; // HelpersNum functions, then a "let" (that must not be redeclared by the next run) and the return value.
+
+static double FirstRunTime = 0, CachedRunTime = 0;
+static ULONG64 LibraryRet = 0, CachedRetMismatches = 0, HelperRet = 0;
+static ULONG64 ChangedRet = 0, EvictedRets[QJS_SCRIPTS_CACHE_SIZE + 2] = {}, FirstAgainRet = 0;
+static BOOLEAN ErrorIsNull = FALSE;
+
+static BcCoroutine RunScript(const CHAR* src, CmdParams& params, ULONG64* pRet) noexcept
+{
+	NullableU64 ret;
+
+	co_await BcAwaiter_Join{ QuickJSCppInterface::Eval(src, params.context, params.contextLen, params.is32bitCompat, &ret, TRUE, FALSE) };
+
+	*pRet = ret.isNull ? ~0ULL : ret.value;
+}
+
+class Cmd_SCRIPTCACHE : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "SCRIPTCACHE"; }
+	virtual const CHAR* GetDesc() { return "Runs the scripts of the test as the Script Window does."; }
+	virtual const CHAR* GetSyntax() { return "SCRIPTCACHE"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		ULONG64 ret;
+
+		// the library: the first run compiles it, the next ones execute its bytecode.
+
+		double start = Now();
+		co_await BcAwaiter_Join{ RunScript(Library.c_str(), params, &LibraryRet) };
+		FirstRunTime = Now() - start;
+
+		start = Now();
+
+		for (ULONG i = 0; i < RunsNum; i++)
+		{
+			co_await BcAwaiter_Join{ RunScript(Library.c_str(), params, &ret) };
+			CachedRetMismatches += ret != LibraryRet;
+		}
+
+		CachedRunTime = (Now() - start) / RunsNum;
+
+		// the helpers are defined in the global object: an expression can call them.
+
+		NullableU64 nu64;
+		co_await BcAwaiter_Join{ QuickJSCppInterface::Eval("helper123(5)", params.context, params.contextLen, params.is32bitCompat, &nu64, TRUE) };
+		HelperRet = nu64.isNull ? ~0ULL : nu64.value;
+
+		// a different text is compiled again.
+
+		co_await BcAwaiter_Join{ RunScript("let a = 40; a + 2", params, &ChangedRet) };
+
+		// more scripts than the entries of the cache: the library is evicted and compiled again.
+
+		for (ULONG i = 0; i < sizeof(EvictedRets) / sizeof(EvictedRets[0]); i++)
+		{
+			CHAR src[64];
+			::sprintf(src, "const k = %u; k * 3", i);
+			co_await BcAwaiter_Join{ RunScript(src, params, &EvictedRets[i]) };
+		}
+
+		co_await BcAwaiter_Join{ RunScript(Library.c_str(), params, &FirstAgainRet) };
+
+		// an exception: no return value.
+
+		co_await BcAwaiter_Join{ RunScript("let b = 1; throw 'failure'", params, &ret) };
+		ErrorIsNull = ret == ~0ULL;
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_SCRIPTCACHE)
+
+int main()
+{
+	for (ULONG i = 0; i < HelpersNum; i++)
+	{
+		CHAR fn[256];
+		::sprintf(fn,
+			"function helper%u(x)\n"
+			"{\n"
+			"\tlet s = 0;\n"
+			"\tfor (let i = 0; i < x; i++)\n"
+			"\t\ts += (i * %u) %% 7 + (x > 3 ? 1 : 2);\n"
+			"\treturn s + %u;\n"
+			"}\n", i, i + 1, i);
+		Library += fn;
+	}
+
+	Library += "let total = 0;\nfor (let i = 0; i < 10; i++) total += helper7(i);\ntotal";
+
+	SimTarget t;
+
+	WriteCode(t, 0x40);
+
+	t.Type("SCRIPTCACHE");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	// helper7(x) = sum over i < x of ((8 * i) % 7 + (x > 3 ? 1 : 2)), plus 7.
+
+	ULONG64 expected = 0;
+
+	for (ULONG x = 0; x < 10; x++)
+	{
+		ULONG64 s = 0;
+		for (ULONG i = 0; i < x; i++)
+			s += (i * 8) % 7 + (x > 3 ? 1 : 2);
+		expected += s + 7;
+	}
+
+	ULONG64 expectedHelper = 0;
+	for (ULONG i = 0; i < 5; i++)
+		expectedHelper += (i * 124) % 7 + 1;
+	expectedHelper += 123;
+
+	CHECK(LibraryRet == expected);
+	CHECK(CachedRetMismatches == 0);
+	CHECK(HelperRet == expectedHelper);
+	CHECK(ChangedRet == 42);
+
+	for (ULONG i = 0; i < sizeof(EvictedRets) / sizeof(EvictedRets[0]); i++)
+		CHECK(EvictedRets[i] == i * 3);
+
+	CHECK(FirstAgainRet == expected);
+	CHECK(ErrorIsNull);
+
+	// the compilation of the library is most of the cost of its first run.
+
+	CHECK(CachedRunTime < FirstRunTime);
+
+	::printf("Script of %u functions (%u bytes): first run %.0f us, cached runs %.0f us (%.1fx).\n",
+		HelpersNum, (ULONG)Library.size(), FirstRunTime * 1e6, CachedRunTime * 1e6, CachedRunTime ? FirstRunTime / CachedRunTime : 0);
+
+	return Finish();
+}
@@ -0,0 +1,154 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+//
+// The reads of the commands that look at many small structures: STACK, which reads the code before each return address
+// candidate on the stack, and THREAD -kp, which reads the KTHREAD of each thread of a process. The reads of each command
+// are declared at once and coalesced by page, instead of one KD request for each candidate or thread.
+//
+
+static constexpr ULONG64 FuncsAddress = 0xFFFFF80000020000; // in the image of the kernel.
+static constexpr ULONG64 ProcessAddress = 0xFFFFE00000100000;
+static constexpr ULONG64 ThreadsAddress = 0xFFFFE00000200000;
+
+static constexpr ULONG CallSitesNum = 64;
+static constexpr ULONG CallSitesPerPage = 16;
+static constexpr ULONG ThreadsNum = 64;
+static constexpr ULONG ThreadSize = 0x500; // larger than the KTHREAD fields read by THREAD (see SimSymbols::Kernel).
+
+static ULONG64 Reads(SimTarget& t, const CHAR* cmd)
+{
+	const SimTarget::CmdCounters* c = t.GetCmd(cmd);
+
+	if (!c || !c->counters.byApi.count(DbgKdReadVirtualMemoryApi))
+		return 0;
+
+	ULONG64 reads = c->counters.byApi.at(DbgKdReadVirtualMemoryApi);
+
+	::printf("%-32s %3llu reads, %3llu round trips, %6llu bytes.\n", cmd, reads, c->counters.roundTrips, c->counters.bytesRead);
+
+	return reads;
+}
+
+static VOID Run(SimTarget& t, const CHAR* cmd) // each command in its own session: the page cache is emptied at the continue.
+{
+	t.Type(cmd);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x10);
+
+	// STACK: the stack without return addresses first, for the reads that don't depend on the candidates (the stack
+	// pages and the module list).
+
+	Run(t, "STACK -scan");
+
+	ULONG64 fixedReads = Reads(t, "STACK -scan");
+
+	CHECK(fixedReads > 0);
+
+	// then a CALL instruction before each return address, 16 in each code page.
+
+	std::vector<ULONG64> rets;
+
+	for (ULONG i = 0; i < CallSitesNum; i++)
+	{
+		ULONG64 site = FuncsAddress + (i / CallSitesPerPage) * PAGE_SIZE + (i % CallSitesPerPage) * 0x100 + 0x40;
+		BYTE call[5] = { 0xE8, 0, 0, 0, 0 };
+		t.Write(site, call, sizeof(call));
+
+		ULONG64 ret = site + sizeof(call);
+		t.Write(t.Context[0].Rsp + 0x100 + i * 0x180, &ret, sizeof(ret));
+
+		rets.push_back(ret);
+	}
+
+	Run(t, "STACK -scan");
+
+	ULONG64 scanReads = Reads(t, "STACK -scan");
+
+	std::string log = t.GetLogLines();
+
+	for (ULONG64 ret : rets)
+	{
+		CHAR sym[64];
+		::sprintf(sym, "@ 0x%016llX", ret);
+
+		CHECK(log.find(sym) != std::string::npos);
+	}
+
+	// at most one read for each page of code, instead of one for each candidate.
+
+	const ULONG codePages = CallSitesNum / CallSitesPerPage;
+
+	::printf("STACK: %u return addresses in %u code pages, %llu reads for the candidates.\n",
+		CallSitesNum, codePages, scanReads - fixedReads);
+
+	CHECK(scanReads >= fixedReads);
+	CHECK(scanReads - fixedReads <= codePages);
+
+	// THREAD -kp: a process with its threads in a list, as in ThreadListHead of KPROCESS.
+
+	t.Map(ProcessAddress, PAGE_SIZE);
+	BYTE* threads = t.Map(ThreadsAddress, ThreadsNum * ThreadSize);
+
+	const ULONG offsetTlh = 0x30, offsetTle = 0x2F8, offsetState = 0x184, offsetKs = 0x58, offsetUt = 0x478 + 8, offsetTeb = 0xF0;
+
+	ULONG64 prev = ProcessAddress + offsetTlh;
+
+	for (ULONG i = 0; i < ThreadsNum; i++)
+	{
+		BYTE* thread = threads + i * ThreadSize;
+		ULONG64 entry = ThreadsAddress + i * ThreadSize + offsetTle;
+
+		*(ULONG64*)(thread + offsetKs) = 0xFFFFF88000300000 + i * 0x6000;
+		*(ULONG64*)(thread + offsetUt) = 0x1000 + i * 4;
+		*(ULONG64*)(thread + offsetTeb) = i % 2 ? 0x7FF000000000 + i * PAGE_SIZE : 0;
+		thread[offsetState] = 5; // Waiting.
+
+		t.Write(prev, &entry, sizeof(entry)); // Flink.
+		prev = entry;
+	}
+
+	ULONG64 head = ProcessAddress + offsetTlh;
+	t.Write(prev, &head, sizeof(head));
+
+	CHAR cmd[64];
+	::sprintf(cmd, "THREAD -kp %llX", ProcessAddress);
+
+	Run(t, cmd);
+
+	ULONG64 threadReads = Reads(t, cmd);
+
+	log = t.GetLogLines();
+
+	ULONG listed = 0;
+
+	for (ULONG i = 0; i < ThreadsNum; i++)
+	{
+		CHAR line[128];
+		::sprintf(line, "%X%*s%016llX %016llX Waiting", 0x1000 + i * 4, 8 - 4, "", ThreadsAddress + i * ThreadSize, (ULONG64)0xFFFFF88000300000 + i * 0x6000);
+
+		if (log.find(line) != std::string::npos)
+			listed++;
+	}
+
+	CHECK(listed == ThreadsNum);
+
+	// the list walk reads the pages of the threads once (through the page cache), and so does the batch of the KTHREADs.
+
+	const ULONG threadPages = (ThreadsNum * ThreadSize + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	::printf("THREAD -kp: %u threads in %u pages, %llu reads.\n", ThreadsNum, threadPages, threadReads);
+
+	CHECK(threadReads < ThreadsNum);
+	CHECK(threadReads <= 2 * threadPages + 2);
+
+	return Finish();
+}
@@ -0,0 +1,309 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Cmd.h"
+#include "Root.h"
+#include "Platform.h"
+
+//
+// The stack walker driven by the snapshot of the unwind info, compared with the scan of the stack: a chain of five frames of a
+// kernel module (a frame pointer with a dynamic allocation, a large allocation, a chained unwind info, a thread start), with stale
+// return addresses and function pointers in the locals. The IP is also interrupted in the epilog and in the prolog of the last function.
+//
+
+static constexpr ULONG ImageSize = 0x4000;
+static constexpr ULONG UnwindRva = 0x2000;
+static constexpr ULONG PdataRva = 0x2800;
+
+// the functions of the module, by rva.
+
+static constexpr ULONG ThreadStart = 0x1000; // sub rsp, 28h; call F3.
+static constexpr ULONG F3 = 0x1040; // push rsi; sub rsp, 30h; jmp F3Cold.
+static constexpr ULONG F3Cold = 0x1060; // call F2: the unwind info is chained to the one of F3.
+static constexpr ULONG F2 = 0x1080; // push rbp; push rdi; sub rsp, 1000h; call F1.
+static constexpr ULONG F1 = 0x1100; // push rbp; sub rsp, 40h; lea rbp, [rsp+20h]; sub rsp, rax; call rbx.
+static constexpr ULONG F0 = 0x1180; // push rbx; sub rsp, 20h; mov eax, [rcx]; nop; nop; add rsp, 20h; pop rbx; ret.
+
+struct Function
+{
+	ULONG rva;
+	std::vector<BYTE> code;
+	std::vector<BYTE> unwindInfo; // the header and the codes.
+};
+
+static std::vector<Function> Functions()
+{
+	return {
+		{ ThreadStart,
+			{ 0x48, 0x83, 0xEC, 0x28, 0xE8, 0x37, 0x00, 0x00, 0x00, 0x48, 0x83, 0xC4, 0x28, 0xC3 },
+			{ 0x01, 0x04, 0x01, 0x00, 0x04, 0x42 } }, // ALLOC_SMALL 28h.
+		{ F3,
+			{ 0x56, 0x48, 0x83, 0xEC, 0x30, 0xEB, 0x19 },
+			{ 0x01, 0x05, 0x02, 0x00, 0x05, 0x52, 0x01, 0x60 } }, // ALLOC_SMALL 30h, PUSH_NONVOL rsi.
+		{ F3Cold,
+			{ 0xE8, 0x1B, 0x00, 0x00, 0x00, 0x48, 0x83, 0xC4, 0x30, 0x5E, 0xC3 },
+			{ 0x21, 0x00, 0x00, 0x00 } }, // UNW_FLAG_CHAININFO, followed by the entry of F3.
+		{ F2,
+			{ 0x55, 0x57, 0x48, 0x81, 0xEC, 0x00, 0x10, 0x00, 0x00, 0xE8, 0x72, 0x00, 0x00, 0x00, 0x48, 0x81, 0xC4, 0x00, 0x10, 0x00, 0x00, 0x5F, 0x5D, 0xC3 },
+			{ 0x01, 0x09, 0x04, 0x00, 0x09, 0x01, 0x00, 0x02, 0x02, 0x70, 0x01, 0x50 } }, // ALLOC_LARGE 1000h, PUSH_NONVOL rdi, PUSH_NONVOL rbp.
+		{ F1,
+			{ 0x55, 0x48, 0x83, 0xEC, 0x40, 0x48, 0x8D, 0x6C, 0x24, 0x20, 0x48, 0x2B, 0xE0, 0xFF, 0xD3, 0x48, 0x8D, 0x65, 0x20, 0x5D, 0xC3 },
+			{ 0x01, 0x0A, 0x03, 0x25, 0x0A, 0x03, 0x05, 0x72, 0x01, 0x50 } }, // SET_FPREG rbp + 20h, ALLOC_SMALL 40h, PUSH_NONVOL rbp.
+		{ F0,
+			{ 0x53, 0x48, 0x83, 0xEC, 0x20, 0x8B, 0x01, 0x90, 0x90, 0x48, 0x83, 0xC4, 0x20, 0x5B, 0xC3 },
+			{ 0x01, 0x05, 0x02, 0x00, 0x05, 0x32, 0x01, 0x30 } }, // ALLOC_SMALL 20h, PUSH_NONVOL rbx.
+	};
+}
+
+// the return addresses after the calls.
+
+static constexpr ULONG RetToThreadStart = ThreadStart + 0x09;
+static constexpr ULONG RetToF3Cold = F3Cold + 0x05;
+static constexpr ULONG RetToF2 = F2 + 0x0E;
+static constexpr ULONG RetToF1 = F1 + 0x0F;
+
+// a test command: the stack walked with the unwind info and scanned, from the context of the state change.
+
+static constexpr ULONG MaxFrames = 64;
+
+struct Frames
+{
+	ULONG64 slots[MaxFrames];
+	ULONG64 rets[MaxFrames];
+	ULONG num;
+	BOOLEAN res;
+};
+
+static Frames Walked, Scanned;
+
+static VOID Store(Frames& f, BOOLEAN res, const eastl::vector<eastl::pair<ULONG64, ULONG64>>& addrs)
+{
+	f.res = res;
+	f.num = 0;
+
+	for (auto& a : addrs)
+		if (f.num < MaxFrames)
+		{
+			f.slots[f.num] = a.first;
+			f.rets[f.num] = a.second;
+			f.num++;
+		}
+}
+
+class Cmd_WALKSCAN : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "WALKSCAN"; }
+	virtual const CHAR* GetDesc() { return "Walks and scans the stack."; }
+	virtual const CHAR* GetSyntax() { return "WALKSCAN"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		BOOLEAN res = FALSE, is64 = FALSE;
+		eastl::vector<eastl::pair<ULONG64, ULONG64>> addrs;
+
+		co_await BcAwaiter_Join{ WalkStack(res, addrs, is64, params.context, params.is32bitCompat, MaxFrames) };
+		Store(Walked, res, addrs);
+
+		co_await BcAwaiter_Join{ ScanStackForRets(res, addrs, is64, ((CONTEXT*)params.context)->Rsp, params.is32bitCompat, MaxFrames) };
+		Store(Scanned, res, addrs);
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_WALKSCAN)
+
+static BOOLEAN Contains(const Frames& f, ULONG64 slot, ULONG64 ret)
+{
+	for (ULONG i = 0; i < f.num; i++)
+		if (f.slots[i] == slot && f.rets[i] == ret)
+			return TRUE;
+
+	return FALSE;
+}
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x40);
+
+	// the module, in the host memory: its unwind info is read directly, as by the load image notify routine.
+
+	ULONG64 base = t.AddModule("walk.sys", 0, ImageSize);
+
+	std::vector<IMAGE_RUNTIME_FUNCTION_ENTRY> pdata;
+	ULONG unwindRva = UnwindRva;
+
+	for (const Function& f : Functions())
+	{
+		BYTE int3s[0x40];
+		::memset(int3s, 0xCC, sizeof(int3s));
+		t.Write(base + f.rva, int3s, sizeof(int3s));
+
+		t.Write(base + f.rva, f.code.data(), (ULONG)f.code.size());
+		t.Write(base + unwindRva, f.unwindInfo.data(), (ULONG)f.unwindInfo.size());
+
+		if (f.rva == F3Cold)
+		{
+			IMAGE_RUNTIME_FUNCTION_ENTRY parent = pdata.back();
+			t.Write(base + unwindRva + 4, &parent, sizeof(parent));
+		}
+
+		pdata.push_back({ f.rva, f.rva + (ULONG)f.code.size(), unwindRva });
+
+		unwindRva += 0x20;
+	}
+
+	std::sort(pdata.begin(), pdata.end(), [](auto& a, auto& b) { return a.BeginAddress < b.BeginAddress; });
+
+	t.SetPdata(base, pdata.data(), (ULONG)pdata.size(), PdataRva);
+
+	IMAGE_INFO info = {};
+	info.SystemModeImage = 1;
+	info.ImageBase = (PVOID)base;
+	info.ImageSize = ImageSize;
+
+	Platform::LoadImageNotifyRoutine(NULL, NULL, &info);
+
+	CHECK(Root::I->UnwindInfo && Root::I->UnwindInfo->entriesNum == pdata.size());
+
+	// the stack, from the RSP of F0 after its prolog.
+
+	const ULONG64 s = t.Context[0].Rsp;
+
+	auto put = [&](ULONG64 offset, ULONG64 value) { t.Write(s + offset, &value, sizeof(value)); };
+
+	put(0x20, 0x5555); // the RBX of F1.
+	put(0x28, base + RetToF1);
+
+	put(0x40, base + RetToF2); // in the dynamic allocation of F1: stale.
+	put(0x170, 0x6666); // the RBP of F2.
+	put(0x178, base + RetToF2);
+
+	put(0x800, base + RetToThreadStart); // in the locals of F2: stale.
+	put(0x900, base + F1); // a function pointer.
+	put(0x1180, 0x7777); // the RDI of F3.
+	put(0x1188, 0x8888); // the RBP of F3.
+	put(0x1190, base + RetToF3Cold);
+
+	put(0x11C8, 0x9999); // the RSI of ThreadStart.
+	put(0x11D0, base + RetToThreadStart);
+
+	put(0x1200, 0); // the end of the chain.
+
+	const std::vector<std::pair<ULONG64, ULONG64>> expected = {
+		{ s + 0x28, base + RetToF1 },
+		{ s + 0x178, base + RetToF2 },
+		{ s + 0x1190, base + RetToF3Cold },
+		{ s + 0x11D0, base + RetToThreadStart },
+	};
+
+	auto isExpected = [&](const Frames& f) -> BOOLEAN {
+
+		if (!f.res || f.num != expected.size())
+			return FALSE;
+
+		for (ULONG i = 0; i < f.num; i++)
+			if (f.slots[i] != expected[i].first || f.rets[i] != expected[i].second)
+				return FALSE;
+
+		return TRUE;
+	};
+
+	// F0 interrupted (by a single step) in its body, after its epilog adjusted RSP and before its "pop rbx". F1 moved RSP with a dynamic
+	// allocation: only RBP, set by the prolog of F1, gives its frame.
+
+	struct State
+	{
+		ULONG rip;
+		ULONG64 rsp;
+	};
+
+	for (State st : { State{ F0 + 0x05, 0 }, State{ F0 + 0x09, 0 }, State{ F0 + 0x0D, 0x20 } })
+	{
+		CONTEXT& ctx = t.Context[0];
+
+		ctx.Rsp = s + st.rsp;
+		ctx.Rbp = s + 0x150; // F1: the RSP after its prolog plus 20h.
+		ctx.Rbx = base + F0;
+		ctx.Rax = 0x100;
+
+		Walked = {};
+		Scanned = {};
+
+		t.Type("WALKSCAN");
+		t.Type("X");
+		ctx.Rip = base + st.rip;
+		t.SingleStep();
+
+		CHECK(isExpected(Walked));
+
+		// the scan finds the same frames, plus the stale return addresses.
+
+		for (auto& e : expected)
+			CHECK(Contains(Scanned, e.first, e.second));
+
+		CHECK(Contains(Scanned, s + 0x40, base + RetToF2));
+		CHECK(Contains(Scanned, s + 0x800, base + RetToThreadStart));
+		CHECK(!Contains(Scanned, s + 0x900, base + F1));
+		CHECK(Scanned.num == expected.size() + 2);
+	}
+
+	// F0 interrupted in its prolog, after its "push rbx": the walker can't unwind it and falls back to the scan.
+
+	{
+		CONTEXT& ctx = t.Context[0];
+
+		ctx.Rsp = s + 0x20;
+
+		Walked = {};
+		Scanned = {};
+
+		t.Type("WALKSCAN");
+		t.Type("X");
+		ctx.Rip = base + F0 + 1;
+		t.SingleStep();
+
+		CHECK(Walked.res && Walked.num == Scanned.num);
+		CHECK(Walked.num && Walked.slots[0] == s + 0x28 && Walked.rets[0] == base + RetToF1);
+	}
+
+	// the KD round trips of STACK and STACK -scan, each one in its own session (the memory cache is emptied at the resume).
+
+	t.Context[0].Rsp = s;
+
+	t.Context[0].Rip = base + F0 + 0x05;
+
+	t.Type("STACK");
+	t.Type("X");
+	t.SingleStep();
+
+	t.Type("STACK -scan");
+	t.Type("X");
+	t.SingleStep();
+
+	const SimTarget::CmdCounters* walk = t.GetCmd("STACK");
+	const SimTarget::CmdCounters* scan = t.GetCmd("STACK -scan");
+
+	CHECK(walk && scan);
+
+	if (walk && scan)
+	{
+		CHECK(walk->counters.roundTrips < scan->counters.roundTrips);
+		CHECK(walk->counters.bytesRead < scan->counters.bytesRead);
+
+		::printf("STACK: %u frames in %llu round trips (%llu bytes); STACK -scan: %u return addresses in %llu round trips (%llu bytes).\n",
+			(ULONG)expected.size(), walk->counters.roundTrips, walk->counters.bytesRead,
+			(ULONG)expected.size() + 2, scan->counters.roundTrips, scan->counters.bytesRead);
+	}
+
+	return Finish();
+}
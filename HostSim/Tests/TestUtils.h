@@ -0,0 +1,49 @@
+#pragma once
+
+#include "SimTarget.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+//
+// Shared by the tests: the checks and their failures, the clock of the benchmarks and the code where the sessions break in.
+//
+
+static int Failures = 0;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { ::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); Failures++; } } while (0)
+
+static constexpr ULONG64 CodeAddress = 0xFFFFF80000001000;
+
+static inline double Now()
+{
+	timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// a NOP sled at CodeAddress, with a hardcoded INT3 at its start: the address passed to SimTarget::BreakIn.
+
+static inline VOID WriteCode(SimTarget& t, ULONG size)
+{
+	BYTE code[0x200];
+
+	if (size > sizeof(code))
+		::HostSim_FatalError("WriteCode: the code is too long.");
+
+	::memset(code, 0x90, size);
+	code[0] = 0xCC;
+	t.Write(CodeAddress, code, size);
+}
+
+// the exit code of the test, after the count of the failed checks.
+
+static inline int Finish()
+{
+	if (Failures)
+		::printf("%d checks failed.\n", Failures);
+
+	return Failures ? 1 : 0;
+}
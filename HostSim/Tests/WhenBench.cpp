@@ -0,0 +1,167 @@
+#include "TestUtils.h"
+
+#include <stdio.h>
+
+#include "Cmd.h"
+#include "Root.h"
+#include "QuickJSCppInterface.h"
+
+//
+// BPX WHEN conditions with the QuickJS build of BugChecker: the function compiled once by BPX and called at each hit,
+// compared with the evaluation of the source at each hit, which was done before. Then a conditional breakpoint hit a
+// thousand times on the simulated target.
+//
+
+static constexpr ULONG64 BpAddress = CodeAddress + 0x10;
+
+static constexpr ULONG EvalsNum = 2000;
+static constexpr ULONG HitsNum = 1000;
+static constexpr ULONG TrueEvery = 100; // the condition is true at one hit out of 100.
+
+static const CHAR* Condition = "rcx == 7 && (rdx & 0xFF) != 0x10";
+
+// a test command: the same condition called and evaluated EvalsNum times, on the current context.
+
+static double CallTime = 0, EvalTime = 0;
+static ULONG CallTrueNum = 0, EvalTrueNum = 0, MismatchesNum = 0;
+
+class Cmd_WHENBENCH : public Cmd
+{
+public:
+
+	virtual const CHAR* GetId() { return "WHENBENCH"; }
+	virtual const CHAR* GetDesc() { return "Compares the compiled and the evaluated WHEN condition."; }
+	virtual const CHAR* GetSyntax() { return "WHENBENCH"; }
+
+	virtual BcCoroutine Execute(CmdParams& params) noexcept
+	{
+		LONG fn = QuickJSCppInterface::Compile(Condition);
+
+		if (fn < 0)
+		{
+			Print("Unable to compile the condition.");
+			co_return;
+		}
+
+		CONTEXT* context = (CONTEXT*)params.context;
+
+		for (ULONG pass = 0; pass < 2; pass++)
+		{
+			double start = Now();
+
+			for (ULONG i = 0; i < EvalsNum; i++)
+			{
+				context->Rcx = i % TrueEvery ? 8 : 7;
+				context->Rdx = i;
+
+				NullableU64 called, evaluated;
+
+				if (!pass)
+				{
+					co_await BcAwaiter_Join{ QuickJSCppInterface::Call(fn, params.context, params.contextLen, params.is32bitCompat, &called, TRUE) };
+					CallTrueNum += !called.isNull && called.value;
+				}
+				else
+				{
+					co_await BcAwaiter_Join{ QuickJSCppInterface::Eval(Condition, params.context, params.contextLen, params.is32bitCompat, &evaluated, TRUE) };
+					EvalTrueNum += !evaluated.isNull && evaluated.value;
+				}
+			}
+
+			(!pass ? CallTime : EvalTime) = Now() - start;
+		}
+
+		// both give the same result on the same context.
+
+		for (ULONG i = 0; i < TrueEvery; i++)
+		{
+			context->Rcx = i % 3 ? 7 : i;
+			context->Rdx = i % 2 ? 0x110 : 0x111;
+
+			NullableU64 called, evaluated;
+
+			co_await BcAwaiter_Join{ QuickJSCppInterface::Call(fn, params.context, params.contextLen, params.is32bitCompat, &called, TRUE) };
+			co_await BcAwaiter_Join{ QuickJSCppInterface::Eval(Condition, params.context, params.contextLen, params.is32bitCompat, &evaluated, TRUE) };
+
+			if (called.isNull || evaluated.isNull || called.value != evaluated.value)
+				MismatchesNum++;
+		}
+
+		QuickJSCppInterface::FreeCompiled(fn);
+
+		co_return;
+	}
+};
+
+REGISTER_COMMAND(Cmd_WHENBENCH)
+
+int main()
+{
+	SimTarget t;
+
+	WriteCode(t, 0x40);
+
+	// the benchmark, in a session.
+
+	t.Type("WHENBENCH");
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(CallTrueNum == EvalsNum / TrueEvery);
+	CHECK(EvalTrueNum == EvalsNum / TrueEvery);
+	CHECK(MismatchesNum == 0);
+
+	::printf("%s: compiled %.1f us per call, evaluated %.1f us per evaluation (%.1fx).\n",
+		Condition, CallTime * 1e6 / EvalsNum, EvalTime * 1e6 / EvalsNum, CallTime ? EvalTime / CallTime : 0);
+
+	// the breakpoint: BugChecker continues without breaking in while the condition is false.
+
+	CHAR bpx[128];
+	::sprintf(bpx, "BPX %llX WHEN %s", BpAddress, Condition);
+
+	t.Type(bpx);
+	t.Type("X");
+	t.BreakIn(CodeAddress);
+
+	CHECK(t.KdBreakPointsNum() == 1);
+
+	ULONG64 breakIns = 0;
+
+	for (ULONG i = 0; i < HitsNum; i++)
+	{
+		t.Context[0].Rip = BpAddress;
+		t.Context[0].Rcx = i % TrueEvery ? 8 : 7;
+		t.Context[0].Rdx = i;
+
+		if (t.Context[0].Rcx == 7)
+		{
+			t.Type("X"); // the condition is true: the user resumes.
+			breakIns++;
+		}
+
+		t.HitBreakPoint(BpAddress);
+		t.Run(1); // the single step that writes the breakpoint again.
+	}
+
+	{
+		BcCall _call_;
+
+		BreakPoint* bp = Root::I->BreakPoints.Find(BpAddress);
+
+		CHECK(bp != NULL);
+
+		if (bp)
+		{
+			CHECK(bp->whenFn >= 0);
+			CHECK(bp->hitsNum == HitsNum);
+			CHECK(bp->trueNum == breakIns);
+
+			::printf("BPX WHEN: %u hits, %llu break ins, %.1f us per condition.\n", HitsNum, breakIns,
+				Root::I->RdtscTicksPerMs ? bp->condTicks * 1000.0 / Root::I->RdtscTicksPerMs / HitsNum : 0.0);
+		}
+	}
+
+	CHECK(t.KdBreakPointsNum() == 1);
+
+	return Finish();
+}
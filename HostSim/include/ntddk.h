@@ -0,0 +1,764 @@
+//
+// === ntddk.h ===
+//
+// Host replacement of the WDK header, used to compile the BugChecker sources on Linux with GCC. It
+// declares only the types, constants and kernel APIs that BugChecker uses: the APIs are implemented
+// in "KernelFill.cpp" on top of the C library and of the simulated target (see "SimTarget.h").
+//
+// This file is included by C and C++ sources, so it must remain valid C.
+//
+
+#ifndef HOSTSIM_NTDDK_H
+#define HOSTSIM_NTDDK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+// the C++ library headers use identifiers like "__in" and "__out": they are included before the SAL annotations are defined.
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include <compare>
+#include <coroutine>
+#include <iterator>
+#include <limits>
+#include <cmath>
+#endif
+
+#ifdef __cplusplus
+#define HOSTSIM_EXTERN_C extern "C"
+#define HOSTSIM_EXTERN_C_BEGIN extern "C" {
+#define HOSTSIM_EXTERN_C_END }
+#else
+#define HOSTSIM_EXTERN_C extern
+#define HOSTSIM_EXTERN_C_BEGIN
+#define HOSTSIM_EXTERN_C_END
+#endif
+
+//
+// MSVC keywords and annotations.
+//
+
+#define __int64 long long
+#define __int32 int
+#define __int16 short
+#define __int8 char
+
+#define __stdcall
+#define __cdecl
+#define __fastcall
+#define __declspec(x)
+#define __forceinline inline __attribute__((always_inline))
+
+#undef __try // libstdc++ defines it too, with the exceptions disabled.
+#define __try if (1)
+#define __except(x) else if (0)
+
+#define IN
+#define OUT
+#define OPTIONAL
+#define NTAPI
+#define NTKERNELAPI
+#define NTSYSAPI
+#define DECLSPEC_ALIGN(x) __attribute__((aligned(x)))
+#define UNREFERENCED_PARAMETER(p) ((void)(p))
+#define ASSERT(x) ((void)0)
+
+#define __in
+#define __in_opt
+#define __in_z
+#define __in_z_opt
+#define __in_ecount(x)
+#define __in_bcount(x)
+#define __out
+#define __out_opt
+#define __out_ecount(x)
+#define __out_bcount(x)
+#define __out_ecount_z_opt(x)
+#define __inout
+#define __inout_opt
+#define __deref_out
+#define __deref_out_opt
+#define __deref_opt_out_z
+#define __format_string
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+#define _Inout_opt_
+
+//
+// Base types: LONG and ULONG are 32 bit wide, as on Windows (LLP64), and WCHAR is 16 bit wide (-fshort-wchar).
+//
+
+typedef void VOID;
+typedef void* PVOID;
+typedef char CHAR;
+typedef unsigned char UCHAR;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef int LONG;
+typedef unsigned int ULONG;
+typedef int LONG32;
+typedef unsigned int ULONG32;
+typedef long long LONG64;
+typedef unsigned long long ULONG64;
+typedef unsigned long long DWORD64;
+typedef unsigned int DWORD32;
+typedef long long LONGLONG;
+typedef unsigned long long ULONGLONG;
+typedef long long LONG_PTR;
+typedef unsigned long long ULONG_PTR;
+typedef long long INT_PTR;
+typedef unsigned long long UINT_PTR;
+typedef unsigned long long SIZE_T;
+typedef unsigned char BOOLEAN;
+typedef wchar_t WCHAR;
+typedef LONG NTSTATUS;
+typedef UCHAR KIRQL;
+typedef CHAR KPROCESSOR_MODE;
+typedef PVOID HANDLE;
+
+typedef CHAR* PCHAR;
+typedef UCHAR* PUCHAR;
+typedef SHORT* PSHORT;
+typedef USHORT* PUSHORT;
+typedef LONG* PLONG;
+typedef ULONG* PULONG;
+typedef ULONG64* PULONG64;
+typedef ULONG_PTR* PULONG_PTR;
+typedef SIZE_T* PSIZE_T;
+typedef BOOLEAN* PBOOLEAN;
+typedef WCHAR* PWCHAR;
+typedef WCHAR* PWSTR;
+typedef const WCHAR* PCWSTR;
+typedef CHAR* PSTR;
+typedef const CHAR* PCSTR;
+typedef HANDLE* PHANDLE;
+typedef KIRQL* PKIRQL;
+
+#define CONST const
+
+#define TRUE 1
+#define FALSE 0
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+#define ANYSIZE_ARRAY 1
+#define MAXIMUM_FILENAME_LENGTH 256
+
+#define MAXULONG 0xFFFFFFFF
+#define MAXLONG 0x7FFFFFFF
+#define MAXULONG_PTR (~((ULONG_PTR)0))
+
+#define _I64_MIN (-9223372036854775807LL - 1)
+#define _I64_MAX 9223372036854775807LL
+#define _UI64_MAX 0xFFFFFFFFFFFFFFFFULL
+
+typedef void* _locale_t;
+
+//
+// Names of the Microsoft C library.
+//
+
+#define _stricmp strcasecmp
+#define _strnicmp strncasecmp
+#define _snprintf snprintf
+#define _vsnprintf vsnprintf
+
+typedef union _LARGE_INTEGER
+{
+	struct
+	{
+		ULONG LowPart;
+		LONG HighPart;
+	};
+	struct
+	{
+		ULONG LowPart;
+		LONG HighPart;
+	} u;
+	LONGLONG QuadPart;
+} LARGE_INTEGER, * PLARGE_INTEGER;
+
+typedef LARGE_INTEGER PHYSICAL_ADDRESS;
+
+#define FIELD_OFFSET(type, field) ((LONG)offsetof(type, field))
+#define CONTAINING_RECORD(address, type, field) ((type*)((PCHAR)(address) - (ULONG_PTR)(&((type*)0)->field)))
+
+#define PAGE_SIZE 0x1000
+#define MM_USER_PROBE_ADDRESS 0x7FFFFFFF0000ULL
+
+//
+// Status codes.
+//
+
+#define NT_SUCCESS(Status) (((NTSTATUS)(Status)) >= 0)
+
+#define STATUS_SUCCESS                   ((NTSTATUS)0x00000000L)
+#define STATUS_PENDING                   ((NTSTATUS)0x00000103L)
+#define STATUS_UNSUCCESSFUL              ((NTSTATUS)0xC0000001L)
+#define STATUS_NOT_IMPLEMENTED           ((NTSTATUS)0xC0000002L)
+#define STATUS_INVALID_PARAMETER         ((NTSTATUS)0xC000000DL)
+#define STATUS_NO_SUCH_FILE              ((NTSTATUS)0xC000000FL)
+#define STATUS_END_OF_FILE               ((NTSTATUS)0xC0000011L)
+#define STATUS_OBJECT_NAME_NOT_FOUND     ((NTSTATUS)0xC0000034L)
+#define STATUS_ACCESS_VIOLATION          ((NTSTATUS)0xC0000005L)
+#define STATUS_INSUFFICIENT_RESOURCES    ((NTSTATUS)0xC000009AL)
+#define STATUS_BREAKPOINT                ((NTSTATUS)0x80000003L)
+#define STATUS_SINGLE_STEP               ((NTSTATUS)0x80000004L)
+#define STATUS_WX86_BREAKPOINT           ((NTSTATUS)0x4000001FL)
+#define STATUS_WX86_SINGLE_STEP          ((NTSTATUS)0x4000001EL)
+
+#define DBG_CONTINUE                     ((NTSTATUS)0x00010002L)
+#define DBG_EXCEPTION_HANDLED            ((NTSTATUS)0x00010001L)
+
+//
+// IRQLs.
+//
+
+#define PASSIVE_LEVEL 0
+#define APC_LEVEL 1
+#define DISPATCH_LEVEL 2
+#define CLOCK_LEVEL 13
+#define HIGH_LEVEL 15
+
+//
+// Lists and strings.
+//
+
+typedef struct _LIST_ENTRY
+{
+	struct _LIST_ENTRY* Flink;
+	struct _LIST_ENTRY* Blink;
+} LIST_ENTRY, * PLIST_ENTRY;
+
+typedef struct _UNICODE_STRING
+{
+	USHORT Length;
+	USHORT MaximumLength;
+	PWSTR Buffer;
+} UNICODE_STRING, * PUNICODE_STRING;
+
+typedef const UNICODE_STRING* PCUNICODE_STRING;
+
+typedef struct LIST_ENTRY32
+{
+	ULONG Flink;
+	ULONG Blink;
+} LIST_ENTRY32, * PLIST_ENTRY32;
+
+typedef struct _STRING32
+{
+	USHORT Length;
+	USHORT MaximumLength;
+	ULONG Buffer;
+} STRING32, * PSTRING32, UNICODE_STRING32, * PUNICODE_STRING32;
+
+typedef struct _GUID
+{
+	ULONG Data1;
+	USHORT Data2;
+	USHORT Data3;
+	UCHAR Data4[8];
+} GUID;
+
+typedef struct _ANSI_STRING
+{
+	USHORT Length;
+	USHORT MaximumLength;
+	PCHAR Buffer;
+} ANSI_STRING, * PANSI_STRING;
+
+//
+// Processor context (AMD64 layout, 1232 bytes) and exceptions.
+//
+
+typedef struct DECLSPEC_ALIGN(16) _M128A
+{
+	ULONGLONG Low;
+	LONGLONG High;
+} M128A, * PM128A;
+
+typedef struct DECLSPEC_ALIGN(16) _XSAVE_FORMAT
+{
+	USHORT ControlWord;
+	USHORT StatusWord;
+	UCHAR TagWord;
+	UCHAR Reserved1;
+	USHORT ErrorOpcode;
+	ULONG ErrorOffset;
+	USHORT ErrorSelector;
+	USHORT Reserved2;
+	ULONG DataOffset;
+	USHORT DataSelector;
+	USHORT Reserved3;
+	ULONG MxCsr;
+	ULONG MxCsr_Mask;
+	M128A FloatRegisters[8];
+	M128A XmmRegisters[16];
+	UCHAR Reserved4[96];
+} XSAVE_FORMAT, * PXSAVE_FORMAT;
+
+typedef XSAVE_FORMAT XMM_SAVE_AREA32, * PXMM_SAVE_AREA32;
+
+typedef struct DECLSPEC_ALIGN(16) _CONTEXT
+{
+	DWORD64 P1Home;
+	DWORD64 P2Home;
+	DWORD64 P3Home;
+	DWORD64 P4Home;
+	DWORD64 P5Home;
+	DWORD64 P6Home;
+
+	ULONG ContextFlags;
+	ULONG MxCsr;
+
+	USHORT SegCs;
+	USHORT SegDs;
+	USHORT SegEs;
+	USHORT SegFs;
+	USHORT SegGs;
+	USHORT SegSs;
+	ULONG EFlags;
+
+	DWORD64 Dr0;
+	DWORD64 Dr1;
+	DWORD64 Dr2;
+	DWORD64 Dr3;
+	DWORD64 Dr6;
+	DWORD64 Dr7;
+
+	DWORD64 Rax;
+	DWORD64 Rcx;
+	DWORD64 Rdx;
+	DWORD64 Rbx;
+	DWORD64 Rsp;
+	DWORD64 Rbp;
+	DWORD64 Rsi;
+	DWORD64 Rdi;
+	DWORD64 R8;
+	DWORD64 R9;
+	DWORD64 R10;
+	DWORD64 R11;
+	DWORD64 R12;
+	DWORD64 R13;
+	DWORD64 R14;
+	DWORD64 R15;
+
+	DWORD64 Rip;
+
+	union
+	{
+		XMM_SAVE_AREA32 FltSave;
+		struct
+		{
+			M128A Header[2];
+			M128A Legacy[8];
+			M128A Xmm0;
+			M128A Xmm1;
+			M128A Xmm2;
+			M128A Xmm3;
+			M128A Xmm4;
+			M128A Xmm5;
+			M128A Xmm6;
+			M128A Xmm7;
+			M128A Xmm8;
+			M128A Xmm9;
+			M128A Xmm10;
+			M128A Xmm11;
+			M128A Xmm12;
+			M128A Xmm13;
+			M128A Xmm14;
+			M128A Xmm15;
+		};
+	};
+
+	M128A VectorRegister[26];
+	DWORD64 VectorControl;
+
+	DWORD64 DebugControl;
+	DWORD64 LastBranchToRip;
+	DWORD64 LastBranchFromRip;
+	DWORD64 LastExceptionToRip;
+	DWORD64 LastExceptionFromRip;
+} CONTEXT, * PCONTEXT;
+
+#define EXCEPTION_MAXIMUM_PARAMETERS 15
+
+typedef struct _EXCEPTION_RECORD
+{
+	NTSTATUS ExceptionCode;
+	ULONG ExceptionFlags;
+	struct _EXCEPTION_RECORD* ExceptionRecord;
+	PVOID ExceptionAddress;
+	ULONG NumberParameters;
+	ULONG_PTR ExceptionInformation[EXCEPTION_MAXIMUM_PARAMETERS];
+} EXCEPTION_RECORD, * PEXCEPTION_RECORD;
+
+typedef struct _EXCEPTION_RECORD64
+{
+	NTSTATUS ExceptionCode;
+	ULONG ExceptionFlags;
+	ULONG64 ExceptionRecord;
+	ULONG64 ExceptionAddress;
+	ULONG NumberParameters;
+	ULONG __unusedAlignment;
+	ULONG64 ExceptionInformation[EXCEPTION_MAXIMUM_PARAMETERS];
+} EXCEPTION_RECORD64, * PEXCEPTION_RECORD64;
+
+typedef enum _EXCEPTION_DISPOSITION
+{
+	ExceptionContinueExecution,
+	ExceptionContinueSearch,
+	ExceptionNestedException,
+	ExceptionCollidedUnwind
+} EXCEPTION_DISPOSITION;
+
+#define EXCEPTION_EXECUTE_HANDLER 1
+
+//
+// Kernel objects: only the fields used by BugChecker are meaningful.
+//
+
+typedef enum _MODE
+{
+	KernelMode,
+	UserMode,
+	MaximumMode
+} MODE;
+
+typedef enum _POOL_TYPE
+{
+	NonPagedPool,
+	PagedPool
+} POOL_TYPE;
+
+typedef enum _MEMORY_CACHING_TYPE
+{
+	MmNonCached,
+	MmCached,
+	MmWriteCombined
+} MEMORY_CACHING_TYPE;
+
+typedef enum _LOCK_OPERATION
+{
+	IoReadAccess,
+	IoWriteAccess,
+	IoModifyAccess
+} LOCK_OPERATION;
+
+typedef enum _MM_PAGE_PRIORITY
+{
+	LowPagePriority,
+	NormalPagePriority = 16,
+	HighPagePriority = 32
+} MM_PAGE_PRIORITY;
+
+typedef struct _KPROCESS* PKPROCESS, * PRKPROCESS, * PEPROCESS;
+typedef struct _KTHREAD* PKTHREAD, * PETHREAD;
+
+typedef struct _MDL
+{
+	struct _MDL* Next;
+	PVOID MappedSystemVa;
+	PVOID StartVa;
+	ULONG ByteCount;
+} MDL, * PMDL;
+
+typedef struct _IO_STATUS_BLOCK
+{
+	union
+	{
+		NTSTATUS Status;
+		PVOID Pointer;
+	};
+	ULONG_PTR Information;
+} IO_STATUS_BLOCK, * PIO_STATUS_BLOCK;
+
+typedef struct _IO_STACK_LOCATION
+{
+	UCHAR MajorFunction;
+	UCHAR MinorFunction;
+	union
+	{
+		struct
+		{
+			ULONG OutputBufferLength;
+			ULONG InputBufferLength;
+			ULONG IoControlCode;
+			PVOID Type3InputBuffer;
+		} DeviceIoControl;
+	} Parameters;
+} IO_STACK_LOCATION, * PIO_STACK_LOCATION;
+
+typedef struct _IRP
+{
+	IO_STATUS_BLOCK IoStatus;
+	union
+	{
+		PVOID SystemBuffer;
+	} AssociatedIrp;
+	IO_STACK_LOCATION CurrentStackLocation;
+} IRP, * PIRP;
+
+struct _DRIVER_OBJECT;
+
+typedef struct _DEVICE_OBJECT
+{
+	struct _DRIVER_OBJECT* DriverObject;
+	ULONG Flags;
+} DEVICE_OBJECT, * PDEVICE_OBJECT;
+
+typedef NTSTATUS(*PDRIVER_DISPATCH)(PDEVICE_OBJECT DeviceObject, PIRP Irp);
+typedef VOID(*PDRIVER_UNLOAD)(struct _DRIVER_OBJECT* DriverObject);
+
+#define IRP_MJ_CREATE 0x00
+#define IRP_MJ_CLOSE 0x02
+#define IRP_MJ_DEVICE_CONTROL 0x0e
+#define IRP_MJ_MAXIMUM_FUNCTION 0x1b
+
+typedef struct _DRIVER_OBJECT
+{
+	PDEVICE_OBJECT DeviceObject;
+	PVOID DriverSection;
+	PDRIVER_UNLOAD DriverUnload;
+	PDRIVER_DISPATCH MajorFunction[IRP_MJ_MAXIMUM_FUNCTION + 1];
+} DRIVER_OBJECT, * PDRIVER_OBJECT;
+
+#define IO_NO_INCREMENT 0
+#define IO_TYPE_DEVICE 0x00000003
+#define DO_DEVICE_INITIALIZING 0x00000080
+#define FILE_DEVICE_UNKNOWN 0x00000022
+#define FILE_DEVICE_SECURE_OPEN 0x00000100
+
+#define METHOD_BUFFERED 0
+#define FILE_ANY_ACCESS 0
+#define FILE_READ_ACCESS 0x0001
+#define FILE_WRITE_ACCESS 0x0002
+#define CTL_CODE(DeviceType, Function, Method, Access) (((DeviceType) << 16) | ((Access) << 14) | ((Function) << 2) | (Method))
+
+typedef struct _IMAGE_INFO
+{
+	union
+	{
+		ULONG Properties;
+		struct
+		{
+			ULONG ImageAddressingMode : 8;
+			ULONG SystemModeImage : 1;
+			ULONG ImageMappedToAllPids : 1;
+			ULONG ExtendedInfoPresent : 1;
+			ULONG Reserved : 21;
+		};
+	};
+	PVOID ImageBase;
+	ULONG ImageSelector;
+	SIZE_T ImageSize;
+	ULONG ImageSectionNumber;
+} IMAGE_INFO, * PIMAGE_INFO;
+
+typedef VOID(*PCREATE_PROCESS_NOTIFY_ROUTINE)(HANDLE ParentId, HANDLE ProcessId, BOOLEAN Create);
+typedef VOID(*PLOAD_IMAGE_NOTIFY_ROUTINE)(PUNICODE_STRING FullImageName, HANDLE ProcessId, PIMAGE_INFO ImageInfo);
+
+typedef struct _PROCESSOR_NUMBER
+{
+	USHORT Group;
+	UCHAR Number;
+	UCHAR Reserved;
+} PROCESSOR_NUMBER, * PPROCESSOR_NUMBER;
+
+#define ALL_PROCESSOR_GROUPS 0xffff
+
+//
+// Files.
+//
+
+typedef struct _OBJECT_ATTRIBUTES
+{
+	ULONG Length;
+	HANDLE RootDirectory;
+	PUNICODE_STRING ObjectName;
+	ULONG Attributes;
+	PVOID SecurityDescriptor;
+	PVOID SecurityQualityOfService;
+} OBJECT_ATTRIBUTES, * POBJECT_ATTRIBUTES;
+
+#define OBJ_CASE_INSENSITIVE 0x00000040L
+#define OBJ_KERNEL_HANDLE 0x00000200L
+
+#define InitializeObjectAttributes(p, n, a, r, s) { \
+	(p)->Length = sizeof(OBJECT_ATTRIBUTES); \
+	(p)->RootDirectory = r; \
+	(p)->Attributes = a; \
+	(p)->ObjectName = n; \
+	(p)->SecurityDescriptor = s; \
+	(p)->SecurityQualityOfService = NULL; \
+	}
+
+typedef ULONG ACCESS_MASK;
+
+#define SYNCHRONIZE 0x00100000L
+#define GENERIC_READ 0x80000000L
+#define FILE_READ_DATA 0x0001
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define FILE_OPEN 0x00000001
+#define FILE_NON_DIRECTORY_FILE 0x00000040
+#define FILE_RANDOM_ACCESS 0x00000800
+#define FILE_SYNCHRONOUS_IO_NONALERT 0x00000020
+
+typedef enum _FILE_INFORMATION_CLASS
+{
+	FileStandardInformation = 5
+} FILE_INFORMATION_CLASS;
+
+typedef struct _FILE_STANDARD_INFORMATION
+{
+	LARGE_INTEGER AllocationSize;
+	LARGE_INTEGER EndOfFile;
+	ULONG NumberOfLinks;
+	BOOLEAN DeletePending;
+	BOOLEAN Directory;
+} FILE_STANDARD_INFORMATION, * PFILE_STANDARD_INFORMATION;
+
+#define PAGE_EXECUTE_READWRITE 0x40
+
+//
+// Kernel shared data and debugger globals.
+//
+
+typedef struct _KUSER_SHARED_DATA
+{
+	UCHAR KdDebuggerEnabled;
+} KUSER_SHARED_DATA, * PKUSER_SHARED_DATA;
+
+HOSTSIM_EXTERN_C KUSER_SHARED_DATA HostSim_SharedUserData;
+HOSTSIM_EXTERN_C PBOOLEAN KdDebuggerNotPresent;
+HOSTSIM_EXTERN_C PBOOLEAN KdDebuggerEnabled;
+
+#define SharedUserData (&HostSim_SharedUserData)
+#define KD_DEBUGGER_NOT_PRESENT (*KdDebuggerNotPresent)
+
+//
+// Kernel APIs (see "KernelFill.cpp").
+//
+
+HOSTSIM_EXTERN_C_BEGIN
+
+ULONG DbgPrint(PCSTR Format, ...);
+
+PVOID ExAllocatePool(POOL_TYPE PoolType, SIZE_T NumberOfBytes);
+VOID ExFreePool(PVOID P);
+
+LARGE_INTEGER KeQueryPerformanceCounter(PLARGE_INTEGER PerformanceFrequency);
+ULONG KeQueryMaximumProcessorCountEx(USHORT GroupNumber);
+ULONG KeGetCurrentProcessorNumberEx(PPROCESSOR_NUMBER ProcNumber);
+
+VOID RtlInitUnicodeString(PUNICODE_STRING DestinationString, PCWSTR SourceString);
+PVOID RtlImageDirectoryEntryToData(PVOID Base, BOOLEAN MappedAsImage, USHORT DirectoryEntry, PULONG Size);
+
+PVOID MmMapIoSpace(PHYSICAL_ADDRESS PhysicalAddress, SIZE_T NumberOfBytes, MEMORY_CACHING_TYPE CacheType);
+VOID MmUnmapIoSpace(PVOID BaseAddress, SIZE_T NumberOfBytes);
+BOOLEAN MmIsAddressValid(PVOID VirtualAddress);
+VOID MmProbeAndLockPages(PMDL MemoryDescriptorList, KPROCESSOR_MODE AccessMode, LOCK_OPERATION Operation);
+VOID MmUnlockPages(PMDL MemoryDescriptorList);
+PVOID MmMapLockedPagesSpecifyCache(PMDL MemoryDescriptorList, KPROCESSOR_MODE AccessMode, MEMORY_CACHING_TYPE CacheType, PVOID RequestedAddress, ULONG BugCheckOnFailure, ULONG Priority);
+VOID MmUnmapLockedPages(PVOID BaseAddress, PMDL MemoryDescriptorList);
+NTSTATUS MmProtectMdlSystemAddress(PMDL MemoryDescriptorList, ULONG NewProtect);
+
+PMDL IoAllocateMdl(PVOID VirtualAddress, ULONG Length, BOOLEAN SecondaryBuffer, BOOLEAN ChargeQuota, PIRP Irp);
+VOID IoFreeMdl(PMDL Mdl);
+NTSTATUS IoCreateDevice(PDRIVER_OBJECT DriverObject, ULONG DeviceExtensionSize, PUNICODE_STRING DeviceName, ULONG DeviceType, ULONG DeviceCharacteristics, BOOLEAN Exclusive, PDEVICE_OBJECT* DeviceObject);
+VOID IoDeleteDevice(PDEVICE_OBJECT DeviceObject);
+NTSTATUS IoCreateSymbolicLink(PUNICODE_STRING SymbolicLinkName, PUNICODE_STRING DeviceName);
+NTSTATUS IoDeleteSymbolicLink(PUNICODE_STRING SymbolicLinkName);
+VOID IoCompleteRequest(PIRP Irp, char PriorityBoost);
+PIO_STACK_LOCATION IoGetCurrentIrpStackLocation(PIRP Irp);
+
+NTSTATUS PsSetCreateProcessNotifyRoutine(PCREATE_PROCESS_NOTIFY_ROUTINE NotifyRoutine, BOOLEAN Remove);
+NTSTATUS PsSetLoadImageNotifyRoutine(PLOAD_IMAGE_NOTIFY_ROUTINE NotifyRoutine);
+NTSTATUS PsRemoveLoadImageNotifyRoutine(PLOAD_IMAGE_NOTIFY_ROUTINE NotifyRoutine);
+
+VOID ObDereferenceObject(PVOID Object);
+
+NTSTATUS ZwCreateFile(PHANDLE FileHandle, ACCESS_MASK DesiredAccess, POBJECT_ATTRIBUTES ObjectAttributes, PIO_STATUS_BLOCK IoStatusBlock, PLARGE_INTEGER AllocationSize, ULONG FileAttributes, ULONG ShareAccess, ULONG CreateDisposition, ULONG CreateOptions, PVOID EaBuffer, ULONG EaLength);
+NTSTATUS ZwQueryInformationFile(HANDLE FileHandle, PIO_STATUS_BLOCK IoStatusBlock, PVOID FileInformation, ULONG Length, FILE_INFORMATION_CLASS FileInformationClass);
+NTSTATUS ZwReadFile(HANDLE FileHandle, HANDLE Event, PVOID ApcRoutine, PVOID ApcContext, PIO_STATUS_BLOCK IoStatusBlock, PVOID Buffer, ULONG Length, PLARGE_INTEGER ByteOffset, PULONG Key);
+NTSTATUS ZwClose(HANDLE Handle);
+
+//
+// Intrinsics: the interrupt flag and the GS segment of the processor are simulated.
+//
+
+void _enable(void);
+void _disable(void);
+unsigned long long __readeflags(void);
+unsigned long long __readgsqword(unsigned long Offset);
+void __outdword(unsigned short Port, unsigned long Data);
+unsigned long __indword(unsigned short Port);
+
+//
+// Simulator hooks.
+//
+
+__attribute__((noreturn)) void HostSim_FatalError(const char* msg);
+
+HOSTSIM_EXTERN_C_END
+
+static inline unsigned long long __rdtsc(void)
+{
+	return __builtin_ia32_rdtsc();
+}
+
+static inline void _mm_pause(void)
+{
+	__builtin_ia32_pause();
+}
+
+static inline LONG _InterlockedIncrement(volatile LONG* Addend)
+{
+	return __atomic_add_fetch(Addend, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG _InterlockedDecrement(volatile LONG* Addend)
+{
+	return __atomic_sub_fetch(Addend, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG _InterlockedExchange(volatile LONG* Target, LONG Value)
+{
+	return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG _InterlockedCompareExchange(volatile LONG* Destination, LONG Exchange, LONG Comparand)
+{
+	__atomic_compare_exchange_n(Destination, &Comparand, Exchange, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return Comparand;
+}
+
+static inline UCHAR _BitScanForward(unsigned long* Index, unsigned int Mask)
+{
+	if (!Mask) return 0;
+	*Index = (unsigned long)__builtin_ctz(Mask);
+	return 1;
+}
+
+static inline UCHAR _BitScanForward64(unsigned long* Index, unsigned long long Mask)
+{
+	if (!Mask) return 0;
+	*Index = (unsigned long)__builtin_ctzll(Mask);
+	return 1;
+}
+
+#include "ntimage.h"
+
+#endif
@@ -1,7 +1,9 @@
 #pragma once
 
+#ifndef BC_HOSTSIM // on the host, ULONG is defined (32 bit wide) by the ntddk.h of HostSim.
 typedef unsigned char BYTE;
 typedef unsigned long ULONG;
+#endif
 
 #define BCSFILE_HEADER_SIGNATURE		0x00534342
 #define BCSFILE_HEADER_VERSION			2